@@ -73,6 +73,14 @@ const AP_Scheduler::Task Rover::scheduler_tasks[] PROGMEM = {
     { SCHED_TASK(mount_update),           1,    600 },
     { SCHED_TASK(gcs_failsafe_check),     5,    600 },
     { SCHED_TASK(compass_accumulate),     1,    900 },
+    { SCHED_TASK(compass_cal_update),     1,   1000 },
+    { SCHED_TASK(accel_cal_update),       1,   1000 },
+#if INS_BATCH_SAMPLER_ENABLED
+    { SCHED_TASK(log_imu_batch),          1,    500 },
+#endif
+#if GYRO_FFT_ENABLED
+    { SCHED_TASK(gyro_fft_update),        1,   1000 },
+#endif
     { SCHED_TASK(update_notify),          1,    300 },
     { SCHED_TASK(one_second_loop),       50,   3000 },
 #if FRSKY_TELEM_ENABLED == ENABLED
@@ -204,6 +212,40 @@ void Rover::compass_accumulate(void)
     }
 }
 
+/*
+  run the next slice of any onboard compass calibration
+ */
+void Rover::compass_cal_update(void)
+{
+#if COMPASS_CAL_ENABLED
+    if (!hal.util->get_soft_armed()) {
+        compass.compass_cal_update();
+    }
+#endif
+}
+
+/*
+  run the next slice of any background accel calibration, and prompt
+  the user for the next orientation
+ */
+void Rover::accel_cal_update(void)
+{
+    if (hal.util->get_soft_armed()) {
+        if (ins.calibrating()) {
+            ins.accel_cal_cancel();
+        }
+        return;
+    }
+    ins.accel_cal_update();
+    GCS_MAVLINK::send_accel_cal_status(ins);
+
+    float trim_roll, trim_pitch;
+    if (ins.accel_cal_get_trim(trim_roll, trim_pitch)) {
+        // reset ahrs's trim to suggested values from calibration routine
+        ahrs.set_trim(Vector3f(trim_roll, trim_pitch, 0));
+    }
+}
+
 /*
   check for new compass data - 10Hz
  */
@@ -236,6 +278,31 @@ void Rover::update_logging1(void)
         Log_Write_Nav_Tuning();
 }
 
+#if INS_BATCH_SAMPLER_ENABLED
+/*
+  write out any batch of raw IMU samples a few messages at a time - 50Hz
+ */
+void Rover::log_imu_batch(void)
+{
+    ins.write_batch_log();
+}
+#endif
+
+#if GYRO_FFT_ENABLED
+/*
+  run the next step of the gyro spectrum analysis, logging each new
+  result
+ */
+void Rover::gyro_fft_update(void)
+{
+    uint32_t last_ms = gyro_fft.last_result_ms();
+    gyro_fft.update();
+    if (gyro_fft.last_result_ms() != last_ms && should_log(MASK_LOG_IMU)) {
+        gyro_fft.log_data(DataFlash, LOG_GYRO_FFT_MSG);
+    }
+}
+#endif
+
 /*
   log some key data - 10Hz
  */
@@ -267,6 +334,10 @@ void Rover::one_second_loop(void)
 {
     if (should_log(MASK_LOG_CURRENT))
         Log_Write_Current();
+
+#if COMPASS_CAL_ENABLED
+    GCS_MAVLINK::send_compass_cal_status(compass);
+#endif
     // send a heartbeat
     gcs_send_message(MSG_HEARTBEAT);
 
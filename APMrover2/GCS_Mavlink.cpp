@@ -553,6 +553,16 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
 #endif
         break;
 
+    case MSG_GYRO_FFT:
+#if GYRO_FFT_ENABLED
+        if (!rover.gyro_fft.have_result()) {
+            break;
+        }
+        CHECK_PAYLOAD_SIZE(NAMED_VALUE_FLOAT);
+        rover.gyro_fft.send_mavlink(chan);
+#endif
+        break;
+
     case MSG_RETRY_DEFERRED:
     case MSG_TERRAIN:
     case MSG_OPTICAL_FLOW:
@@ -782,6 +792,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_BATTERY2);
         send_message(MSG_MOUNT_STATUS);
         send_message(MSG_EKF_STATUS_REPORT);
+        send_message(MSG_GYRO_FFT);
     }
 }
 
@@ -865,6 +876,19 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
                     } else {
                         result = MAV_RESULT_FAILED;
                     }
+                } else if (is_equal(packet.param2,1.0f)) {
+#if COMPASS_CAL_ENABLED
+                    // onboard compass calibration, which runs in the
+                    // background while the vehicle is rotated
+                    if (!hal.util->get_soft_armed() &&
+                        rover.compass.start_calibration_all(true, true, 2.0f)) {
+                        result = MAV_RESULT_ACCEPTED;
+                    } else {
+                        result = MAV_RESULT_FAILED;
+                    }
+#else
+                    result = MAV_RESULT_UNSUPPORTED;
+#endif
                 } else if (is_equal(packet.param3,1.0f)) {
                     rover.init_barometer();
                     result = MAV_RESULT_ACCEPTED;
@@ -872,16 +896,15 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
                     rover.trim_radio();
                     result = MAV_RESULT_ACCEPTED;
                 } else if (is_equal(packet.param5,1.0f)) {
-                    float trim_roll, trim_pitch;
-                    AP_InertialSensor_UserInteract_MAVLink interact(this);
                     if (rover.g.skip_gyro_cal) {
                         // start with gyro calibration, otherwise if the user
                         // has SKIP_GYRO_CAL=1 they don't get to do it
                         rover.ins.init_gyro();
                     }
-                    if(rover.ins.calibrate_accel(&interact, trim_roll, trim_pitch)) {
-                        // reset ahrs's trim to suggested values from calibration routine
-                        rover.ahrs.set_trim(Vector3f(trim_roll, trim_pitch, 0));
+                    // the accel calibration runs in the background, asking
+                    // for each orientation by STATUSTEXT. The user
+                    // confirms each one with a COMMAND_ACK
+                    if (!hal.util->get_soft_armed() && rover.ins.accel_cal_start()) {
                         result = MAV_RESULT_ACCEPTED;
                     } else {
                         result = MAV_RESULT_FAILED;
@@ -993,6 +1016,12 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
             break;
         }
 
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+    {
+        // the vehicle is in place for the next accel cal orientation
+        rover.ins.accel_cal_collect_sample();
+        break;
+    }
 
     case MAVLINK_MSG_ID_SET_MODE:
 		{
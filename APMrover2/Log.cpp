@@ -386,6 +386,9 @@ const LogStructure Rover::log_structure[] PROGMEM = {
       "SONR", "QfHHHbHCb",  "TimeUS,LatAcc,S1Dist,S2Dist,DCnt,TAng,TTim,Spd,Thr" },
     { LOG_STEERING_MSG, sizeof(log_Steering),             
       "STER", "Qff",   "TimeUS,Demanded,Achieved" },
+#if GYRO_FFT_ENABLED
+    GYRO_FFT_LOG_FORMAT(LOG_GYRO_FFT_MSG),
+#endif
 };
 
 void Rover::log_init(void)
@@ -479,6 +479,12 @@ const AP_Param::Info Rover::var_info[] PROGMEM = {
     // @Path: ../libraries/AP_InertialSensor/AP_InertialSensor.cpp
     GOBJECT(ins,                            "INS_", AP_InertialSensor),
 
+#if GYRO_FFT_ENABLED
+    // @Group: FFT_
+    // @Path: ../libraries/AP_GyroFFT/AP_GyroFFT.cpp
+    GOBJECT(gyro_fft,                       "FFT_", AP_GyroFFT),
+#endif
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
     // @Group: SIM_
     // @Path: ../libraries/SITL/SITL.cpp
@@ -517,7 +523,7 @@ const AP_Param::Info Rover::var_info[] PROGMEM = {
 #if AP_AHRS_NAVEKF_AVAILABLE
     // @Group: EKF_
     // @Path: ../libraries/AP_NavEKF/AP_NavEKF.cpp
-    GOBJECTN(ahrs.get_NavEKF(), NavEKF, "EKF_", NavEKF),
+    GOBJECTN(ahrs.get_NavEKF_params(), NavEKF, "EKF_", NavEKF),
 #endif
 
     // @Group: MIS_
@@ -80,6 +80,7 @@ public:
         k_param_steering_learn, // unused
         k_param_NavEKF,  // Extended Kalman Filter Inertial Navigation Group
         k_param_mission, // mission library
+        k_param_gyro_fft,
 
         // 140: battery controls
         k_param_battery_monitoring = 140,   // deprecated, can be deleted
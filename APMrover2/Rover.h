@@ -39,6 +39,7 @@
 #include <AP_Compass.h>     // ArduPilot Mega Magnetometer Library
 #include <AP_Math.h>        // ArduPilot Mega Vector/Matrix math Library
 #include <AP_InertialSensor.h> // Inertial Sensor (uncalibated IMU) Library
+#include <AP_GyroFFT.h>        // gyro spectrum analysis
 #include <AP_AHRS.h>         // ArduPilot Mega DCM Library
 #include <AP_NavEKF.h>
 #include <AP_Mission.h>     // Mission command library
@@ -151,6 +152,9 @@ private:
     AP_Baro barometer;
     Compass compass;
     AP_InertialSensor ins;
+#if GYRO_FFT_ENABLED
+    AP_GyroFFT gyro_fft {ins};
+#endif
     RangeFinder sonar;
 
     // flight modes convenience array
@@ -373,9 +377,13 @@ private:
     void update_alt();
     void gcs_failsafe_check(void);
     void compass_accumulate(void);
+    void compass_cal_update(void);
+    void accel_cal_update(void);
     void update_compass(void);
     void update_logging1(void);
     void update_logging2(void);
+    void log_imu_batch(void);
+    void gyro_fft_update(void);
     void update_aux(void);
     void one_second_loop(void);
     void update_GPS_50Hz(void);
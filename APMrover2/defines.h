@@ -68,6 +68,7 @@ enum mode {
 #define LOG_STARTUP_MSG 		0x06
 #define LOG_SONAR_MSG 		    0x07
 #define LOG_STEERING_MSG        0x0D
+#define LOG_GYRO_FFT_MSG        0x0E
 
 #define TYPE_AIRSTART_MSG		0x00
 #define TYPE_GROUNDSTART_MSG	0x01
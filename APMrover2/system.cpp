@@ -406,6 +406,10 @@ void Rover::startup_INS_ground(void)
 	ins.init(style, ins_sample_rate);
 
     ahrs.reset();
+
+#if GYRO_FFT_ENABLED
+    gyro_fft.init();
+#endif
 }
 
 // updates the notify state
@@ -273,6 +273,7 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_GIMBAL_REPORT:
     case MSG_EKF_STATUS_REPORT:
     case MSG_PID_TUNING:
+    case MSG_GYRO_FFT:
         break; // just here to prevent a warning
     }
     return true;
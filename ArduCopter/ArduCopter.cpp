@@ -109,31 +109,36 @@ const AP_Scheduler::Task Copter::scheduler_tasks[] PROGMEM = {
     { SCHED_TASK(update_thr_average),    4,     90 },   // 10
     { SCHED_TASK(three_hz_loop),       133,     75 },   // 11
     { SCHED_TASK(compass_accumulate),    8,    100 },   // 12
-    { SCHED_TASK(barometer_accumulate),  8,     90 },   // 13
+    { SCHED_TASK(compass_cal_update),    8,    100 },   // 13
+    { SCHED_TASK(accel_cal_update),      8,    100 },   // 14
+#if GYRO_FFT_ENABLED
+    { SCHED_TASK(gyro_fft_update),       8,    100 },   // 15
+#endif
+    { SCHED_TASK(barometer_accumulate),  8,     90 },   // 16
 #if FRAME_CONFIG == HELI_FRAME
     { SCHED_TASK(check_dynamic_flight),  8,     75 },
 #endif
-    { SCHED_TASK(update_notify),         8,     90 },   // 14
-    { SCHED_TASK(one_hz_loop),         400,    100 },   // 15
-    { SCHED_TASK(ekf_check),            40,     75 },   // 16
-    { SCHED_TASK(crash_check),          40,     75 },   // 17
-    { SCHED_TASK(landinggear_update),   40,     75 },   // 18
-    { SCHED_TASK(lost_vehicle_check),   40,     50 },   // 19
-    { SCHED_TASK(gcs_check_input),       1,    180 },   // 20
-    { SCHED_TASK(gcs_send_heartbeat),  400,    110 },   // 21
-    { SCHED_TASK(gcs_send_deferred),     8,    550 },   // 22
-    { SCHED_TASK(gcs_data_stream_send),  8,    550 },   // 23
-    { SCHED_TASK(update_mount),          8,     75 },   // 24
-    { SCHED_TASK(ten_hz_logging_loop),  40,    350 },   // 25
-    { SCHED_TASK(fifty_hz_logging_loop), 8,    110 },   // 26
-    { SCHED_TASK(full_rate_logging_loop),1,    100 },   // 27
-    { SCHED_TASK(perf_update),        4000,     75 },   // 28
-    { SCHED_TASK(read_receiver_rssi),   40,     75 },   // 29
+    { SCHED_TASK(update_notify),         8,     90 },   // 17
+    { SCHED_TASK(one_hz_loop),         400,    100 },   // 18
+    { SCHED_TASK(ekf_check),            40,     75 },   // 19
+    { SCHED_TASK(crash_check),          40,     75 },   // 20
+    { SCHED_TASK(landinggear_update),   40,     75 },   // 21
+    { SCHED_TASK(lost_vehicle_check),   40,     50 },   // 22
+    { SCHED_TASK(gcs_check_input),       1,    180 },   // 23
+    { SCHED_TASK(gcs_send_heartbeat),  400,    110 },   // 24
+    { SCHED_TASK(gcs_send_deferred),     8,    550 },   // 25
+    { SCHED_TASK(gcs_data_stream_send),  8,    550 },   // 26
+    { SCHED_TASK(update_mount),          8,     75 },   // 27
+    { SCHED_TASK(ten_hz_logging_loop),  40,    350 },   // 28
+    { SCHED_TASK(fifty_hz_logging_loop), 8,    110 },   // 29
+    { SCHED_TASK(full_rate_logging_loop),1,    100 },   // 30
+    { SCHED_TASK(perf_update),        4000,     75 },   // 31
+    { SCHED_TASK(read_receiver_rssi),   40,     75 },   // 32
 #if FRSKY_TELEM_ENABLED == ENABLED
-    { SCHED_TASK(frsky_telemetry_send), 80,     75 },   // 30
+    { SCHED_TASK(frsky_telemetry_send), 80,     75 },   // 33
 #endif
 #if EPM_ENABLED == ENABLED
-    { SCHED_TASK(epm_update),           40,     75 },   // 31
+    { SCHED_TASK(epm_update),           40,     75 },   // 34
 #endif
 #ifdef USERHOOK_FASTLOOP
     { SCHED_TASK(userhook_FastLoop),     4,     75 },
@@ -183,6 +188,55 @@ void Copter::compass_accumulate(void)
     }
 }
 
+/*
+  run the next slice of any onboard compass calibration
+ */
+void Copter::compass_cal_update(void)
+{
+#if COMPASS_CAL_ENABLED
+    if (!motors.armed()) {
+        compass.compass_cal_update();
+    }
+#endif
+}
+
+/*
+  run the next slice of any background accel calibration, and prompt
+  the user for the next orientation
+ */
+void Copter::accel_cal_update(void)
+{
+    if (motors.armed()) {
+        if (ins.calibrating()) {
+            ins.accel_cal_cancel();
+        }
+        return;
+    }
+    ins.accel_cal_update();
+    GCS_MAVLINK::send_accel_cal_status(ins);
+
+    float trim_roll, trim_pitch;
+    if (ins.accel_cal_get_trim(trim_roll, trim_pitch)) {
+        // reset ahrs's trim to suggested values from calibration routine
+        ahrs.set_trim(Vector3f(trim_roll, trim_pitch, 0));
+    }
+}
+
+#if GYRO_FFT_ENABLED
+/*
+  run the next step of the gyro spectrum analysis, logging each new
+  result
+ */
+void Copter::gyro_fft_update(void)
+{
+    uint32_t last_ms = gyro_fft.last_result_ms();
+    gyro_fft.update();
+    if (gyro_fft.last_result_ms() != last_ms && should_log(MASK_LOG_IMU)) {
+        gyro_fft.log_data(DataFlash, LOG_GYRO_FFT_MSG);
+    }
+}
+#endif
+
 /*
   try to accumulate a baro reading
  */
@@ -258,6 +312,11 @@ void Copter::fast_loop()
     // send outputs to the motors library
     motors_output();
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // let the gyro notch follow the motor frequency
+    ins.set_harmonic_notch_throttle(motors.get_throttle() * 0.001f);
+#endif
+
     // Inertial Nav
     // --------------------
     read_inertia();
@@ -391,6 +450,11 @@ void Copter::fifty_hz_logging_loop()
         DataFlash.Log_Write_IMU(ins);
     }
 #endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+    // write out any batch of raw IMU samples a few messages at a time
+    ins.write_batch_log();
+#endif
 }
 
 // full_rate_logging_loop
@@ -430,6 +494,10 @@ void Copter::one_hz_loop()
         Log_Write_Data(DATA_AP_STATE, ap.value);
     }
 
+#if COMPASS_CAL_ENABLED
+    GCS_MAVLINK::send_compass_cal_status(compass);
+#endif
+
     // perform pre-arm checks & display failures every 30 seconds
     static uint8_t pre_arm_display_counter = 15;
     pre_arm_display_counter++;
@@ -588,6 +656,7 @@ void Copter::read_AHRS(void)
 #endif
 
     ahrs.update();
+    ekf_check_core_switch();
 }
 
 // read baro and sonar altitude at 10hz
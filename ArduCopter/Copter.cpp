@@ -28,6 +28,9 @@ Copter::Copter(void) :
     ins_sample_rate(AP_InertialSensor::RATE_400HZ),
     flight_modes(&g.flight_mode1),
     sonar_enabled(true),
+#if GYRO_FFT_ENABLED
+    gyro_fft(ins),
+#endif
     ahrs(ins, barometer, gps, sonar),
     mission(ahrs, 
             FUNCTOR_BIND_MEMBER(&Copter::start_command, bool, const AP_Mission::Mission_Command &),
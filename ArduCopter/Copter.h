@@ -56,6 +56,7 @@
 #include <AP_Math.h>            // ArduPilot Mega Vector/Matrix math Library
 #include <AP_Curve.h>           // Curve used to linearlise throttle pwm to thrust
 #include <AP_InertialSensor.h>  // ArduPilot Mega Inertial Sensor (accel & gyro) Library
+#include <AP_GyroFFT.h>         // gyro spectrum analysis
 #include <AP_AHRS.h>
 #include <AP_NavEKF.h>
 #include <AP_Mission.h>         // Mission command library
@@ -171,6 +172,10 @@ private:
     Compass compass;
     AP_InertialSensor ins;
 
+#if GYRO_FFT_ENABLED
+    AP_GyroFFT gyro_fft;
+#endif
+
 #if CONFIG_SONAR == ENABLED
     RangeFinder sonar;
     bool sonar_enabled; // enable user switch for sonar
@@ -513,6 +518,9 @@ private:
     static const struct LogStructure log_structure[];
 
     void compass_accumulate(void);
+    void compass_cal_update(void);
+    void accel_cal_update(void);
+    void gyro_fft_update(void);
     void barometer_accumulate(void);
     void perf_update(void);
     void fast_loop();
@@ -755,6 +763,7 @@ private:
     void parachute_release();
     void parachute_manual_release();
     void ekf_check();
+    void ekf_check_core_switch();
     bool ekf_over_threshold();
     void failsafe_ekf_event();
     void failsafe_ekf_off_event(void);
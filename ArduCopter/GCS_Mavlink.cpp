@@ -709,6 +709,16 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
 #endif
         break;
 
+    case MSG_GYRO_FFT:
+#if GYRO_FFT_ENABLED
+        if (!copter.gyro_fft.have_result()) {
+            break;
+        }
+        CHECK_PAYLOAD_SIZE(NAMED_VALUE_FLOAT);
+        copter.gyro_fft.send_mavlink(chan);
+#endif
+        break;
+
     case MSG_FENCE_STATUS:
     case MSG_WIND:
         // unused
@@ -943,6 +953,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_OPTICAL_FLOW);
         send_message(MSG_GIMBAL_REPORT);
         send_message(MSG_EKF_STATUS_REPORT);
+        send_message(MSG_GYRO_FFT);
     }
 }
 
@@ -1232,6 +1243,19 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
                 } else {
                     result = MAV_RESULT_FAILED;
                 }
+            } else if (is_equal(packet.param2,1.0f)) {
+#if COMPASS_CAL_ENABLED
+                // onboard compass calibration, which runs in the
+                // background while the vehicle is rotated
+                if (!copter.motors.armed() &&
+                    copter.compass.start_calibration_all(true, true, 2.0f)) {
+                    result = MAV_RESULT_ACCEPTED;
+                } else {
+                    result = MAV_RESULT_FAILED;
+                }
+#else
+                result = MAV_RESULT_UNSUPPORTED;
+#endif
             } else if (is_equal(packet.param3,1.0f)) {
                 // fast barometer calibration
                 copter.init_barometer(false);
@@ -1239,13 +1263,10 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
             } else if (is_equal(packet.param4,1.0f)) {
                 result = MAV_RESULT_UNSUPPORTED;
             } else if (is_equal(packet.param5,1.0f)) {
-                // 3d accel calibration
-                float trim_roll, trim_pitch;
-                // this blocks
-                AP_InertialSensor_UserInteract_MAVLink interact(this);
-                if(copter.ins.calibrate_accel(&interact, trim_roll, trim_pitch)) {
-                    // reset ahrs's trim to suggested values from calibration routine
-                    copter.ahrs.set_trim(Vector3f(trim_roll, trim_pitch, 0));
+                // 3d accel calibration. This runs in the background,
+                // asking for each orientation by STATUSTEXT. The
+                // user confirms each one with a COMMAND_ACK
+                if (!copter.motors.armed() && copter.ins.accel_cal_start()) {
                     result = MAV_RESULT_ACCEPTED;
                 } else {
                     result = MAV_RESULT_FAILED;
@@ -1424,6 +1445,8 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
     case MAVLINK_MSG_ID_COMMAND_ACK:        // MAV ID: 77
     {
         copter.command_ack_counter++;
+        // the vehicle is in place for the next accel cal orientation
+        copter.ins.accel_cal_collect_sample();
         break;
     }
 
@@ -1701,6 +1724,41 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
     }
 #endif // AC_RALLY == ENABLED
 
+#if AC_FENCE == ENABLED
+    // receive a polygon fence point from GCS and store in EEPROM
+    case MAVLINK_MSG_ID_FENCE_POINT: {
+        mavlink_fence_point_t packet;
+        mavlink_msg_fence_point_decode(msg, &packet);
+        if (copter.fence.enabled()) {
+            send_text_P(SEVERITY_LOW,PSTR("fencing must be disabled"));
+        } else if (packet.count != copter.fence.get_polygon_total() ||
+                   packet.idx >= copter.fence.max_polygon_points()) {
+            send_text_P(SEVERITY_LOW,PSTR("bad fence point"));
+        } else {
+            Vector2l point;
+            point.x = packet.lat*1.0e7f;
+            point.y = packet.lng*1.0e7f;
+            copter.fence.set_polygon_point(point, packet.idx);
+        }
+        break;
+    }
+
+    // send a polygon fence point to GCS
+    case MAVLINK_MSG_ID_FENCE_FETCH_POINT: {
+        mavlink_fence_fetch_point_t packet;
+        mavlink_msg_fence_fetch_point_decode(msg, &packet);
+        if (packet.idx >= copter.fence.get_polygon_total()) {
+            send_text_P(SEVERITY_LOW,PSTR("bad fence point"));
+        } else {
+            Vector2l point = copter.fence.get_polygon_point(packet.idx);
+            mavlink_msg_fence_point_send_buf(msg, chan, msg->sysid, msg->compid, packet.idx,
+                                             copter.fence.get_polygon_total(),
+                                             point.x*1.0e-7f, point.y*1.0e-7f);
+        }
+        break;
+    }
+#endif // AC_FENCE == ENABLED
+
     case MAVLINK_MSG_ID_AUTOPILOT_VERSION_REQUEST:
         copter.gcs[chan-MAVLINK_COMM_0].send_autopilot_version();
         break;
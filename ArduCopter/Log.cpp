@@ -686,6 +686,9 @@ const struct LogStructure Copter::log_structure[] PROGMEM = {
       "DFLT",  "QBf",         "TimeUS,Id,Value" },
     { LOG_ERROR_MSG, sizeof(log_Error),         
       "ERR",   "QBB",         "TimeUS,Subsys,ECode" },
+#if GYRO_FFT_ENABLED
+    GYRO_FFT_LOG_FORMAT(LOG_GYRO_FFT_MSG),
+#endif
 };
 
 #if CLI_ENABLED == ENABLED
@@ -712,6 +715,7 @@ void Copter::start_logging()
         if (!ap.logging_started) {
             ap.logging_started = true;
             in_mavlink_delay = true;
+            DataFlash.SetCompact((g.log_bitmask & MASK_LOG_COMPACT) != 0);
             DataFlash.StartNewLog();
             in_mavlink_delay = false;
             DataFlash.Log_Write_Message_P(PSTR(FIRMWARE_STRING));
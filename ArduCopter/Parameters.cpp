@@ -346,7 +346,7 @@ const AP_Param::Info Copter::var_info[] PROGMEM = {
 
     // @Param: LOG_BITMASK
     // @DisplayName: Log bitmask
-    // @Description: 4 byte bitmap of log types to enable
+    // @Description: 4 byte bitmap of log types to enable. Bit 20 selects the compact log encoding, which makes logs about half the size. Only Tools/Replay can read compact logs at the moment, other log viewers and analysis tools will show them as corrupt, so leave bit 20 off unless you use Replay
     // @Values: 830:Default,894:Default+RCIN,958:Default+IMU,1854:Default+Motors,-6146:NearlyAll-AC315,45054:NearlyAll,131070:All+DisarmedLogging,131071:All+FastATT,262142:All+MotBatt,393214:All+FastIMU,397310:All+FastIMU+PID,0:Disabled
     // @User: Standard
     GSCALAR(log_bitmask,    "LOG_BITMASK",          DEFAULT_LOG_BITMASK),
@@ -858,6 +858,12 @@ const AP_Param::Info Copter::var_info[] PROGMEM = {
     // @Path: ../libraries/AP_InertialSensor/AP_InertialSensor.cpp
     GOBJECT(ins,            "INS_", AP_InertialSensor),
 
+#if GYRO_FFT_ENABLED
+    // @Group: FFT_
+    // @Path: ../libraries/AP_GyroFFT/AP_GyroFFT.cpp
+    GOBJECT(gyro_fft,       "FFT_", AP_GyroFFT),
+#endif
+
     // @Group: WPNAV_
     // @Path: ../libraries/AC_WPNav/AC_WPNav.cpp
     GOBJECT(wp_nav, "WPNAV_",       AC_WPNav),
@@ -1004,7 +1010,7 @@ const AP_Param::Info Copter::var_info[] PROGMEM = {
 #if AP_AHRS_NAVEKF_AVAILABLE
     // @Group: EKF_
     // @Path: ../libraries/AP_NavEKF/AP_NavEKF.cpp
-    GOBJECTN(ahrs.get_NavEKF(), NavEKF, "EKF_", NavEKF),
+    GOBJECTN(ahrs.get_NavEKF_params(), NavEKF, "EKF_", NavEKF),
 #endif
 
     // @Group: MIS_
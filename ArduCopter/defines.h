@@ -239,6 +239,7 @@ enum FlipState {
 #define LOG_RATE_MSG                    0x1D
 #define LOG_MOTBATT_MSG                 0x1E
 #define LOG_PARAMTUNE_MSG               0x1F
+#define LOG_GYRO_FFT_MSG                0x20
 
 #define MASK_LOG_ATTITUDE_FAST          (1<<0)
 #define MASK_LOG_ATTITUDE_MED           (1<<1)
@@ -260,6 +261,7 @@ enum FlipState {
 #define MASK_LOG_MOTBATT                (1UL<<17)
 #define MASK_LOG_IMU_FAST               (1UL<<18)
 #define MASK_LOG_IMU_RAW                (1UL<<19)
+#define MASK_LOG_COMPACT                (1UL<<20) // compact log encoding, see LogCompact.h
 #define MASK_LOG_ANY                    0xFFFF
 
 // DATA - event logging
@@ -361,6 +363,7 @@ enum FlipState {
 // EKF check definitions
 #define ERROR_CODE_EKFCHECK_BAD_VARIANCE       2
 #define ERROR_CODE_EKFCHECK_VARIANCE_CLEARED   0
+#define ERROR_CODE_EKFCHECK_CORE_SWITCH        3
 // Baro specific error codes
 #define ERROR_CODE_BARO_GLITCH              2
 
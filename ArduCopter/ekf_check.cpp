@@ -24,6 +24,7 @@ static struct {
     uint8_t fail_count;         // number of iterations ekf or dcm have been out of tolerances
     uint8_t bad_variance : 1;   // true if ekf should be considered untrusted (fail_count has exceeded EKF_CHECK_ITERATIONS_MAX)
     uint32_t last_warn_time;    // system time of last warning in milliseconds.  Used to throttle text warnings sent to GCS
+    uint8_t core_switch_count;  // AHRS primary EKF instance change count when last checked
 } ekf_check_state;
 
 // ekf_check - detects if ekf variance are out of tolerance and triggers failsafe
@@ -153,3 +154,30 @@ void Copter::failsafe_ekf_off_event(void)
     failsafe.ekf = false;
     Log_Write_Error(ERROR_SUBSYSTEM_FAILSAFE_EKFINAV, ERROR_CODE_FAILSAFE_RESOLVED);
 }
+
+// ekf_check_core_switch - shift controller targets when the AHRS changes its
+// primary EKF instance, so the step between solutions is not flown as an error
+// should be called after each ahrs update
+void Copter::ekf_check_core_switch()
+{
+    Vector3f pos_step;
+    float yaw_step;
+    uint8_t count = ahrs.get_NavEKF_core_switch(pos_step, yaw_step);
+    if (count == ekf_check_state.core_switch_count) {
+        return;
+    }
+    ekf_check_state.core_switch_count = count;
+
+    // hold the new heading rather than turning back to the old one
+    attitude_control.set_yaw_target_to_current_heading();
+
+    // move the position targets with the solution (NED m to NEU cm)
+    if (pos_control.is_active_xy()) {
+        const Vector3f &target = pos_control.get_pos_target();
+        pos_control.set_xy_target(target.x + pos_step.x * 100.0f, target.y + pos_step.y * 100.0f);
+    }
+    if (pos_control.is_active_z()) {
+        pos_control.set_alt_target(pos_control.get_pos_target().z - pos_step.z * 100.0f);
+    }
+    Log_Write_Error(ERROR_SUBSYSTEM_EKFCHECK, ERROR_CODE_EKFCHECK_CORE_SWITCH);
+}
@@ -337,6 +337,16 @@ bool Copter::pre_arm_checks(bool display_failure)
             return false;
         }
 
+#if COMPASS_CAL_ENABLED
+        // don't arm while an onboard calibration is running
+        if (compass.is_calibrating()) {
+            if (display_failure) {
+                gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: Compass calibration running"));
+            }
+            return false;
+        }
+#endif
+
         // check for unreasonable compass offsets
         Vector3f offsets = compass.get_offsets();
         if(offsets.length() > COMPASS_OFFSETS_MAX) {
@@ -394,6 +404,14 @@ bool Copter::pre_arm_checks(bool display_failure)
 
     // check INS
     if ((g.arming_check == ARMING_CHECK_ALL) || (g.arming_check & ARMING_CHECK_INS)) {
+        // don't arm while an accel calibration is running
+        if (ins.calibrating()) {
+            if (display_failure) {
+                gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: Accel calibration running"));
+            }
+            return false;
+        }
+
         // check accelerometers have been calibrated
         if(!ins.accel_calibrated_ok_all()) {
             if (display_failure) {
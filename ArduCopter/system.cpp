@@ -296,6 +296,10 @@ void Copter::startup_ground(bool force_gyro_cal)
     report_ins();
  #endif
 
+#if GYRO_FFT_ENABLED
+    gyro_fft.init();
+#endif
+
     // reset ahrs gyro bias
     if (force_gyro_cal) {
         ahrs.reset_gyro_drift();
@@ -143,17 +143,17 @@ void Copter::tuning() {
         // disabled for now - we need accessor functions
     case TUNING_EKF_VERTICAL_POS:
         // EKF's baro vs accel (higher rely on accels more, baro impact is reduced)
-        ahrs.get_NavEKF()._gpsVertPosNoise = tuning_value;
+        ahrs.get_NavEKF_params()._gpsVertPosNoise = tuning_value;
         break;
 
     case TUNING_EKF_HORIZONTAL_POS:
         // EKF's gps vs accel (higher rely on accels more, gps impact is reduced)
-        ahrs.get_NavEKF()._gpsHorizPosNoise = tuning_value;
+        ahrs.get_NavEKF_params()._gpsHorizPosNoise = tuning_value;
         break;
 
     case TUNING_EKF_ACCEL_NOISE:
         // EKF's accel noise (lower means trust accels more, gps & baro less)
-        ahrs.get_NavEKF()._accNoise = tuning_value;
+        ahrs.get_NavEKF_params()._accNoise = tuning_value;
         break;
 #endif
 
@@ -57,6 +57,14 @@ const AP_Scheduler::Task Plane::scheduler_tasks[] PROGMEM = {
     { SCHED_TASK(check_usb_mux),          5,    300 },
     { SCHED_TASK(read_battery),           5,   1000 },
     { SCHED_TASK(compass_accumulate),     1,   1500 },
+    { SCHED_TASK(compass_cal_update),     1,   1000 },
+    { SCHED_TASK(accel_cal_update),       1,   1000 },
+#if INS_BATCH_SAMPLER_ENABLED
+    { SCHED_TASK(log_imu_batch),          1,    500 },
+#endif
+#if GYRO_FFT_ENABLED
+    { SCHED_TASK(gyro_fft_update),        1,   1000 },
+#endif
     { SCHED_TASK(barometer_accumulate),   1,    900 },
     { SCHED_TASK(update_notify),          1,    300 },
     { SCHED_TASK(read_rangefinder),       1,    500 },
@@ -220,6 +228,55 @@ void Plane::compass_accumulate(void)
     }    
 }
 
+/*
+  run the next slice of any onboard compass calibration
+ */
+void Plane::compass_cal_update(void)
+{
+#if COMPASS_CAL_ENABLED
+    if (!hal.util->get_soft_armed()) {
+        compass.compass_cal_update();
+    }
+#endif
+}
+
+/*
+  run the next slice of any background accel calibration, and prompt
+  the user for the next orientation
+ */
+void Plane::accel_cal_update(void)
+{
+    if (hal.util->get_soft_armed()) {
+        if (ins.calibrating()) {
+            ins.accel_cal_cancel();
+        }
+        return;
+    }
+    ins.accel_cal_update();
+    GCS_MAVLINK::send_accel_cal_status(ins);
+
+    float trim_roll, trim_pitch;
+    if (ins.accel_cal_get_trim(trim_roll, trim_pitch)) {
+        // reset ahrs's trim to suggested values from calibration routine
+        ahrs.set_trim(Vector3f(trim_roll, trim_pitch, 0));
+    }
+}
+
+#if GYRO_FFT_ENABLED
+/*
+  run the next step of the gyro spectrum analysis, logging each new
+  result
+ */
+void Plane::gyro_fft_update(void)
+{
+    uint32_t last_ms = gyro_fft.last_result_ms();
+    gyro_fft.update();
+    if (gyro_fft.last_result_ms() != last_ms && should_log(MASK_LOG_IMU)) {
+        gyro_fft.log_data(DataFlash, LOG_GYRO_FFT_MSG);
+    }
+}
+#endif
+
 /*
   try to accumulate a baro reading
  */
@@ -241,6 +298,16 @@ void Plane::update_logging1(void)
         Log_Write_IMU();
 }
 
+#if INS_BATCH_SAMPLER_ENABLED
+/*
+  write out any batch of raw IMU samples a few messages at a time - 50Hz
+ */
+void Plane::log_imu_batch(void)
+{
+    ins.write_batch_log();
+}
+#endif
+
 /*
   do 10Hz logging - part2
  */
@@ -284,6 +351,10 @@ void Plane::one_second_loop()
     if (should_log(MASK_LOG_CURRENT))
         Log_Write_Current();
 
+#if COMPASS_CAL_ENABLED
+    GCS_MAVLINK::send_compass_cal_status(compass);
+#endif
+
     // send a heartbeat
     gcs_send_message(MSG_HEARTBEAT);
 
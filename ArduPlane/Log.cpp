@@ -487,6 +487,9 @@ static const struct LogStructure log_structure[] PROGMEM = {
 #if OPTFLOW == ENABLED
     { LOG_OPTFLOW_MSG, sizeof(log_Optflow),
       "OF",   "QBffff",   "TimeUS,Qual,flowX,flowY,bodyX,bodyY" },
+#endif
+#if GYRO_FFT_ENABLED
+    GYRO_FFT_LOG_FORMAT(LOG_GYRO_FFT_MSG),
 #endif
     TECS_LOG_FORMAT(LOG_TECS_MSG)
 };
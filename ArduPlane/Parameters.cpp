@@ -1131,6 +1131,12 @@ const AP_Param::Info Plane::var_info[] PROGMEM = {
     // @Path: ../libraries/AP_InertialSensor/AP_InertialSensor.cpp
     GOBJECT(ins,                    "INS_", AP_InertialSensor),
 
+#if GYRO_FFT_ENABLED
+    // @Group: FFT_
+    // @Path: ../libraries/AP_GyroFFT/AP_GyroFFT.cpp
+    GOBJECT(gyro_fft,               "FFT_", AP_GyroFFT),
+#endif
+
     // @Group: AHRS_
     // @Path: ../libraries/AP_AHRS/AP_AHRS.cpp
     GOBJECT(ahrs,                   "AHRS_",    AP_AHRS),
@@ -1190,7 +1196,7 @@ const AP_Param::Info Plane::var_info[] PROGMEM = {
 #if AP_AHRS_NAVEKF_AVAILABLE
     // @Group: EKF_
     // @Path: ../libraries/AP_NavEKF/AP_NavEKF.cpp
-    GOBJECTN(ahrs.get_NavEKF_const(), NavEKF, "EKF_", NavEKF),
+    GOBJECTN(ahrs.get_NavEKF_params(), NavEKF, "EKF_", NavEKF),
 #endif
 
     AP_VAREND
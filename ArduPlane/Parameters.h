@@ -139,6 +139,7 @@ public:
         k_param_rudder_only,
         k_param_gcs3,            // 93
         k_param_gcs_pid_mask,
+        k_param_gyro_fft,
 
         // 100: Arming parameters
         k_param_arming = 100,
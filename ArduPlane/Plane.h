@@ -44,6 +44,7 @@
 #include <AP_ADC.h>         // ArduPilot Mega Analog to Digital Converter Library
 #include <AP_ADC_AnalogSource.h>
 #include <AP_InertialSensor.h> // Inertial Sensor Library
+#include <AP_GyroFFT.h>        // gyro spectrum analysis
 #include <AP_AHRS.h>         // ArduPilot Mega DCM Library
 #include <RC_Channel.h>     // RC Channel Library
 #include <AP_RangeFinder.h>     // Range finder library
@@ -85,6 +86,7 @@
 #include <AP_ServoRelayEvents.h>
 
 #include <AP_Rally.h>
+#include <AC_PolyFence.h>   // polygon geofence engine
 
 #include <AP_OpticalFlow.h>     // Optical Flow library
 
@@ -172,6 +174,10 @@ private:
 
     AP_InertialSensor ins;
 
+#if GYRO_FFT_ENABLED
+    AP_GyroFFT gyro_fft {ins};
+#endif
+
 // Inertial Navigation EKF
 #if AP_AHRS_NAVEKF_AVAILABLE
     AP_AHRS_NavEKF ahrs {ins, barometer, gps, rangefinder};
@@ -822,6 +828,9 @@ private:
     void update_alt(void);
     void obc_fs_check(void);
     void compass_accumulate(void);
+    void compass_cal_update(void);
+    void accel_cal_update(void);
+    void gyro_fft_update(void);
     void barometer_accumulate(void);
     void update_optical_flow(void);
     void one_second_loop(void);
@@ -831,6 +840,7 @@ private:
     void compass_save(void);
     void update_logging1(void);
     void update_logging2(void);
+    void log_imu_batch(void);
     void terrain_update(void);
     void update_flight_mode(void);
     void stabilize();
@@ -115,6 +115,9 @@ enum log_messages {
 #if OPTFLOW == ENABLED
     ,LOG_OPTFLOW_MSG
 #endif
+#if GYRO_FFT_ENABLED
+    ,LOG_GYRO_FFT_MSG
+#endif
 };
 
 #define MASK_LOG_ATTITUDE_FAST          (1<<0)
@@ -39,6 +39,8 @@ static struct GeofenceState {
     int32_t guided_lng;
     /* point 0 is the return point */
     Vector2l *boundary;
+    /* index over boundary[1] onwards */
+    AC_PolyFence *polygons;
 } *geofence_state;
 
 
@@ -94,7 +96,7 @@ void Plane::geofence_load(void)
     uint8_t i;
 
     if (geofence_state == NULL) {
-        if (hal.util->available_memory() < 512 + sizeof(struct GeofenceState)) {
+        if (hal.util->available_memory() < 512 + sizeof(struct GeofenceState) + sizeof(AC_PolyFence)) {
             // too risky to enable as we could run out of stack
             goto failed;
         }
@@ -110,6 +112,14 @@ void Plane::geofence_load(void)
             geofence_state = NULL;
             goto failed;
         }
+
+        geofence_state->polygons = new AC_PolyFence();
+        if (geofence_state->polygons == NULL) {
+            free(geofence_state->boundary);
+            free(geofence_state);
+            geofence_state = NULL;
+            goto failed;
+        }
         
         geofence_state->old_switch_position = 254;
     }
@@ -124,11 +134,11 @@ void Plane::geofence_load(void)
     }
     geofence_state->num_points = i;
 
-    if (!Polygon_complete(&geofence_state->boundary[1], geofence_state->num_points-1)) {
-        // first point and last point must be the same
+    if (!geofence_state->polygons->load(&geofence_state->boundary[1], geofence_state->num_points-1)) {
+        // each polygon must end with a repeat of its first point
         goto failed;
     }
-    if (Polygon_outside(geofence_state->boundary[0], &geofence_state->boundary[1], geofence_state->num_points-1)) {
+    if (geofence_state->polygons->outside(geofence_state->boundary[0])) {
         // return point needs to be inside the fence
         goto failed;
     }
@@ -324,7 +334,7 @@ void Plane::geofence_check(bool altitude_check_only)
         Vector2l location;
         location.x = loc.lat;
         location.y = loc.lng;
-        outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+        outside = geofence_state->polygons->outside(location);
         if (outside) {
             breach_type = FENCE_BREACH_BOUNDARY;
         }
@@ -554,6 +554,10 @@ void Plane::startup_INS_ground(void)
     ins.init(style, ins_sample_rate);
     ahrs.reset();
 
+#if GYRO_FFT_ENABLED
+    gyro_fft.init();
+#endif
+
     // read Baro pressure at ground
     //-----------------------------
     init_barometer();
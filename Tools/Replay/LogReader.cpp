@@ -11,6 +11,7 @@
 
 #include "LogReader.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -36,7 +37,16 @@ LogReader::LogReader(AP_AHRS &_ahrs, AP_InertialSensor &_ins, AP_Baro &_baro, Co
     gyro_mask(7),
     last_timestamp_usec(0),
     installed_vehicle_specific_parsers(false)
-{}
+{
+    memset(last_msg, 0, sizeof(last_msg));
+}
+
+LogReader::~LogReader()
+{
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        free(last_msg[i]);
+    }
+}
 
 bool LogReader::open_log(const char *logfile)
 {
@@ -86,6 +96,34 @@ MsgHandler_PARM *parameter_handler;
 static const char *generated_types[] = { "EKF1", "EKF2", "EKF3", "EKF4", "EKF5", 
                                          "AHR2", "POS", NULL };
 
+/*
+  read a compact message, decoding it against the last message of its
+  type. The header has already been read. Returns false at the end of
+  the log, and sets decoded to false if the message can't be decoded
+ */
+bool LogReader::read_compact(const struct log_Format &f, uint8_t *msg, bool &decoded)
+{
+    uint8_t len;
+    uint8_t payload[LOG_COMPACT_MAX_PAYLOAD];
+    if (::read(fd, &len, 1) != 1 ||
+        ::read(fd, payload, len) != len) {
+        return false;
+    }
+    decoded = false;
+    if (last_msg[f.type] == NULL) {
+        // the log started part way through, wait for the next full
+        // message of this type
+        return true;
+    }
+    memcpy(msg, last_msg[f.type], f.length);
+    if (!LogCompact::decode(f.format, payload, len, msg, f.length)) {
+        ::printf("bad compact message for type (%d)\n", f.type);
+        return true;
+    }
+    decoded = true;
+    return true;
+}
+
 /*
   see if a type is in a list of types
  */
@@ -102,21 +140,42 @@ bool LogReader::in_list(const char *type, const char *list[])
 bool LogReader::update(char type[5])
 {
     uint8_t hdr[3];
-    if (::read(fd, hdr, 3) != 3) {
-        return false;
-    }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
-        printf("bad log header\n");
-        return false;
+    uint8_t msg[256];
+
+    // compact messages that can't be decoded yet, as at the start of
+    // a log that began part way through, are skipped
+    for (;;) {
+        if (::read(fd, hdr, 3) != 3) {
+            return false;
+        }
+        if (hdr[0] != HEAD_BYTE1 ||
+            (hdr[1] != HEAD_BYTE2 && hdr[1] != HEAD_BYTE2_COMPACT)) {
+            printf("bad log header\n");
+            return false;
+        }
+        if (hdr[1] == HEAD_BYTE2) {
+            break;
+        }
+        bool decoded;
+        if (!read_compact(formats[hdr[2]], msg, decoded)) {
+            return false;
+        }
+        if (decoded) {
+            break;
+        }
     }
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
+    if (hdr[1] == HEAD_BYTE2 && hdr[2] == LOG_FORMAT_MSG) {
         struct log_Format f;
         memcpy(&f, hdr, 3);
         if (::read(fd, &f.type, sizeof(f)-3) != sizeof(f)-3) {
             return false;
         }
         memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+        // compact messages of this type now need a new full one to
+        // decode against
+        free(last_msg[f.type]);
+        last_msg[f.type] = NULL;
         strncpy(type, f.name, 4);
         type[4] = 0;
 
@@ -221,11 +280,19 @@ bool LogReader::update(char type[5])
         exit(1);
     }
 
-    uint8_t msg[f.length];
+    if (hdr[1] == HEAD_BYTE2) {
+        memcpy(msg, hdr, 3);
+        if (::read(fd, &msg[3], f.length-3) != f.length-3) {
+            return false;
+        }
+    }
 
-    memcpy(msg, hdr, 3);
-    if (::read(fd, &msg[3], f.length-3) != f.length-3) {
-        return false;
+    // keep the message to decode compact messages of the same type
+    if (last_msg[f.type] == NULL) {
+        last_msg[f.type] = (uint8_t *)malloc(f.length);
+    }
+    if (last_msg[f.type] != NULL) {
+        memcpy(last_msg[f.type], msg, f.length);
     }
 
     strncpy(type, f.name, 4);
@@ -4,6 +4,7 @@ class LogReader
 {
 public:
     LogReader(AP_AHRS &_ahrs, AP_InertialSensor &_ins, AP_Baro &_baro, Compass &_compass, AP_GPS &_gps, AP_Airspeed &_airspeed, DataFlash_Class &_dataflash);
+    ~LogReader();
     bool open_log(const char *logfile);
     bool update(char type[5]);
     bool wait_type(const char *type);
@@ -45,6 +46,10 @@ private:
     struct log_Format formats[LOGREADER_MAX_FORMATS];
     class MsgHandler *msgparser[LOGREADER_MAX_FORMATS];
 
+    // last message of each type, to decode compact messages against
+    uint8_t *last_msg[LOGREADER_MAX_FORMATS];
+    bool read_compact(const struct log_Format &f, uint8_t *msg, bool &decoded);
+
     template <typename R>
     void require_field(class MsgHandler *p, uint8_t *msg, const char *label, R &ret);
     void require_field(class MsgHandler *p, uint8_t *data, const char *label, char *buffer, uint8_t bufferlen);
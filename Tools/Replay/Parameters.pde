@@ -32,7 +32,7 @@ const AP_Param::Info var_info[] PROGMEM = {
 
     // @Group: EKF_
     // @Path: ../libraries/AP_NavEKF/AP_NavEKF.cpp
-    GOBJECTN(ahrs.get_NavEKF(), NavEKF, "EKF_", NavEKF),
+    GOBJECTN(ahrs.get_NavEKF_params(), NavEKF, "EKF_", NavEKF),
 
     // @Group: COMPASS_
     // @Path: ../libraries/AP_Compass/AP_Compass.cpp
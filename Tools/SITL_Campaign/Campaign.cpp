@@ -0,0 +1,897 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Monte-Carlo campaign of SITL flights
+*/
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "Campaign.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// the SITL uartA port of instance 0
+#define CAMPAIGN_MAVLINK_PORT      5760
+
+// our MAVLink ids, as a GCS
+#define CAMPAIGN_SYSID             255
+#define CAMPAIGN_COMPID            190
+
+// wall clock limits, for a vehicle that has stopped responding
+#define CAMPAIGN_CONNECT_TIMEOUT_US  30000000ULL
+#define CAMPAIGN_SILENT_TIMEOUT_US   30000000ULL
+#define CAMPAIGN_RETRY_US            1000000ULL
+
+// simulated time allowed for the vehicle to pass its arming checks
+#define CAMPAIGN_ARM_TIMEOUT_MS    180000U
+
+// vertical speed on touching the ground counted as a crash, m/s
+#define CAMPAIGN_CRASH_SPEED       3.0f
+
+const char *Campaign::_outcome_names[OUTCOME_NUM] = {
+    "none",
+    "complete",
+    "crash",
+    "timeout",
+    "disarmed",
+    "arm_failed",
+    "lost"
+};
+
+Campaign::Campaign() :
+    _num_params(0),
+    _mission_count(0),
+    _results(NULL),
+    _num_runs(0),
+    _next_run(0),
+    _finished(0),
+    _jobs(0),
+    _first_instance(1),
+    _seed(1),
+    _timeout_s(600),
+    _max_xtrack(0),
+    _sum_rms_xtrack(0)
+{
+    memset(_run, 0, sizeof(_run));
+    memset(_outcome_count, 0, sizeof(_outcome_count));
+}
+
+/*
+  parse a distribution: a constant, uniform:MIN:MAX or normal:MEAN:SD
+ */
+bool Campaign::_parse_distribution(const char *s, struct distribution &d)
+{
+    char *end;
+    if (strncasecmp(s, "uniform:", 8) == 0) {
+        d.type = distribution::UNIFORM;
+        s += 8;
+    } else if (strncasecmp(s, "normal:", 7) == 0) {
+        d.type = distribution::NORMAL;
+        s += 7;
+    } else {
+        d.type = distribution::CONSTANT;
+        d.a = strtod(s, &end);
+        d.b = 0;
+        return end != s;
+    }
+    d.a = strtod(s, &end);
+    if (end == s || *end != ':') {
+        return false;
+    }
+    s = end + 1;
+    d.b = strtod(s, &end);
+    return end != s;
+}
+
+bool Campaign::add_param(const char *spec)
+{
+    if (_num_params >= CAMPAIGN_MAX_PARAMS) {
+        ::printf("Too many campaign parameters\n");
+        return false;
+    }
+    struct param_spec &p = _params[_num_params];
+    memset(&p, 0, sizeof(p));
+
+    const char *eq = strchr(spec, '=');
+    if (eq == NULL || eq == spec || (size_t)(eq - spec) > sizeof(p.name)-1) {
+        ::printf("Bad parameter spec '%s'\n", spec);
+        return false;
+    }
+    strncpy(p.name, spec, eq - spec);
+
+    char value[64];
+    strncpy(value, eq+1, sizeof(value)-1);
+    value[sizeof(value)-1] = 0;
+    char *at = strchr(value, '@');
+    if (at != NULL) {
+        *at = 0;
+        p.delayed = true;
+        if (!_parse_distribution(at+1, p.time)) {
+            ::printf("Bad time in parameter spec '%s'\n", spec);
+            return false;
+        }
+    }
+    if (!_parse_distribution(value, p.value)) {
+        ::printf("Bad distribution in parameter spec '%s'\n", spec);
+        return false;
+    }
+    _num_params++;
+    return true;
+}
+
+/*
+  load a mission in the QGC WPL 110 format used by the autotest
+  missions
+ */
+bool Campaign::load_mission(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        ::printf("Unable to open mission %s\n", filename);
+        return false;
+    }
+    char line[256];
+    if (fgets(line, sizeof(line), f) == NULL ||
+        strncmp(line, "QGC WPL 110", 11) != 0) {
+        ::printf("%s is not a QGC WPL 110 mission\n", filename);
+        fclose(f);
+        return false;
+    }
+    _mission_count = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned seq, current, frame, command, autocontinue;
+        double p1, p2, p3, p4, x, y, z;
+        if (sscanf(line, "%u %u %u %u %lf %lf %lf %lf %lf %lf %lf %u",
+                   &seq, &current, &frame, &command,
+                   &p1, &p2, &p3, &p4, &x, &y, &z, &autocontinue) != 12) {
+            continue;
+        }
+        if (_mission_count >= CAMPAIGN_MAX_MISSION) {
+            ::printf("Mission %s is too long\n", filename);
+            fclose(f);
+            return false;
+        }
+        struct mission_item &m = _mission[_mission_count++];
+        m.command = command;
+        m.frame = frame;
+        m.param1 = p1;
+        m.param2 = p2;
+        m.param3 = p3;
+        m.param4 = p4;
+        m.x = x;
+        m.y = y;
+        m.z = z;
+        m.autocontinue = autocontinue;
+    }
+    fclose(f);
+    if (_mission_count < 2) {
+        ::printf("Mission %s has no commands\n", filename);
+        return false;
+    }
+    return true;
+}
+
+bool Campaign::start(const char *vehicle, const char *model, const char *home,
+                     const char *dir, const char *results_file,
+                     uint32_t num_runs, uint8_t jobs, uint8_t first_instance,
+                     uint32_t seed, float timeout_s)
+{
+    // runs chdir to their own directory, so the vehicle needs a full path
+    char *path = realpath(vehicle, NULL);
+    if (path == NULL || access(path, X_OK) != 0) {
+        ::printf("Vehicle %s not found\n", vehicle);
+        return false;
+    }
+    if (_mission_count == 0) {
+        ::printf("No mission loaded\n");
+        return false;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        ::printf("Unable to create %s: %s\n", dir, strerror(errno));
+        return false;
+    }
+    _results = fopen(results_file, "w");
+    if (_results == NULL) {
+        ::printf("Unable to create %s: %s\n", results_file, strerror(errno));
+        return false;
+    }
+
+    _vehicle = path;
+    _model = model;
+    _home = home;
+    _dir = dir;
+    _num_runs = num_runs;
+    _jobs = constrain_int16(jobs, 1, CAMPAIGN_MAX_JOBS);
+    _first_instance = first_instance;
+    _seed = seed;
+    _timeout_s = timeout_s;
+
+    _write_header();
+
+    ::printf("Campaign of %u runs, %u at a time\n", (unsigned)_num_runs, (unsigned)_jobs);
+    return true;
+}
+
+/*
+  uniform and normal samples, from a xorshift generator seeded per run
+  so that any run can be repeated on its own
+ */
+float Campaign::_sample(const struct distribution &d, uint32_t &state) const
+{
+    switch (d.type) {
+    case distribution::UNIFORM: {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return d.a + (d.b - d.a) * (state / 4294967295.0f);
+    }
+    case distribution::NORMAL: {
+        // Box-Muller
+        float u1, u2;
+        do {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            u1 = state / 4294967295.0f;
+        } while (u1 <= 0);
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        u2 = state / 4294967295.0f;
+        return d.a + d.b * sqrtf(-2 * logf(u1)) * cosf(2 * PI * u2);
+    }
+    case distribution::CONSTANT:
+    default:
+        return d.a;
+    }
+}
+
+/*
+  start a SITL vehicle for run number, with its sampled parameters
+ */
+bool Campaign::_launch(struct run &r, uint32_t number)
+{
+    uint8_t slot = &r - &_run[0];
+
+    memset(&r, 0, sizeof(r));
+    r.number = number;
+    r.seed = _seed + number;
+    r.instance = _first_instance + slot;
+    r.fd = -1;
+    r.last_reached = -1;
+
+    uint32_t state = r.seed * 2654435761U;
+    if (state == 0) {
+        state = 1;
+    }
+    for (uint8_t i=0; i<_num_params; i++) {
+        r.value[i] = _sample(_params[i].value, state);
+        if (_params[i].delayed) {
+            r.set_time[i] = _sample(_params[i].time, state);
+        }
+    }
+
+    char run_dir[PATH_MAX];
+    snprintf(run_dir, sizeof(run_dir), "%s/run%05u", _dir, (unsigned)number);
+    if (mkdir(run_dir, 0755) != 0 && errno != EEXIST) {
+        ::printf("Unable to create %s: %s\n", run_dir, strerror(errno));
+        return false;
+    }
+
+    char instance[8];
+    snprintf(instance, sizeof(instance), "%u", (unsigned)r.instance);
+
+    // parameters set at startup, as -P NAME=VALUE
+    char param_args[CAMPAIGN_MAX_PARAMS][40];
+    const char *argv[16 + 2*CAMPAIGN_MAX_PARAMS];
+    uint8_t argc = 0;
+    argv[argc++] = _vehicle;
+    argv[argc++] = "-w";
+    argv[argc++] = "-I";
+    argv[argc++] = instance;
+    argv[argc++] = "--model";
+    argv[argc++] = _model;
+    argv[argc++] = "--home";
+    argv[argc++] = _home;
+    argv[argc++] = "--speedup";
+    argv[argc++] = "0";
+    for (uint8_t i=0; i<_num_params; i++) {
+        if (_params[i].delayed) {
+            continue;
+        }
+        snprintf(param_args[i], sizeof(param_args[i]), "%s=%f", _params[i].name, (double)r.value[i]);
+        argv[argc++] = "-P";
+        argv[argc++] = param_args[i];
+    }
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        ::printf("fork failed: %s\n", strerror(errno));
+        return false;
+    }
+    if (pid == 0) {
+        if (chdir(run_dir) != 0) {
+            _exit(1);
+        }
+        int fd = open("sitl.log", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if (fd != -1) {
+            dup2(fd, 1);
+            dup2(fd, 2);
+            close(fd);
+        }
+        execv(_vehicle, (char * const *)argv);
+        _exit(1);
+    }
+
+    r.pid = pid;
+    _set_state(r, STATE_CONNECTING);
+    return true;
+}
+
+void Campaign::_set_state(struct run &r, enum run_state state)
+{
+    r.state = state;
+    r.state_start_us = _wall_time_us();
+    r.last_command_us = 0;
+}
+
+/*
+  try to connect to the MAVLink port of a run
+ */
+void Campaign::_connect(struct run &r)
+{
+    struct sockaddr_in sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+#ifdef HAVE_SOCK_SIN_LEN
+    sockaddr.sin_len = sizeof(sockaddr);
+#endif
+    sockaddr.sin_port = htons(CAMPAIGN_MAVLINK_PORT + r.instance*10);
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return;
+    }
+    if (connect(fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) != 0) {
+        close(fd);
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    r.fd = fd;
+    r.last_data_us = _wall_time_us();
+    _set_state(r, STATE_WAIT_HEARTBEAT);
+}
+
+/*
+  stop a run and record its result
+ */
+void Campaign::_finish(struct run &r, enum outcome result)
+{
+    if (r.fd != -1) {
+        close(r.fd);
+        r.fd = -1;
+    }
+    if (r.pid > 0) {
+        kill(r.pid, SIGTERM);
+        waitpid(r.pid, NULL, 0);
+        r.pid = 0;
+    }
+    r.result = result;
+    _write_result(r);
+
+    _outcome_count[result]++;
+    if (r.max_xtrack > _max_xtrack) {
+        _max_xtrack = r.max_xtrack;
+    }
+    if (r.xtrack_samples > 0) {
+        _sum_rms_xtrack += sqrtf(r.sum_sq_xtrack / r.xtrack_samples);
+    }
+    _finished++;
+
+    ::printf("Run %u: %s after %.1fs, max track error %.1fm\n",
+             (unsigned)r.number, _outcome_names[result],
+             (double)((r.time_boot_ms - r.mission_start_ms) * 0.001f),
+             (double)r.max_xtrack);
+
+    r.state = STATE_IDLE;
+}
+
+void Campaign::_send(struct run &r, mavlink_message_t &msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
+    if (send(r.fd, buf, len, MSG_NOSIGNAL) != len) {
+        // the read side notices a dead connection
+    }
+}
+
+void Campaign::_send_command(struct run &r, uint16_t command, float param1)
+{
+    mavlink_message_t msg;
+    mavlink_msg_command_long_pack(CAMPAIGN_SYSID, CAMPAIGN_COMPID, &msg,
+                                  r.target_system, MAV_COMP_ID_SYSTEM_CONTROL,
+                                  command, 0, param1, 0, 0, 0, 0, 0, 0);
+    _send(r, msg);
+}
+
+void Campaign::_send_mission_item(struct run &r, uint16_t seq)
+{
+    const struct mission_item &m = _mission[seq];
+    mavlink_message_t msg;
+    mavlink_msg_mission_item_pack(CAMPAIGN_SYSID, CAMPAIGN_COMPID, &msg,
+                                  r.target_system, MAV_COMP_ID_MISSIONPLANNER,
+                                  seq, m.frame, m.command, 0, m.autocontinue,
+                                  m.param1, m.param2, m.param3, m.param4,
+                                  m.x, m.y, m.z);
+    _send(r, msg);
+}
+
+void Campaign::_send_param(struct run &r, uint8_t i)
+{
+    mavlink_message_t msg;
+    mavlink_msg_param_set_pack(CAMPAIGN_SYSID, CAMPAIGN_COMPID, &msg,
+                               r.target_system, MAV_COMP_ID_SYSTEM_CONTROL,
+                               _params[i].name, r.value[i], MAV_PARAM_TYPE_REAL32);
+    _send(r, msg);
+}
+
+/*
+  location of a mission item that moves the vehicle
+ */
+bool Campaign::_nav_location(uint16_t seq, Location &loc) const
+{
+    if (seq >= _mission_count) {
+        return false;
+    }
+    const struct mission_item &m = _mission[seq];
+    switch (m.command) {
+    case MAV_CMD_NAV_WAYPOINT:
+    case MAV_CMD_NAV_LOITER_UNLIM:
+    case MAV_CMD_NAV_LOITER_TURNS:
+    case MAV_CMD_NAV_LOITER_TIME:
+    case MAV_CMD_NAV_LAND:
+    case MAV_CMD_NAV_TAKEOFF:
+    case MAV_CMD_NAV_SPLINE_WAYPOINT:
+        break;
+    default:
+        return false;
+    }
+    if (is_zero(m.x) && is_zero(m.y)) {
+        return false;
+    }
+    memset(&loc, 0, sizeof(loc));
+    loc.lat = m.x * 1.0e7;
+    loc.lng = m.y * 1.0e7;
+    return true;
+}
+
+/*
+  horizontal distance from the vehicle to the leg it is flying, from
+  the last mission location before the current item to the current
+  item. Returns a negative value when there is no leg to measure
+  against
+ */
+float Campaign::_cross_track_error(const struct run &r) const
+{
+    Location target, origin;
+    if (!_nav_location(r.current_wp, target)) {
+        return -1;
+    }
+    int16_t seq;
+    for (seq = r.current_wp-1; seq >= 0; seq--) {
+        if (_nav_location(seq, origin)) {
+            break;
+        }
+    }
+    if (seq < 0) {
+        return -1;
+    }
+    Vector2f leg = location_diff(origin, target);
+    Vector2f pos = location_diff(origin, r.loc);
+    float length = leg.length();
+    if (length < 1.0f) {
+        return -1;
+    }
+    float along = (leg * pos) / length;
+    if (along <= 0) {
+        return pos.length();
+    }
+    if (along >= length) {
+        return (pos - leg).length();
+    }
+    return fabsf(leg % pos) / length;
+}
+
+void Campaign::_handle_position(struct run &r, const mavlink_global_position_int_t &pos)
+{
+    float relative_alt = pos.relative_alt * 0.001f;
+    float vz = pos.vz * 0.01f;
+
+    r.loc.lat = pos.lat;
+    r.loc.lng = pos.lon;
+
+    /*
+      touching down: the descent rate just before reaching the ground
+      is the impact speed
+     */
+    if (r.was_armed && r.relative_alt > 0.5f && relative_alt <= 0.5f) {
+        float impact = max(r.last_vz, vz);
+        if (impact > r.max_impact_speed) {
+            r.max_impact_speed = impact;
+        }
+        if (impact > CAMPAIGN_CRASH_SPEED) {
+            r.crash = true;
+        }
+    }
+    r.relative_alt = relative_alt;
+    r.last_vz = vz;
+
+    if (r.state == STATE_FLYING && r.armed) {
+        float xtrack = _cross_track_error(r);
+        if (xtrack >= 0) {
+            if (xtrack > r.max_xtrack) {
+                r.max_xtrack = xtrack;
+            }
+            r.sum_sq_xtrack += sq(xtrack);
+            r.xtrack_samples++;
+        }
+    }
+}
+
+void Campaign::_handle_statustext(struct run &r, const char *text)
+{
+    if (strstr(text, "EKF variance") != NULL) {
+        r.ekf_failsafes++;
+    } else if (strcasestr(text, "failsafe") != NULL) {
+        r.failsafes++;
+    } else if (strncmp(text, "Crash", 5) == 0) {
+        r.crash = true;
+    }
+}
+
+void Campaign::_handle_message(struct run &r, const mavlink_message_t &msg)
+{
+    switch (msg.msgid) {
+    case MAVLINK_MSG_ID_HEARTBEAT: {
+        mavlink_heartbeat_t hb;
+        mavlink_msg_heartbeat_decode(&msg, &hb);
+        if (hb.type == MAV_TYPE_GCS) {
+            break;
+        }
+        r.armed = (hb.base_mode & MAV_MODE_FLAG_SAFETY_ARMED) != 0;
+        if (r.armed) {
+            r.was_armed = true;
+        }
+        if (r.state == STATE_WAIT_HEARTBEAT) {
+            r.target_system = msg.sysid;
+            mavlink_message_t req;
+            mavlink_msg_request_data_stream_pack(CAMPAIGN_SYSID, CAMPAIGN_COMPID, &req,
+                                                 r.target_system, MAV_COMP_ID_SYSTEM_CONTROL,
+                                                 MAV_DATA_STREAM_ALL, 10, 1);
+            _send(r, req);
+            _set_state(r, STATE_UPLOAD);
+        }
+        break;
+    }
+
+    case MAVLINK_MSG_ID_MISSION_REQUEST:
+        if (r.state == STATE_UPLOAD) {
+            uint16_t seq = mavlink_msg_mission_request_get_seq(&msg);
+            if (seq < _mission_count) {
+                _send_mission_item(r, seq);
+            }
+        }
+        break;
+
+    case MAVLINK_MSG_ID_MISSION_ACK:
+        if (r.state == STATE_UPLOAD) {
+            if (mavlink_msg_mission_ack_get_type(&msg) == MAV_MISSION_ACCEPTED) {
+                _set_state(r, STATE_ARMING);
+            } else {
+                // try the upload again
+                r.last_command_us = 0;
+            }
+        }
+        break;
+
+    case MAVLINK_MSG_ID_COMMAND_ACK: {
+        mavlink_command_ack_t ack;
+        mavlink_msg_command_ack_decode(&msg, &ack);
+        if (ack.result != MAV_RESULT_ACCEPTED) {
+            break;
+        }
+        if (r.state == STATE_ARMING && ack.command == MAV_CMD_COMPONENT_ARM_DISARM) {
+            r.was_armed = true;
+            _set_state(r, STATE_STARTING);
+        } else if (r.state == STATE_STARTING && ack.command == MAV_CMD_MISSION_START) {
+            r.mission_start_ms = r.time_boot_ms;
+            _set_state(r, STATE_FLYING);
+        }
+        break;
+    }
+
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT: {
+        mavlink_global_position_int_t pos;
+        mavlink_msg_global_position_int_decode(&msg, &pos);
+        r.time_boot_ms = pos.time_boot_ms;
+        _handle_position(r, pos);
+        break;
+    }
+
+    case MAVLINK_MSG_ID_MISSION_CURRENT:
+        r.current_wp = mavlink_msg_mission_current_get_seq(&msg);
+        break;
+
+    case MAVLINK_MSG_ID_MISSION_ITEM_REACHED: {
+        int32_t seq = mavlink_msg_mission_item_reached_get_seq(&msg);
+        if (seq > r.last_reached) {
+            r.last_reached = seq;
+        }
+        break;
+    }
+
+    case MAVLINK_MSG_ID_PARAM_VALUE: {
+        mavlink_param_value_t pv;
+        mavlink_msg_param_value_decode(&msg, &pv);
+        for (uint8_t i=0; i<_num_params; i++) {
+            if (_params[i].delayed && strncmp(pv.param_id, _params[i].name, 16) == 0) {
+                r.param_sent[i] = true;
+            }
+        }
+        break;
+    }
+
+    case MAVLINK_MSG_ID_STATUSTEXT: {
+        char text[51];
+        mavlink_msg_statustext_get_text(&msg, text);
+        text[50] = 0;
+        _handle_statustext(r, text);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+/*
+  move one run along
+ */
+void Campaign::_update_run(struct run &r, uint64_t now)
+{
+    // has the vehicle gone away?
+    if (r.pid > 0) {
+        int status;
+        if (waitpid(r.pid, &status, WNOHANG) == r.pid) {
+            r.pid = 0;
+            _finish(r, r.crash ? OUTCOME_CRASH : OUTCOME_LOST);
+            return;
+        }
+    }
+
+    if (r.state == STATE_CONNECTING) {
+        if (now - r.state_start_us > CAMPAIGN_CONNECT_TIMEOUT_US) {
+            _finish(r, OUTCOME_LOST);
+        } else if (now - r.last_command_us > 200000) {
+            r.last_command_us = now;
+            _connect(r);
+        }
+        return;
+    }
+
+    // read everything that is waiting
+    uint8_t buf[1024];
+    ssize_t n;
+    bool got_data = false;
+    while ((n = recv(r.fd, buf, sizeof(buf), 0)) > 0) {
+        got_data = true;
+        for (ssize_t i=0; i<n; i++) {
+            mavlink_message_t msg;
+            mavlink_status_t status;
+            if (mavlink_frame_char_buffer(&r.rxmsg, &r.status, buf[i], &msg, &status) == MAVLINK_FRAMING_OK) {
+                _handle_message(r, msg);
+            }
+        }
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        _finish(r, r.crash ? OUTCOME_CRASH : OUTCOME_LOST);
+        return;
+    }
+    if (got_data) {
+        r.last_data_us = now;
+    } else if (now - r.last_data_us > CAMPAIGN_SILENT_TIMEOUT_US) {
+        _finish(r, OUTCOME_LOST);
+        return;
+    }
+
+    bool retry = now - r.last_command_us > CAMPAIGN_RETRY_US;
+
+    switch (r.state) {
+    case STATE_UPLOAD:
+        if (retry) {
+            mavlink_message_t msg;
+            mavlink_msg_mission_count_pack(CAMPAIGN_SYSID, CAMPAIGN_COMPID, &msg,
+                                           r.target_system, MAV_COMP_ID_MISSIONPLANNER,
+                                           _mission_count);
+            _send(r, msg);
+            r.last_command_us = now;
+        }
+        break;
+
+    case STATE_ARMING:
+        if (r.time_boot_ms > CAMPAIGN_ARM_TIMEOUT_MS) {
+            _finish(r, OUTCOME_ARM_FAILED);
+        } else if (retry) {
+            _send_command(r, MAV_CMD_COMPONENT_ARM_DISARM, 1);
+            r.last_command_us = now;
+        }
+        break;
+
+    case STATE_STARTING:
+        if (!r.armed && r.time_boot_ms > CAMPAIGN_ARM_TIMEOUT_MS) {
+            _finish(r, OUTCOME_ARM_FAILED);
+        } else if (retry) {
+            _send_command(r, MAV_CMD_MISSION_START, 0);
+            r.last_command_us = now;
+        }
+        break;
+
+    case STATE_FLYING: {
+        uint32_t flight_ms = r.time_boot_ms - r.mission_start_ms;
+
+        // faults injected during the flight
+        for (uint8_t i=0; i<_num_params; i++) {
+            if (_params[i].delayed && !r.param_sent[i] &&
+                flight_ms >= r.set_time[i] * 1000 && retry) {
+                _send_param(r, i);
+                r.last_command_us = now;
+            }
+        }
+
+        if (r.was_armed && !r.armed) {
+            if (r.crash) {
+                _finish(r, OUTCOME_CRASH);
+            } else if (r.last_reached >= _mission_count-1 ||
+                       r.current_wp >= _mission_count-1) {
+                _finish(r, OUTCOME_COMPLETE);
+            } else {
+                _finish(r, OUTCOME_DISARMED);
+            }
+        } else if (flight_ms > _timeout_s * 1000) {
+            _finish(r, r.crash ? OUTCOME_CRASH : OUTCOME_TIMEOUT);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+bool Campaign::update(void)
+{
+    uint64_t now = _wall_time_us();
+    bool running = false;
+
+    for (uint8_t i=0; i<_jobs; i++) {
+        struct run &r = _run[i];
+        if (r.state == STATE_IDLE && _next_run < _num_runs) {
+            if (!_launch(r, _next_run++)) {
+                _finish(r, OUTCOME_LOST);
+                continue;
+            }
+        }
+        if (r.state != STATE_IDLE) {
+            _update_run(r, now);
+            running = true;
+        }
+    }
+
+    if (!running && _next_run >= _num_runs) {
+        if (_results != NULL) {
+            fclose(_results);
+            _results = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+void Campaign::_write_header(void)
+{
+    fprintf(_results, "run,seed");
+    for (uint8_t i=0; i<_num_params; i++) {
+        fprintf(_results, ",%s", _params[i].name);
+        if (_params[i].delayed) {
+            fprintf(_results, ",%s_time", _params[i].name);
+        }
+    }
+    fprintf(_results, ",outcome,flight_time,max_xtrack,rms_xtrack,"
+            "ekf_failsafes,failsafes,crash,max_impact_speed,last_wp\n");
+    fflush(_results);
+}
+
+void Campaign::_write_result(const struct run &r)
+{
+    if (_results == NULL) {
+        return;
+    }
+    fprintf(_results, "%u,%u", (unsigned)r.number, (unsigned)r.seed);
+    for (uint8_t i=0; i<_num_params; i++) {
+        fprintf(_results, ",%f", (double)r.value[i]);
+        if (_params[i].delayed) {
+            fprintf(_results, ",%.1f", (double)r.set_time[i]);
+        }
+    }
+    float flight_time = 0;
+    if (r.mission_start_ms != 0 && r.time_boot_ms > r.mission_start_ms) {
+        flight_time = (r.time_boot_ms - r.mission_start_ms) * 0.001f;
+    }
+    float rms_xtrack = 0;
+    if (r.xtrack_samples > 0) {
+        rms_xtrack = sqrtf(r.sum_sq_xtrack / r.xtrack_samples);
+    }
+    fprintf(_results, ",%s,%.1f,%.2f,%.2f,%u,%u,%u,%.2f,%d\n",
+            _outcome_names[r.result],
+            (double)flight_time,
+            (double)r.max_xtrack,
+            (double)rms_xtrack,
+            (unsigned)r.ekf_failsafes,
+            (unsigned)r.failsafes,
+            (unsigned)r.crash,
+            (double)r.max_impact_speed,
+            (int)r.last_reached);
+    fflush(_results);
+}
+
+void Campaign::print_summary(void) const
+{
+    ::printf("Campaign finished: %u runs\n", (unsigned)_finished);
+    for (uint8_t i=OUTCOME_COMPLETE; i<OUTCOME_NUM; i++) {
+        ::printf("  %-10s %u\n", _outcome_names[i], (unsigned)_outcome_count[i]);
+    }
+    if (_finished > 0) {
+        ::printf("  max track error %.1fm, mean rms track error %.2fm\n",
+                 (double)_max_xtrack, (double)(_sum_rms_xtrack / _finished));
+    }
+}
+
+uint64_t Campaign::_wall_time_us(void)
+{
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return tp.tv_sec*1000000ULL + tp.tv_usec;
+}
+
+#endif // CONFIG_HAL_BOARD
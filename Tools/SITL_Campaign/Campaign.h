@@ -0,0 +1,204 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Monte-Carlo campaign of SITL flights
+
+  Each run starts a SITL vehicle with the built-in physics running
+  free of the wall clock, with SIM_ parameters sampled from the
+  distributions given for the campaign. The vehicle is armed and flown
+  through a mission over MAVLink, and the outcome of the flight is
+  written as one line of a CSV results file. Several runs go in
+  parallel, each in its own directory with its own SITL instance.
+*/
+
+#ifndef _CAMPAIGN_H
+#define _CAMPAIGN_H
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include <GCS_MAVLink.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#define CAMPAIGN_MAX_PARAMS   32
+#define CAMPAIGN_MAX_JOBS     32
+#define CAMPAIGN_MAX_MISSION  128
+
+class Campaign
+{
+public:
+    Campaign();
+
+    /*
+      add a parameter to sample, as NAME=DIST or NAME=DIST@TIME where
+      DIST is a constant, uniform:MIN:MAX or normal:MEAN:SD. With a
+      TIME the value is set that many seconds after the mission
+      starts, otherwise it is set when the vehicle starts
+     */
+    bool add_param(const char *spec);
+
+    /* load a mission in QGC WPL 110 format */
+    bool load_mission(const char *filename);
+
+    /*
+      start the campaign. Runs go in directory dir, and the results
+      to results_file
+     */
+    bool start(const char *vehicle, const char *model, const char *home,
+               const char *dir, const char *results_file,
+               uint32_t num_runs, uint8_t jobs, uint8_t first_instance,
+               uint32_t seed, float timeout_s);
+
+    /*
+      start and monitor runs. Returns false once the campaign is done
+     */
+    bool update(void);
+
+    /* print a summary of all finished runs */
+    void print_summary(void) const;
+
+private:
+    // how a parameter value is picked for each run
+    struct distribution {
+        enum { CONSTANT, UNIFORM, NORMAL } type;
+        float a, b;
+    };
+
+    struct param_spec {
+        char name[17];
+        struct distribution value;
+        bool delayed;
+        struct distribution time;
+    } _params[CAMPAIGN_MAX_PARAMS];
+    uint8_t _num_params;
+
+    struct mission_item {
+        uint16_t command;
+        uint8_t frame;
+        float param1, param2, param3, param4;
+        float x, y, z;
+        uint8_t autocontinue;
+    } _mission[CAMPAIGN_MAX_MISSION];
+    uint16_t _mission_count;
+
+    enum outcome {
+        OUTCOME_NONE = 0,
+        OUTCOME_COMPLETE,
+        OUTCOME_CRASH,
+        OUTCOME_TIMEOUT,
+        OUTCOME_DISARMED,
+        OUTCOME_ARM_FAILED,
+        OUTCOME_LOST,
+        OUTCOME_NUM
+    };
+
+    enum run_state {
+        STATE_IDLE = 0,
+        STATE_CONNECTING,
+        STATE_WAIT_HEARTBEAT,
+        STATE_UPLOAD,
+        STATE_ARMING,
+        STATE_STARTING,
+        STATE_FLYING
+    };
+
+    // one running vehicle
+    struct run {
+        enum run_state state;
+        uint32_t number;
+        uint32_t seed;
+        uint8_t instance;
+        pid_t pid;
+        int fd;
+        uint64_t state_start_us;     // wall clock
+        uint64_t last_command_us;    // wall clock
+        uint64_t last_data_us;       // wall clock
+
+        mavlink_message_t rxmsg;
+        mavlink_status_t status;
+        uint8_t target_system;
+
+        float value[CAMPAIGN_MAX_PARAMS];
+        float set_time[CAMPAIGN_MAX_PARAMS];
+        bool param_sent[CAMPAIGN_MAX_PARAMS];
+
+        // metrics
+        uint32_t time_boot_ms;
+        uint32_t mission_start_ms;
+        bool armed;
+        bool was_armed;
+        uint16_t current_wp;
+        int32_t last_reached;
+        Location loc;
+        float relative_alt;
+        float last_vz;
+        float max_xtrack;
+        float sum_sq_xtrack;
+        uint32_t xtrack_samples;
+        uint16_t ekf_failsafes;
+        uint16_t failsafes;
+        bool crash;
+        float max_impact_speed;
+        enum outcome result;
+    } _run[CAMPAIGN_MAX_JOBS];
+
+    const char *_vehicle;
+    const char *_model;
+    const char *_home;
+    const char *_dir;
+    FILE *_results;
+    uint32_t _num_runs;
+    uint32_t _next_run;
+    uint32_t _finished;
+    uint8_t _jobs;
+    uint8_t _first_instance;
+    uint32_t _seed;
+    float _timeout_s;
+
+    // summary of finished runs
+    uint32_t _outcome_count[OUTCOME_NUM];
+    float _max_xtrack;
+    float _sum_rms_xtrack;
+
+    static const char *_outcome_names[OUTCOME_NUM];
+
+    bool _parse_distribution(const char *s, struct distribution &d);
+    float _sample(const struct distribution &d, uint32_t &state) const;
+
+    bool _launch(struct run &r, uint32_t number);
+    void _connect(struct run &r);
+    void _finish(struct run &r, enum outcome result);
+    void _update_run(struct run &r, uint64_t now);
+    void _set_state(struct run &r, enum run_state state);
+
+    void _handle_message(struct run &r, const mavlink_message_t &msg);
+    void _handle_position(struct run &r, const mavlink_global_position_int_t &pos);
+    void _handle_statustext(struct run &r, const char *text);
+    float _cross_track_error(const struct run &r) const;
+    bool _nav_location(uint16_t seq, Location &loc) const;
+
+    void _send(struct run &r, mavlink_message_t &msg);
+    void _send_command(struct run &r, uint16_t command, float param1);
+    void _send_mission_item(struct run &r, uint16_t seq);
+    void _send_param(struct run &r, uint8_t i);
+
+    void _write_header(void);
+    void _write_result(const struct run &r);
+
+    static uint64_t _wall_time_us(void);
+};
+
+#endif // _CAMPAIGN_H
@@ -0,0 +1,232 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Monte-Carlo campaign runner for SITL
+
+  Build with "make sitl", and build the vehicle to test the same way.
+  Each run flies the mission with its own sampled SIM_ parameters,
+  with the vehicle physics running as fast as the CPU allows:
+
+    SITL_Campaign.elf -C -- -v ../../ArduCopter/ArduCopter.elf \
+        -m ../autotest/copter_mission.txt -n 1000 -j 8 \
+        -p SIM_WIND_SPD=uniform:0:10 -p SIM_WIND_DIR=uniform:0:360 \
+        -p SIM_GPS_GLITCH_X=normal:0:0.0001@uniform:20:60
+
+  A parameter with @TIME is set that many seconds into the mission,
+  to inject a fault in flight. The options before "--" are the usual
+  SITL HAL options; -C keeps the HAL console off TCP. The vehicles use
+  SITL instances from 1 up, one per job.
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_ADC.h>
+#include <AP_Declination.h>
+#include <AP_ADC_AnalogSource.h>
+#include <Filter.h>
+#include <AP_Buffer.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_Notify.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_InertialSensor.h>
+#include <AP_InertialNav.h>
+#include <AP_NavEKF.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Terrain.h>
+#include <AP_OpticalFlow.h>
+#include <AP_SerialManager.h>
+#include <RC_Channel.h>
+#include <AP_RangeFinder.h>
+#include "Campaign.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <unistd.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+static Campaign campaign;
+
+static void usage(void)
+{
+    ::printf("Usage: SITL_Campaign.elf [SITL options] -- [options]\n"
+             "Options:\n"
+             "\t-v VEHICLE    SITL vehicle binary\n"
+             "\t-m MISSION    mission to fly, QGC WPL 110 format\n"
+             "\t-n RUNS       number of runs (default 100)\n"
+             "\t-j JOBS       runs in parallel (default number of CPUs)\n"
+             "\t-p NAME=DIST  sample a parameter; DIST is VALUE, uniform:MIN:MAX\n"
+             "\t              or normal:MEAN:SD, with @DIST to set it in flight\n"
+             "\t-M MODEL      vehicle model, as for SITL --model (default quad)\n"
+             "\t-O HOME       home location (lat,lng,alt,yaw)\n"
+             "\t-t SECONDS    simulated time limit for a flight (default 600)\n"
+             "\t-s SEED       random seed of the first run (default 1)\n"
+             "\t-d DIR        directory for the runs (default campaign)\n"
+             "\t-o FILE       results file (default DIR/results.csv)\n"
+             "\t-f INSTANCE   SITL instance of the first job (default 1)\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    const char *vehicle = NULL;
+    const char *mission = NULL;
+    const char *model = "quad";
+    const char *home = "-35.363261,149.165230,584,353";
+    const char *dir = "campaign";
+    const char *results = NULL;
+    uint32_t num_runs = 100;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    uint8_t first_instance = 1;
+    uint32_t seed = 1;
+    float timeout_s = 600;
+    int opt;
+
+    hal.util->commandline_arguments(argc, argv);
+
+    // skip the SITL HAL options
+    uint8_t start = 0;
+    for (uint8_t i=1; i<argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            start = i;
+            break;
+        }
+    }
+    if (start == 0) {
+        usage();
+        exit(1);
+    }
+    argc -= start;
+    argv += start;
+    optind = 1;
+    while ((opt = getopt(argc, argv, "v:m:n:j:p:M:O:t:s:d:o:f:h")) != -1) {
+        switch (opt) {
+        case 'v':
+            vehicle = optarg;
+            break;
+        case 'm':
+            mission = optarg;
+            break;
+        case 'n':
+            num_runs = strtoul(optarg, NULL, 0);
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        case 'p':
+            if (!campaign.add_param(optarg)) {
+                exit(1);
+            }
+            break;
+        case 'M':
+            model = optarg;
+            break;
+        case 'O':
+            home = optarg;
+            break;
+        case 't':
+            timeout_s = atof(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        case 'o':
+            results = optarg;
+            break;
+        case 'f':
+            first_instance = atoi(optarg);
+            break;
+        default:
+            usage();
+            exit(1);
+        }
+    }
+
+    if (vehicle == NULL || mission == NULL) {
+        usage();
+        exit(1);
+    }
+    if (!campaign.load_mission(mission)) {
+        exit(1);
+    }
+
+    static char results_path[256];
+    if (results == NULL) {
+        snprintf(results_path, sizeof(results_path), "%s/results.csv", dir);
+        results = results_path;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+    if (jobs > CAMPAIGN_MAX_JOBS) {
+        jobs = CAMPAIGN_MAX_JOBS;
+    }
+
+    if (!campaign.start(vehicle, model, home, dir, results,
+                        num_runs, jobs, first_instance, seed, timeout_s)) {
+        exit(1);
+    }
+}
+
+void loop()
+{
+    if (!campaign.update()) {
+        campaign.print_summary();
+        exit(0);
+    }
+    hal.scheduler->delay_microseconds(1000);
+}
+
+#else
+
+void setup()
+{
+    hal.console->println_P(PSTR("SITL_Campaign only runs on the SITL HAL"));
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // CONFIG_HAL_BOARD
+
+AP_HAL_MAIN();
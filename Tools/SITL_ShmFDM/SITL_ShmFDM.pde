@@ -0,0 +1,196 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  stand-in external FDM over shared memory
+
+  Runs one of the built-in physics models as a separate process and
+  serves it to a SITL vehicle started with "--model shm", stepping in
+  lockstep with the vehicle. This gives a way to test and time the
+  shared memory transport without a third party simulator:
+
+    SITL_ShmFDM.elf -C -I 9 -- -i 0 -M quad &
+    ArduCopter.elf --model shm
+
+  The options before "--" are the usual SITL HAL options; use an
+  instance that doesn't clash with the vehicle's ports. -i gives the
+  SITL instance of the vehicle being served.
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_ADC.h>
+#include <AP_Declination.h>
+#include <AP_ADC_AnalogSource.h>
+#include <Filter.h>
+#include <AP_Buffer.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_Notify.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_InertialSensor.h>
+#include <AP_InertialNav.h>
+#include <AP_NavEKF.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Terrain.h>
+#include <AP_OpticalFlow.h>
+#include <AP_SerialManager.h>
+#include <RC_Channel.h>
+#include <AP_RangeFinder.h>
+#include <SIM_Models.h>
+#include <SIM_ShmLink.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <sys/time.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+static ShmLink shm_link(ShmLink::SIDE_FDM);
+static Aircraft *model;
+static uint32_t frame_count;
+
+static uint64_t wall_time_us(void)
+{
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return tp.tv_sec*1000000ULL + tp.tv_usec;
+}
+
+static void usage(void)
+{
+    ::printf("Usage: SITL_ShmFDM.elf [SITL options] -- [options]\n"
+             "Options:\n"
+             "\t-i INSTANCE  SITL instance of the vehicle (default 0)\n"
+             "\t-M MODEL     vehicle model, as for SITL --model (default quad)\n"
+             "\t-O HOME      home location (lat,lng,alt,yaw)\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    uint8_t instance = 0;
+    const char *model_str = "quad";
+    const char *home = "-35.363261,149.165230,584,353";
+    int opt;
+
+    hal.util->commandline_arguments(argc, argv);
+
+    // skip the SITL HAL options
+    uint8_t start = 0;
+    for (uint8_t i=1; i<argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            start = i;
+            break;
+        }
+    }
+    if (start != 0) {
+        argc -= start;
+        argv += start;
+        optind = 1;
+        while ((opt = getopt(argc, argv, "i:M:O:h")) != -1) {
+            switch (opt) {
+            case 'i':
+                instance = atoi(optarg);
+                break;
+            case 'M':
+                model_str = optarg;
+                break;
+            case 'O':
+                home = optarg;
+                break;
+            default:
+                usage();
+                exit(1);
+            }
+        }
+    }
+
+    sim_model_constructor constructor = sim_model_find(model_str, true);
+    if (constructor == NULL) {
+        ::printf("Unknown model %s\n", model_str);
+        exit(1);
+    }
+    model = constructor(home, model_str);
+    // the vehicle paces the model, so don't sleep in it
+    model->set_speedup(0);
+    model->set_instance(instance);
+
+    if (!shm_link.open_instance(instance)) {
+        exit(1);
+    }
+    ::printf("Serving %s to SITL instance %u\n", model_str, (unsigned)instance);
+}
+
+void loop()
+{
+    static uint64_t last_report_us;
+    static uint32_t last_report_frames;
+    Aircraft::sitl_input input;
+    struct sitl_fdm fdm;
+
+    if (shm_link.recv(&input, sizeof(input), 1000) == sizeof(input)) {
+        model->update(input);
+        model->fill_fdm(fdm);
+        shm_link.send(&fdm, sizeof(fdm));
+        frame_count++;
+    }
+
+    uint64_t now = wall_time_us();
+    if (now - last_report_us > 10000000UL) {
+        ::printf("ShmFDM: %.1f frames/s, sim time %.1fs\n",
+                 (double)((frame_count - last_report_frames) * 1.0e6 / (now - last_report_us)),
+                 (double)(model->get_time_us() * 1.0e-6));
+        last_report_us = now;
+        last_report_frames = frame_count;
+    }
+}
+
+#else
+
+void setup()
+{
+    hal.console->println_P(PSTR("SITL_ShmFDM only runs on the SITL HAL"));
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // CONFIG_HAL_BOARD
+
+AP_HAL_MAIN();
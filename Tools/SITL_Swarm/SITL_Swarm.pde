@@ -0,0 +1,189 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  physics host for a swarm of SITL vehicles
+
+  Build with "make sitl", then start the vehicles as normal SITL
+  instances without a --model, so they take their FDM over UDP, and
+  run this as the FDM for all of them:
+
+    ArduCopter.elf -I 1 &
+    ArduCopter.elf -I 2 &
+    ...
+    SITL_Swarm.elf -C -I 0 -- -n 20 -f 1 -M quad -O -35.363261,149.165230,584,353
+
+  The options before "--" are the usual SITL HAL options; -C keeps the
+  HAL console off TCP. The MAVLink of all the vehicles is available on
+  one UDP port, 14550 by default, with each vehicle using its own
+  SYSID_THISMAV.
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_ADC.h>
+#include <AP_Declination.h>
+#include <AP_ADC_AnalogSource.h>
+#include <Filter.h>
+#include <AP_Buffer.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_Notify.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_InertialSensor.h>
+#include <AP_InertialNav.h>
+#include <AP_NavEKF.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Terrain.h>
+#include <AP_OpticalFlow.h>
+#include <AP_SerialManager.h>
+#include <RC_Channel.h>
+#include <AP_RangeFinder.h>
+#include <SIM_Swarm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+static Swarm swarm;
+
+static void usage(void)
+{
+    ::printf("Usage: SITL_Swarm.elf [SITL options] -- [options]\n"
+             "Options:\n"
+             "\t-n NUM       number of vehicles (default 2)\n"
+             "\t-f INSTANCE  SITL instance of the first vehicle (default 1)\n"
+             "\t-M MODEL     vehicle model, as for SITL --model (default quad)\n"
+             "\t-O HOME      home of the first vehicle (lat,lng,alt,yaw)\n"
+             "\t-d METERS    spacing between vehicles, going east (default 5)\n"
+             "\t-s SPEEDUP   simulation speedup, 0 for as fast as possible (default 1)\n"
+             "\t-g PORT      UDP port for the GCS (default 14550)\n");
+}
+
+void setup()
+{
+    uint8_t argc;
+    char * const *argv;
+    uint8_t num_vehicles = 2;
+    uint8_t first_instance = 1;
+    const char *model = "quad";
+    const char *home = "-35.363261,149.165230,584,353";
+    float spacing = 5;
+    float speedup = 1;
+    uint16_t gcs_port = 14550;
+    int opt;
+
+    hal.util->commandline_arguments(argc, argv);
+
+    // skip the SITL HAL options
+    uint8_t start = 0;
+    for (uint8_t i=1; i<argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            start = i;
+            break;
+        }
+    }
+    if (start != 0) {
+        argc -= start;
+        argv += start;
+        optind = 1;
+        while ((opt = getopt(argc, argv, "n:f:M:O:d:s:g:h")) != -1) {
+            switch (opt) {
+            case 'n':
+                num_vehicles = atoi(optarg);
+                break;
+            case 'f':
+                first_instance = atoi(optarg);
+                break;
+            case 'M':
+                model = optarg;
+                break;
+            case 'O':
+                home = optarg;
+                break;
+            case 'd':
+                spacing = atof(optarg);
+                break;
+            case 's':
+                speedup = atof(optarg);
+                break;
+            case 'g':
+                gcs_port = atoi(optarg);
+                break;
+            default:
+                usage();
+                exit(1);
+            }
+        }
+    }
+
+    if (!swarm.init(home, model, num_vehicles, first_instance, spacing, speedup, gcs_port)) {
+        exit(1);
+    }
+}
+
+void loop()
+{
+    static uint64_t last_report_us;
+    static uint64_t last_report_frames;
+
+    swarm.update();
+
+    uint64_t now = hal.scheduler->micros64();
+    if (now - last_report_us > 10000000UL) {
+        ::printf("Swarm: %u vehicles, %.1f frames/s\n",
+                 (unsigned)swarm.num_vehicles(),
+                 (double)((swarm.frame_count() - last_report_frames) * 1.0e6 / (now - last_report_us)));
+        last_report_us = now;
+        last_report_frames = swarm.frame_count();
+    }
+}
+
+#else
+
+void setup()
+{
+    hal.console->println_P(PSTR("SITL_Swarm only runs on the SITL HAL"));
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // CONFIG_HAL_BOARD
+
+AP_HAL_MAIN();
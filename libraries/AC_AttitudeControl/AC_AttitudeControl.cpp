@@ -746,9 +746,9 @@ float AC_AttitudeControl::sqrt_controller(float error, float p, float second_ord
     float linear_dist = second_ord_lim/sq(p);
 
     if (error > linear_dist) {
-        return safe_sqrt(2.0f*second_ord_lim*(error-(linear_dist/2.0f)));
+        return ap_safe_sqrt(2.0f*second_ord_lim*(error-(linear_dist/2.0f)));
     } else if (error < -linear_dist) {
-        return -safe_sqrt(2.0f*second_ord_lim*(-error-(linear_dist/2.0f)));
+        return -ap_safe_sqrt(2.0f*second_ord_lim*(-error-(linear_dist/2.0f)));
     } else {
         return error*p;
     }
@@ -1,9 +1,12 @@
 /// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
 #include <AP_HAL.h>
 #include <AC_Fence.h>
+#include <stdlib.h>
 
 extern const AP_HAL::HAL& hal;
 
+static const StorageAccess fence_storage(StorageManager::StorageFence);
+
 const AP_Param::GroupInfo AC_Fence::var_info[] PROGMEM = {
     // @Param: ENABLE
     // @DisplayName: Fence enable/disable
@@ -15,7 +18,7 @@ const AP_Param::GroupInfo AC_Fence::var_info[] PROGMEM = {
     // @Param: TYPE
     // @DisplayName: Fence Type
     // @Description: Enabled fence types held as bitmask
-    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle
+    // @Values: 0:None,1:Altitude,2:Circle,3:Altitude and Circle,4:Polygon,5:Altitude and Polygon,6:Circle and Polygon,7:All
     // @User: Standard
     AP_GROUPINFO("TYPE",        1,  AC_Fence,   _enabled_fences,  AC_FENCE_TYPE_ALT_MAX | AC_FENCE_TYPE_CIRCLE),
 
@@ -50,6 +53,13 @@ const AP_Param::GroupInfo AC_Fence::var_info[] PROGMEM = {
     // @Range: 1 10
     // @User: Standard
     AP_GROUPINFO("MARGIN",      5,  AC_Fence,   _margin, AC_FENCE_MARGIN_DEFAULT),
+
+    // @Param: TOTAL
+    // @DisplayName: Fence polygon point total
+    // @Description: Number of polygon fence points uploaded, including the return point. The points after the return point are one or more closed polygons, each ending with a repeat of its first point. Polygons wound the other way to the first one are exclusion zones. The number of points is limited by the fence storage space of the board, and by the 8 bit point index of the FENCE_POINT message to 255
+    // @Range: 0 255
+    // @User: Advanced
+    AP_GROUPINFO("TOTAL",       6,  AC_Fence,   _total, 0),
     
     AP_GROUPEND
 };
@@ -59,8 +69,12 @@ AC_Fence::AC_Fence(const AP_InertialNav& inav) :
     _inav(inav),
     _alt_max_backup(0),
     _circle_radius_backup(0),
+    _polygon_backup_distance(0),
     _alt_max_breach_distance(0),
     _circle_breach_distance(0),
+    _polygon_breach_distance(0),
+    _boundary(NULL),
+    _loaded_total(-1),
     _home_distance(0),
     _breached_fences(AC_FENCE_TYPE_NONE),
     _breach_time(0),
@@ -89,7 +103,7 @@ uint8_t AC_Fence::get_enabled_fences() const
 }
 
 /// pre_arm_check - returns true if all pre-takeoff checks have completed successfully
-bool AC_Fence::pre_arm_check() const
+bool AC_Fence::pre_arm_check()
 {
     // if not enabled or not fence set-up always return true
     if (!_enabled || _enabled_fences == AC_FENCE_TYPE_NONE) {
@@ -102,10 +116,24 @@ bool AC_Fence::pre_arm_check() const
     }
 
     // if we have horizontal limits enabled, check inertial nav position is ok
-    if ((_enabled_fences & AC_FENCE_TYPE_CIRCLE)!=0 && !_inav.get_filter_status().flags.horiz_pos_abs && !_inav.get_filter_status().flags.pred_horiz_pos_abs) {
+    if ((_enabled_fences & (AC_FENCE_TYPE_CIRCLE | AC_FENCE_TYPE_POLYGON))!=0 && !_inav.get_filter_status().flags.horiz_pos_abs && !_inav.get_filter_status().flags.pred_horiz_pos_abs) {
         return false;
     }
 
+    // if we have a polygon fence enabled, check it loaded and we are inside it
+    if ((_enabled_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+        if (_loaded_total != _total) {
+            load_polygon();
+        }
+        if (!_polygon.loaded()) {
+            return false;
+        }
+        Vector2l location(_inav.get_latitude(), _inav.get_longitude());
+        if (_polygon.outside(location)) {
+            return false;
+        }
+    }
+
     // if we got this far everything must be ok
     return true;
 }
@@ -190,11 +218,49 @@ uint8_t AC_Fence::check_fence(float curr_alt)
         }
     }
 
+    // polygon fence check
+    if ((_enabled_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+
+        // reload if points have been uploaded
+        if (_loaded_total != _total) {
+            load_polygon();
+        }
+
+        // only check with a valid polygon and a good position estimate
+        if (_polygon.loaded() && _inav.get_filter_status().flags.horiz_pos_abs) {
+            Vector2l location(_inav.get_latitude(), _inav.get_longitude());
+
+            // check if we are outside the fence
+            if (_polygon.outside(location)) {
+
+                // record distance outside the fence
+                _polygon_breach_distance = _polygon.boundary_distance(location);
+
+                // check for a new breach or a breach of the backup fence
+                if ((_breached_fences & AC_FENCE_TYPE_POLYGON) == 0 || (!is_zero(_polygon_backup_distance) && _polygon_breach_distance >= _polygon_backup_distance)) {
+
+                    // record that we have breached the polygon
+                    record_breach(AC_FENCE_TYPE_POLYGON);
+                    ret = ret | AC_FENCE_TYPE_POLYGON;
+
+                    // create a backup fence 20m further out
+                    _polygon_backup_distance = _polygon_breach_distance + AC_FENCE_POLYGON_BACKUP_DISTANCE;
+                }
+            }else{
+                // clear polygon breach if present
+                if ((_breached_fences & AC_FENCE_TYPE_POLYGON) != 0) {
+                    clear_breach(AC_FENCE_TYPE_POLYGON);
+                    _polygon_backup_distance = 0.0f;
+                    _polygon_breach_distance = 0.0f;
+                }
+            }
+        }
+    }
+
     // return any new breaches that have occurred
     return ret;
 
-    // To-Do: add min alt and polygon check
-    //outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+    // To-Do: add min alt check
 }
 
 /// record_breach - update breach bitmask, time and count
@@ -229,19 +295,19 @@ void AC_Fence::clear_breach(uint8_t fence_type)
 /// get_breach_distance - returns distance in meters outside of the given fence
 float AC_Fence::get_breach_distance(uint8_t fence_type) const
 {
-    switch (fence_type) {
-        case AC_FENCE_TYPE_ALT_MAX:
-            return _alt_max_breach_distance;
-            break;
-        case AC_FENCE_TYPE_CIRCLE:
-            return _circle_breach_distance;
-            break;
-        case AC_FENCE_TYPE_ALT_MAX | AC_FENCE_TYPE_CIRCLE:
-            return max(_alt_max_breach_distance,_circle_breach_distance);
+    // return the largest distance of the given fence types. Any fence
+    // type we don't recognise is ignored
+    float distance = 0;
+    if ((fence_type & AC_FENCE_TYPE_ALT_MAX) != 0) {
+        distance = max(distance, _alt_max_breach_distance);
     }
-
-    // we don't recognise the fence type so just return 0
-    return 0;
+    if ((fence_type & AC_FENCE_TYPE_CIRCLE) != 0) {
+        distance = max(distance, _circle_breach_distance);
+    }
+    if ((fence_type & AC_FENCE_TYPE_POLYGON) != 0) {
+        distance = max(distance, _polygon_breach_distance);
+    }
+    return distance;
 }
 
 /// manual_recovery_start - caller indicates that pilot is re-taking manual control so fence should be disabled for 10 seconds
@@ -256,3 +322,65 @@ void AC_Fence::manual_recovery_start()
     // record time pilot began manual recovery
     _manual_recovery_start_ms = hal.scheduler->millis();
 }
+
+/// max_polygon_points - maximum number of points storage can hold
+uint8_t AC_Fence::max_polygon_points() const
+{
+    return min(255, fence_storage.size() / sizeof(Vector2l));
+}
+
+/// get_polygon_point - returns point i, or zero if i is invalid
+Vector2l AC_Fence::get_polygon_point(uint8_t i) const
+{
+    if (_total <= 0 || i >= _total || i >= max_polygon_points()) {
+        return Vector2l(0,0);
+    }
+    Vector2l ret;
+    ret.x = fence_storage.read_uint32(i * sizeof(Vector2l));
+    ret.y = fence_storage.read_uint32(i * sizeof(Vector2l) + 4);
+    return ret;
+}
+
+/// set_polygon_point - stores point i. The polygon is reloaded on the next check
+void AC_Fence::set_polygon_point(const Vector2l &point, uint8_t i)
+{
+    if (_total <= 0 || i >= _total || i >= max_polygon_points()) {
+        // not allowed
+        return;
+    }
+    fence_storage.write_uint32(i * sizeof(Vector2l), point.x);
+    fence_storage.write_uint32(i * sizeof(Vector2l) + 4, point.y);
+    _loaded_total = -1;
+}
+
+/// load_polygon - read the polygon points from storage and index them
+void AC_Fence::load_polygon()
+{
+    _polygon.clear();
+    _loaded_total = _total;
+
+    if (_total < AC_FENCE_POLYGON_MIN_POINTS || _total > max_polygon_points()) {
+        return;
+    }
+
+    // the copy is allocated on first use so vehicles without a
+    // polygon fence don't pay for it
+    if (_boundary == NULL) {
+        if (hal.util->available_memory() < 512 + max_polygon_points() * sizeof(Vector2l)) {
+            return;
+        }
+        _boundary = (Vector2l *)calloc(max_polygon_points(), sizeof(Vector2l));
+        if (_boundary == NULL) {
+            return;
+        }
+    }
+
+    for (uint16_t i=0; i<_total; i++) {
+        _boundary[i] = get_polygon_point(i);
+    }
+
+    // point 0 is the return point, which must be inside the fence
+    if (!_polygon.load(&_boundary[1], _total-1) || _polygon.outside(_boundary[0])) {
+        _polygon.clear();
+    }
+}
@@ -7,11 +7,14 @@
 #include <AP_Param.h>
 #include <AP_Math.h>
 #include <AP_InertialNav.h>     // Inertial Navigation library
+#include <StorageManager.h>
+#include <AC_PolyFence.h>       // polygon fence engine
 
 // bit masks for enabled fence types.  Used for TYPE parameter
 #define AC_FENCE_TYPE_NONE                          0       // fence disabled
 #define AC_FENCE_TYPE_ALT_MAX                       1       // high alt fence which usually initiates an RTL
 #define AC_FENCE_TYPE_CIRCLE                        2       // circular horizontal fence (usually initiates an RTL)
+#define AC_FENCE_TYPE_POLYGON                       4       // polygon horizontal fence with optional exclusion zones (usually initiates an RTL)
 
 // valid actions should a fence be breached
 #define AC_FENCE_ACTION_REPORT_ONLY                 0       // report to GCS that boundary has been breached but take no further action
@@ -22,6 +25,8 @@
 #define AC_FENCE_CIRCLE_RADIUS_DEFAULT              300.0f  // default circular fence radius is 300m
 #define AC_FENCE_ALT_MAX_BACKUP_DISTANCE            20.0f   // after fence is broken we recreate the fence 20m further up
 #define AC_FENCE_CIRCLE_RADIUS_BACKUP_DISTANCE      20.0f   // after fence is broken we recreate the fence 20m further out
+#define AC_FENCE_POLYGON_BACKUP_DISTANCE            20.0f   // after polygon fence is broken we refire the breach each 20m further out
+#define AC_FENCE_POLYGON_MIN_POINTS                 5       // return point + triangle + closing point
 #define AC_FENCE_MARGIN_DEFAULT                     2.0f    // default distance in meters that autopilot's should maintain from the fence to avoid a breach
 
 // give up distance
@@ -45,7 +50,7 @@ public:
     uint8_t get_enabled_fences() const;
 
     /// pre_arm_check - returns true if all pre-takeoff checks have completed successfully
-    bool pre_arm_check() const;
+    bool pre_arm_check();
 
     ///
     /// methods to check we are within the boundaries and recover
@@ -85,6 +90,23 @@ public:
     /// set_home_distance - update vehicle's distance from home in meters - required for circular horizontal fence monitoring
     void set_home_distance(float distance) { _home_distance = distance; }
 
+    ///
+    /// polygon fence points. Point 0 is the return point and the rest
+    /// are the polygons, in the same layout as the plane geofence
+    ///
+
+    /// get_polygon_total - number of stored polygon fence points
+    uint8_t get_polygon_total() const { return constrain_int16(_total, 0, 255); }
+
+    /// max_polygon_points - maximum number of points storage can hold
+    uint8_t max_polygon_points() const;
+
+    /// get_polygon_point - returns point i, or zero if i is invalid
+    Vector2l get_polygon_point(uint8_t i) const;
+
+    /// set_polygon_point - stores point i. The polygon is reloaded on the next check
+    void set_polygon_point(const Vector2l &point, uint8_t i);
+
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
@@ -95,6 +117,9 @@ private:
     /// clear_breach - update breach bitmask, time and count
     void clear_breach(uint8_t fence_type);
 
+    /// load_polygon - read the polygon points from storage and index them
+    void load_polygon();
+
     // pointers to other objects we depend upon
     const AP_InertialNav& _inav;
 
@@ -105,14 +130,22 @@ private:
     AP_Float        _alt_max;               // altitude upper limit in meters
     AP_Float        _circle_radius;         // circle fence radius in meters
     AP_Float        _margin;                // distance in meters that autopilot's should maintain from the fence to avoid a breach
+    AP_Int16        _total;                 // number of polygon fence points, including the return point
 
     // backup fences
     float           _alt_max_backup;        // backup altitude upper limit in meters used to refire the breach if the vehicle continues to move further away
     float           _circle_radius_backup;  // backup circle fence radius in meters used to refire the breach if the vehicle continues to move further away
+    float           _polygon_backup_distance;   // backup distance outside the polygon used to refire the breach if the vehicle continues to move further away
 
     // breach distances
     float           _alt_max_breach_distance;   // distance above the altitude max
     float           _circle_breach_distance;    // distance beyond the circular fence
+    float           _polygon_breach_distance;   // distance outside the polygon fence
+
+    // polygon fence
+    Vector2l        *_boundary;             // copy of the points in storage, allocated on first load
+    AC_PolyFence    _polygon;               // index over _boundary[1] onwards
+    int16_t         _loaded_total;          // _total when the polygon was last loaded, -1 if it needs reloading
 
     // other internal variables
     float           _home_distance;         // distance from home in meters (provided by main code)
@@ -0,0 +1,392 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include <AC_PolyFence.h>
+#include <stdlib.h>
+#include <float.h>
+
+extern const AP_HAL::HAL& hal;
+
+AC_PolyFence::AC_PolyFence() :
+    _points(NULL),
+    _num_polygons(0),
+    _exclusion_mask(0),
+    _cell_height(1),
+    _cell_width(1),
+    _grid_rows(0),
+    _grid_cols(0),
+    _cell_start(NULL),
+    _cell_edges(NULL),
+    _edge_polygon(NULL),
+    _lng_scale(1.0f)
+{
+}
+
+/*
+  forget the fence and free the index
+ */
+void AC_PolyFence::clear()
+{
+    free(_cell_start);
+    free(_cell_edges);
+    free(_edge_polygon);
+    _cell_start = NULL;
+    _cell_edges = NULL;
+    _edge_polygon = NULL;
+    _points = NULL;
+    _num_polygons = 0;
+    _exclusion_mask = 0;
+    _grid_rows = 0;
+    _grid_cols = 0;
+}
+
+/*
+  return the grid row for latitude x. Points beyond the fence go in
+  the edge rows
+ */
+uint16_t AC_PolyFence::row_of(int32_t x) const
+{
+    int64_t d = (int64_t)x - _grid_origin.x;
+    if (d <= 0) {
+        return 0;
+    }
+    d /= _cell_height;
+    if (d >= _grid_rows) {
+        return _grid_rows - 1;
+    }
+    return (uint16_t)d;
+}
+
+/*
+  return the grid column for longitude y. Points beyond the fence go
+  in the edge columns
+ */
+uint16_t AC_PolyFence::col_of(int32_t y) const
+{
+    int64_t d = (int64_t)y - _grid_origin.y;
+    if (d <= 0) {
+        return 0;
+    }
+    d /= _cell_width;
+    if (d >= _grid_cols) {
+        return _grid_cols - 1;
+    }
+    return (uint16_t)d;
+}
+
+/*
+  split the points into closed polygons, classify them and build the
+  edge grid
+ */
+bool AC_PolyFence::load(const Vector2l *points, uint16_t num_points)
+{
+    clear();
+
+    if (points == NULL || num_points < AC_POLYFENCE_MIN_POLYGON_POINTS) {
+        return false;
+    }
+
+    // split into polygons, each ending with a repeat of its first point
+    uint8_t num_polygons = 0;
+    uint16_t start = 0;
+    while (start < num_points) {
+        if (num_polygons == AC_POLYFENCE_MAX_POLYGONS) {
+            return false;
+        }
+        uint16_t end = start+1;
+        while (end < num_points &&
+               (points[end].x != points[start].x || points[end].y != points[start].y)) {
+            end++;
+        }
+        if (end == num_points || end - start + 1 < AC_POLYFENCE_MIN_POLYGON_POINTS) {
+            // not closed, or too few points to enclose anything
+            return false;
+        }
+        _poly_start[num_polygons++] = start;
+        start = end+1;
+    }
+    _poly_start[num_polygons] = num_points;
+
+    // find the winding of each polygon from the sign of its area. The
+    // area is only used for its sign, so float is plenty
+    float first_area = 0;
+    uint32_t exclusion_mask = 0;
+    for (uint8_t i=0; i<num_polygons; i++) {
+        const Vector2l &p0 = points[_poly_start[i]];
+        float area = 0;
+        for (uint16_t k=_poly_start[i]+1; k<_poly_start[i+1]-2; k++) {
+            float ax = (float)((int64_t)points[k].x - p0.x);
+            float ay = (float)((int64_t)points[k].y - p0.y);
+            float bx = (float)((int64_t)points[k+1].x - p0.x);
+            float by = (float)((int64_t)points[k+1].y - p0.y);
+            area += ax*by - ay*bx;
+        }
+        if (is_zero(area)) {
+            return false;
+        }
+        if (i == 0) {
+            first_area = area;
+        } else if ((area > 0) != (first_area > 0)) {
+            exclusion_mask |= (1UL<<i);
+        }
+    }
+
+    // extent of the fence
+    Vector2l pmin = points[0];
+    Vector2l pmax = points[0];
+    for (uint16_t k=1; k<num_points; k++) {
+        pmin.x = min(pmin.x, points[k].x);
+        pmin.y = min(pmin.y, points[k].y);
+        pmax.x = max(pmax.x, points[k].x);
+        pmax.y = max(pmax.y, points[k].y);
+    }
+    Location loc;
+    loc.lat = points[0].x;
+    _lng_scale = longitude_scale(loc);
+    float height_m = ((int64_t)pmax.x - pmin.x) * LATLON_TO_M;
+    float width_m = ((int64_t)pmax.y - pmin.y) * LATLON_TO_M * _lng_scale;
+
+    // aim for about one cell per edge with cells close to square in
+    // meters, then shrink the grid until it fits in the memory we have
+    uint16_t num_edges = num_points - num_polygons;
+    uint16_t num_cells = constrain_int16(num_edges, 1, AC_POLYFENCE_MAX_CELLS);
+    uint32_t num_entries;
+    _points = points;
+    _grid_origin = pmin;
+    _grid_limit = pmax;
+    while (true) {
+        float cell_size = sqrtf(height_m * width_m / num_cells);
+        _grid_rows = constrain_int16(height_m / cell_size + 0.5f, 1, num_cells);
+        _grid_cols = constrain_int16(width_m / cell_size + 0.5f, 1, num_cells / _grid_rows);
+        _cell_height = (uint32_t)(((int64_t)pmax.x - pmin.x) / _grid_rows) + 1;
+        _cell_width = (uint32_t)(((int64_t)pmax.y - pmin.y) / _grid_cols) + 1;
+        num_entries = 0;
+        for (uint8_t i=0; i<num_polygons; i++) {
+            for (uint16_t k=_poly_start[i]; k<_poly_start[i+1]-1; k++) {
+                uint16_t r1 = row_of(points[k].x), r2 = row_of(points[k+1].x);
+                uint16_t c1 = col_of(points[k].y), c2 = col_of(points[k+1].y);
+                num_entries += (uint32_t)((r1 > r2 ? r1 - r2 : r2 - r1) + 1) * ((c1 > c2 ? c1 - c2 : c2 - c1) + 1);
+            }
+        }
+        uint16_t cells = _grid_rows * _grid_cols;
+        uint32_t size = (cells+1)*sizeof(uint16_t) + num_entries*sizeof(uint16_t) + num_points;
+        if (num_cells == 1 || (num_entries <= 0xFFFF && hal.util->available_memory() >= 512 + size)) {
+            break;
+        }
+        num_cells /= 2;
+    }
+    if (num_entries > 0xFFFF) {
+        clear();
+        return false;
+    }
+
+    uint16_t cells = _grid_rows * _grid_cols;
+    _cell_start = (uint16_t *)calloc(cells+1, sizeof(uint16_t));
+    _cell_edges = (uint16_t *)calloc(num_entries, sizeof(uint16_t));
+    _edge_polygon = (uint8_t *)calloc(num_points, sizeof(uint8_t));
+    if (_cell_start == NULL || _cell_edges == NULL || _edge_polygon == NULL) {
+        clear();
+        return false;
+    }
+
+    // count the edges in each cell, then turn the counts into start
+    // offsets and fill in the edges. _cell_start[c] is used as the fill
+    // position for cell c, which leaves it at the start of cell c+1
+    for (uint8_t pass=0; pass<2; pass++) {
+        for (uint8_t i=0; i<num_polygons; i++) {
+            for (uint16_t k=_poly_start[i]; k<_poly_start[i+1]-1; k++) {
+                uint16_t r1 = row_of(points[k].x), r2 = row_of(points[k+1].x);
+                uint16_t c1 = col_of(points[k].y), c2 = col_of(points[k+1].y);
+                for (uint16_t r=min(r1,r2); r<=max(r1,r2); r++) {
+                    for (uint16_t c=min(c1,c2); c<=max(c1,c2); c++) {
+                        uint16_t cell = r*_grid_cols + c;
+                        if (pass == 0) {
+                            _cell_start[cell+1]++;
+                        } else {
+                            _cell_edges[_cell_start[cell]++] = k;
+                        }
+                    }
+                }
+                _edge_polygon[k] = i;
+            }
+        }
+        if (pass == 0) {
+            for (uint16_t c=0; c<cells; c++) {
+                _cell_start[c+1] += _cell_start[c];
+            }
+        }
+    }
+    for (uint16_t c=cells; c>0; c--) {
+        _cell_start[c] = _cell_start[c-1];
+    }
+    _cell_start[0] = 0;
+
+    _exclusion_mask = exclusion_mask;
+    _num_polygons = num_polygons;
+    return true;
+}
+
+/*
+  return true if P is outside the fence. Any edge that crosses the
+  ray from P in the +x direction does so in P's column at or above
+  P's row, so only those cells are checked. An edge is in every row
+  of its bounding box, so it is only tested in the lowest of those
+  rows that is on the ray
+ */
+bool AC_PolyFence::outside(const Vector2l &P) const
+{
+    if (!loaded()) {
+        return true;
+    }
+
+    if (P.x < _grid_origin.x || P.x > _grid_limit.x ||
+        P.y < _grid_origin.y || P.y > _grid_limit.y) {
+        // outside the extent of every polygon
+        return true;
+    }
+
+    // bit i is set if P is inside polygon i
+    uint32_t inside = 0;
+    uint16_t row = row_of(P.x);
+    uint16_t col = col_of(P.y);
+    for (uint16_t r=row; r<_grid_rows; r++) {
+        uint16_t cell = r*_grid_cols + col;
+        int64_t row_bottom = _grid_origin.x + (int64_t)r*_cell_height;
+        for (uint16_t i=_cell_start[cell]; i<_cell_start[cell+1]; i++) {
+            uint16_t k = _cell_edges[i];
+            const Vector2l &A = _points[k+1];
+            const Vector2l &B = _points[k];
+            if ((A.y > P.y) == (B.y > P.y)) {
+                // doesn't span P's longitude
+                continue;
+            }
+            if (r > row && min(A.x, B.x) < row_bottom) {
+                // already tested in a lower row
+                continue;
+            }
+            // same argument order as Polygon_outside() so points
+            // exactly on an edge give the same result
+            if (Polygon_edge_crosses(P, A, B)) {
+                inside ^= (1UL<<_edge_polygon[k]);
+            }
+        }
+    }
+
+    if ((inside & ~_exclusion_mask) == 0) {
+        // not inside any inclusion zone
+        return true;
+    }
+    return (inside & _exclusion_mask) != 0;
+}
+
+/*
+  distance in meters from P to the edge from point k to point k+1
+ */
+float AC_PolyFence::edge_distance(const Vector2l &P, uint16_t k) const
+{
+    const Vector2l &A = _points[k];
+    const Vector2l &B = _points[k+1];
+    Vector2f a(((int64_t)A.x - P.x) * LATLON_TO_M,
+               ((int64_t)A.y - P.y) * LATLON_TO_M * _lng_scale);
+    Vector2f b(((int64_t)B.x - P.x) * LATLON_TO_M,
+               ((int64_t)B.y - P.y) * LATLON_TO_M * _lng_scale);
+    Vector2f d = b - a;
+    float len_sq = d.length_squared();
+    if (is_zero(len_sq)) {
+        return a.length();
+    }
+    // closest point on the edge to P, which is at the origin
+    float t = constrain_float(-(a * d) / len_sq, 0.0f, 1.0f);
+    return (a + d*t).length();
+}
+
+/*
+  minimum of best and the distance from P to each edge in a cell
+ */
+float AC_PolyFence::cell_distance(const Vector2l &P, uint16_t row, uint16_t col, float best) const
+{
+    uint16_t cell = row*_grid_cols + col;
+    for (uint16_t i=_cell_start[cell]; i<_cell_start[cell+1]; i++) {
+        best = min(best, edge_distance(P, _cell_edges[i]));
+    }
+    return best;
+}
+
+/*
+  return distance in meters from P to the nearest fence edge. The
+  block of searched cells grows outward from P's cell, a side at a
+  time, until every unsearched cell is further away than the closest
+  edge found
+ */
+float AC_PolyFence::boundary_distance(const Vector2l &P) const
+{
+    if (!loaded()) {
+        return 0;
+    }
+
+    const float lat_scale = LATLON_TO_M;
+    const float lng_scale = LATLON_TO_M * _lng_scale;
+    uint16_t r0 = row_of(P.x), r1 = r0;
+    uint16_t c0 = col_of(P.y), c1 = c0;
+    float best = cell_distance(P, r0, c0, FLT_MAX);
+
+    while (true) {
+        // distance from P to the unsearched cells on each side
+        float gap_down = FLT_MAX, gap_up = FLT_MAX, gap_left = FLT_MAX, gap_right = FLT_MAX;
+        if (r0 > 0) {
+            gap_down = ((int64_t)P.x - (_grid_origin.x + (int64_t)r0*_cell_height)) * lat_scale;
+        }
+        if (r1 < _grid_rows-1) {
+            gap_up = ((_grid_origin.x + (int64_t)(r1+1)*_cell_height) - (int64_t)P.x) * lat_scale;
+        }
+        if (c0 > 0) {
+            gap_left = ((int64_t)P.y - (_grid_origin.y + (int64_t)c0*_cell_width)) * lng_scale;
+        }
+        if (c1 < _grid_cols-1) {
+            gap_right = ((_grid_origin.y + (int64_t)(c1+1)*_cell_width) - (int64_t)P.y) * lng_scale;
+        }
+        float gap = min(min(gap_down, gap_up), min(gap_left, gap_right));
+        if (best <= gap) {
+            // also ends the search once the whole grid has been searched
+            break;
+        }
+
+        // grow the block on the nearest side
+        if (gap == gap_down) {
+            r0--;
+            for (uint16_t c=c0; c<=c1; c++) {
+                best = cell_distance(P, r0, c, best);
+            }
+        } else if (gap == gap_up) {
+            r1++;
+            for (uint16_t c=c0; c<=c1; c++) {
+                best = cell_distance(P, r1, c, best);
+            }
+        } else if (gap == gap_left) {
+            c0--;
+            for (uint16_t r=r0; r<=r1; r++) {
+                best = cell_distance(P, r, c0, best);
+            }
+        } else {
+            c1++;
+            for (uint16_t r=r0; r<=r1; r++) {
+                best = cell_distance(P, r, c1, best);
+            }
+        }
+    }
+    return best;
+}
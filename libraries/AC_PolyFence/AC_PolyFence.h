@@ -0,0 +1,117 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  polygon fence engine shared by the Plane geofence and AC_Fence
+
+  A fence is a list of closed polygons held back to back in a single
+  array of lat/lng points (x is latitude, y is longitude, both in
+  1e-7 degrees). Each polygon ends with a repeat of its first
+  point. The first polygon is an inclusion zone. Later polygons wound
+  the same way as the first are additional inclusion zones, and those
+  wound the other way are exclusion zones.
+
+  The edges are indexed into a grid of cells roughly square in
+  meters, so an inside/outside check only looks at the edges in the
+  cells along the test ray from the point, and a distance to boundary
+  query searches outward from the point's cell.
+ */
+
+#ifndef AC_POLYFENCE_H
+#define AC_POLYFENCE_H
+
+#include <inttypes.h>
+#include <AP_Common.h>
+#include <AP_Math.h>
+
+#define AC_POLYFENCE_MAX_POLYGONS       32      // limited by the 32 bit masks used when checking
+#define AC_POLYFENCE_MAX_CELLS          256     // upper limit on the number of grid cells
+#define AC_POLYFENCE_MIN_POLYGON_POINTS 4       // a triangle plus the closing point
+
+class AC_PolyFence
+{
+public:
+    AC_PolyFence();
+
+    /// load - split points into polygons and build the edge index. The
+    ///     points are not copied so must stay valid and unchanged until
+    ///     the next load() or clear(). Returns false if the points do not
+    ///     form valid closed polygons or memory could not be allocated
+    bool load(const Vector2l *points, uint16_t num_points);
+
+    /// clear - forget the fence and free the index
+    void clear();
+
+    /// loaded - returns true if a valid fence is loaded
+    bool loaded() const { return _num_polygons != 0; }
+
+    /// num_polygons - number of polygons in the loaded fence
+    uint8_t num_polygons() const { return _num_polygons; }
+
+    /// is_exclusion - returns true if polygon i is an exclusion zone
+    bool is_exclusion(uint8_t i) const { return (_exclusion_mask & (1UL<<i)) != 0; }
+
+    /// outside - returns true if P is outside all inclusion polygons or
+    ///     inside any exclusion polygon. This gives the same answer as
+    ///     Polygon_outside() for a single polygon fence
+    bool outside(const Vector2l &P) const;
+
+    /// boundary_distance - returns the distance in meters from P to the
+    ///     nearest fence edge, whether P is inside or outside
+    float boundary_distance(const Vector2l &P) const;
+
+private:
+
+    // grid row for latitude x and column for longitude y, clamped to
+    // the grid
+    uint16_t row_of(int32_t x) const;
+    uint16_t col_of(int32_t y) const;
+
+    // distance in meters from P to the edge starting at point k
+    float edge_distance(const Vector2l &P, uint16_t k) const;
+
+    // minimum distance from P to any edge in the given cell
+    float cell_distance(const Vector2l &P, uint16_t row, uint16_t col, float best) const;
+
+    // the fence points, owned by the caller
+    const Vector2l *_points;
+
+    // index of the first point of each polygon, with one extra entry
+    // pointing past the end of the last polygon
+    uint16_t        _poly_start[AC_POLYFENCE_MAX_POLYGONS+1];
+    uint8_t         _num_polygons;
+    uint32_t        _exclusion_mask;        // bit i set if polygon i is an exclusion zone
+
+    // edge grid. Rows are latitude and columns longitude. The edges
+    // touching cell c are _cell_edges[_cell_start[c]] to
+    // _cell_edges[_cell_start[c+1]-1], each given as the index of
+    // its first point. An edge is placed in every cell of its
+    // bounding box
+    Vector2l        _grid_origin;           // lat/lng of the corner of cell 0
+    Vector2l        _grid_limit;            // largest lat/lng of any fence point
+    uint32_t        _cell_height;           // latitude size of a cell
+    uint32_t        _cell_width;            // longitude size of a cell
+    uint16_t        _grid_rows;
+    uint16_t        _grid_cols;
+    uint16_t        *_cell_start;
+    uint16_t        *_cell_edges;
+    uint8_t         *_edge_polygon;         // polygon each point/edge belongs to
+
+    // scaling from lat/lng units to meters near the fence
+    float           _lng_scale;
+};
+
+#endif  // AC_POLYFENCE_H
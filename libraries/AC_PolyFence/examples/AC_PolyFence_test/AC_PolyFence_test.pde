@@ -0,0 +1,210 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Tests for the AC_PolyFence engine. Checks the indexed inside/outside
+// test against Polygon_outside() and the distance to boundary against
+// a search over all edges, then times both on a large fence
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_RangeFinder.h>
+#include <AP_OpticalFlow.h>
+#include <AC_PolyFence.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define STAR_POINTS     400             // vertices in the outer boundary
+#define CENTER_LAT      -353632620L
+#define CENTER_LNG      1491652370L
+#define NUM_TESTS       2000
+#define NUM_TIMING      2000
+
+static Vector2l fence[STAR_POINTS + 1 + 5];
+static uint16_t star_count;
+static uint16_t fence_count;
+static AC_PolyFence polyfence;
+static uint32_t seed = 1;
+static Vector2l timing_points[NUM_TIMING];
+
+static int32_t random_offset(int32_t range)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (int32_t)((seed >> 8) % (2*(uint32_t)range+1)) - range;
+}
+
+// the fence is a star shaped inclusion zone with a square exclusion
+// zone near its middle, wound the other way
+static void make_fence(void)
+{
+    for (uint16_t i=0; i<STAR_POINTS; i++) {
+        float angle = i * (2*PI/STAR_POINTS);
+        float radius = (i & 1) ? 60000 : 100000;
+        fence[i].x = CENTER_LAT + (int32_t)(radius * cosf(angle));
+        fence[i].y = CENTER_LNG + (int32_t)(radius * sinf(angle));
+    }
+    fence[STAR_POINTS] = fence[0];
+    star_count = STAR_POINTS+1;
+
+    // counter winding square, 2km on a side
+    Vector2l *sq = &fence[star_count];
+    sq[0] = Vector2l(CENTER_LAT - 10000, CENTER_LNG - 10000);
+    sq[1] = Vector2l(CENTER_LAT - 10000, CENTER_LNG + 10000);
+    sq[2] = Vector2l(CENTER_LAT + 10000, CENTER_LNG + 10000);
+    sq[3] = Vector2l(CENTER_LAT + 10000, CENTER_LNG - 10000);
+    sq[4] = sq[0];
+    fence_count = star_count + 5;
+}
+
+// reference answer using Polygon_outside() on each polygon
+static bool reference_outside(const Vector2l &P)
+{
+    return Polygon_outside(P, fence, star_count) ||
+        !Polygon_outside(P, &fence[star_count], fence_count - star_count);
+}
+
+// reference distance, checking every edge
+static float reference_distance(const Vector2l &P)
+{
+    Location loc;
+    loc.lat = fence[0].x;
+    float scale = longitude_scale(loc);
+    float best = 1.0e30f;
+    for (uint16_t k=0; k<fence_count-1; k++) {
+        if (k == star_count-1) {
+            // no edge between the two polygons
+            continue;
+        }
+        Vector2f a((fence[k].x - P.x) * LATLON_TO_M, (fence[k].y - P.y) * LATLON_TO_M * scale);
+        Vector2f b((fence[k+1].x - P.x) * LATLON_TO_M, (fence[k+1].y - P.y) * LATLON_TO_M * scale);
+        Vector2f d = b - a;
+        float t = constrain_float(-(a * d) / d.length_squared(), 0.0f, 1.0f);
+        best = min(best, (a + d*t).length());
+    }
+    return best;
+}
+
+static Vector2l random_point(void)
+{
+    return Vector2l(CENTER_LAT + random_offset(120000), CENTER_LNG + random_offset(120000));
+}
+
+void setup(void)
+{
+    bool all_passed = true;
+
+    hal.console->println("AC_PolyFence tests\n");
+
+    make_fence();
+    if (!polyfence.load(fence, fence_count)) {
+        hal.console->println("load failed");
+        hal.console->println("TEST FAILED");
+        return;
+    }
+    hal.console->printf("%u polygons, exclusion=%u\n",
+                        (unsigned)polyfence.num_polygons(),
+                        (unsigned)polyfence.is_exclusion(1));
+    if (polyfence.num_polygons() != 2 || polyfence.is_exclusion(0) || !polyfence.is_exclusion(1)) {
+        all_passed = false;
+    }
+
+    // an unclosed polygon must be rejected
+    AC_PolyFence bad;
+    if (bad.load(fence, star_count-1)) {
+        hal.console->println("unclosed polygon accepted");
+        all_passed = false;
+    }
+
+    // fixed points
+    if (!polyfence.outside(Vector2l(CENTER_LAT, CENTER_LNG)) ||
+        polyfence.outside(Vector2l(CENTER_LAT + 30000, CENTER_LNG)) ||
+        !polyfence.outside(Vector2l(CENTER_LAT + 200000, CENTER_LNG))) {
+        hal.console->println("fixed point check failed");
+        all_passed = false;
+    }
+
+    // random points, including some exactly on vertices
+    uint16_t outside_fail = 0;
+    float max_dist_err = 0;
+    for (uint16_t n=0; n<NUM_TESTS; n++) {
+        Vector2l P = (n % 10 == 0) ? fence[n % fence_count] : random_point();
+        if (polyfence.outside(P) != reference_outside(P)) {
+            outside_fail++;
+        }
+        max_dist_err = max(max_dist_err, fabsf(polyfence.boundary_distance(P) - reference_distance(P)));
+    }
+    hal.console->printf("outside mismatches %u  max distance error %.3fm\n",
+                        (unsigned)outside_fail, max_dist_err);
+    if (outside_fail != 0 || max_dist_err > 0.01f) {
+        all_passed = false;
+    }
+
+    // timing, using the same points for each method
+    for (uint16_t n=0; n<NUM_TIMING; n++) {
+        timing_points[n] = random_point();
+    }
+    uint16_t count = 0;
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_TIMING; n++) {
+        count += reference_outside(timing_points[n]);
+    }
+    uint32_t t_reference = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_TIMING; n++) {
+        count += polyfence.outside(timing_points[n]);
+    }
+    uint32_t t_outside = hal.scheduler->micros() - t0;
+    float sum = 0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_TIMING; n++) {
+        sum += reference_distance(timing_points[n]);
+    }
+    uint32_t t_reference_distance = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_TIMING; n++) {
+        sum += polyfence.boundary_distance(timing_points[n]);
+    }
+    uint32_t t_distance = hal.scheduler->micros() - t0;
+
+    hal.console->printf("%u points on a %u point fence (%u %.0f)\n",
+                        NUM_TIMING, (unsigned)fence_count, (unsigned)count, sum);
+    hal.console->printf("Polygon_outside     %6lu usec\n", (unsigned long)t_reference);
+    hal.console->printf("outside             %6lu usec\n", (unsigned long)t_outside);
+    hal.console->printf("all edges distance  %6lu usec\n", (unsigned long)t_reference_distance);
+    hal.console->printf("boundary_distance   %6lu usec\n", (unsigned long)t_distance);
+
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void) {}
+
+AP_HAL_MAIN();
@@ -237,18 +237,24 @@ void AP_AHRS::update_trig(void)
     // sin_yaw, cos_yaw
     yaw_vector.x = temp.a.x;
     yaw_vector.y = temp.b.x;
-    yaw_vector.normalize();
+    float yaw_length_sq = yaw_vector.length_squared();
+    if (yaw_length_sq > 0) {
+        yaw_vector *= ap_inv_sqrtf(yaw_length_sq);
+    }
     _sin_yaw = constrain_float(yaw_vector.y, -1.0, 1.0);
     _cos_yaw = constrain_float(yaw_vector.x, -1.0, 1.0);
 
-    // cos_roll, cos_pitch
+    // cos_roll, cos_pitch. Using the inverse of cos_pitch saves a
+    // sqrt and two divides
     float cx2 = temp.c.x * temp.c.x;
+    float inv_cos_pitch = 0;
     if (cx2 >= 1.0f) {
         _cos_pitch = 0;
         _cos_roll = 1.0f;
     } else {
-        _cos_pitch = safe_sqrt(1 - cx2);
-        _cos_roll = temp.c.z / _cos_pitch;
+        inv_cos_pitch = ap_inv_sqrtf(1 - cx2);
+        _cos_pitch = (1 - cx2) * inv_cos_pitch;
+        _cos_roll = temp.c.z * inv_cos_pitch;
     }
     _cos_pitch = constrain_float(_cos_pitch, 0, 1.0);
     _cos_roll = constrain_float(_cos_roll, -1.0, 1.0); // this relies on constrain_float() of infinity doing the right thing,which it does do in avr-libc
@@ -256,13 +262,13 @@ void AP_AHRS::update_trig(void)
     // sin_roll, sin_pitch
     _sin_pitch = -temp.c.x;
     if (is_zero(_cos_pitch)) {
-        _sin_roll = sinf(roll);
+        _sin_roll = ap_sinf(roll);
     } else {
-        _sin_roll = temp.c.y / _cos_pitch;
+        _sin_roll = temp.c.y * inv_cos_pitch;
     }
 
     // sanity checks
-    if (yaw_vector.is_inf() || yaw_vector.is_nan()) {
+    if (!(yaw_length_sq > 0) || yaw_vector.is_inf() || yaw_vector.is_nan()) {
         yaw_vector.x = 0.0f;
         yaw_vector.y = 0.0f;
         _sin_yaw = 0.0f;
@@ -270,11 +276,11 @@ void AP_AHRS::update_trig(void)
     }
 
     if (isinf(_cos_roll) || isnan(_cos_roll)) {
-        _cos_roll = cosf(roll);
+        _cos_roll = ap_cosf(roll);
     }
 
     if (isinf(_sin_roll) || isnan(_sin_roll)) {
-        _sin_roll = sinf(roll);
+        _sin_roll = ap_sinf(roll);
     }
 }
 
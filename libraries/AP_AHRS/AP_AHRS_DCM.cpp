@@ -208,7 +208,7 @@ AP_AHRS_DCM::renorm(Vector3f const &a, Vector3f &result)
     // we don't want to compound the error by making DCM less
     // accurate.
 
-    renorm_val = 1.0f / a.length();
+    renorm_val = ap_inv_sqrtf(a.length_squared());
 
     // keep the average for reporting
     _renorm_val_sum += renorm_val;
@@ -432,7 +432,7 @@ AP_AHRS_DCM::drift_correction_yaw(void)
             new_value = true;
             float gps_course_rad = ToRad(_gps.ground_course_cd() * 0.01f);
             float yaw_error_rad = wrap_PI(gps_course_rad - yaw);
-            yaw_error = sinf(yaw_error_rad);
+            yaw_error = ap_sinf(yaw_error_rad);
 
             /* reset yaw to match GPS heading under any of the
                following 3 conditions:
@@ -731,10 +731,10 @@ AP_AHRS_DCM::drift_correction(float deltat)
     float tilt = pythagorous2(GA_e.x, GA_e.y);
 
     // equation 11
-    float theta = atan2f(GA_b[besti].y, GA_b[besti].x);
+    float theta = ap_atan2f(GA_b[besti].y, GA_b[besti].x);
 
     // equation 12
-    Vector3f GA_e2 = Vector3f(cosf(theta)*tilt, sinf(theta)*tilt, GA_e.z);
+    Vector3f GA_e2 = Vector3f(ap_cosf(theta)*tilt, ap_sinf(theta)*tilt, GA_e.z);
 
     // step 6
     error = GA_b[besti] % GA_e2;
@@ -900,7 +900,11 @@ AP_AHRS_DCM::euler_angles(void)
 {
     _body_dcm_matrix = _dcm_matrix;
     _body_dcm_matrix.rotateXYinv(_trim);
-    _body_dcm_matrix.to_euler(&roll, &pitch, &yaw);
+
+    // same as Matrix3f::to_euler(), but using the build selected trig
+    pitch = -ap_safe_asin(_body_dcm_matrix.c.x);
+    roll  = ap_atan2f(_body_dcm_matrix.c.y, _body_dcm_matrix.c.z);
+    yaw   = ap_atan2f(_body_dcm_matrix.b.x, _body_dcm_matrix.a.x);
 
     update_cd_values();
 }
@@ -24,6 +24,11 @@
 
 #if AP_AHRS_NAVEKF_AVAILABLE
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <unistd.h>
+#include <stdio.h>
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 // return the smoothed gyro vector corrected for drift
@@ -59,8 +64,192 @@ void AP_AHRS_NavEKF::reset_gyro_drift(void)
     AP_AHRS_DCM::reset_gyro_drift();
 
     // reset the EKF gyro bias states
-    EKF.resetGyroBias();
+    for (uint8_t i=0; i<num_cores; i++) {
+        ekf_core[i]->resetGyroBias();
+    }
+}
+
+/*
+  allocate EKF instances to IMU lanes. With EKF_IMU_MASK of zero we
+  run a single instance that blends the first two IMUs
+ */
+void AP_AHRS_NavEKF::setup_cores(void)
+{
+    num_cores = 0;
+    primary_core = 0;
+    uint8_t imu_mask = EKF.getIMUMask();
+    for (uint8_t i=0; i<_ins.get_gyro_count() && num_cores < AP_AHRS_NAVEKF_MAX_CORES; i++) {
+        if (imu_mask & (1U<<i)) {
+            if (ekf_core[num_cores] == NULL) {
+                ekf_core[num_cores] = new NavEKF(this, _baro, _rng);
+                if (ekf_core[num_cores] == NULL) {
+                    hal.console->printf("Failed to allocate EKF instance for IMU %u\n", (unsigned)i);
+                    break;
+                }
+            }
+            ekf_core[num_cores]->setIMUIndex(i);
+            num_cores++;
+        }
+    }
+    if (num_cores == 0) {
+        EKF.setIMUIndex(-1);
+        num_cores = 1;
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    start_core_threads();
+#endif
+}
+
+// initialise all EKF instances
+bool AP_AHRS_NavEKF::initialise_cores(bool bootstrap)
+{
+    bool ret = true;
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (i > 0) {
+            ekf_core[i]->copyParameters(EKF);
+        }
+        if (bootstrap) {
+            ret = ekf_core[i]->InitialiseFilterBootstrap() && ret;
+        } else {
+            ret = ekf_core[i]->InitialiseFilterDynamic() && ret;
+        }
+    }
+    return ret;
+}
+
+// run a filter update on all EKF instances
+void AP_AHRS_NavEKF::update_cores(void)
+{
+    for (uint8_t i=1; i<num_cores; i++) {
+        ekf_core[i]->copyParameters(EKF);
+    }
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // kick off the threaded instances, then run the rest here
+    for (uint8_t i=1; i<num_cores; i++) {
+        if (_core_thread[i].running) {
+            sem_post(&_core_thread[i].start_sem);
+        }
+    }
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (!_core_thread[i].running) {
+            ekf_core[i]->UpdateFilter();
+        }
+    }
+    // wait for the threaded instances so sensor data is not changed under them
+    for (uint8_t i=1; i<num_cores; i++) {
+        if (_core_thread[i].running) {
+            while (sem_wait(&_core_thread[i].done_sem) != 0) ;
+        }
+    }
+#else
+    for (uint8_t i=0; i<num_cores; i++) {
+        ekf_core[i]->UpdateFilter();
+    }
+#endif
+    select_primary_core();
+}
+
+/*
+  choose the primary EKF instance. We only switch away from the
+  current primary if it is unhealthy or is rejecting measurements,
+  and then only to a healthy instance with a clearly lower error score
+ */
+void AP_AHRS_NavEKF::select_primary_core(void)
+{
+    if (num_cores < 2) {
+        primary_core = 0;
+        return;
+    }
+    const NavEKF *primary = ekf_core[primary_core];
+    float primary_score = primary->errorScore();
+    if (primary->healthy() && primary_score <= 1.0f) {
+        return;
+    }
+    uint8_t best = primary_core;
+    float best_score = primary->healthy() ? primary_score - AP_AHRS_NAVEKF_CORE_SWITCH_MARGIN : 1.0e6f;
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (i == primary_core || !ekf_core[i]->healthy()) {
+            continue;
+        }
+        float score = ekf_core[i]->errorScore();
+        if (score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    if (best == primary_core) {
+        return;
+    }
+
+    // record the step in the solution so controllers holding a
+    // position or heading can shift their targets with it
+    Vector3f old_pos, new_pos, old_eulers, new_eulers;
+    primary->getPosNED(old_pos);
+    ekf_core[best]->getPosNED(new_pos);
+    primary->getEulerAngles(old_eulers);
+    ekf_core[best]->getEulerAngles(new_eulers);
+    _core_switch_pos_step = new_pos - old_pos;
+    _core_switch_yaw_step = wrap_PI(new_eulers.z - old_eulers.z);
+    _core_switch_count++;
+    primary_core = best;
+}
+
+// return the EKF instance running on the given IMU
+const NavEKF *AP_AHRS_NavEKF::core_for_imu(uint8_t imu) const
+{
+    for (uint8_t i=0; i<num_cores; i++) {
+        if (ekf_core[i]->getIMUIndex() == imu) {
+            return ekf_core[i];
+        }
+    }
+    return NULL;
+}
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+/*
+  thread body for a secondary EKF instance. Each update is started by
+  the main thread and the main thread waits for it to complete
+ */
+void *AP_AHRS_NavEKF::_core_thread_main(void *arg)
+{
+    struct core_thread *ct = (struct core_thread *)arg;
+    while (true) {
+        while (sem_wait(&ct->start_sem) != 0) ;
+        ct->ahrs->ekf_core[ct->core]->UpdateFilter();
+        sem_post(&ct->done_sem);
+    }
+    return NULL;
+}
+
+/*
+  start threads for the secondary EKF instances if we have more than
+  one CPU core available. Threads inherit the realtime priority of the
+  main thread. If a thread can't be created that instance is run in
+  the main thread instead
+ */
+void AP_AHRS_NavEKF::start_core_threads(void)
+{
+    bool use_threads = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    for (uint8_t i=1; i<num_cores; i++) {
+        struct core_thread &ct = _core_thread[i];
+        if (!use_threads || ct.running) {
+            continue;
+        }
+        ct.ahrs = this;
+        ct.core = i;
+        sem_init(&ct.start_sem, 0, 0);
+        sem_init(&ct.done_sem, 0, 0);
+        if (pthread_create(&ct.ctx, NULL, &AP_AHRS_NavEKF::_core_thread_main, &ct) != 0) {
+            hal.console->printf("Failed to create EKF thread %u\n", (unsigned)i);
+            continue;
+        }
+        ct.running = true;
+        char name[16];
+        snprintf(name, sizeof(name), "ahrs-ekf%u", (unsigned)i);
+        pthread_setname_np(ct.ctx, name);
+    }
 }
+#endif // CONFIG_HAL_BOARD
 
 void AP_AHRS_NavEKF::update(void)
 {
@@ -83,15 +272,19 @@ void AP_AHRS_NavEKF::update(void)
             start_time_ms = hal.scheduler->millis();
         }
         if (hal.scheduler->millis() - start_time_ms > startup_delay_ms) {
-            ekf_started = EKF.InitialiseFilterDynamic();
+            if (num_cores == 0) {
+                setup_cores();
+            }
+            ekf_started = initialise_cores(false);
         }
     }
     if (ekf_started) {
-        EKF.UpdateFilter();
-        EKF.getRotationBodyToNED(_dcm_matrix);
+        update_cores();
+        const NavEKF &ekf = get_NavEKF_const();
+        ekf.getRotationBodyToNED(_dcm_matrix);
         if (using_EKF()) {
             Vector3f eulers;
-            EKF.getEulerAngles(eulers);
+            ekf.getEulerAngles(eulers);
             roll  = eulers.x;
             pitch = eulers.y;
             yaw   = eulers.z;
@@ -100,30 +293,44 @@ void AP_AHRS_NavEKF::update(void)
             update_trig();
 
             // keep _gyro_bias for get_gyro_drift()
-            EKF.getGyroBias(_gyro_bias);
+            ekf.getGyroBias(_gyro_bias);
             _gyro_bias = -_gyro_bias;
 
             // calculate corrected gryo estimate for get_gyro()
-            _gyro_estimate.zero();
-            uint8_t healthy_count = 0;    
-            for (uint8_t i=0; i<_ins.get_gyro_count(); i++) {
-                if (_ins.get_gyro_health(i) && healthy_count < 2) {
-                    _gyro_estimate += _ins.get_gyro(i);
-                    healthy_count++;
+            int8_t imu_index = ekf.getIMUIndex();
+            if (imu_index >= 0) {
+                // the primary EKF is only using one IMU
+                _gyro_estimate = _ins.get_gyro(imu_index);
+            } else {
+                _gyro_estimate.zero();
+                uint8_t healthy_count = 0;    
+                for (uint8_t i=0; i<_ins.get_gyro_count(); i++) {
+                    if (_ins.get_gyro_health(i) && healthy_count < 2) {
+                        _gyro_estimate += _ins.get_gyro(i);
+                        healthy_count++;
+                    }
+                }
+                if (healthy_count > 1) {
+                    _gyro_estimate /= healthy_count;
                 }
-            }
-            if (healthy_count > 1) {
-                _gyro_estimate /= healthy_count;
             }
             _gyro_estimate += _gyro_bias;
 
             float abias1, abias2;
-            EKF.getAccelZBias(abias1, abias2);
+            ekf.getAccelZBias(abias1, abias2);
 
             // update _accel_ef_ekf
             for (uint8_t i=0; i<_ins.get_accel_count(); i++) {
                 Vector3f accel = _ins.get_accel(i);
-                if (i==0) {
+                if (imu_index >= 0) {
+                    // each IMU lane has its own bias estimate
+                    const NavEKF *lane_ekf = core_for_imu(i);
+                    if (lane_ekf != NULL) {
+                        float lane_abias1, lane_abias2;
+                        lane_ekf->getAccelZBias(lane_abias1, lane_abias2);
+                        accel.z -= lane_abias1;
+                    }
+                } else if (i==0) {
                     accel.z -= abias1;
                 } else if (i==1) {
                     accel.z -= abias2;
@@ -133,9 +340,11 @@ void AP_AHRS_NavEKF::update(void)
                 }
             }
 
-            if(_ins.get_accel_health(0) && _ins.get_accel_health(1)) {
+            if (imu_index >= 0) {
+                _accel_ef_ekf_blended = _accel_ef_ekf[imu_index];
+            } else if(_ins.get_accel_health(0) && _ins.get_accel_health(1)) {
                 float IMU1_weighting;
-                EKF.getIMU1Weighting(IMU1_weighting);
+                ekf.getIMU1Weighting(IMU1_weighting);
                 _accel_ef_ekf_blended = _accel_ef_ekf[0] * IMU1_weighting + _accel_ef_ekf[1] * (1.0f-IMU1_weighting);
             } else {
                 _accel_ef_ekf_blended = _accel_ef_ekf[0];
@@ -166,7 +375,7 @@ void AP_AHRS_NavEKF::reset(bool recover_eulers)
 {
     AP_AHRS_DCM::reset(recover_eulers);
     if (ekf_started) {
-        ekf_started = EKF.InitialiseFilterBootstrap();        
+        ekf_started = initialise_cores(true);
     }
 }
 
@@ -175,7 +384,7 @@ void AP_AHRS_NavEKF::reset_attitude(const float &_roll, const float &_pitch, con
 {
     AP_AHRS_DCM::reset_attitude(_roll, _pitch, _yaw);
     if (ekf_started) {
-        ekf_started = EKF.InitialiseFilterBootstrap();        
+        ekf_started = initialise_cores(true);
     }
 }
 
@@ -183,7 +392,7 @@ void AP_AHRS_NavEKF::reset_attitude(const float &_roll, const float &_pitch, con
 bool AP_AHRS_NavEKF::get_position(struct Location &loc) const
 {
     Vector3f ned_pos;
-    if (using_EKF() && EKF.getLLH(loc) && EKF.getPosNED(ned_pos)) {
+    if (using_EKF() && get_NavEKF_const().getLLH(loc) && get_NavEKF_const().getPosNED(ned_pos)) {
         // fixup altitude using relative position from AHRS home, not
         // EKF origin
         loc.alt = get_home().alt - ned_pos.z*100;
@@ -212,7 +421,7 @@ Vector3f AP_AHRS_NavEKF::wind_estimate(void)
         return AP_AHRS_DCM::wind_estimate();
     }
     Vector3f wind;
-    EKF.getWind(wind);
+    get_NavEKF_const().getWind(wind);
     return wind;
 }
 
@@ -227,7 +436,7 @@ bool AP_AHRS_NavEKF::airspeed_estimate(float *airspeed_ret) const
 bool AP_AHRS_NavEKF::use_compass(void)
 {
     if (using_EKF()) {
-        return EKF.use_compass();
+        return get_NavEKF_const().use_compass();
     }
     return AP_AHRS_DCM::use_compass();
 }
@@ -243,7 +452,7 @@ bool AP_AHRS_NavEKF::get_secondary_attitude(Vector3f &eulers)
     }
     if (ekf_started) {
         // EKF is secondary
-        EKF.getEulerAngles(eulers);
+        get_NavEKF_const().getEulerAngles(eulers);
         return true;
     }
     // no secondary available
@@ -260,7 +469,7 @@ bool AP_AHRS_NavEKF::get_secondary_position(struct Location &loc)
     }    
     if (ekf_started) {
         // EKF is secondary
-        EKF.getLLH(loc);
+        get_NavEKF_const().getLLH(loc);
         return true;
     }
     // no secondary available
@@ -274,7 +483,7 @@ Vector2f AP_AHRS_NavEKF::groundspeed_vector(void)
         return AP_AHRS_DCM::groundspeed_vector();
     }
     Vector3f vec;
-    EKF.getVelNED(vec);
+    get_NavEKF_const().getVelNED(vec);
     return Vector2f(vec.x, vec.y);
 }
 
@@ -294,7 +503,7 @@ bool AP_AHRS_NavEKF::have_inertial_nav(void) const
 bool AP_AHRS_NavEKF::get_velocity_NED(Vector3f &vec) const
 {
     if (using_EKF()) {
-        EKF.getVelNED(vec);
+        get_NavEKF_const().getVelNED(vec);
         return true;
     }
     return false;
@@ -305,7 +514,7 @@ bool AP_AHRS_NavEKF::get_velocity_NED(Vector3f &vec) const
 bool AP_AHRS_NavEKF::get_relative_position_NED(Vector3f &vec) const
 {
     if (using_EKF()) {
-        return EKF.getPosNED(vec);
+        return get_NavEKF_const().getPosNED(vec);
     }
     return false;
 }
@@ -313,11 +522,11 @@ bool AP_AHRS_NavEKF::get_relative_position_NED(Vector3f &vec) const
 bool AP_AHRS_NavEKF::using_EKF(void) const
 {
     uint8_t ekf_faults;
-    EKF.getFilterFaults(ekf_faults);
+    get_NavEKF_const().getFilterFaults(ekf_faults);
     // If EKF is started we switch away if it reports unhealthy. This could be due to bad
     // sensor data. If EKF reversion is inhibited, we only switch across if the EKF encounters
     // an internal processing error, but not for bad sensor data.
-    bool ret = ekf_started && ((_ekf_use == EKF_USE_WITH_FALLBACK && EKF.healthy()) || (_ekf_use == EKF_USE_WITHOUT_FALLBACK && ekf_faults == 0));
+    bool ret = ekf_started && ((_ekf_use == EKF_USE_WITH_FALLBACK && get_NavEKF_const().healthy()) || (_ekf_use == EKF_USE_WITHOUT_FALLBACK && ekf_faults == 0));
     if (!ret) {
         return false;
     }
@@ -325,7 +534,7 @@ bool AP_AHRS_NavEKF::using_EKF(void) const
     if (_vehicle_class == AHRS_VEHICLE_FIXED_WING ||
         _vehicle_class == AHRS_VEHICLE_GROUND) {
         nav_filter_status filt_state;
-        EKF.getFilterStatus(filt_state);
+        get_NavEKF_const().getFilterStatus(filt_state);
         if (hal.util->get_soft_armed() && !filt_state.flags.using_gps && _gps.status() >= AP_GPS::GPS_OK_FIX_3D) {
             // if the EKF is not fusing GPS and we have a 3D lock, then
             // plane and rover would prefer to use the GPS position from
@@ -356,7 +565,7 @@ bool AP_AHRS_NavEKF::healthy(void) const
     // sensor data. If EKF reversion is inhibited, we only switch across if the EKF encounters
     // an internal processing error, but not for bad sensor data.
     if (_ekf_use != EKF_DO_NOT_USE) {
-        bool ret = ekf_started && EKF.healthy();
+        bool ret = ekf_started && get_NavEKF_const().healthy();
         if (!ret) {
             return false;
         }
@@ -389,26 +598,35 @@ bool AP_AHRS_NavEKF::initialised(void) const
 // write optical flow data to EKF
 void  AP_AHRS_NavEKF::writeOptFlowMeas(uint8_t &rawFlowQuality, Vector2f &rawFlowRates, Vector2f &rawGyroRates, uint32_t &msecFlowMeas)
 {
-    EKF.writeOptFlowMeas(rawFlowQuality, rawFlowRates, rawGyroRates, msecFlowMeas);
+    for (uint8_t i=0; i<num_cores; i++) {
+        ekf_core[i]->writeOptFlowMeas(rawFlowQuality, rawFlowRates, rawGyroRates, msecFlowMeas);
+    }
 }
 
 // inhibit GPS useage
 uint8_t AP_AHRS_NavEKF::setInhibitGPS(void)
 {
-    return EKF.setInhibitGPS();
+    uint8_t ret = 0;
+    for (uint8_t i=0; i<num_cores; i++) {
+        uint8_t core_ret = ekf_core[i]->setInhibitGPS();
+        if (i == primary_core) {
+            ret = core_ret;
+        }
+    }
+    return ret;
 }
 
 // get speed limit
 void AP_AHRS_NavEKF::getEkfControlLimits(float &ekfGndSpdLimit, float &ekfNavVelGainScaler)
 {
-    EKF.getEkfControlLimits(ekfGndSpdLimit,ekfNavVelGainScaler);
+    get_NavEKF().getEkfControlLimits(ekfGndSpdLimit,ekfNavVelGainScaler);
 }
 
 // get compass offset estimates
 // true if offsets are valid
 bool AP_AHRS_NavEKF::getMagOffsets(Vector3f &magOffsets)
 {
-    bool status = EKF.getMagOffsets(magOffsets);
+    bool status = get_NavEKF().getMagOffsets(magOffsets);
     return status;
 }
 
@@ -30,6 +30,21 @@
 #define AP_AHRS_NAVEKF_AVAILABLE 1
 #define AP_AHRS_NAVEKF_SETTLE_TIME_MS 20000     // time in milliseconds the ekf needs to settle after being started
 
+// boards with enough memory can run an independent EKF on each IMU
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_1000
+#define AP_AHRS_NAVEKF_MAX_CORES 3
+#else
+#define AP_AHRS_NAVEKF_MAX_CORES 1
+#endif
+
+// an EKF instance must beat the primary instance's error score by this margin before we switch to it
+#define AP_AHRS_NAVEKF_CORE_SWITCH_MARGIN 0.3f
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
 class AP_AHRS_NavEKF : public AP_AHRS_DCM
 {
 public:
@@ -37,10 +52,21 @@ public:
     AP_AHRS_NavEKF(AP_InertialSensor &ins, AP_Baro &baro, AP_GPS &gps, RangeFinder &rng) :
     AP_AHRS_DCM(ins, baro, gps),
         EKF(this, baro, rng),
+        _rng(rng),
         ekf_started(false),
         startup_delay_ms(1000),
-        start_time_ms(0)
+        start_time_ms(0),
+        num_cores(0),
+        primary_core(0),
+        _core_switch_count(0),
+        _core_switch_yaw_step(0)
         {
+            // the secondary instances are only allocated if EKF_IMU_MASK asks for them
+            memset(ekf_core, 0, sizeof(ekf_core));
+            ekf_core[0] = &EKF;
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+            memset(_core_thread, 0, sizeof(_core_thread));
+#endif
         }
 
     // return the smoothed gyro vector corrected for drift
@@ -77,8 +103,24 @@ public:
     // true if compass is being used
     bool use_compass(void);
 
-    NavEKF &get_NavEKF(void) { return EKF; }
-    const NavEKF &get_NavEKF_const(void) const { return EKF; }
+    // return the EKF instance currently selected as the primary navigation solution
+    NavEKF &get_NavEKF(void) { return *ekf_core[primary_core]; }
+    const NavEKF &get_NavEKF_const(void) const { return *ekf_core[primary_core]; }
+
+    // return the EKF instance that owns the EKF_ parameters
+    NavEKF &get_NavEKF_params(void) { return EKF; }
+
+    // return the number of EKF instances being run and the index of the primary instance
+    uint8_t get_NavEKF_core_count(void) const { return num_cores; }
+    uint8_t get_NavEKF_primary_core(void) const { return primary_core; }
+
+    // return the number of times the primary EKF instance has changed,
+    // and the step in position (NED, m) and yaw (rad) at the last change
+    uint8_t get_NavEKF_core_switch(Vector3f &pos_step, float &yaw_step) const {
+        pos_step = _core_switch_pos_step;
+        yaw_step = _core_switch_yaw_step;
+        return _core_switch_count;
+    }
 
     // return secondary attitude solution if available, as eulers in radians
     bool get_secondary_attitude(Vector3f &eulers);
@@ -127,7 +169,24 @@ public:
 private:
     bool using_EKF(void) const;
 
+    // allocate EKF instances to IMU lanes according to EKF_IMU_MASK
+    void setup_cores(void);
+
+    // initialise all EKF instances, returning true if they all initialised
+    bool initialise_cores(bool bootstrap);
+
+    // run a filter update on all EKF instances
+    void update_cores(void);
+
+    // choose the healthiest EKF instance as the primary
+    void select_primary_core(void);
+
+    // return the EKF instance running on the given IMU, or NULL if there is none
+    const NavEKF *core_for_imu(uint8_t imu) const;
+
     NavEKF EKF;
+    const RangeFinder &_rng;
+    NavEKF *ekf_core[AP_AHRS_NAVEKF_MAX_CORES];
     bool ekf_started;
     Matrix3f _dcm_matrix;
     Vector3f _dcm_attitude;
@@ -137,6 +196,27 @@ private:
     Vector3f _accel_ef_ekf_blended;
     const uint16_t startup_delay_ms;
     uint32_t start_time_ms;
+    uint8_t num_cores;
+    uint8_t primary_core;
+    uint8_t _core_switch_count;
+    Vector3f _core_switch_pos_step;
+    float _core_switch_yaw_step;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    // secondary EKF instances are updated on their own threads when
+    // the board has spare CPU cores
+    struct core_thread {
+        AP_AHRS_NavEKF *ahrs;
+        uint8_t core;
+        bool running;
+        pthread_t ctx;
+        sem_t start_sem;
+        sem_t done_sem;
+    } _core_thread[AP_AHRS_NAVEKF_MAX_CORES];
+
+    static void *_core_thread_main(void *arg);
+    void start_core_threads(void);
+#endif
 };
 #endif
 
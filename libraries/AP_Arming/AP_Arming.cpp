@@ -131,6 +131,12 @@ bool AP_Arming::ins_checks(bool report)
     if ((checks_to_perform & ARMING_CHECK_ALL) ||
         (checks_to_perform & ARMING_CHECK_INS)) {
         const AP_InertialSensor &ins = ahrs.get_ins();
+        if (ins.calibrating()) {
+            if (report) {
+                gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: Accel calibration running"));
+            }
+            return false;
+        }
         if (! ins.get_gyro_health_all()) {
             if (report) {
                 gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: gyros not healthy!"));
@@ -242,6 +248,16 @@ bool AP_Arming::compass_checks(bool report)
             return false;
         }
 
+#if COMPASS_CAL_ENABLED
+        // don't arm while an onboard calibration is running
+        if (_compass.is_calibrating()) {
+            if (report) {
+                gcs_send_text_P(SEVERITY_HIGH,PSTR("PreArm: Compass calibration running"));
+            }
+            return false;
+        }
+#endif
+
         // check for unreasonable compass offsets
         Vector3f offsets = _compass.get_offsets();
         if (offsets.length() > 600) {
@@ -197,7 +197,10 @@ AP_Baro_MS5611::AP_Baro_MS5611(AP_Baro &baro, AP_SerialBus *serial, bool use_tim
     _serial->sem_give();
 
     if (_use_timer) {
-        hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Baro_MS5611::_timer, void));
+        // _timer() limits itself to 100Hz, call it often enough that
+        // it doesn't miss a conversion
+        hal.scheduler->register_bus_process(FUNCTOR_BIND_MEMBER(&AP_Baro_MS5611::_timer, void),
+                                            _serial->get_semaphore(), 2000);
     }
 }
 
@@ -32,6 +32,9 @@ public:
 
     /** Release the internal semaphore for this device. */
     virtual void sem_give() = 0;
+
+    /** Semaphore of the bus the device is on, valid after init() */
+    virtual AP_HAL::Semaphore *get_semaphore() = 0;
 };
 
 /** SPI serial device. */
@@ -47,6 +50,7 @@ public:
     bool sem_take_nonblocking();
     bool sem_take_blocking();
     void sem_give();
+    AP_HAL::Semaphore *get_semaphore() { return _spi_sem; }
 
 private:
     enum AP_HAL::SPIDevice _device;
@@ -67,6 +71,7 @@ public:
     bool sem_take_nonblocking();
     bool sem_take_blocking();
     void sem_give();
+    AP_HAL::Semaphore *get_semaphore() { return _i2c_sem; }
 
 private:
     uint8_t _addr;
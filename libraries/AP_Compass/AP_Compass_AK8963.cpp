@@ -438,7 +438,9 @@ bool AP_Compass_AK8963::init()
     _compass_instance = register_compass();    
 
     hal.scheduler->resume_timer_procs();
-    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_Compass_AK8963::_update, void));
+    // _update() limits itself to 100Hz
+    hal.scheduler->register_bus_process(FUNCTOR_BIND_MEMBER(&AP_Compass_AK8963::_update, void),
+                                        _backend->get_semaphore(), 2000);
 
     _start_conversion();
 
@@ -31,6 +31,10 @@ void AP_Compass_Backend::publish_field(const Vector3f &mag, uint8_t instance)
         state.field.rotate((enum Rotation)state.orientation.get());
     }
 
+#if COMPASS_CAL_ENABLED
+    _compass._calibrator[instance].new_sample(state.field);
+#endif
+
     apply_corrections(state.field, instance);
 
     state.last_update_ms = hal.scheduler->millis();
@@ -47,7 +51,7 @@ uint8_t AP_Compass_Backend::register_compass(void) const
 }    
 
 /*
-  apply offset and motor compensation corrections
+  apply offset, soft iron and motor compensation corrections
  */
 void AP_Compass_Backend::apply_corrections(Vector3f &mag, uint8_t i)
 {
@@ -60,6 +64,16 @@ void AP_Compass_Backend::apply_corrections(Vector3f &mag, uint8_t i)
       being applied so it can be logged correctly
      */
     mag += offsets;
+
+    const Vector3f &diagonals = state.diagonals.get();
+    if (!diagonals.is_zero()) {
+        const Vector3f &offdiagonals = state.offdiagonals.get();
+        Matrix3f mat(diagonals.x,    offdiagonals.x, offdiagonals.y,
+                     offdiagonals.x, diagonals.y,    offdiagonals.z,
+                     offdiagonals.y, offdiagonals.z, diagonals.z);
+        mag = mat * mag;
+    }
+
     if(_compass._motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && !is_zero(_compass._thr_or_curr)) {
         state.motor_offset = mot * _compass._thr_or_curr;
         mag += state.motor_offset;
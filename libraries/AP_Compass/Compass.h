@@ -9,6 +9,7 @@
 #include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
 #include <AP_HAL.h>
 #include "AP_Compass_Backend.h"
+#include "CompassCalibrator.h"
 
 // compass product id
 #define AP_COMPASS_TYPE_UNKNOWN         0x00
@@ -43,6 +44,9 @@
 #define COMPASS_MAX_BACKEND   1   
 #endif
 
+// onboard calibration needs room for the samples and time for the fit
+#define COMPASS_CAL_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+
 class Compass
 {
 friend class AP_Compass_Backend;
@@ -137,6 +141,37 @@ public:
     // learn offsets accessor
     bool learn_offsets_enabled() const { return _learn; }
 
+    /// Sets and saves the soft iron corrections
+    ///
+    /// @param  i                   compass instance
+    /// @param  diagonals           diagonal terms of the correction matrix
+    /// @param  offdiagonals        xy, xz and yz terms of the correction matrix
+    ///
+    void set_and_save_soft_iron(uint8_t i, const Vector3f &diagonals, const Vector3f &offdiagonals);
+
+#if COMPASS_CAL_ENABLED
+    /// Onboard calibration. Samples are taken as the vehicle is
+    /// rotated, and the fit is done a slice at a time by
+    /// compass_cal_update(), which should be called at 50Hz
+    ///
+    /// @param  retry               start again if the first attempt fails
+    /// @param  autosave            save the result without waiting for accept_calibration()
+    /// @param  delay_sec           time to wait before taking samples
+    ///
+    bool start_calibration(uint8_t i, bool retry=false, bool autosave=false, float delay_sec=0.0f);
+    bool start_calibration_all(bool retry=false, bool autosave=false, float delay_sec=0.0f);
+    void cancel_calibration(uint8_t i);
+    void cancel_calibration_all(void);
+
+    /// save the result of a successful calibration
+    bool accept_calibration(uint8_t i);
+
+    bool is_calibrating(void) const;
+    void compass_cal_update(void);
+
+    const CompassCalibrator &get_calibrator(uint8_t i) const { return _calibrator[i]; }
+#endif
+
     /// Perform automatic offset updates
     ///
     void learn_offsets(void);
@@ -292,6 +327,16 @@ private:
     // throttle expressed as a percentage from 0 ~ 1.0 or current expressed in amps
     float       _thr_or_curr;
 
+#if COMPASS_CAL_ENABLED
+    CompassCalibrator _calibrator[COMPASS_MAX_INSTANCES];
+
+    // bitmask of calibrations whose results have been saved
+    uint8_t     _cal_saved;
+
+    // RMS fit residual a calibration must beat
+    AP_Float    _calibration_threshold;
+#endif
+
     struct mag_state {
         AP_Int8     external;
         bool        healthy;
@@ -309,6 +354,11 @@ private:
         uint8_t     mag_history_index;
         Vector3i    mag_history[_mag_history_size];
 
+        // soft iron correction matrix. All zero diagonals means no
+        // correction
+        AP_Vector3f diagonals;
+        AP_Vector3f offdiagonals;
+
         // factors multiplied by throttle and added to compass outputs
         AP_Vector3f motor_compensation;
 
@@ -0,0 +1,444 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include <matrixN.h>
+#include <stdlib.h>
+#include "CompassCalibrator.h"
+
+extern const AP_HAL::HAL& hal;
+
+// number of samples processed in each call to update() while fitting
+#define COMPASS_CAL_SAMPLES_PER_SLICE   100
+
+// passes over the samples made by each fit
+#define COMPASS_CAL_SPHERE_ITERATIONS       10
+#define COMPASS_CAL_ELLIPSOID_ITERATIONS    20
+
+// fail if no new sample is accepted for this long, either because
+// the compass has stopped or the vehicle is no longer being rotated
+#define COMPASS_CAL_SAMPLE_TIMEOUT_MS   30000
+
+CompassCalibrator::CompassCalibrator() :
+    _status(COMPASS_CAL_NOT_STARTED),
+    _retry(false),
+    _autosave(false),
+    _delay_sec(0),
+    _start_time_ms(0),
+    _last_sample_ms(0),
+    _tolerance(COMPASS_CAL_DEFAULT_TOLERANCE),
+    _sample_buffer(NULL),
+    _samples_collected(0),
+    _fitness(0),
+    _lambda(1),
+    _fit_step(0),
+    _num_params(0),
+    _pass_index(0),
+    _pass_sum(0)
+{
+}
+
+void CompassCalibrator::start(bool retry, bool autosave, float delay_sec)
+{
+    clear();
+    _retry = retry;
+    _autosave = autosave;
+    _delay_sec = delay_sec;
+    _start_time_ms = hal.scheduler->millis();
+    set_status(COMPASS_CAL_WAITING_TO_START);
+}
+
+void CompassCalibrator::clear()
+{
+    set_status(COMPASS_CAL_NOT_STARTED);
+}
+
+void CompassCalibrator::get_calibration(Vector3f &offsets, Vector3f &diagonals, Vector3f &offdiagonals) const
+{
+    offsets = _params.offset;
+    diagonals = _params.diag;
+    offdiagonals = _params.offdiag;
+}
+
+float CompassCalibrator::get_completion_percent() const
+{
+    // collecting samples is most of the time taken, so progress is
+    // shown by how full the sample buffer is. Step two starts with half
+    // the samples thrown away
+    switch (_status) {
+    case COMPASS_CAL_RUNNING_STEP_ONE:
+        return 50.0f * _samples_collected / COMPASS_CAL_NUM_SAMPLES;
+    case COMPASS_CAL_RUNNING_STEP_TWO:
+        return 100.0f * _samples_collected / COMPASS_CAL_NUM_SAMPLES;
+    case COMPASS_CAL_SUCCESS:
+        return 100.0f;
+    default:
+        return 0.0f;
+    }
+}
+
+void CompassCalibrator::set_status(enum compass_cal_status_t status)
+{
+    switch (status) {
+    case COMPASS_CAL_WAITING_TO_START:
+        _params.radius = 200;
+        _params.offset.zero();
+        _params.diag = Vector3f(1,1,1);
+        _params.offdiag.zero();
+        _fitness = 0;
+        _samples_collected = 0;
+        if (_sample_buffer == NULL) {
+            _sample_buffer = (Vector3f *)calloc(COMPASS_CAL_NUM_SAMPLES, sizeof(Vector3f));
+            if (_sample_buffer == NULL) {
+                _status = COMPASS_CAL_FAILED;
+                return;
+            }
+        }
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_ONE:
+        _num_params = 0;
+        _last_sample_ms = hal.scheduler->millis();
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_TWO:
+        thin_samples();
+        _num_params = 0;
+        _last_sample_ms = hal.scheduler->millis();
+        break;
+
+    case COMPASS_CAL_FAILED:
+        if (_retry) {
+            // one more go, starting straight away
+            _retry = false;
+            _delay_sec = 0;
+            set_status(COMPASS_CAL_WAITING_TO_START);
+            return;
+        }
+        free(_sample_buffer);
+        _sample_buffer = NULL;
+        break;
+
+    case COMPASS_CAL_NOT_STARTED:
+    case COMPASS_CAL_SUCCESS:
+        free(_sample_buffer);
+        _sample_buffer = NULL;
+        break;
+    }
+    _status = status;
+}
+
+void CompassCalibrator::new_sample(const Vector3f &sample)
+{
+    if (!running()) {
+        return;
+    }
+    if (_samples_collected < COMPASS_CAL_NUM_SAMPLES && accept_sample(sample)) {
+        _sample_buffer[_samples_collected++] = sample;
+        _last_sample_ms = hal.scheduler->millis();
+    }
+}
+
+void CompassCalibrator::update()
+{
+    uint32_t tnow = hal.scheduler->millis();
+
+    if (_status == COMPASS_CAL_WAITING_TO_START) {
+        if (tnow - _start_time_ms > _delay_sec*1000) {
+            set_status(COMPASS_CAL_RUNNING_STEP_ONE);
+        }
+        return;
+    }
+
+    if (!running()) {
+        return;
+    }
+
+    if (_samples_collected < COMPASS_CAL_NUM_SAMPLES) {
+        if (tnow - _last_sample_ms > COMPASS_CAL_SAMPLE_TIMEOUT_MS) {
+            set_status(COMPASS_CAL_FAILED);
+        }
+        return;
+    }
+
+    if (_num_params == 0) {
+        fit_start();
+        return;
+    }
+
+    if (!fit_step()) {
+        return;
+    }
+
+    if (!fit_acceptable()) {
+        set_status(COMPASS_CAL_FAILED);
+    } else if (_status == COMPASS_CAL_RUNNING_STEP_ONE) {
+        set_status(COMPASS_CAL_RUNNING_STEP_TWO);
+    } else {
+        set_status(COMPASS_CAL_SUCCESS);
+    }
+}
+
+/*
+  only take samples that are well away from those we already have, so
+  the samples end up spread over the whole sphere rather than bunched
+  where the vehicle happened to be held longest
+ */
+bool CompassCalibrator::accept_sample(const Vector3f &sample) const
+{
+    // randomly placed discs stop fitting on a sphere at around half
+    // its area, so the spacing is that of a hexagonal packing of twice
+    // the number of samples we want
+    static const float theta = sqrtf((4.0f*PI) / (1.7320508f * COMPASS_CAL_NUM_SAMPLES));
+
+    // the radius is a low guess at the field strength until the
+    // sphere fit has found it. The length of the raw sample can't be
+    // used as it includes the unknown offsets
+    float min_distance = 2.0f * _params.radius * sinf(theta * 0.5f);
+
+    for (uint16_t i=0; i<_samples_collected; i++) {
+        if ((sample - _sample_buffer[i]).length() < min_distance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  throw away every other sample. The first samples were spread around
+  an unknown centre, so this makes room for ones spread around the
+  centre from the sphere fit
+ */
+void CompassCalibrator::thin_samples()
+{
+    for (uint16_t i=1; i<_samples_collected/2; i++) {
+        _sample_buffer[i] = _sample_buffer[2*i];
+    }
+    _samples_collected /= 2;
+}
+
+void CompassCalibrator::fit_start()
+{
+    if (_status == COMPASS_CAL_RUNNING_STEP_ONE) {
+        // start the sphere fit from the centre of the samples
+        Vector3f sum;
+        for (uint16_t i=0; i<_samples_collected; i++) {
+            sum += _sample_buffer[i];
+        }
+        _params.offset = -sum / _samples_collected;
+        float radius_sum = 0;
+        for (uint16_t i=0; i<_samples_collected; i++) {
+            radius_sum += (_sample_buffer[i] + _params.offset).length();
+        }
+        _params.radius = radius_sum / _samples_collected;
+        _num_params = COMPASS_CAL_NUM_SPHERE_PARAMS;
+    } else {
+        // the ellipsoid fit starts from the sphere fit
+        _num_params = COMPASS_CAL_NUM_ELLIPSOID_PARAMS;
+    }
+    _candidate = _params;
+    _fitness = FLT_MAX;
+    _lambda = 1.0f;
+    _fit_step = 0;
+    _pass_index = 0;
+    _pass_sum = 0;
+    memset(_jtj, 0, sizeof(_jtj));
+    memset(_jtfi, 0, sizeof(_jtfi));
+}
+
+bool CompassCalibrator::fit_step()
+{
+    // accumulate the normal equations for the next slice of samples
+    uint16_t end = min(_pass_index + COMPASS_CAL_SAMPLES_PER_SLICE, _samples_collected);
+    float jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    for (; _pass_index < end; _pass_index++) {
+        const Vector3f &sample = _sample_buffer[_pass_index];
+        float resid = calc_residual(sample, _candidate);
+        if (_num_params == COMPASS_CAL_NUM_SPHERE_PARAMS) {
+            calc_sphere_jacobian(sample, _candidate, jacob);
+        } else {
+            calc_ellipsoid_jacobian(sample, _candidate, jacob);
+        }
+        _pass_sum += resid * resid;
+        for (uint8_t i=0; i<_num_params; i++) {
+            _jtfi[i] += jacob[i] * resid;
+            for (uint8_t j=0; j<_num_params; j++) {
+                _jtj[i][j] += jacob[i] * jacob[j];
+            }
+        }
+    }
+    if (_pass_index < _samples_collected) {
+        return false;
+    }
+
+    // end of a pass. Keep the candidate if it is the best fit yet and
+    // move towards Gauss-Newton, otherwise move towards gradient descent
+    float fitness = _pass_sum / _samples_collected;
+    if (!isnan(fitness) && fitness < _fitness) {
+        _params = _candidate;
+        _fitness = fitness;
+        memcpy(_best_jtj, _jtj, sizeof(_jtj));
+        memcpy(_best_jtfi, _jtfi, sizeof(_jtfi));
+        _lambda *= 0.1f;
+    } else {
+        _lambda *= 10.0f;
+    }
+
+    _fit_step++;
+    uint8_t iterations = _num_params == COMPASS_CAL_NUM_SPHERE_PARAMS ?
+        COMPASS_CAL_SPHERE_ITERATIONS : COMPASS_CAL_ELLIPSOID_ITERATIONS;
+    if (_fit_step >= iterations) {
+        return true;
+    }
+
+    fit_solve();
+    _pass_index = 0;
+    _pass_sum = 0;
+    memset(_jtj, 0, sizeof(_jtj));
+    memset(_jtfi, 0, sizeof(_jtfi));
+    return false;
+}
+
+/*
+  solve (JtJ + lambda*diag(JtJ)) * delta = -Jt*residual for the step
+  from the best parameters to the next candidate. Unused rows of the
+  sphere fit are left as identity so they give a zero step
+ */
+void CompassCalibrator::fit_solve()
+{
+    MatrixN<float,COMPASS_CAL_NUM_ELLIPSOID_PARAMS,COMPASS_CAL_NUM_ELLIPSOID_PARAMS> A;
+    float delta[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+
+    A.identity();
+    memset(delta, 0, sizeof(delta));
+    for (uint8_t i=0; i<_num_params; i++) {
+        for (uint8_t j=0; j<_num_params; j++) {
+            A[i][j] = _best_jtj[i][j];
+        }
+        A[i][i] += _lambda * _best_jtj[i][i];
+        delta[i] = -_best_jtfi[i];
+    }
+
+    _candidate = _params;
+    if (!A.solve(delta)) {
+        return;
+    }
+
+    // the sphere parameters start with the radius, the ellipsoid ones
+    // with the offsets
+    uint8_t first = _num_params == COMPASS_CAL_NUM_SPHERE_PARAMS ? 0 : 1;
+    for (uint8_t i=0; i<_num_params; i++) {
+        if (isnan(delta[i]) || isinf(delta[i])) {
+            _candidate = _params;
+            return;
+        }
+        _candidate.get(first+i) += delta[i];
+    }
+}
+
+/*
+  residual for one sample is the difference between the fitted field
+  strength and the length of the corrected sample
+ */
+float CompassCalibrator::calc_residual(const Vector3f &sample, const param_t &params) const
+{
+    Matrix3f softiron(params.diag.x,    params.offdiag.x, params.offdiag.y,
+                      params.offdiag.x, params.diag.y,    params.offdiag.z,
+                      params.offdiag.y, params.offdiag.z, params.diag.z);
+    return params.radius - (softiron * (sample + params.offset)).length();
+}
+
+/*
+  derivatives of the residual with respect to the radius and offsets
+ */
+void CompassCalibrator::calc_sphere_jacobian(const Vector3f &sample, const param_t &params, float *ret) const
+{
+    Matrix3f softiron(params.diag.x,    params.offdiag.x, params.offdiag.y,
+                      params.offdiag.x, params.diag.y,    params.offdiag.z,
+                      params.offdiag.y, params.offdiag.z, params.diag.z);
+    Vector3f A = softiron * (sample + params.offset);
+    float length = A.length();
+    if (is_zero(length)) {
+        memset(ret, 0, COMPASS_CAL_NUM_SPHERE_PARAMS*sizeof(float));
+        return;
+    }
+    // softiron is symmetric, so this is its transpose times A
+    Vector3f dofs = softiron * A / -length;
+
+    ret[0] = 1.0f;
+    ret[1] = dofs.x;
+    ret[2] = dofs.y;
+    ret[3] = dofs.z;
+}
+
+/*
+  derivatives of the residual with respect to the offsets, diagonals
+  and off-diagonals
+ */
+void CompassCalibrator::calc_ellipsoid_jacobian(const Vector3f &sample, const param_t &params, float *ret) const
+{
+    Matrix3f softiron(params.diag.x,    params.offdiag.x, params.offdiag.y,
+                      params.offdiag.x, params.diag.y,    params.offdiag.z,
+                      params.offdiag.y, params.offdiag.z, params.diag.z);
+    Vector3f v = sample + params.offset;
+    Vector3f A = softiron * v;
+    float length = A.length();
+    if (is_zero(length)) {
+        memset(ret, 0, COMPASS_CAL_NUM_ELLIPSOID_PARAMS*sizeof(float));
+        return;
+    }
+    Vector3f dofs = softiron * A / -length;
+
+    ret[0] = dofs.x;
+    ret[1] = dofs.y;
+    ret[2] = dofs.z;
+    ret[3] = -A.x * v.x / length;
+    ret[4] = -A.y * v.y / length;
+    ret[5] = -A.z * v.z / length;
+    ret[6] = -(A.x * v.y + A.y * v.x) / length;
+    ret[7] = -(A.x * v.z + A.z * v.x) / length;
+    ret[8] = -(A.y * v.z + A.z * v.y) / length;
+}
+
+/*
+  check the fit gives a plausible compass. The RMS residual is only
+  checked on the final ellipsoid fit
+ */
+bool CompassCalibrator::fit_acceptable() const
+{
+    if (_params.radius < 150 || _params.radius > 950) {
+        return false;
+    }
+    if (fabsf(_params.offset.x) > 1000 ||
+        fabsf(_params.offset.y) > 1000 ||
+        fabsf(_params.offset.z) > 1000) {
+        return false;
+    }
+    if (_params.diag.x < 0.2f || _params.diag.x > 5.0f ||
+        _params.diag.y < 0.2f || _params.diag.y > 5.0f ||
+        _params.diag.z < 0.2f || _params.diag.z > 5.0f) {
+        return false;
+    }
+    if (fabsf(_params.offdiag.x) > 1.0f ||
+        fabsf(_params.offdiag.y) > 1.0f ||
+        fabsf(_params.offdiag.z) > 1.0f) {
+        return false;
+    }
+    if (_status == COMPASS_CAL_RUNNING_STEP_TWO && get_fitness() > _tolerance) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,166 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  onboard compass calibrator
+
+  Collects raw field samples spread evenly over the sphere of
+  directions while the vehicle is rotated, then fits an ellipsoid to
+  them with Levenberg-Marquardt. The corrected field is
+
+    field = M * (raw + offsets)
+
+  where M is symmetric with the diagonals on its diagonal and the
+  off-diagonals (xy, xz, yz) off it. The fit is done in two steps. The
+  first fits a sphere to find the offsets and field strength, and the
+  second throws away half the samples, collects new ones spread
+  around the now known centre and fits the full ellipsoid.
+
+  All the work is done from update() in small slices, so a
+  calibration can run in the background of the main loop without
+  holding it up.
+ */
+
+#ifndef __COMPASS_CALIBRATOR_H__
+#define __COMPASS_CALIBRATOR_H__
+
+#include <AP_Math.h>
+
+#define COMPASS_CAL_NUM_SPHERE_PARAMS       4
+#define COMPASS_CAL_NUM_ELLIPSOID_PARAMS    9
+#define COMPASS_CAL_NUM_SAMPLES             300
+#define COMPASS_CAL_DEFAULT_TOLERANCE       5.0f    // milligauss RMS
+
+enum compass_cal_status_t {
+    COMPASS_CAL_NOT_STARTED=0,
+    COMPASS_CAL_WAITING_TO_START=1,
+    COMPASS_CAL_RUNNING_STEP_ONE=2,
+    COMPASS_CAL_RUNNING_STEP_TWO=3,
+    COMPASS_CAL_SUCCESS=4,
+    COMPASS_CAL_FAILED=5
+};
+
+class CompassCalibrator {
+public:
+    CompassCalibrator();
+
+    // start collecting samples after delay_sec. With retry set a
+    // failed fit starts again instead of giving up
+    void start(bool retry, bool autosave, float delay_sec);
+
+    // stop and free the sample buffer
+    void clear();
+
+    // do the next slice of work. Call at 10Hz or more
+    void update();
+
+    // offer a new raw field sample, after board orientation but before
+    // any offsets or scaling
+    void new_sample(const Vector3f &sample);
+
+    // RMS fit residual in milligauss that a fit must beat
+    void set_tolerance(float tolerance) { _tolerance = tolerance; }
+
+    void get_calibration(Vector3f &offsets, Vector3f &diagonals, Vector3f &offdiagonals) const;
+
+    bool running() const {
+        return _status == COMPASS_CAL_RUNNING_STEP_ONE || _status == COMPASS_CAL_RUNNING_STEP_TWO;
+    }
+    enum compass_cal_status_t get_status() const { return _status; }
+    bool get_autosave() const { return _autosave; }
+
+    // RMS fit residual in milligauss
+    float get_fitness() const { return safe_sqrt(_fitness); }
+
+    // percentage of the work done, 0 to 100
+    float get_completion_percent() const;
+
+private:
+    struct param_t {
+        float radius;
+        Vector3f offset;
+        Vector3f diag;
+        Vector3f offdiag;
+
+        // parameter i in the order radius, offset, diag, offdiag. The
+        // sphere fit adjusts the first 4 and the ellipsoid fit all but
+        // the radius
+        float &get(uint8_t i) {
+            if (i == 0) {
+                return radius;
+            }
+            Vector3f &v = i < 4 ? offset : (i < 7 ? diag : offdiag);
+            switch ((i-1) % 3) {
+            case 0:  return v.x;
+            case 1:  return v.y;
+            default: return v.z;
+            }
+        }
+    };
+
+    void set_status(enum compass_cal_status_t status);
+
+    bool accept_sample(const Vector3f &sample) const;
+    void thin_samples();
+
+    // start the fit for the current step
+    void fit_start();
+
+    // one slice of the Levenberg-Marquardt fit. Returns true when the
+    // fit has finished
+    bool fit_step();
+
+    float calc_residual(const Vector3f &sample, const param_t &params) const;
+    void calc_sphere_jacobian(const Vector3f &sample, const param_t &params, float *ret) const;
+    void calc_ellipsoid_jacobian(const Vector3f &sample, const param_t &params, float *ret) const;
+
+    // solve for the next candidate from the normal equations of the
+    // best parameters so far
+    void fit_solve();
+
+    bool fit_acceptable() const;
+
+    enum compass_cal_status_t _status;
+
+    bool _retry;
+    bool _autosave;
+    float _delay_sec;
+    uint32_t _start_time_ms;
+    uint32_t _last_sample_ms;
+    float _tolerance;
+
+    Vector3f *_sample_buffer;
+    uint16_t _samples_collected;
+
+    // fit state. Each pass over the samples accumulates the normal
+    // equations and the mean squared residual at the candidate
+    // parameters. At the end of the pass the candidate is kept if it
+    // beat the best so far, and the next candidate is solved for
+    param_t _params;
+    param_t _candidate;
+    float _fitness;             // mean squared residual of _params
+    float _lambda;
+    uint8_t _fit_step;
+    uint8_t _num_params;
+    uint16_t _pass_index;
+    float _pass_sum;
+    float _jtj[COMPASS_CAL_NUM_ELLIPSOID_PARAMS][COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float _jtfi[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float _best_jtj[COMPASS_CAL_NUM_ELLIPSOID_PARAMS][COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+    float _best_jtfi[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+};
+
+#endif // __COMPASS_CALIBRATOR_H__
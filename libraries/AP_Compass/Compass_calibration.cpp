@@ -0,0 +1,97 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#include <AP_HAL.h>
+#include "Compass.h"
+
+/*
+  onboard compass calibration. One CompassCalibrator runs per compass,
+  taking samples from publish_field() in the backends. The fitting
+  work is done here a slice at a time from the vehicle's scheduler
+ */
+
+#if COMPASS_CAL_ENABLED
+
+bool
+Compass::start_calibration(uint8_t i, bool retry, bool autosave, float delay_sec)
+{
+    if (i >= _compass_count || !healthy(i)) {
+        return false;
+    }
+    _cal_saved &= ~(1U<<i);
+    _calibrator[i].set_tolerance(_calibration_threshold);
+    _calibrator[i].start(retry, autosave, delay_sec);
+    return true;
+}
+
+bool
+Compass::start_calibration_all(bool retry, bool autosave, float delay_sec)
+{
+    for (uint8_t i=0; i<_compass_count; i++) {
+        if (!start_calibration(i, retry, autosave, delay_sec)) {
+            cancel_calibration_all();
+            return false;
+        }
+    }
+    return _compass_count != 0;
+}
+
+void
+Compass::cancel_calibration(uint8_t i)
+{
+    if (i < COMPASS_MAX_INSTANCES) {
+        _calibrator[i].clear();
+    }
+}
+
+void
+Compass::cancel_calibration_all(void)
+{
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        cancel_calibration(i);
+    }
+}
+
+bool
+Compass::accept_calibration(uint8_t i)
+{
+    if (i >= COMPASS_MAX_INSTANCES ||
+        _calibrator[i].get_status() != COMPASS_CAL_SUCCESS) {
+        return false;
+    }
+    if (!(_cal_saved & (1U<<i))) {
+        Vector3f offsets, diagonals, offdiagonals;
+        _calibrator[i].get_calibration(offsets, diagonals, offdiagonals);
+        set_and_save_offsets(i, offsets);
+        set_and_save_soft_iron(i, diagonals, offdiagonals);
+        _cal_saved |= (1U<<i);
+    }
+    return true;
+}
+
+bool
+Compass::is_calibrating(void) const
+{
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        switch (_calibrator[i].get_status()) {
+        case COMPASS_CAL_WAITING_TO_START:
+        case COMPASS_CAL_RUNNING_STEP_ONE:
+        case COMPASS_CAL_RUNNING_STEP_TWO:
+            return true;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+void
+Compass::compass_cal_update(void)
+{
+    for (uint8_t i=0; i<_compass_count; i++) {
+        _calibrator[i].update();
+        if (_calibrator[i].get_autosave()) {
+            accept_calibration(i);
+        }
+    }
+}
+
+#endif // COMPASS_CAL_ENABLED
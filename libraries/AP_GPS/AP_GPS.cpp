@@ -106,6 +106,15 @@ const AP_Param::GroupInfo AP_GPS::var_info[] PROGMEM = {
     AP_GROUPINFO("RAW_DATA", 9, AP_GPS, _raw_data, 0),
 #endif
 
+    // @Param: RATE_MS
+    // @DisplayName: GPS update rate in milliseconds
+    // @Description: Controls how often the GPS should provide a position update. Lowering below 5Hz (200ms) is not allowed. Rates above 5Hz need a receiver that supports them, such as a uBlox M8 for 10Hz, and are currently only set on uBlox receivers.
+    // @Units: milliseconds
+    // @Values: 200:5Hz,100:10Hz,50:20Hz
+    // @Range: 50 200
+    // @User: Advanced
+    AP_GROUPINFO("RATE_MS", 10, AP_GPS, _rate_ms, 200),
+
     AP_GROUPEND
 };
 
@@ -130,6 +139,34 @@ const uint32_t AP_GPS::_baudrates[] PROGMEM = {4800U, 38400U, 115200U, 57600U, 9
 // right mode
 const prog_char AP_GPS::_initialisation_blob[] PROGMEM = UBLOX_SET_BINARY MTK_SET_BINARY SIRF_SET_BINARY;
 
+// number of bytes without any protocol sync sequence after which the
+// baud rate is taken to be wrong and the next one is tried
+#define GPS_DETECT_NOSYNC_BYTES 200
+
+/*
+  return true if b0 followed by b1 could be the start of a message in
+  one of the supported protocols. At the wrong baud rate the GPS data
+  arrives as noise where these are rare, so seeing none of them lets
+  detection move to the next baud rate without waiting for the timeout
+ */
+static bool gps_sync_pair(uint8_t b0, uint8_t b1)
+{
+    switch (b0) {
+    case 0xB5:      // uBlox and MTK
+        return b1 == 0x62;
+    case 0xD0:      // MTK19
+    case 0xD1:
+        return b1 == 0xDD;
+    case 0xA0:      // SiRF
+        return b1 == 0xA2;
+    case '$':       // NMEA
+        return b1 == 'G';
+    case 0x55:      // SBP, followed by the low byte of the message type
+        return b1 < 0x20 || b1 == 0xFF;
+    }
+    return false;
+}
+
 /*
   send some more initialisation string bytes if there is room in the
   UART transmit buffer
@@ -202,8 +239,10 @@ AP_GPS::detect_instance(uint8_t instance)
         dstate->detect_started_ms = now;
     }
 
-    if (now - dstate->last_baud_change_ms > 1200) {
-        // try the next baud rate
+    if (now - dstate->last_baud_change_ms > 1200 ||
+        (dstate->bytes_at_baud >= GPS_DETECT_NOSYNC_BYTES && !dstate->sync_seen)) {
+        // try the next baud rate, either because nothing was detected
+        // or because what is arriving is not GPS data at this rate
 		dstate->last_baud++;
 		if (dstate->last_baud == sizeof(_baudrates) / sizeof(_baudrates[0])) {
 			dstate->last_baud = 0;
@@ -212,6 +251,8 @@ AP_GPS::detect_instance(uint8_t instance)
 		_port[instance]->begin(baudrate);
 		_port[instance]->set_flow_control(AP_HAL::UARTDriver::FLOW_CONTROL_DISABLE);
 		dstate->last_baud_change_ms = now;
+        dstate->bytes_at_baud = 0;
+        dstate->sync_seen = false;
         send_blob_start(instance, _initialisation_blob, sizeof(_initialisation_blob));
     }
 
@@ -219,6 +260,15 @@ AP_GPS::detect_instance(uint8_t instance)
 
     while (_port[instance]->available() > 0 && new_gps == NULL) {
         uint8_t data = _port[instance]->read();
+        if (!dstate->sync_seen) {
+            dstate->sync_seen = gps_sync_pair(dstate->last_byte, data);
+            dstate->last_byte = data;
+            dstate->bytes_at_baud++;
+            if (!dstate->sync_seen && dstate->bytes_at_baud >= GPS_DETECT_NOSYNC_BYTES) {
+                // leave the rest for the next baud rate
+                break;
+            }
+        }
         /*
           running a uBlox at less than 38400 will lead to packet
           corruption, as we can't receive the packets in the 200ms
@@ -346,13 +396,60 @@ AP_GPS::update_instance(uint8_t instance)
             state[instance].instance = instance;
             state[instance].status = NO_GPS;
             timing[instance].last_message_time_ms = tnow;
+            // start detection again at the baud rate the GPS was
+            // found at, as it is most likely to come back there
+            detect_state[instance].last_baud_change_ms = tnow;
+            detect_state[instance].bytes_at_baud = 0;
+            detect_state[instance].sync_seen = false;
+            timing[instance].tov_offset_valid = false;
         }
     } else {
         timing[instance].last_message_time_ms = tnow;
         if (state[instance].status >= GPS_OK_FIX_2D) {
             timing[instance].last_fix_time_ms = tnow;
         }
+        update_fix_tov(instance, tnow);
+    }
+}
+
+/*
+  estimate the system time a new fix was valid at from its GPS time of
+  week. The difference between the receive time and the time of week
+  is a fixed clock offset plus the delivery delay, which varies with
+  message scheduling in the receiver, the UART and how long the bytes
+  wait before they are parsed. The smallest difference seen recently
+  is taken as the offset for the lowest delay, so adding it to the
+  time of week gives a fix time free of that jitter
+ */
+void
+AP_GPS::update_fix_tov(uint8_t instance, uint32_t tnow)
+{
+    GPS_timing &t = timing[instance];
+    const GPS_State &s = state[instance];
+
+    if (s.status < GPS_OK_FIX_2D || s.time_week_ms == t.last_time_week_ms) {
+        // no new GPS time to go on, so the fix can only be taken as
+        // valid when it was received
+        t.last_fix_tov_ms = tnow;
+        return;
+    }
+    t.last_time_week_ms = s.time_week_ms;
+
+    uint32_t offset = tnow - s.time_week_ms;
+    int32_t excess = (int32_t)(offset - t.tov_offset_ms);
+    if (!t.tov_offset_valid || excess < 0 || excess > 1000) {
+        // a new lowest delay, or a jump in GPS time such as a week
+        // rollover or a receiver restart
+        t.tov_offset_ms = offset;
+        t.tov_offset_update_ms = tnow;
+        t.tov_offset_valid = true;
+    } else if (tnow - t.tov_offset_update_ms > 1000) {
+        // let the offset creep up by 1ms a second so it can follow a
+        // system clock that runs fast against GPS time
+        t.tov_offset_ms++;
+        t.tov_offset_update_ms = tnow;
     }
+    t.last_fix_tov_ms = s.time_week_ms + t.tov_offset_ms;
 }
 
 /*
@@ -429,6 +526,7 @@ AP_GPS::setHIL(uint8_t instance, GPS_Status _status, uint64_t time_epoch_ms,
     istate.time_week_ms  = gps_time_ms - istate.time_week*(86400*7*(uint64_t)1000);
     timing[instance].last_message_time_ms = tnow;
     timing[instance].last_fix_time_ms = tnow;
+    timing[instance].last_fix_tov_ms = tnow;
     _type[instance].set(GPS_TYPE_HIL);
 }
 
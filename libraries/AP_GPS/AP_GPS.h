@@ -296,6 +296,17 @@ public:
         return last_message_time_ms(primary_instance);
     }
 
+    // the estimated system time in milliseconds at which the last fix
+    // was valid. This removes the varying delay between the GPS
+    // measurement and the fix being parsed, leaving only the fixed
+    // latency of the receiver for the user of the fix to allow for
+    uint32_t last_fix_tov_ms(uint8_t instance) const {
+        return _GPS_TIMING(instance).last_fix_tov_ms;
+    }
+    uint32_t last_fix_tov_ms(void) const {
+        return last_fix_tov_ms(primary_instance);
+    }
+
     // return last fix time since the 1/1/1970 in microseconds
     uint64_t time_epoch_usec(uint8_t instance);
     uint64_t time_epoch_usec(void) { 
@@ -335,6 +346,7 @@ public:
     AP_Int8 _sbas_mode;
     AP_Int8 _min_elevation;
     AP_Int8 _raw_data;
+    AP_Int16 _rate_ms;
     
     // handle sending of initialisation strings to the GPS
     void send_blob_start(uint8_t instance, const prog_char *_blob, uint16_t size);
@@ -367,6 +379,17 @@ private:
 
         // the time we got our last fix in system milliseconds
         uint32_t last_message_time_ms;
+
+        // estimated system time the last fix was valid at
+        uint32_t last_fix_tov_ms;
+
+        // GPS time of week of the last fix, and the smallest recent
+        // difference between the system time a fix was received at
+        // and its GPS time of week
+        uint32_t last_time_week_ms;
+        uint32_t tov_offset_ms;
+        uint32_t tov_offset_update_ms;
+        bool tov_offset_valid;
     };
     GPS_timing timing[GPS_MAX_INSTANCES];
     GPS_State state[GPS_MAX_INSTANCES];
@@ -387,6 +410,9 @@ private:
         uint32_t detect_started_ms;
         uint32_t last_baud_change_ms;
         uint8_t last_baud;
+        uint16_t bytes_at_baud;     // bytes received since the last baud rate change
+        uint8_t last_byte;          // previous byte, for matching two byte sync sequences
+        bool sync_seen;             // a protocol sync sequence has been seen at this baud rate
         struct UBLOX_detect_state ublox_detect_state;
         struct MTK_detect_state mtk_detect_state;
         struct MTK19_detect_state mtk19_detect_state;
@@ -407,6 +433,7 @@ private:
 
     void detect_instance(uint8_t instance);
     void update_instance(uint8_t instance);
+    void update_fix_tov(uint8_t instance, uint32_t tnow);
 };
 
 #include <GPS_Backend.h>
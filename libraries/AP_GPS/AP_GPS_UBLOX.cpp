@@ -67,7 +67,7 @@ AP_GPS_UBLOX::AP_GPS_UBLOX(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UART
     _disable_counter(0),
     next_fix(AP_GPS::NO_FIX),
     rate_update_step(0),
-    _last_5hz_time(0),
+    _last_rate_time(0),
     _last_hw_status(0)
 {
     // stop any config strings that are pending
@@ -93,15 +93,20 @@ AP_GPS_UBLOX::send_next_rate_update(void)
 
     //hal.console->printf_P(PSTR("next_rate: %u\n"), (unsigned)rate_update_step);
 
+    // messages we don't need with every solution are kept at about
+    // their 5Hz rates, so that at 20Hz the solution messages still
+    // fit in the bandwidth of a 38400 baud link
+    uint8_t rate_div = 200 / _navigation_rate_ms();
+
     switch (rate_update_step++) {
     case 0:
-        _configure_navigation_rate(200);
+        _configure_navigation_rate(_navigation_rate_ms());
         break;
     case 1:
         _configure_message_rate(CLASS_NAV, MSG_POSLLH, 1); // 28+8 bytes
         break;
     case 2:
-        _configure_message_rate(CLASS_NAV, MSG_STATUS, 1); // 16+8 bytes
+        _configure_message_rate(CLASS_NAV, MSG_STATUS, rate_div); // 16+8 bytes
         break;
     case 3:
         _configure_message_rate(CLASS_NAV, MSG_SOL, 1);    // 52+8 bytes
@@ -112,11 +117,11 @@ AP_GPS_UBLOX::send_next_rate_update(void)
 #if UBLOX_HW_LOGGING
     case 5:
         // gather MON_HW at 0.5Hz
-        _configure_message_rate(CLASS_MON, MSG_MON_HW, 2); // 64+8 bytes
+        _configure_message_rate(CLASS_MON, MSG_MON_HW, 2*rate_div); // 64+8 bytes
         break;
     case 6:
         // gather MON_HW2 at 0.5Hz
-        _configure_message_rate(CLASS_MON, MSG_MON_HW2, 2); // 24+8 bytes
+        _configure_message_rate(CLASS_MON, MSG_MON_HW2, 2*rate_div); // 24+8 bytes
         break;
 #endif
 #if UBLOX_VERSION_AUTODETECTION 
@@ -507,11 +512,11 @@ AP_GPS_UBLOX::_parse_gps(void)
         if (next_fix >= AP_GPS::GPS_OK_FIX_2D) {
             state.last_gps_time_ms = hal.scheduler->millis();
             if (state.time_week == _buffer.solution.week &&
-                state.time_week_ms + 200 == _buffer.solution.time) {
-                // we got a 5Hz update. This relies on the way
-                // that uBlox gives timestamps that are always
-                // multiples of 200 for 5Hz
-                _last_5hz_time = state.last_gps_time_ms;
+                state.time_week_ms + _navigation_rate_ms() == _buffer.solution.time) {
+                // we got an update at the configured rate. This
+                // relies on the way that uBlox gives timestamps
+                // that are always multiples of the rate
+                _last_rate_time = state.last_gps_time_ms;
             }
             state.time_week_ms    = _buffer.solution.time;
             state.time_week       = _buffer.solution.week;
@@ -577,13 +582,13 @@ AP_GPS_UBLOX::_parse_gps(void)
     if (_new_position && _new_speed && _last_vel_time == _last_pos_time) {
         _new_speed = _new_position = false;
 		_fix_count++;
-        if ((hal.scheduler->millis() - _last_5hz_time) > 15000U && !need_rate_update) {
+        if ((hal.scheduler->millis() - _last_rate_time) > 15000U && !need_rate_update) {
             // the GPS is running slow. It possibly browned out and
             // restarted with incorrect parameters. We will slowly
             // send out new parameters to fix it
             need_rate_update = true;
             rate_update_step = 0;
-            _last_5hz_time = hal.scheduler->millis();
+            _last_rate_time = hal.scheduler->millis();
         }
 
 		if (_fix_count == 50 && gps._sbas_mode != 2) {
@@ -663,7 +668,7 @@ AP_GPS_UBLOX::_configure_message_rate(uint8_t msg_class, uint8_t msg_id, uint8_t
 }
 
 /*
- *  configure a UBlox GPS navigation solution rate of 200ms
+ *  configure a UBlox GPS navigation solution rate
  */
 void
 AP_GPS_UBLOX::_configure_navigation_rate(uint16_t rate_ms)
@@ -675,6 +680,15 @@ AP_GPS_UBLOX::_configure_navigation_rate(uint16_t rate_ms)
     _send_message(CLASS_CFG, MSG_CFG_RATE, &msg, sizeof(msg));
 }
 
+/*
+ *  the navigation solution interval asked for in GPS_RATE_MS
+ */
+uint16_t
+AP_GPS_UBLOX::_navigation_rate_ms(void) const
+{
+    return constrain_int16(gps._rate_ms, 50, 200);
+}
+
 /*
  *  configure a UBlox GPS for the given message rate
  */
@@ -685,7 +699,7 @@ AP_GPS_UBLOX::_configure_gps(void)
 
     // start the process of updating the GPS rates
     need_rate_update = true;
-    _last_5hz_time = hal.scheduler->millis();
+    _last_rate_time = hal.scheduler->millis();
     rate_update_step = 0;
 
     // ask for the current navigation settings
@@ -319,10 +319,11 @@ private:
     AP_GPS::GPS_Status next_fix;
 
     uint8_t rate_update_step;
-    uint32_t _last_5hz_time;
+    uint32_t _last_rate_time;
     uint32_t _last_hw_status;
 
     void 	    _configure_navigation_rate(uint16_t rate_ms);
+    uint16_t    _navigation_rate_ms(void) const;
     void        _configure_message_rate(uint8_t msg_class, uint8_t msg_id, uint8_t rate);
     void        _configure_gps(void);
     void        _configure_sbas(bool enable);
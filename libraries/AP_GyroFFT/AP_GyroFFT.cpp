@@ -0,0 +1,371 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include "AP_GyroFFT.h"
+
+#if GYRO_FFT_ENABLED
+
+#include <stdlib.h>
+
+extern const AP_HAL::HAL& hal;
+
+const AP_Param::GroupInfo AP_GyroFFT::var_info[] PROGMEM = {
+    // @Param: ENABLE
+    // @DisplayName: Gyro FFT enable
+    // @Description: Enable onboard spectrum analysis of the first gyro. The peak frequencies and band energies are logged and sent to the GCS, and can set the gyro harmonic notch when INS_HNTCH_MODE is 2. Only the first gyro is analysed, and only on Linux and SITL boards, which keep the gyro sample window it needs. This option takes effect on the next reboot
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("ENABLE",  0, AP_GyroFFT, _enable, 0),
+
+    // @Param: WINDOW
+    // @DisplayName: Gyro FFT window size
+    // @Description: Number of gyro samples in each analysis. Larger windows resolve frequencies more finely but take longer to collect and use more memory. Rounded down to a power of two. This option takes effect on the next reboot
+    // @Range: 32 512
+    // @User: Advanced
+    AP_GROUPINFO("WINDOW",  1, AP_GyroFFT, _window_size, 256),
+
+    // @Param: MINHZ
+    // @DisplayName: Gyro FFT minimum frequency
+    // @Description: Lowest frequency searched for a peak. This should be below the lowest motor frequency in flight but above the frequencies of the vehicle's own motion
+    // @Units: Hz
+    // @Range: 10 400
+    // @User: Advanced
+    AP_GROUPINFO("MINHZ",   2, AP_GyroFFT, _min_hz, 40),
+
+    // @Param: MAXHZ
+    // @DisplayName: Gyro FFT maximum frequency
+    // @Description: Highest frequency searched for a peak. Frequencies above half the gyro sample rate can't be seen
+    // @Units: Hz
+    // @Range: 20 4000
+    // @User: Advanced
+    AP_GROUPINFO("MAXHZ",   3, AP_GyroFFT, _max_hz, 400),
+
+    AP_GROUPEND
+};
+
+AP_GyroFFT::AP_GyroFFT(AP_InertialSensor &ins) :
+    _ins(ins),
+    _state(FFT_STATE_IDLE),
+    _n(0),
+    _log2n(0),
+    _sample_rate_hz(0),
+    _samples(NULL),
+    _num_samples(0),
+    _window_drops(0),
+    _re(NULL),
+    _im(NULL),
+    _hann(NULL),
+    _cos(NULL),
+    _sin(NULL),
+    _window_power(0),
+    _axis(0),
+    _stage(0),
+    _weighted_freq(0),
+    _result_ms(0)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+    memset(_work_bands, 0, sizeof(_work_bands));
+    memset(_band_energy, 0, sizeof(_band_energy));
+    memset(_send_index, 0, sizeof(_send_index));
+}
+
+void AP_GyroFFT::init(void)
+{
+    if (!_enable || _state != FFT_STATE_IDLE) {
+        return;
+    }
+
+    // round the window down to a power of two
+    uint16_t size = constrain_int16(_window_size, FFT_MIN_WINDOW_SIZE, FFT_MAX_WINDOW_SIZE);
+    _n = 1;
+    _log2n = 0;
+    while ((_n << 1) <= size) {
+        _n <<= 1;
+        _log2n++;
+    }
+
+    _samples = (Vector3f *)calloc(_n, sizeof(Vector3f));
+    _re = (float *)calloc(_n, sizeof(float));
+    _im = (float *)calloc(_n, sizeof(float));
+    _hann = (float *)calloc(_n, sizeof(float));
+    _cos = (float *)calloc(_n/2, sizeof(float));
+    _sin = (float *)calloc(_n/2, sizeof(float));
+    // the gyro window must hold all the samples that arrive between
+    // calls to update(), which is up to 160 at 8kHz and 50Hz
+    if (_samples == NULL || _re == NULL || _im == NULL || _hann == NULL ||
+        _cos == NULL || _sin == NULL ||
+        !_ins.enable_gyro_window(max(_n, (uint16_t)256))) {
+        free(_samples); _samples = NULL;
+        free(_re); _re = NULL;
+        free(_im); _im = NULL;
+        free(_hann); _hann = NULL;
+        free(_cos); _cos = NULL;
+        free(_sin); _sin = NULL;
+        hal.console->println_P(PSTR("GyroFFT: not enough memory"));
+        return;
+    }
+
+    float sum_sq = 0;
+    for (uint16_t i=0; i<_n; i++) {
+        _hann[i] = 0.5f - 0.5f * cosf(2 * PI * i / _n);
+        sum_sq += sq(_hann[i]);
+    }
+    for (uint16_t i=0; i<_n/2; i++) {
+        _cos[i] = cosf(2 * PI * i / _n);
+        _sin[i] = sinf(2 * PI * i / _n);
+    }
+
+    // scales the power in each bin so the bins sum to the mean
+    // square of the windowed signal
+    _window_power = _n * sum_sq;
+
+    _start_window();
+}
+
+void AP_GyroFFT::update(void)
+{
+    switch (_state) {
+    case FFT_STATE_IDLE:
+        break;
+
+    case FFT_STATE_COLLECTING:
+        _collect();
+        break;
+
+    case FFT_STATE_WINDOW:
+        _apply_window();
+        _stage = 1;
+        _state = FFT_STATE_BUTTERFLY;
+        break;
+
+    case FFT_STATE_BUTTERFLY:
+        _butterfly_stage();
+        if (++_stage > _log2n) {
+            _state = FFT_STATE_ANALYSE;
+        }
+        break;
+
+    case FFT_STATE_ANALYSE:
+        _analyse_axis();
+        if (++_axis < 3) {
+            _state = FFT_STATE_WINDOW;
+        } else {
+            _publish();
+            _start_window();
+        }
+        break;
+    }
+}
+
+/*
+  start collecting a new window, throwing away anything that arrived
+  while the last one was being analysed
+ */
+void AP_GyroFFT::_start_window(void)
+{
+    while (_ins.read_gyro_window(_samples, _n) != 0) ;
+    _window_drops = _ins.get_gyro_window_drops();
+    _sample_rate_hz = _ins.get_gyro_window_rate_hz();
+    _num_samples = 0;
+    _state = FFT_STATE_COLLECTING;
+}
+
+/*
+  fill the window with consecutive gyro samples. If any were dropped
+  on the way the window is started again
+ */
+void AP_GyroFFT::_collect(void)
+{
+    if (_ins.get_gyro_window_drops() != _window_drops ||
+        _ins.get_gyro_window_rate_hz() != _sample_rate_hz) {
+        _start_window();
+        return;
+    }
+
+    if (_sample_rate_hz == 0) {
+        return;
+    }
+
+    _num_samples += _ins.read_gyro_window(&_samples[_num_samples], _n - _num_samples);
+    if (_num_samples == _n) {
+        _axis = 0;
+        _state = FFT_STATE_WINDOW;
+    }
+}
+
+/*
+  load one axis into the FFT buffers in bit reversed order, with the
+  mean removed and the Hann window applied
+ */
+void AP_GyroFFT::_apply_window(void)
+{
+    float mean = 0;
+    for (uint16_t i=0; i<_n; i++) {
+        mean += _samples[i][_axis];
+    }
+    mean /= _n;
+
+    for (uint16_t i=0; i<_n; i++) {
+        uint16_t rev = 0;
+        for (uint8_t b=0; b<_log2n; b++) {
+            if (i & (1U<<b)) {
+                rev |= 1U << (_log2n - 1 - b);
+            }
+        }
+        _re[rev] = (_samples[i][_axis] - mean) * _hann[i];
+        _im[rev] = 0;
+    }
+}
+
+/*
+  one stage of a decimation in time radix-2 FFT
+ */
+void AP_GyroFFT::_butterfly_stage(void)
+{
+    const uint16_t span = 1U << _stage;
+    const uint16_t half = span >> 1;
+    const uint16_t step = _n / span;
+
+    for (uint16_t k=0; k<_n; k+=span) {
+        for (uint16_t j=0; j<half; j++) {
+            const float c = _cos[j*step];
+            const float s = _sin[j*step];
+            const uint16_t a = k + j;
+            const uint16_t b = a + half;
+            const float tre = c * _re[b] + s * _im[b];
+            const float tim = c * _im[b] - s * _re[b];
+            _re[b] = _re[a] - tre;
+            _im[b] = _im[a] - tim;
+            _re[a] += tre;
+            _im[a] += tim;
+        }
+    }
+}
+
+/*
+  find the largest peak in the search range and add up the energy
+  in each band
+ */
+void AP_GyroFFT::_analyse_axis(void)
+{
+    const float bin_hz = (float)_sample_rate_hz / _n;
+    const float max_hz = min((float)_max_hz, _sample_rate_hz * 0.5f);
+    const float min_hz = min((float)_min_hz, max_hz - bin_hz);
+    const uint16_t first_bin = max(1, (int16_t)ceilf(min_hz / bin_hz));
+    const uint16_t last_bin = min(_n/2 - 1, (uint16_t)(max_hz / bin_hz));
+
+    if (_axis == 0) {
+        memset(_work_bands, 0, sizeof(_work_bands));
+    }
+    if (first_bin > last_bin) {
+        _work_freq[_axis] = 0;
+        _work_energy[_axis] = 0;
+        return;
+    }
+
+    // the power in each bin is left in _re
+    for (uint16_t k=first_bin-1; k<=last_bin+1; k++) {
+        _re[k] = 2 * (sq(_re[k]) + sq(_im[k])) / _window_power;
+    }
+
+    uint16_t peak_bin = first_bin;
+    for (uint16_t k=first_bin; k<=last_bin; k++) {
+        if (_re[k] > _re[peak_bin]) {
+            peak_bin = k;
+        }
+        uint8_t band = (k * bin_hz - min_hz) * FFT_NUM_BANDS / (max_hz - min_hz);
+        _work_bands[min(band, FFT_NUM_BANDS-1)] += _re[k];
+    }
+
+    // fit a parabola through the peak and its neighbours to get the
+    // frequency between bins
+    const float a = _re[peak_bin-1];
+    const float b = _re[peak_bin];
+    const float c = _re[peak_bin+1];
+    float delta = 0;
+    const float denom = a - 2*b + c;
+    if (!is_zero(denom)) {
+        delta = constrain_float(0.5f * (a - c) / denom, -0.5f, 0.5f);
+    }
+
+    // the Hann window spreads a tone over three bins
+    _work_freq[_axis] = (peak_bin + delta) * bin_hz;
+    _work_energy[_axis] = a + b + c;
+}
+
+void AP_GyroFFT::_publish(void)
+{
+    _peak_freq = _work_freq;
+    _peak_energy = _work_energy;
+    memcpy(_band_energy, _work_bands, sizeof(_band_energy));
+
+    float total = _peak_energy.x + _peak_energy.y + _peak_energy.z;
+    if (total > 0) {
+        _weighted_freq = (_peak_freq.x * _peak_energy.x +
+                          _peak_freq.y * _peak_energy.y +
+                          _peak_freq.z * _peak_energy.z) / total;
+    }
+    _result_ms = hal.scheduler->millis();
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    _ins.set_harmonic_notch_tracked_freq(_weighted_freq);
+#endif
+}
+
+void AP_GyroFFT::send_mavlink(mavlink_channel_t chan)
+{
+    if (!have_result()) {
+        return;
+    }
+    static const char names[FFT_NUM_MAVLINK_VALUES][11] = {
+        "FFT_PkX", "FFT_PkY", "FFT_PkZ",
+        "FFT_EnX", "FFT_EnY", "FFT_EnZ",
+        "FFT_B1", "FFT_B2", "FFT_B3", "FFT_B4"
+    };
+    const float values[FFT_NUM_MAVLINK_VALUES] = {
+        _peak_freq.x, _peak_freq.y, _peak_freq.z,
+        _peak_energy.x, _peak_energy.y, _peak_energy.z,
+        _band_energy[0], _band_energy[1], _band_energy[2], _band_energy[3]
+    };
+    uint8_t &i = _send_index[chan];
+    if (i >= FFT_NUM_MAVLINK_VALUES) {
+        i = 0;
+    }
+    mavlink_msg_named_value_float_send(chan, _result_ms, names[i], values[i]);
+    i++;
+}
+
+void AP_GyroFFT::log_data(DataFlash_Class &dataflash, uint8_t msgid)
+{
+    if (!have_result()) {
+        return;
+    }
+    struct log_GyroFFT pkt = {
+        LOG_PACKET_HEADER_INIT(msgid),
+        time_us  : hal.scheduler->micros64(),
+        freq_x   : _peak_freq.x,
+        freq_y   : _peak_freq.y,
+        freq_z   : _peak_freq.z,
+        energy_x : _peak_energy.x,
+        energy_y : _peak_energy.y,
+        energy_z : _peak_energy.z,
+        band     : { _band_energy[0], _band_energy[1], _band_energy[2], _band_energy[3] }
+    };
+    dataflash.WriteBlock(&pkt, sizeof(pkt));
+}
+
+#endif // GYRO_FFT_ENABLED
@@ -0,0 +1,176 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  onboard spectrum analysis of the first gyro, for vibration
+  monitoring
+
+  Raw gyro samples are taken from the AP_InertialSensor gyro window at
+  the rate the backend reads the sensor. Once a window of samples has
+  been collected a Hann windowed radix-2 FFT is run on each axis in
+  turn. The work is spread over calls to update(), one butterfly stage
+  per call, so the time taken in any one scheduler tick is small.
+
+  For each axis the result is the frequency and energy of the largest
+  peak between FFT_MINHZ and FFT_MAXHZ, and the energy in four equal
+  width bands across that range. The energy weighted peak frequency
+  can be used to place the gyro harmonic notch.
+ */
+
+#ifndef __AP_GYROFFT_H__
+#define __AP_GYROFFT_H__
+
+#include <AP_HAL.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_InertialSensor.h>
+#include <GCS_MAVLink.h>
+#include <DataFlash.h>
+
+// the FFT needs the gyro window, and enough memory and CPU to be
+// worth running
+#define GYRO_FFT_ENABLED INS_GYRO_WINDOW_ENABLED
+
+#define FFT_MIN_WINDOW_SIZE 32
+#define FFT_MAX_WINDOW_SIZE 512
+#define FFT_NUM_BANDS 4
+
+// number of values send_mavlink() cycles through
+#define FFT_NUM_MAVLINK_VALUES (6 + FFT_NUM_BANDS)
+
+class AP_GyroFFT
+{
+public:
+    AP_GyroFFT(AP_InertialSensor &ins);
+
+    // allocate the buffers and ask the INS for gyro samples. Does
+    // nothing if FFT_ENABLE is not set
+    void init(void);
+
+    // run the next step of the analysis. Should be called at 50Hz or
+    // more, depending on the gyro rate and window size
+    void update(void);
+
+    // true once there has been at least one analysis
+    bool have_result(void) const { return _result_ms != 0; }
+
+    // time of the last analysis
+    uint32_t last_result_ms(void) const { return _result_ms; }
+
+    // frequency in Hz of the largest peak on each axis
+    const Vector3f &get_peak_freq(void) const { return _peak_freq; }
+
+    // energy in the largest peak on each axis in (rad/s)^2
+    const Vector3f &get_peak_energy(void) const { return _peak_energy; }
+
+    // energy summed over the three axes in a band in (rad/s)^2
+    float get_band_energy(uint8_t band) const { return _band_energy[band]; }
+
+    // frequency of the axis peaks, weighted by their energy
+    float get_weighted_freq(void) const { return _weighted_freq; }
+
+    // send the next value of the last result as a NAMED_VALUE_FLOAT
+    // message. Each call sends one value, taking the values in turn
+    void send_mavlink(mavlink_channel_t chan);
+
+    // write the last result to the log
+    void log_data(DataFlash_Class &dataflash, uint8_t msgid);
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+    struct PACKED log_GyroFFT {
+        LOG_PACKET_HEADER;
+        uint64_t time_us;
+        float freq_x;
+        float freq_y;
+        float freq_z;
+        float energy_x;
+        float energy_y;
+        float energy_z;
+        float band[FFT_NUM_BANDS];
+    };
+
+private:
+    enum fft_state {
+        FFT_STATE_IDLE=0,
+        FFT_STATE_COLLECTING,
+        FFT_STATE_WINDOW,
+        FFT_STATE_BUTTERFLY,
+        FFT_STATE_ANALYSE
+    };
+
+    AP_InertialSensor &_ins;
+
+    AP_Int8 _enable;
+    AP_Int16 _window_size;
+    AP_Int16 _min_hz;
+    AP_Int16 _max_hz;
+
+    enum fft_state _state;
+
+    // window size in use and its log2
+    uint16_t _n;
+    uint8_t _log2n;
+
+    // gyro sample rate the current window was collected at
+    uint16_t _sample_rate_hz;
+
+    // collected samples, and the number so far
+    Vector3f *_samples;
+    uint16_t _num_samples;
+    uint32_t _window_drops;
+
+    // the FFT of one axis, done in place
+    float *_re;
+    float *_im;
+
+    // Hann window and the twiddle factors for the butterflies
+    float *_hann;
+    float *_cos;
+    float *_sin;
+    float _window_power;
+
+    // progress through the current window
+    uint8_t _axis;
+    uint8_t _stage;
+
+    // results of the axes done so far
+    Vector3f _work_freq;
+    Vector3f _work_energy;
+    float _work_bands[FFT_NUM_BANDS];
+
+    // results of the last complete analysis
+    Vector3f _peak_freq;
+    Vector3f _peak_energy;
+    float _band_energy[FFT_NUM_BANDS];
+    float _weighted_freq;
+    uint32_t _result_ms;
+
+    // next value send_mavlink() sends on each channel
+    uint8_t _send_index[MAVLINK_COMM_NUM_BUFFERS];
+
+    void _start_window(void);
+    void _collect(void);
+    void _apply_window(void);
+    void _butterfly_stage(void);
+    void _analyse_axis(void);
+    void _publish(void);
+};
+
+#define GYRO_FFT_LOG_FORMAT(msg) { msg, sizeof(AP_GyroFFT::log_GyroFFT), \
+                                   "FFT", "Qffffffffff", "TimeUS,PkX,PkY,PkZ,EnX,EnY,EnZ,B1,B2,B3,B4" }
+
+#endif // __AP_GYROFFT_H__
@@ -44,6 +44,20 @@ public:
     virtual void     write(uint8_t ch, uint16_t period_us) = 0;
     virtual void     write(uint8_t ch, uint16_t* period_us, uint8_t len) = 0;
 
+    /*
+      Delay subsequent calls to write() going to the output until
+      push() is called. Backends where each write is a bus transaction
+      can then send all the channels changed in a loop in one burst.
+      Backends that don't need this leave both as no-ops.
+     */
+    virtual void     cork(void) {}
+
+    /*
+      Send all the writes made since cork() to the output, and go back
+      to sending each write as it is made
+     */
+    virtual void     push(void) {}
+
     /* Read back current output state, as either single channel or
      * array of channels. */
     virtual uint16_t read(uint8_t ch) = 0;
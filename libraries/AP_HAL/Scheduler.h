@@ -42,6 +42,35 @@ public:
     // register a low priority IO task
     virtual void     register_io_process(AP_HAL::MemberProc) = 0;
 
+    /*
+      register a task that only talks to the bus protected by bus_sem,
+      to be called every period_us. On HALs with a thread per bus it
+      runs on that thread, so a slow device on one bus doesn't delay
+      devices on another. Otherwise it is a normal timer task, and
+      should do its own rate limiting
+     */
+    virtual void     register_bus_process(AP_HAL::MemberProc proc,
+                                          AP_HAL::Semaphore *bus_sem,
+                                          uint32_t period_us) {
+        register_timer_process(proc);
+    }
+
+    /*
+      queue a one-off transaction on the bus protected by bus_sem. proc
+      is called once from the bus thread, then *done is set if it is
+      not NULL. Returns false if the queue is full. Without bus
+      threads proc is called straight away
+     */
+    virtual bool     queue_bus_transaction(AP_HAL::MemberProc proc,
+                                           AP_HAL::Semaphore *bus_sem,
+                                           volatile bool *done) {
+        proc();
+        if (done != NULL) {
+            *done = true;
+        }
+        return true;
+    }
+
     // suspend and resume both timer and IO processes
     virtual void     suspend_timer_procs() = 0;
     virtual void     resume_timer_procs() = 0;
@@ -32,6 +32,7 @@ namespace Linux {
     class LinuxRCOutput_ZYNQ;
     class LinuxSemaphore;
     class LinuxScheduler;
+    class LinuxBusThread;
     class LinuxUtil;
     class ToneAlarm;					//limit the scope of ToneAlarm driver to Linux_HAL only
 }
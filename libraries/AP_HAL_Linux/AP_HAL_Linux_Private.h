@@ -23,6 +23,7 @@
 #include "RCOutput_ZYNQ.h"
 #include "Semaphores.h"
 #include "Scheduler.h"
+#include "BusThread.h"
 #include "ToneAlarmDriver.h"
 #include "Util.h"
 
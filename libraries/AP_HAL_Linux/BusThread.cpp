@@ -0,0 +1,179 @@
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+
+#include "BusThread.h"
+#include <poll.h>
+#include <time.h>
+
+using namespace Linux;
+
+extern const AP_HAL::HAL& hal;
+
+// longest the thread sleeps with nothing due, so late registrations
+// are picked up
+#define BUS_THREAD_MAX_SLEEP_US 10000
+
+LinuxBusThread::LinuxBusThread() :
+    _bus_sem(NULL),
+    _started(false),
+    _num_periodic(0),
+    _queue_head(0),
+    _queue_count(0)
+{
+    pthread_condattr_t attr;
+
+    pthread_mutex_init(&_queue_lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&_queue_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/*
+  add a proc to be called every period_us
+ */
+bool LinuxBusThread::register_periodic(AP_HAL::MemberProc proc, uint32_t period_us)
+{
+    bool ret = false;
+
+    pthread_mutex_lock(&_queue_lock);
+    for (uint8_t i = 0; i < _num_periodic; i++) {
+        if (_periodic[i].proc == proc) {
+            pthread_mutex_unlock(&_queue_lock);
+            return true;
+        }
+    }
+    if (_num_periodic < LINUX_BUS_THREAD_MAX_PROCS) {
+        _periodic[_num_periodic].proc = proc;
+        _periodic[_num_periodic].period_us = period_us;
+        _periodic[_num_periodic].next_run_us = hal.scheduler->micros64();
+        _num_periodic++;
+        ret = true;
+    }
+    pthread_cond_signal(&_queue_cond);
+    pthread_mutex_unlock(&_queue_lock);
+
+    return ret;
+}
+
+/*
+  queue a one-off transaction, waking the thread to run it
+ */
+bool LinuxBusThread::queue(AP_HAL::MemberProc proc, volatile bool *done)
+{
+    pthread_mutex_lock(&_queue_lock);
+    if (_queue_count >= LINUX_BUS_THREAD_QUEUE_LEN) {
+        pthread_mutex_unlock(&_queue_lock);
+        return false;
+    }
+    uint8_t idx = (_queue_head + _queue_count) % LINUX_BUS_THREAD_QUEUE_LEN;
+    _queue[idx].proc = proc;
+    _queue[idx].done = done;
+    if (done != NULL) {
+        *done = false;
+    }
+    _queue_count++;
+    pthread_cond_signal(&_queue_cond);
+    pthread_mutex_unlock(&_queue_lock);
+
+    return true;
+}
+
+bool LinuxBusThread::is_current_thread() const
+{
+    return _started && pthread_equal(pthread_self(), _thread_ctx);
+}
+
+void LinuxBusThread::_run_periodic(uint64_t now)
+{
+    pthread_mutex_lock(&_queue_lock);
+    uint8_t num_periodic = _num_periodic;
+    pthread_mutex_unlock(&_queue_lock);
+
+    for (uint8_t i = 0; i < num_periodic; i++) {
+        struct periodic_proc &p = _periodic[i];
+        if (now < p.next_run_us) {
+            continue;
+        }
+        p.proc();
+        p.next_run_us += p.period_us;
+        if (p.next_run_us + p.period_us < now) {
+            // we've fallen more than a period behind, don't try to
+            // catch up with a burst of calls
+            p.next_run_us = now + p.period_us;
+        }
+    }
+}
+
+void LinuxBusThread::_run_queue(void)
+{
+    while (true) {
+        pthread_mutex_lock(&_queue_lock);
+        if (_queue_count == 0) {
+            pthread_mutex_unlock(&_queue_lock);
+            return;
+        }
+        struct queued_proc q = _queue[_queue_head];
+        _queue_head = (_queue_head + 1) % LINUX_BUS_THREAD_QUEUE_LEN;
+        _queue_count--;
+        pthread_mutex_unlock(&_queue_lock);
+
+        q.proc();
+        if (q.done != NULL) {
+            *q.done = true;
+        }
+    }
+}
+
+uint64_t LinuxBusThread::_next_deadline(uint64_t now) const
+{
+    uint64_t deadline = now + BUS_THREAD_MAX_SLEEP_US;
+    for (uint8_t i = 0; i < _num_periodic; i++) {
+        if (_periodic[i].next_run_us < deadline) {
+            deadline = _periodic[i].next_run_us;
+        }
+    }
+    return deadline;
+}
+
+void *LinuxBusThread::thread_main(void *arg)
+{
+    LinuxBusThread *bus = (LinuxBusThread *)arg;
+
+    while (hal.scheduler->system_initializing()) {
+        poll(NULL, 0, 1);
+    }
+
+    while (true) {
+        bus->_proc_sem.take(0);
+        bus->_run_queue();
+        bus->_run_periodic(hal.scheduler->micros64());
+        bus->_proc_sem.give();
+
+        /*
+          sleep until the next periodic proc is due, or a transaction
+          is queued. The scheduler clock and CLOCK_MONOTONIC only
+          differ by an offset, so convert via the time left to wait
+         */
+        pthread_mutex_lock(&bus->_queue_lock);
+        uint64_t now = hal.scheduler->micros64();
+        uint64_t deadline = bus->_next_deadline(now);
+        if (bus->_queue_count == 0 && deadline > now) {
+            uint64_t wait_us = deadline - now;
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            ts.tv_sec += wait_us / 1000000ULL;
+            ts.tv_nsec += (wait_us % 1000000ULL) * 1000ULL;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&bus->_queue_cond, &bus->_queue_lock, &ts);
+        }
+        pthread_mutex_unlock(&bus->_queue_lock);
+    }
+    return NULL;
+}
+
+#endif // CONFIG_HAL_BOARD
@@ -0,0 +1,73 @@
+
+#ifndef __AP_HAL_LINUX_BUSTHREAD_H__
+#define __AP_HAL_LINUX_BUSTHREAD_H__
+
+#include <AP_HAL_Boards.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#include <AP_HAL_Linux.h>
+#include "Semaphores.h"
+#include <pthread.h>
+
+#define LINUX_BUS_THREAD_MAX_PROCS 4
+#define LINUX_BUS_THREAD_QUEUE_LEN 8
+
+/*
+  a worker thread owning one SPI or I2C bus. Periodic device reads
+  registered with the scheduler for that bus run here at their own
+  rates, along with one-off transactions queued from other threads, so
+  a slow transfer on one bus doesn't hold up devices on the others
+ */
+class Linux::LinuxBusThread {
+public:
+    LinuxBusThread();
+
+    // the bus semaphore this thread serves, or NULL if unused
+    AP_HAL::Semaphore *bus_semaphore() const { return _bus_sem; }
+    void set_bus_semaphore(AP_HAL::Semaphore *sem) { _bus_sem = sem; }
+
+    bool register_periodic(AP_HAL::MemberProc proc, uint32_t period_us);
+    bool queue(AP_HAL::MemberProc proc, volatile bool *done);
+
+    // held while procs run, so the scheduler can suspend this thread
+    LinuxSemaphore &proc_semaphore() { return _proc_sem; }
+
+    pthread_t *thread_ctx() { return &_thread_ctx; }
+    bool is_current_thread() const;
+
+    static void *thread_main(void *arg);
+
+private:
+    void _run_periodic(uint64_t now);
+    void _run_queue(void);
+    uint64_t _next_deadline(uint64_t now) const;
+
+    AP_HAL::Semaphore *_bus_sem;
+    pthread_t _thread_ctx;
+    bool _started;
+
+    struct periodic_proc {
+        AP_HAL::MemberProc proc;
+        uint32_t period_us;
+        uint64_t next_run_us;
+    } _periodic[LINUX_BUS_THREAD_MAX_PROCS];
+    uint8_t _num_periodic;
+
+    // ring of queued transactions, protected by _queue_lock
+    struct queued_proc {
+        AP_HAL::MemberProc proc;
+        volatile bool *done;
+    } _queue[LINUX_BUS_THREAD_QUEUE_LEN];
+    uint8_t _queue_head;
+    uint8_t _queue_count;
+    pthread_mutex_t _queue_lock;
+    pthread_cond_t _queue_cond;
+
+    LinuxSemaphore _proc_sem;
+
+    friend class Linux::LinuxScheduler;
+};
+
+#endif // CONFIG_HAL_BOARD
+
+#endif // __AP_HAL_LINUX_BUSTHREAD_H__
@@ -49,6 +49,9 @@ void LinuxRCOutput_AioPRU::init(void* machtnicht)
 
    close(mem_fd);
 
+   _pending_mask = 0;
+   _corking = false;
+
    // Reset PRU 1
    *ctrl = 0;
    hal.scheduler->delay(1);
@@ -106,6 +109,11 @@ void LinuxRCOutput_AioPRU::disable_ch(uint8_t ch)
 void LinuxRCOutput_AioPRU::write(uint8_t ch, uint16_t period_us)
 {
    if(ch < PWM_CHAN_COUNT) {
+      if(_corking) {
+         _pending[ch] = TICK_PER_US * period_us;
+         _pending_mask |= 1U << ch;
+         return;
+      }
       pwm->channel[ch].time_high = TICK_PER_US * period_us;
    }
 }
@@ -123,6 +131,30 @@ void LinuxRCOutput_AioPRU::write(uint8_t ch, uint16_t* period_us, uint8_t len)
    }
 }
 
+void LinuxRCOutput_AioPRU::cork(void)
+{
+   _corking = true;
+}
+
+/*
+  copy the pulse widths staged since cork() to the PRU in one pass, so
+  that all the channels change within the same PWM period
+ */
+void LinuxRCOutput_AioPRU::push(void)
+{
+   uint8_t i;
+
+   _corking = false;
+
+   for(i = 0; i < PWM_CHAN_COUNT; i++) {
+      if(_pending_mask & (1U << i)) {
+         pwm->channel[i].time_high = _pending[i];
+      }
+   }
+
+   _pending_mask = 0;
+}
+
 uint16_t LinuxRCOutput_AioPRU::read(uint8_t ch)
 {
    uint16_t ret = 0;
@@ -27,6 +27,8 @@ class Linux::LinuxRCOutput_AioPRU : public AP_HAL::RCOutput {
     void     disable_ch(uint8_t ch);
     void     write(uint8_t ch, uint16_t period_us);
     void     write(uint8_t ch, uint16_t* period_us, uint8_t len);
+    void     cork(void);
+    void     push(void);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
 
@@ -43,6 +45,11 @@ private:
     };
 
     volatile struct pwm *pwm;
+
+   // pulse widths in ticks written while corked
+   uint32_t _pending[PWM_CHAN_COUNT];
+   uint32_t _pending_mask;
+   bool _corking;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_AIOPRU_H__
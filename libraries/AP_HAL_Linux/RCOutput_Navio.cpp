@@ -55,7 +55,9 @@ LinuxRCOutput_Navio::LinuxRCOutput_Navio():
     _i2c_sem(NULL),
     enable_pin(NULL),
     _frequency(50),
-    _pulses_buffer(new uint16_t[PWM_CHAN_COUNT])
+    _pulses_buffer(new uint16_t[PWM_CHAN_COUNT]()),
+    _pending_write_mask(0),
+    _corking(false)
 {
 }
 
@@ -103,9 +105,11 @@ void LinuxRCOutput_Navio::set_freq(uint32_t chmask, uint16_t freq_hz)
 {
 
     /* Correctly finish last pulses */
+    cork();
     for (int i = 0; i < PWM_CHAN_COUNT; i++) {
         write(i, _pulses_buffer[i]);
     }
+    push();
 
     if (!_i2c_sem->take(10)) {
         return;
@@ -156,32 +160,86 @@ void LinuxRCOutput_Navio::write(uint8_t ch, uint16_t period_us)
         return;
     }
 
+    _pulses_buffer[ch] = period_us;
+    _pending_write_mask |= (1U << ch);
+
+    if (!_corking) {
+        push();
+    }
+}
+
+void LinuxRCOutput_Navio::cork(void)
+{
+    _corking = true;
+}
+
+/*
+  send all the pending channels in one auto-incremented write, starting
+  at the first changed channel. Channels in between that have not
+  changed are written again with their current value
+ */
+void LinuxRCOutput_Navio::push(void)
+{
+    _corking = false;
+
+    if (_pending_write_mask == 0) {
+        return;
+    }
+
+    /* if the bus is busy the channels stay pending for the next push */
     if (!_i2c_sem->take_nonblocking()) {
         return;
     }
 
-    uint16_t length;
+    uint8_t min_ch = PWM_CHAN_COUNT;
+    uint8_t max_ch = 0;
+    for (uint8_t ch = 0; ch < PWM_CHAN_COUNT; ch++) {
+        if (_pending_write_mask & (1U << ch)) {
+            if (ch < min_ch) {
+                min_ch = ch;
+            }
+            max_ch = ch;
+        }
+    }
 
-    if (period_us == 0)
-        length = 0;
-    else
-        length = round((period_us * 4096) / (1000000.f / _frequency)) - 1;
+    /* LEDn_ON_L, LEDn_ON_H, LEDn_OFF_L, LEDn_OFF_H for each channel */
+    uint8_t data[PWM_CHAN_COUNT * 4];
+    uint8_t num_bytes = 0;
 
-    uint8_t data[2] = {length & 0xFF, length >> 8};
-    uint8_t status = hal.i2c->writeRegisters(PCA9685_ADDRESS,
-                                             PCA9685_RA_LED0_OFF_L + 4 * (ch + 3),
-                                             2,
-                                             data);
+    for (uint8_t ch = min_ch; ch <= max_ch; ch++) {
+        uint16_t length;
 
-    _pulses_buffer[ch] = period_us;
+        if (_pulses_buffer[ch] == 0)
+            length = 0;
+        else
+            length = round((_pulses_buffer[ch] * 4096) / (1000000.f / _frequency)) - 1;
+
+        data[num_bytes++] = 0;
+        data[num_bytes++] = 0;
+        data[num_bytes++] = length & 0xFF;
+        data[num_bytes++] = length >> 8;
+    }
+
+    hal.i2c->writeRegisters(PCA9685_ADDRESS,
+                            PCA9685_RA_LED0_ON_L + 4 * (min_ch + 3),
+                            num_bytes,
+                            data);
+
+    _pending_write_mask = 0;
 
     _i2c_sem->give();
 }
 
 void LinuxRCOutput_Navio::write(uint8_t ch, uint16_t* period_us, uint8_t len)
 {
+    bool was_corking = _corking;
+
+    cork();
     for (int i = 0; i < len; i++)
         write(ch + i, period_us[i]);
+    if (!was_corking) {
+        push();
+    }
 }
 
 uint16_t LinuxRCOutput_Navio::read(uint8_t ch)
@@ -16,6 +16,8 @@ class Linux::LinuxRCOutput_Navio : public AP_HAL::RCOutput {
     void     disable_ch(uint8_t ch);
     void     write(uint8_t ch, uint16_t period_us);
     void     write(uint8_t ch, uint16_t* period_us, uint8_t len);
+    void     cork(void);
+    void     push(void);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
 
@@ -27,6 +29,10 @@ private:
     uint16_t _frequency;
 
     uint16_t *_pulses_buffer;
+
+    // channels written since the last push to the PCA9685
+    uint16_t _pending_write_mask;
+    bool _corking;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_NAVIO_H__
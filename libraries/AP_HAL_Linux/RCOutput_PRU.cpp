@@ -38,6 +38,9 @@ void LinuxRCOutput_PRU::init(void* machtnicht)
                                             MAP_SHARED, mem_fd, RCOUT_PRUSS_SHAREDRAM_BASE);
     close(mem_fd);
 
+    _pending_mask = 0;
+    _corking = false;
+
     // all outputs default to 50Hz, the top level vehicle code
     // overrides this when necessary
     set_freq(0xFFFFFFFF, 50);
@@ -72,6 +75,14 @@ void LinuxRCOutput_PRU::disable_ch(uint8_t ch)
 
 void LinuxRCOutput_PRU::write(uint8_t ch, uint16_t period_us)
 {
+    if (ch >= PWM_CHAN_COUNT) {
+        return;
+    }
+    if (_corking) {
+        _pending[chan_pru_map[ch]] = TICK_PER_US*period_us;
+        _pending_mask |= 1U<<chan_pru_map[ch];
+        return;
+    }
     sharedMem_cmd->periodhi[chan_pru_map[ch]][1] = TICK_PER_US*period_us;
 }
 
@@ -86,6 +97,27 @@ void LinuxRCOutput_PRU::write(uint8_t ch, uint16_t* period_us, uint8_t len)
     }
 }
 
+void LinuxRCOutput_PRU::cork(void)
+{
+    _corking = true;
+}
+
+/*
+  copy the pulse widths staged since cork() to the PRU in one pass, so
+  that all the channels change within the same PWM period
+ */
+void LinuxRCOutput_PRU::push(void)
+{
+    uint8_t i;
+    _corking = false;
+    for (i=0;i<MAX_PWMS;i++) {
+        if (_pending_mask & (1U<<i)) {
+            sharedMem_cmd->periodhi[i][1] = _pending[i];
+        }
+    }
+    _pending_mask = 0;
+}
+
 uint16_t LinuxRCOutput_PRU::read(uint8_t ch)
 {
     return (sharedMem_cmd->hilo_read[chan_pru_map[ch]][1]/TICK_PER_US);
@@ -23,6 +23,8 @@ class Linux::LinuxRCOutput_PRU : public AP_HAL::RCOutput {
     void     disable_ch(uint8_t ch);
     void     write(uint8_t ch, uint16_t period_us);
     void     write(uint8_t ch, uint16_t* period_us, uint8_t len);
+    void     cork(void);
+    void     push(void);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
 
@@ -39,6 +41,11 @@ private:
     };
     volatile struct pwm_cmd *sharedMem_cmd;
 
+    // pulse widths in ticks written while corked, by PRU channel
+    uint32_t _pending[MAX_PWMS];
+    uint32_t _pending_mask;
+    bool _corking;
+
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_PRU_H__
@@ -34,6 +34,9 @@ void LinuxRCOutput_ZYNQ::init(void* machtnicht)
                                             MAP_SHARED, mem_fd, RCOUT_ZYNQ_PWM_BASE);
     close(mem_fd);
 
+    _pending_mask = 0;
+    _corking = false;
+
     // all outputs default to 50Hz, the top level vehicle code
     // overrides this when necessary
     set_freq(0xFFFFFFFF, 50);
@@ -68,6 +71,14 @@ void LinuxRCOutput_ZYNQ::disable_ch(uint8_t ch)
 
 void LinuxRCOutput_ZYNQ::write(uint8_t ch, uint16_t period_us)
 {
+    if (ch >= PWM_CHAN_COUNT) {
+        return;
+    }
+    if (_corking) {
+        _pending[ch] = TICK_PER_US*period_us;
+        _pending_mask |= 1U<<ch;
+        return;
+    }
     sharedMem_cmd->periodhi[ch].hi = TICK_PER_US*period_us;
 }
 
@@ -82,6 +93,27 @@ void LinuxRCOutput_ZYNQ::write(uint8_t ch, uint16_t* period_us, uint8_t len)
     }
 }
 
+void LinuxRCOutput_ZYNQ::cork(void)
+{
+    _corking = true;
+}
+
+/*
+  copy the pulse widths staged since cork() to the PWM block in one
+  pass, so that all the channels change within the same PWM period
+ */
+void LinuxRCOutput_ZYNQ::push(void)
+{
+    uint8_t i;
+    _corking = false;
+    for (i=0;i<MAX_ZYNQ_PWMS;i++) {
+        if (_pending_mask & (1U<<i)) {
+            sharedMem_cmd->periodhi[i].hi = _pending[i];
+        }
+    }
+    _pending_mask = 0;
+}
+
 uint16_t LinuxRCOutput_ZYNQ::read(uint8_t ch)
 {
     return (sharedMem_cmd->periodhi[ch].hi/TICK_PER_US);
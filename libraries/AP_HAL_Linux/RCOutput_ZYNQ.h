@@ -22,6 +22,8 @@ class Linux::LinuxRCOutput_ZYNQ : public AP_HAL::RCOutput {
     void     disable_ch(uint8_t ch);
     void     write(uint8_t ch, uint16_t period_us);
     void     write(uint8_t ch, uint16_t* period_us, uint8_t len);
+    void     cork(void);
+    void     push(void);
     uint16_t read(uint8_t ch);
     void     read(uint16_t* period_us, uint8_t len);
 
@@ -38,6 +40,11 @@ private:
         struct s_period_hi periodhi[MAX_ZYNQ_PWMS];
     };
     volatile struct pwm_cmd *sharedMem_cmd;
+
+    // pulse widths in ticks written while corked
+    uint32_t _pending[MAX_ZYNQ_PWMS];
+    uint32_t _pending_mask;
+    bool _corking;
 };
 
 #endif // __AP_HAL_LINUX_RCOUTPUT_ZYNQ_H__
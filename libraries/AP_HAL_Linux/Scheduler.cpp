@@ -21,6 +21,7 @@ using namespace Linux;
 extern const AP_HAL::HAL& hal;
 
 #define APM_LINUX_TIMER_PRIORITY        15
+#define APM_LINUX_BUS_PRIORITY          15
 #define APM_LINUX_UART_PRIORITY         14
 #define APM_LINUX_RCIN_PRIORITY         13
 #define APM_LINUX_MAIN_PRIORITY         12
@@ -32,7 +33,8 @@ LinuxScheduler::LinuxScheduler()
 
 void LinuxScheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
                                              const char *name,
-                                             pthread_startroutine_t start_routine)
+                                             pthread_startroutine_t start_routine,
+                                             void *arg)
 {
     struct sched_param param = { .sched_priority = rtprio };
     pthread_attr_t attr;
@@ -49,7 +51,7 @@ void LinuxScheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
         pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
         pthread_attr_setschedparam(&attr, &param);
     }
-    r = pthread_create(ctx, &attr, start_routine, this);
+    r = pthread_create(ctx, &attr, start_routine, arg);
     if (r != 0) {
         hal.console->printf("Error creating thread '%s': %s\n",
                             name, strerror(r));
@@ -111,7 +113,7 @@ void LinuxScheduler::init(void* machtnichts)
 
     for (iter = table; iter->ctx; iter++)
         _create_realtime_thread(iter->ctx, iter->rtprio, iter->name,
-                                iter->start_routine);
+                                iter->start_routine, this);
 }
 
 void LinuxScheduler::_microsleep(uint32_t usec)
@@ -221,6 +223,58 @@ void LinuxScheduler::register_io_process(AP_HAL::MemberProc proc)
     }
 }
 
+/*
+  find the worker thread for a bus, starting one the first time the
+  bus is seen
+ */
+LinuxBusThread *LinuxScheduler::_get_bus_thread(AP_HAL::Semaphore *bus_sem)
+{
+    if (bus_sem == NULL) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < _num_bus_threads; i++) {
+        if (_bus_thread[i].bus_semaphore() == bus_sem) {
+            return &_bus_thread[i];
+        }
+    }
+    if (_num_bus_threads >= LINUX_SCHEDULER_MAX_BUS_THREADS) {
+        return NULL;
+    }
+
+    LinuxBusThread *bus = &_bus_thread[_num_bus_threads];
+    char name[16];
+    snprintf(name, sizeof(name), "sched-bus%u", (unsigned)_num_bus_threads);
+    bus->set_bus_semaphore(bus_sem);
+    _create_realtime_thread(bus->thread_ctx(), APM_LINUX_BUS_PRIORITY, name,
+                            &Linux::LinuxBusThread::thread_main, bus);
+    bus->_started = true;
+    _num_bus_threads++;
+
+    return bus;
+}
+
+void LinuxScheduler::register_bus_process(AP_HAL::MemberProc proc,
+                                          AP_HAL::Semaphore *bus_sem,
+                                          uint32_t period_us)
+{
+    LinuxBusThread *bus = _get_bus_thread(bus_sem);
+    if (bus == NULL || !bus->register_periodic(proc, period_us)) {
+        // fall back to the timer thread, the proc rate limits itself
+        register_timer_process(proc);
+    }
+}
+
+bool LinuxScheduler::queue_bus_transaction(AP_HAL::MemberProc proc,
+                                           AP_HAL::Semaphore *bus_sem,
+                                           volatile bool *done)
+{
+    LinuxBusThread *bus = _get_bus_thread(bus_sem);
+    if (bus == NULL) {
+        return AP_HAL::Scheduler::queue_bus_transaction(proc, bus_sem, done);
+    }
+    return bus->queue(proc, done);
+}
+
 void LinuxScheduler::register_timer_failsafe(AP_HAL::Proc failsafe, uint32_t period_us)
 {
     _failsafe = failsafe;
@@ -231,10 +285,18 @@ void LinuxScheduler::suspend_timer_procs()
     if (!_timer_semaphore.take(0)) {
         printf("Failed to take timer semaphore\n");
     }
+    for (uint8_t i = 0; i < _num_bus_threads; i++) {
+        if (!_bus_thread[i].proc_semaphore().take(0)) {
+            printf("Failed to take bus thread semaphore\n");
+        }
+    }
 }
 
 void LinuxScheduler::resume_timer_procs()
 {
+    for (int8_t i = _num_bus_threads - 1; i >= 0; i--) {
+        _bus_thread[i].proc_semaphore().give();
+    }
     _timer_semaphore.give();
 }
 
@@ -386,6 +448,11 @@ void LinuxScheduler::panic(const prog_char_t *errormsg)
 
 bool LinuxScheduler::in_timerprocess() 
 {
+    for (uint8_t i = 0; i < _num_bus_threads; i++) {
+        if (_bus_thread[i].is_current_thread()) {
+            return true;
+        }
+    }
     return _in_timer_proc;
 }
 
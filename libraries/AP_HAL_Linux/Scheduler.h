@@ -4,6 +4,7 @@
 
 #include <AP_HAL_Linux.h>
 #include "Semaphores.h"
+#include "BusThread.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include <sys/time.h>
@@ -11,6 +12,7 @@
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_MAX_BUS_THREADS 4
 
 class Linux::LinuxScheduler : public AP_HAL::Scheduler {
 
@@ -30,6 +32,12 @@ public:
 
     void     register_timer_process(AP_HAL::MemberProc);
     void     register_io_process(AP_HAL::MemberProc);
+    void     register_bus_process(AP_HAL::MemberProc proc,
+                                  AP_HAL::Semaphore *bus_sem,
+                                  uint32_t period_us);
+    bool     queue_bus_transaction(AP_HAL::MemberProc proc,
+                                   AP_HAL::Semaphore *bus_sem,
+                                   volatile bool *done);
     void     suspend_timer_procs();
     void     resume_timer_procs();
 
@@ -86,7 +94,13 @@ private:
     void _run_timers(bool called_from_timer_thread);
     void _run_io(void);
     void _create_realtime_thread(pthread_t *ctx, int rtprio, const char *name,
-                                 pthread_startroutine_t start_routine);
+                                 pthread_startroutine_t start_routine,
+                                 void *arg);
+
+    // one worker thread per SPI/I2C bus, found by the bus semaphore
+    LinuxBusThread _bus_thread[LINUX_SCHEDULER_MAX_BUS_THREADS];
+    uint8_t _num_bus_threads;
+    LinuxBusThread *_get_bus_thread(AP_HAL::Semaphore *bus_sem);
 
     uint64_t stopped_clock_usec;
 
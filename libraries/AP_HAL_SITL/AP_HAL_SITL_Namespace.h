@@ -2,6 +2,8 @@
 #ifndef __AP_HAL_SITL_NAMESPACE_H__
 #define __AP_HAL_SITL_NAMESPACE_H__
 
+#include <stdint.h>
+
 namespace HALSITL {
 class SITLUARTDriver;
 class SITLScheduler;
@@ -13,6 +15,7 @@ class SITLRCOutput;
 class ADCSource;
 class RCInput;
 class SITLUtil;
+template <class T, uint16_t N, uint32_t INTERVAL> class DelayLine;
 }
 
 #endif // __AP_HAL_SITL_NAMESPACE_H__
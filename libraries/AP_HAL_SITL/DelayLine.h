@@ -0,0 +1,148 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_HAL_SITL_DELAYLINE_H__
+#define __AP_HAL_SITL_DELAYLINE_H__
+
+#include <stdint.h>
+#include "AP_HAL_SITL_Namespace.h"
+
+/*
+  time indexed delay line for simulated sensors
+
+  Samples are kept in N slots, each covering INTERVAL units of time,
+  so the sample for a given time is found by indexing rather than by
+  searching the buffer. Times can be in any unit that only goes
+  forward: milliseconds for sensors with a delay in ms, or a sample
+  count for sensors with a delay in samples.
+
+  A slot that no sample landed in holds a copy of the sample before
+  it, so lookups always return the latest sample at or before the
+  requested time.
+ */
+template <class T, uint16_t N, uint32_t INTERVAL>
+class HALSITL::DelayLine {
+public:
+    DelayLine() :
+        _first_quantum(0),
+        _last_quantum(0),
+        _have_data(false)
+    {}
+
+    /*
+      add a sample taken at the given time
+     */
+    void push(uint32_t time, const T &value) {
+        uint32_t q = time / INTERVAL;
+        if (_have_data && q > _last_quantum) {
+            // hold the previous sample over any slots we skipped
+            const struct slot &prev = _slot[_last_quantum % N];
+            uint32_t fill = q - _last_quantum - 1;
+            if (fill > N) {
+                fill = N;
+            }
+            for (uint32_t i=q-fill; i<q; i++) {
+                struct slot &s = _slot[i % N];
+                s.quantum = i;
+                s.time = prev.time;
+                s.value = prev.value;
+            }
+        }
+        struct slot &s = _slot[q % N];
+        s.quantum = q;
+        s.time = time;
+        s.value = value;
+        if (!_have_data) {
+            _first_quantum = q;
+        }
+        if (!_have_data || q > _last_quantum) {
+            _last_quantum = q;
+        }
+        _have_data = true;
+    }
+
+    /*
+      get the latest sample at or before time. If time is older than
+      the buffer the oldest sample is returned. Returns false if
+      there is no data yet
+     */
+    bool get(uint32_t time, T &value) const {
+        const struct slot *a, *b;
+        if (!_find(time, a, b)) {
+            return false;
+        }
+        value = a->value;
+        return true;
+    }
+
+    /*
+      get the value at time, linearly interpolated between the samples
+      either side of it. T needs to support scaling by a float and
+      addition
+     */
+    bool get_interpolated(uint32_t time, T &value) const {
+        const struct slot *a, *b;
+        if (!_find(time, a, b)) {
+            return false;
+        }
+        if (b == NULL || b->time <= a->time || time <= a->time) {
+            value = a->value;
+        } else {
+            float f = (time - a->time) / (float)(b->time - a->time);
+            value = a->value * (1.0f - f) + b->value * f;
+        }
+        return true;
+    }
+
+    // total time covered by the buffer
+    uint32_t span(void) const { return INTERVAL * N; }
+
+private:
+    struct slot {
+        uint32_t quantum;
+        uint32_t time;
+        T value;
+    } _slot[N];
+    uint32_t _first_quantum;
+    uint32_t _last_quantum;
+    bool _have_data;
+
+    /*
+      find the slot holding the latest sample at or before time, and
+      the slot holding the sample after it if there is one. Slots
+      holding a copy of an earlier sample are skipped over
+     */
+    bool _find(uint32_t time, const struct slot *&a, const struct slot *&b) const {
+        if (!_have_data) {
+            return false;
+        }
+        uint32_t oldest = _last_quantum >= N-1 ? _last_quantum - (N-1) : 0;
+        if (oldest < _first_quantum) {
+            oldest = _first_quantum;
+        }
+        uint32_t q = time / INTERVAL;
+        if (q > _last_quantum) {
+            q = _last_quantum;
+        }
+        if (q < oldest) {
+            q = oldest;
+        }
+        a = &_slot[q % N];
+        b = NULL;
+        if (a->time > time && q > oldest) {
+            // the sample in this slot is after the time we want, so
+            // the one we want is the last one in the slot before
+            b = a;
+            a = &_slot[(q-1) % N];
+        } else {
+            for (uint32_t i=q+1; i<=_last_quantum; i++) {
+                if (_slot[i % N].time > a->time) {
+                    b = &_slot[i % N];
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+#endif // __AP_HAL_SITL_DELAYLINE_H__
@@ -75,6 +75,7 @@ void HAL_SITL::init(int argc, char * const argv[]) const
     //i2c->begin();
     //i2c->setTimeout(100);
     analogin->init(NULL);
+    utilInstance.init(argc, argv);
 }
 
 const HAL_SITL AP_HAL_SITL;
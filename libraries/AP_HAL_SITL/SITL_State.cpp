@@ -504,6 +504,31 @@ float SITL_State::_rand_float(void)
     return ((((unsigned)random()) % 2000000) - 1.0e6) / 1.0e6;
 }
 
+/*
+  delay in ms for a sensor sample, with up to jitter_ms of extra random
+  latency
+ */
+uint32_t SITL_State::_sensor_delay_ms(int16_t delay_ms, int16_t jitter_ms)
+{
+    uint32_t delay = delay_ms > 0 ? delay_ms : 0;
+    if (jitter_ms > 0) {
+        delay += ((unsigned)random()) % (jitter_ms+1);
+    }
+    return delay;
+}
+
+/*
+  return true if a sensor sample should be dropped, given the
+  percentage of samples lost
+ */
+bool SITL_State::_sensor_dropout(float percent)
+{
+    if (percent <= 0) {
+        return false;
+    }
+    return (((unsigned)random()) % 10000) < percent * 100;
+}
+
 // generate a random Vector3f of size 1
 Vector3f SITL_State::_rand_vec3f(void)
 {
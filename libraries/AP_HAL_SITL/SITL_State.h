@@ -9,6 +9,7 @@
 #include <AP_HAL_SITL.h>
 #include "AP_HAL_SITL_Namespace.h"
 #include "HAL_SITL_Class.h"
+#include "DelayLine.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -82,8 +83,10 @@ private:
         bool have_lock;
     };
 
+    // GPS delay is in samples, so this is indexed by sample count
 #define MAX_GPS_DELAY 100
-    gps_data _gps_data[MAX_GPS_DELAY];
+    DelayLine<gps_data,MAX_GPS_DELAY,1> _gps_delay;
+    uint32_t _gps_sample_count;
 
     bool _gps_has_basestation_position;
     gps_data _gps_basestation_data;
@@ -150,43 +153,17 @@ private:
 
     const char *_fdm_address;
 
-    // delay buffer variables
-    static const uint8_t mag_buffer_length = 250;
-    static const uint8_t wind_buffer_length = 50;
-    static const uint8_t baro_buffer_length = 50;
-
-    // magnetometer delay buffer variables
-    struct readings_mag {
-        uint32_t time;
-        Vector3f data;
-    };
-    uint8_t store_index_mag;
-    uint32_t last_store_time_mag;
-    VectorN<readings_mag,mag_buffer_length> buffer_mag;
-    uint32_t time_delta_mag;
-    uint32_t delayed_time_mag;
-
-    // airspeed sensor delay buffer variables
-    struct readings_wind {
-        uint32_t time;
-        float data;
-    };
-    uint8_t store_index_wind;
-    uint32_t last_store_time_wind;
-    VectorN<readings_wind,wind_buffer_length> buffer_wind;
-    uint32_t time_delta_wind;
-    uint32_t delayed_time_wind;
-
-    // barometer delay buffer variables
-    struct readings_baro {
-        uint32_t time;
-        float data;
-    };
-    uint8_t store_index_baro;
-    uint32_t last_store_time_baro;
-    VectorN<readings_baro,baro_buffer_length> buffer_baro;
-    uint32_t time_delta_baro;
-    uint32_t delayed_time_baro;
+    // sensor delay lines, one slot per 10ms, read back interpolated
+    // between the samples either side of the delayed time
+    DelayLine<Vector3f,250,10> _mag_delay;     // 2.5s
+    DelayLine<float,50,10> _wind_delay;        // 500ms
+    DelayLine<float,50,10> _baro_delay;        // 500ms
+
+    // sensor delay with random jitter, and random sample loss
+    uint32_t _sensor_delay_ms(int16_t delay_ms, int16_t jitter_ms);
+    bool _sensor_dropout(float percent);
+    float _last_airspeed_raw;
+    Vector3f _last_mag_data;
 
     // internal SITL model
     Aircraft *sitl_model;
@@ -13,13 +13,7 @@
 #include <unistd.h>
 #include <utility/getopt_cpp.h>
 
-#include <SIM_Multicopter.h>
-#include <SIM_Helicopter.h>
-#include <SIM_Rover.h>
-#include <SIM_CRRCSim.h>
-#include <SIM_last_letter.h>
-#include <SIM_JSBSim.h>
-#include <SIM_Tracker.h>
+#include <SIM_Models.h>
 
 extern const AP_HAL::HAL& hal;
 
@@ -41,30 +35,14 @@ void SITL_State::_usage(void)
            "\t--rate RATE        set SITL framerate\n"
            "\t--console          use console instead of TCP ports\n"
            "\t--instance N       set instance of SITL (adds 10*instance to all port numbers)\n"
-           "\t--speedup SPEEDUP  set simulation speedup\n"
+           "\t--speedup SPEEDUP  set simulation speedup, 0 for as fast as possible\n"
+           "\t--integrator TYPE  set physics integrator (semi or rk4)\n"
+           "\t--substeps N       set physics steps per frame (1 to 255)\n"
            "\t--gimbal           enable simulated MAVLink gimbal\n"
            "\t--autotest-dir DIR set directory for additional files\n"
         );
 }
 
-static const struct {
-    const char *name;
-    Aircraft *(*constructor)(const char *home_str, const char *frame_str);
-} model_constructors[] = {
-    { "+",         MultiCopter::create },
-    { "quad",      MultiCopter::create },
-    { "copter",    MultiCopter::create },
-    { "x",         MultiCopter::create },
-    { "hexa",      MultiCopter::create },
-    { "octa",      MultiCopter::create },
-    { "heli",      Helicopter::create },
-    { "rover",     Rover::create },
-    { "crrcsim",   CRRCSim::create },
-    { "jsbsim",    JSBSim::create },
-    { "last_letter", last_letter::create },
-    { "tracker",   Tracker::create }
-};
-
 void SITL_State::_parse_command_line(int argc, char * const argv[])
 {
     int opt;
@@ -72,6 +50,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     const char *model_str = NULL;
     char *autotest_dir = NULL;
     float speedup = 1.0f;
+    Aircraft::Integrator integrator = Aircraft::INTEGRATOR_SEMI_IMPLICIT;
+    uint8_t substeps = 1;
 
     if (asprintf(&autotest_dir, SKETCHBOOK "/Tools/autotest") <= 0) {
         hal.scheduler->panic("out of memory");
@@ -95,7 +75,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     enum long_options {
         CMDLINE_CLIENT=0,
         CMDLINE_GIMBAL,
-        CMDLINE_AUTOTESTDIR
+        CMDLINE_AUTOTESTDIR,
+        CMDLINE_INTEGRATOR,
+        CMDLINE_SUBSTEPS
     };
 
     const struct GetOptLong::option options[] = {
@@ -112,6 +94,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"client",          true,   0, CMDLINE_CLIENT},
         {"gimbal",          false,  0, CMDLINE_GIMBAL},
         {"autotest-dir",    true,   0, CMDLINE_AUTOTESTDIR},
+        {"integrator",      true,   0, CMDLINE_INTEGRATOR},
+        {"substeps",        true,   0, CMDLINE_SUBSTEPS},
         {0, false, 0, 0}
     };
 
@@ -164,6 +148,25 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_AUTOTESTDIR:
             autotest_dir = strdup(gopt.optarg);
             break;
+        case CMDLINE_INTEGRATOR:
+            if (strcasecmp(gopt.optarg, "rk4") == 0) {
+                integrator = Aircraft::INTEGRATOR_RK4;
+            } else if (strcasecmp(gopt.optarg, "semi") == 0) {
+                integrator = Aircraft::INTEGRATOR_SEMI_IMPLICIT;
+            } else {
+                _usage();
+                exit(1);
+            }
+            break;
+        case CMDLINE_SUBSTEPS: {
+            int n = atoi(gopt.optarg);
+            if (n < 1 || n > UINT8_MAX) {
+                _usage();
+                exit(1);
+            }
+            substeps = n;
+            break;
+        }
         default:
             _usage();
             exit(1);
@@ -171,16 +174,15 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     }
 
     if (model_str && home_str) {
-        for (uint8_t i=0; i<sizeof(model_constructors)/sizeof(model_constructors[0]); i++) {
-            if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
-                sitl_model = model_constructors[i].constructor(home_str, model_str);
-                sitl_model->set_speedup(speedup);
-                sitl_model->set_instance(_instance);
-                sitl_model->set_autotest_dir(autotest_dir);
-                _synthetic_clock_mode = true;
-                printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
-                break;
-            }
+        sim_model_constructor constructor = sim_model_find(model_str, false);
+        if (constructor != NULL) {
+            sitl_model = constructor(home_str, model_str);
+            sitl_model->set_speedup(speedup);
+            sitl_model->set_integrator(integrator, substeps);
+            sitl_model->set_instance(_instance);
+            sitl_model->set_autotest_dir(autotest_dir);
+            _synthetic_clock_mode = true;
+            printf("Started model %s at %s at speed %.1f\n", model_str, home_str, speedup);
         }
     }
 
@@ -7,9 +7,26 @@
 
 class HALSITL::SITLUtil : public AP_HAL::Util {
 public:
+    void init(int argc, char * const *argv) {
+        saved_argc = argc;
+        saved_argv = argv;
+    }
+
     bool run_debug_shell(AP_HAL::BetterStream *stream) {
         return false;
     }
+
+    /**
+       return commandline arguments, if available
+     */
+    void commandline_arguments(uint8_t &argc, char * const *&argv) {
+        argc = saved_argc;
+        argv = saved_argv;
+    }
+
+private:
+    int saved_argc;
+    char * const *saved_argv;
 };
 
 #endif // __AP_HAL_SITL_UTIL_H__
@@ -31,9 +31,6 @@
 using namespace HALSITL;
 extern const AP_HAL::HAL& hal;
 
-static uint8_t next_gps_index;
-static uint8_t gps_delay;
-
 // state of GPS emulation
 static struct gps_state {
     /* pipe emulating UBLOX GPS serial stream */
@@ -732,21 +729,11 @@ void SITL_State::_update_gps(double latitude, double longitude, float altitude,
     d.speedD = speedD;
     d.have_lock = have_lock;
 
-    // add in some GPS lag
-    _gps_data[next_gps_index++] = d;
-    if (next_gps_index >= gps_delay+1) {
-        next_gps_index = 0;
-    }
-
-    d = _gps_data[next_gps_index];
-
-    if (_sitl->gps_delay != gps_delay) {
-        // cope with updates to the delay control
-        gps_delay = _sitl->gps_delay;
-        for (uint8_t i=0; i<gps_delay; i++) {
-            _gps_data[i] = d;
-        }
-    }
+    // add in some GPS lag, counted in samples
+    uint32_t gps_delay = constrain_int16(_sitl->gps_delay, 0, MAX_GPS_DELAY-1);
+    _gps_delay.push(_gps_sample_count, d);
+    _gps_delay.get(_gps_sample_count > gps_delay ? _gps_sample_count - gps_delay : 0, d);
+    _gps_sample_count++;
 
     if (gps_state.gps_fd == 0 && gps2_state.gps_fd == 0) {
         return;
@@ -8,6 +8,8 @@
 #include <AP_Notify.h>
 #include <AP_Vehicle.h>
 #include <AP_Math.h>
+#include "../AP_HAL/utility/RingBuffer.h"
+#include <DataFlash.h>
 
 /*
   enable TIMING_DEBUG to track down scheduling issues with the main
@@ -37,6 +39,10 @@ extern const AP_HAL::HAL& hal;
 
 #define SAMPLE_UNIT 1
 
+// largest error from one G in m/s/s of a sample the accel
+// calibration will keep
+#define INS_ACCELCAL_MAX_RESIDUAL 0.3f
+
 // Class level parameters
 const AP_Param::GroupInfo AP_InertialSensor::var_info[] PROGMEM = {
     // @Param: PRODUCT_ID
@@ -265,6 +271,93 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("ACCEL_FILTER", 19, AP_InertialSensor, _accel_filter_cutoff,  DEFAULT_ACCEL_FILTER),
 
+#if !defined( __AVR_ATmega1280__ )
+    // @Param: ACAL_POS
+    // @DisplayName: Accel calibration positions
+    // @Description: Number of vehicle orientations used for accelerometer calibration. The first six are level, on each side, nose down, nose up and on its back. Any more are tilted positions of the user's choosing, which let the calibration throw away a bad sample, for example one taken while the vehicle was still moving
+    // @Range: 6 12
+    // @User: Advanced
+    AP_GROUPINFO("ACAL_POS", 20, AP_InertialSensor, _acal_positions, INS_ACCELCAL_MIN_POSITIONS),
+#endif
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    // @Param: HNTCH_ENABLE
+    // @DisplayName: Gyro harmonic notch enable
+    // @Description: Enable the gyro harmonic notch filter. This removes vibration at the motor frequency and its harmonics from the gyros before the low pass filter, which allows a higher INS_GYRO_FILTER and so less phase lag in the rate controllers
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_ENABLE", 21, AP_InertialSensor, _hnotch_enable, 0),
+
+    // @Param: HNTCH_FREQ
+    // @DisplayName: Gyro harmonic notch base frequency
+    // @Description: Centre frequency of the notch on the fundamental. In throttle mode this is the frequency at the reference throttle, normally the hover throttle
+    // @Units: Hz
+    // @Range: 10 400
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_FREQ", 22, AP_InertialSensor, _hnotch_base_freq, 80),
+
+    // @Param: HNTCH_BW
+    // @DisplayName: Gyro harmonic notch bandwidth
+    // @Description: Width of the notch on the fundamental. The notches on higher harmonics are wider in proportion
+    // @Units: Hz
+    // @Range: 5 250
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_BW", 23, AP_InertialSensor, _hnotch_bandwidth, 40),
+
+    // @Param: HNTCH_ATT
+    // @DisplayName: Gyro harmonic notch attenuation
+    // @Description: Depth of the notch at its centre frequency
+    // @Units: dB
+    // @Range: 5 50
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_ATT", 24, AP_InertialSensor, _hnotch_attenuation, 40),
+
+    // @Param: HNTCH_HMNCS
+    // @DisplayName: Gyro harmonic notch harmonics
+    // @Description: Bitmask of the harmonics to notch. Harmonics above 40% of the gyro sample rate are left out
+    // @Bitmask: 0:1st harmonic,1:2nd harmonic,2:3rd harmonic
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_HMNCS", 25, AP_InertialSensor, _hnotch_harmonics, 1),
+
+    // @Param: HNTCH_MODE
+    // @DisplayName: Gyro harmonic notch tracking mode
+    // @Description: How the centre frequency of the notch is chosen. Fixed uses HNTCH_FREQ. Throttle scales HNTCH_FREQ with the square root of the throttle above HNTCH_REF, as motor speed goes with the square root of thrust. FFT uses the vibration peak found by the onboard gyro FFT, and HNTCH_FREQ until there is one
+    // @Values: 0:Fixed,1:Throttle,2:FFT
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_MODE", 26, AP_InertialSensor, _hnotch_mode, HNOTCH_MODE_FIXED),
+
+    // @Param: HNTCH_REF
+    // @DisplayName: Gyro harmonic notch reference throttle
+    // @Description: Throttle at which the motor frequency is HNTCH_FREQ in throttle mode. Below this throttle the notch stays at HNTCH_FREQ
+    // @Range: 0.1 0.9
+    // @User: Advanced
+    AP_GROUPINFO("HNTCH_REF", 27, AP_InertialSensor, _hnotch_ref, 0.35f),
+#endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+    // @Param: LOG_BAT_MASK
+    // @DisplayName: Raw sample batch logging
+    // @Description: Sensors of the first IMU to capture raw samples from in batches at the rate they are read from the sensor. Batches are written to the log as ISBH and ISBD messages, taking turns between the sensors selected
+    // @Bitmask: 0:Accel,1:Gyro
+    // @User: Advanced
+    AP_GROUPINFO("LOG_BAT_MASK", 28, AP_InertialSensor, _batch_mask, 0),
+
+    // @Param: LOG_BAT_CNT
+    // @DisplayName: Raw sample batch size
+    // @Description: Number of raw samples in each batch. Rounded down to a multiple of 32. Each sample takes 6 bytes of memory. This option takes effect on the next reboot
+    // @Range: 32 4096
+    // @Increment: 32
+    // @User: Advanced
+    AP_GROUPINFO("LOG_BAT_CNT", 29, AP_InertialSensor, _batch_samples, 1024),
+
+    // @Param: LOG_BAT_LGCT
+    // @DisplayName: Raw sample batch messages per call
+    // @Description: Number of ISBD messages, each of 32 samples, written to the log each time the vehicle writes batch data, which is at 50Hz. Higher values write batches out faster at the cost of more log bandwidth
+    // @Range: 1 16
+    // @User: Advanced
+    AP_GROUPINFO("LOG_BAT_LGCT", 30, AP_InertialSensor, _batch_msgs_per_call, 2),
+#endif
+
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -297,6 +390,41 @@ AP_InertialSensor::AP_InertialSensor() :
     }
     memset(_delta_velocity_valid,0,sizeof(_delta_velocity_valid));
     memset(_delta_angle_valid,0,sizeof(_delta_angle_valid));
+#if !defined( __AVR_ATmega1280__ )
+    _acal = NULL;
+    _acal_status = ACCEL_CAL_NOT_STARTED;
+    _acal_have_trim = false;
+    _acal_fail_msg = NULL;
+#endif
+#if INS_RAW_SAMPLES_ENABLED
+    _accel_raw_rate_hz = 0;
+    _gyro_raw_rate_hz = 0;
+#endif
+#if INS_GYRO_WINDOW_ENABLED
+    _gyro_window = NULL;
+    _gyro_window_size = 0;
+    _gyro_window_head = 0;
+    _gyro_window_tail = 0;
+    _gyro_window_drops = 0;
+#endif
+#if INS_BATCH_SAMPLER_ENABLED
+    _batch_data = NULL;
+    _batch_size = 0;
+    _batch_type = INS_BATCH_ACCEL;
+    _batch_captured = 0;
+    _batch_start_us = 0;
+    _batch_written = 0;
+    _batch_seqno = 0;
+#endif
+#if INS_HARMONIC_NOTCH_ENABLED
+    _hnotch_throttle = 0;
+    _hnotch_tracked_freq = 0;
+    _hnotch_freq_hz = -1;
+    _hnotch_bw_hz = 0;
+    _hnotch_att_db = 0;
+    _hnotch_harmonics_mask = 0;
+    _hnotch_version = 0;
+#endif
 }
 
 
@@ -455,179 +583,331 @@ bool AP_InertialSensor::_calculate_trim(const Vector3f &accel_sample, float& tri
 // http://chionophilous.wordpress.com/2011/10/24/accelerometer-calibration-iv-1-implementing-gauss-newton-on-an-atmega/
 // original sketch available at
 // http://rolfeschmidt.com/mathtools/skimetrics/adxl_gn_calibration.pde
+//
+// This runs the background calibration to completion, for callers
+// that can block
 bool AP_InertialSensor::calibrate_accel(AP_InertialSensor_UserInteract* interact,
                                         float &trim_roll,
                                         float &trim_pitch)
+{
+    if (!accel_cal_start()) {
+        return false;
+    }
+
+    while (true) {
+        switch (_acal_status) {
+        case ACCEL_CAL_WAITING_FOR_ORIENTATION:
+            interact->printf_P(PSTR("Place vehicle %S and press any key.\n"),
+                               accel_cal_orientation(_acal_step));
+
+            // wait for user input
+            if (!interact->blocking_read()) {
+                //No need to use interact->printf_P for an error, blocking_read does this when it fails
+                accel_cal_cancel();
+                interact->printf_P(PSTR("Calibration FAILED\n"));
+                return false;
+            }
+            accel_cal_collect_sample();
+            break;
+
+        case ACCEL_CAL_SUCCESS:
+            for (uint8_t k=0; k<get_accel_count(); k++) {
+                const Vector3f &offsets = _accel_offset[k].get();
+                const Vector3f &scaling = _accel_scale[k].get();
+                interact->printf_P(PSTR("Offsets[%u]: %.2f %.2f %.2f\n"),
+                                   (unsigned)k,
+                                   (double)offsets.x, (double)offsets.y, (double)offsets.z);
+                interact->printf_P(PSTR("Scaling[%u]: %.2f %.2f %.2f\n"),
+                                   (unsigned)k,
+                                   (double)scaling.x, (double)scaling.y, (double)scaling.z);
+            }
+            interact->printf_P(PSTR("Calibration successful\n"));
+            return accel_cal_get_trim(trim_roll, trim_pitch);
+
+        case ACCEL_CAL_FAILED:
+            interact->printf_P(PSTR("%S\n"), _acal_fail_msg);
+            interact->printf_P(PSTR("Calibration FAILED\n"));
+            return false;
+
+        default:
+            wait_for_sample();
+            update();
+            accel_cal_update();
+            break;
+        }
+    }
+}
+
+/*
+  the orientation the user is asked for at each calibration step
+ */
+const prog_char_t *AP_InertialSensor::accel_cal_orientation(uint8_t step)
+{
+    switch (step) {
+    case 0:
+        return PSTR("level");
+    case 1:
+        return PSTR("on its LEFT side");
+    case 2:
+        return PSTR("on its RIGHT side");
+    case 3:
+        return PSTR("nose DOWN");
+    case 4:
+        return PSTR("nose UP");
+    case 5:
+        return PSTR("on its BACK");
+    default:
+        return PSTR("at a new angle");
+    }
+}
+
+/*
+  start a background accel calibration
+ */
+bool AP_InertialSensor::accel_cal_start(void)
 {
     uint8_t num_accels = min(get_accel_count(), INS_MAX_INSTANCES);
-    Vector3f samples[INS_MAX_INSTANCES][6];
-    Vector3f new_offsets[INS_MAX_INSTANCES];
-    Vector3f new_scaling[INS_MAX_INSTANCES];
-    Vector3f orig_offset[INS_MAX_INSTANCES];
-    Vector3f orig_scale[INS_MAX_INSTANCES];
-    uint8_t num_ok = 0;
 
     // exit immediately if calibration is already in progress
-    if (_calibrating) {
+    if (_calibrating || _acal != NULL || num_accels == 0) {
+        return false;
+    }
+
+    _acal = (struct AccelCalState *)calloc(num_accels, sizeof(struct AccelCalState));
+    if (_acal == NULL) {
         return false;
     }
 
     _calibrating = true;
+    _acal_num_accels = num_accels;
+    _acal_num_steps = constrain_int16(_acal_positions, INS_ACCELCAL_MIN_POSITIONS, INS_ACCELCAL_MAX_POSITIONS);
+    _acal_step = 0;
+    _acal_fitness = 0;
+    _acal_have_trim = false;
+    _acal_fail_msg = NULL;
 
     /*
       we do the accel calibration with no board rotation. This avoids
       having to rotate readings during the calibration
     */
-    enum Rotation saved_orientation = _board_orientation;
+    _acal_saved_orientation = _board_orientation;
     _board_orientation = ROTATION_NONE;
 
     for (uint8_t k=0; k<num_accels; k++) {
         // backup original offsets and scaling
-        orig_offset[k] = _accel_offset[k].get();
-        orig_scale[k]  = _accel_scale[k].get();
+        _acal[k].orig_offset = _accel_offset[k].get();
+        _acal[k].orig_scale  = _accel_scale[k].get();
 
         // clear accelerometer offsets and scaling
         _accel_offset[k] = Vector3f(0,0,0);
         _accel_scale[k] = Vector3f(1,1,1);
     }
 
-    memset(samples, 0, sizeof(samples));
+    _acal_status = ACCEL_CAL_WAITING_FOR_ORIENTATION;
+    _acal_step_start_ms = hal.scheduler->millis();
+    return true;
+}
 
-    // capture data from 6 positions
-    for (uint8_t i=0; i<6; i++) {
-        const prog_char_t *msg;
+/*
+  the user has put the vehicle in the requested orientation. Start
+  sampling it
+ */
+bool AP_InertialSensor::accel_cal_collect_sample(void)
+{
+    if (_acal_status != ACCEL_CAL_WAITING_FOR_ORIENTATION) {
+        return false;
+    }
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        _acal_sum[k].zero();
+    }
+    _acal_sample_count = 0;
+    _acal_step_start_ms = hal.scheduler->millis();
+    _acal_status = ACCEL_CAL_COLLECTING_SAMPLE;
+    return true;
+}
 
-        // display message to user
-        switch ( i ) {
-            case 0:
-                msg = PSTR("level");
-                break;
-            case 1:
-                msg = PSTR("on its LEFT side");
-                break;
-            case 2:
-                msg = PSTR("on its RIGHT side");
-                break;
-            case 3:
-                msg = PSTR("nose DOWN");
-                break;
-            case 4:
-                msg = PSTR("nose UP");
-                break;
-            default:    // default added to avoid compiler warning
-            case 5:
-                msg = PSTR("on its BACK");
-                break;
-        }
-        interact->printf_P(
-                PSTR("Place vehicle %S and press any key.\n"), msg);
+/*
+  add the latest accels to the sample being collected. Called from
+  update() so every sensor reading is used
+ */
+void AP_InertialSensor::_acal_accumulate(void)
+{
+    uint32_t now = hal.scheduler->millis();
 
-        // wait for user input
-        if (!interact->blocking_read()) {
-            //No need to use interact->printf_P for an error, blocking_read does this when it fails
-            goto failed;
+    // wait 100ms for ins filter to rise
+    if (now - _acal_step_start_ms < 100) {
+        return;
+    }
+
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        if (!get_accel_health(k)) {
+            _acal_fail(PSTR("Accel not healthy"));
+            return;
         }
+        Vector3f samp;
+        if (get_delta_velocity(k,samp) && _delta_velocity_dt[k] > 0) {
+            samp /= _delta_velocity_dt[k];
+        } else {
+            samp = get_accel(k);
+        }
+        _acal_sum[k] += samp;
+    }
+    _acal_sample_count++;
+
+    // then average over 400ms
+    if (now - _acal_step_start_ms < 500) {
+        return;
+    }
 
-        const uint8_t update_dt_milliseconds = (uint8_t)(1000.0f/get_sample_rate()+0.5f);
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        struct AccelCalState &cal = _acal[k];
+        cal.samples[cal.num_samples++] = _acal_sum[k] / _acal_sample_count;
+    }
+    if (_acal_step == 0) {
+        // keep the level sample for the trims, as the fit may drop
+        // it from the samples
+        _acal_level_sample = _acal[0].samples[0];
+    }
 
-        // wait 100ms for ins filter to rise
-        for (uint8_t k=0; k<100/update_dt_milliseconds; k++) {
-            wait_for_sample();
-            update();
-            hal.scheduler->delay(update_dt_milliseconds);
+    _acal_step++;
+    _acal_step_start_ms = now;
+    if (_acal_step < _acal_num_steps) {
+        _acal_status = ACCEL_CAL_WAITING_FOR_ORIENTATION;
+    } else {
+        _acal_status = ACCEL_CAL_FITTING;
+    }
+}
+
+/*
+  do the next slice of a background accel calibration. Each call does
+  one Gauss-Newton iteration for each accel
+ */
+void AP_InertialSensor::accel_cal_update(void)
+{
+    switch (_acal_status) {
+    case ACCEL_CAL_WAITING_FOR_ORIENTATION:
+        // give up if the user has gone away
+        if (hal.scheduler->millis() - _acal_step_start_ms > 30000U) {
+            _acal_fail(PSTR("Timed out waiting for user response"));
         }
+        break;
 
-        uint32_t num_samples = 0;
-        while (num_samples < 400/update_dt_milliseconds) {
-            wait_for_sample();
-            // read samples from ins
-            update();
-            // capture sample
-            for (uint8_t k=0; k<num_accels; k++) {
-                Vector3f samp;
-                if(get_delta_velocity(k,samp) && _delta_velocity_dt[k] > 0) {
-                    samp /= _delta_velocity_dt[k];
-                } else {
-                    samp = get_accel(k);
-                }
-                samples[k][i] += samp;
-                if (!get_accel_health(k)) {
-                    interact->printf_P(PSTR("accel[%u] not healthy"), (unsigned)k);
-                    goto failed;
-                }
+    case ACCEL_CAL_FITTING: {
+        bool all_done = true;
+        for (uint8_t k=0; k<_acal_num_accels; k++) {
+            if (_acal[k].done) {
+                continue;
+            }
+            if (!_acal_fit_step(_acal[k])) {
+                // the state has been freed by _acal_fail()
+                return;
+            }
+            if (!_acal[k].done) {
+                all_done = false;
             }
-            hal.scheduler->delay(update_dt_milliseconds);
-            num_samples++;
         }
-        for (uint8_t k=0; k<num_accels; k++) {
-            samples[k][i] /= num_samples;
+        if (all_done) {
+            _acal_finish();
         }
+        break;
     }
 
-    // run the calibration routine
-    for (uint8_t k=0; k<num_accels; k++) {
-        if (!_check_sample_range(samples[k], saved_orientation, interact)) {
-            interact->printf_P(PSTR("Insufficient accel range"));
-            continue;
-        }
+    default:
+        break;
+    }
+}
 
-        bool success = _calibrate_accel(samples[k], new_offsets[k], new_scaling[k], saved_orientation);
+/*
+  stop any accel calibration, restoring the old calibration
+ */
+void AP_InertialSensor::accel_cal_cancel(void)
+{
+    if (_acal != NULL) {
+        _acal_restore();
+    }
+    _acal_status = ACCEL_CAL_NOT_STARTED;
+}
 
-        interact->printf_P(PSTR("Offsets[%u]: %.2f %.2f %.2f\n"),
-                            (unsigned)k,
-                           (double)new_offsets[k].x, (double)new_offsets[k].y, (double)new_offsets[k].z);
-        interact->printf_P(PSTR("Scaling[%u]: %.2f %.2f %.2f\n"),
-                           (unsigned)k,
-                           (double)new_scaling[k].x, (double)new_scaling[k].y, (double)new_scaling[k].z);
-        if (success) num_ok++;
+bool AP_InertialSensor::accel_cal_get_trim(float &trim_roll, float &trim_pitch)
+{
+    if (!_acal_have_trim) {
+        return false;
     }
+    trim_roll = _acal_trim_roll;
+    trim_pitch = _acal_trim_pitch;
+    _acal_have_trim = false;
+    return true;
+}
 
-    if (num_ok == num_accels) {
-        interact->printf_P(PSTR("Calibration successful\n"));
+void AP_InertialSensor::_acal_restore(void)
+{
+    // restore original scaling and offsets
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        _accel_offset[k].set(_acal[k].orig_offset);
+        _accel_scale[k].set(_acal[k].orig_scale);
+    }
+    _board_orientation = _acal_saved_orientation;
+    free(_acal);
+    _acal = NULL;
+    _calibrating = false;
+}
 
-        for (uint8_t k=0; k<num_accels; k++) {
-            // set and save calibration
-            _accel_offset[k].set(new_offsets[k]);
-            _accel_scale[k].set(new_scaling[k]);
-        }
-        for (uint8_t k=num_accels; k<INS_MAX_INSTANCES; k++) {
-            // clear unused accelerometer's scaling and offsets
-            _accel_offset[k] = Vector3f(0,0,0);
-            _accel_scale[k] = Vector3f(0,0,0);
-        }
-        _save_parameters();
-
-        /*
-          calculate the trims as well from primary accels 
-          We use the original board rotation for this sample
-        */
-        Vector3f level_sample = samples[0][0];
-        level_sample.x *= new_scaling[0].x;
-        level_sample.y *= new_scaling[0].y;
-        level_sample.z *= new_scaling[0].z;
-        level_sample -= new_offsets[0];
-        level_sample.rotate(saved_orientation);
-
-        if (!_calculate_trim(level_sample, trim_roll, trim_pitch)) {
-            goto failed;
-        }
+void AP_InertialSensor::_acal_fail(const prog_char_t *msg)
+{
+    _acal_restore();
+    _acal_fail_msg = msg;
+    _acal_status = ACCEL_CAL_FAILED;
+}
 
-        _board_orientation = saved_orientation;
+/*
+  all the accels have a good fit. Save the new calibration
+ */
+void AP_InertialSensor::_acal_finish(void)
+{
+    Vector3f new_offsets[INS_MAX_INSTANCES];
+    Vector3f new_scaling[INS_MAX_INSTANCES];
 
-        _calibrating = false;
-        return true;
+    _acal_fitness = 0;
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        _acal_get_calibration(_acal[k], new_offsets[k], new_scaling[k]);
+        _acal_fitness = max(_acal_fitness, _acal[k].fitness);
     }
 
-failed:
-    interact->printf_P(PSTR("Calibration FAILED\n"));
-    // restore original scaling and offsets
-    for (uint8_t k=0; k<num_accels; k++) {
-        _accel_offset[k].set(orig_offset[k]);
-        _accel_scale[k].set(orig_scale[k]);
+    /*
+      calculate the trims as well from primary accels 
+      We use the original board rotation for this sample
+    */
+    Vector3f level_sample = _acal_level_sample;
+    level_sample.x *= new_scaling[0].x;
+    level_sample.y *= new_scaling[0].y;
+    level_sample.z *= new_scaling[0].z;
+    level_sample -= new_offsets[0];
+    level_sample.rotate(_acal_saved_orientation);
+
+    if (!_calculate_trim(level_sample, _acal_trim_roll, _acal_trim_pitch)) {
+        _acal_fail(PSTR("Trim over maximum of 10 degrees"));
+        return;
     }
-    _board_orientation = saved_orientation;
+
+    for (uint8_t k=0; k<_acal_num_accels; k++) {
+        // set and save calibration
+        _accel_offset[k].set(new_offsets[k]);
+        _accel_scale[k].set(new_scaling[k]);
+    }
+    for (uint8_t k=_acal_num_accels; k<INS_MAX_INSTANCES; k++) {
+        // clear unused accelerometer's scaling and offsets
+        _accel_offset[k] = Vector3f(0,0,0);
+        _accel_scale[k] = Vector3f(0,0,0);
+    }
+    _save_parameters();
+
+    _board_orientation = _acal_saved_orientation;
+    free(_acal);
+    _acal = NULL;
     _calibrating = false;
-    return false;
+
+    _acal_have_trim = true;
+    _acal_status = ACCEL_CAL_SUCCESS;
 }
 #endif
 
@@ -908,16 +1188,15 @@ AP_InertialSensor::_init_gyro()
 
 /*
   check that the samples used for accel calibration have a sufficient
-  range on each axis. The sphere fit in _calibrate_accel() can produce
-  bad offsets and scaling factors if the range of input data is
-  insufficient.
+  range on each axis. The sphere fit can produce bad offsets and
+  scaling factors if the range of input data is insufficient.
 
   We rotate each sample in the check to body frame to cope with 45
   board orientations which could result in smaller ranges. The sample
   inputs are in sensor frame
  */
-bool AP_InertialSensor::_check_sample_range(const Vector3f accel_sample[6], enum Rotation rotation, 
-                                            AP_InertialSensor_UserInteract* interact)
+bool AP_InertialSensor::_check_sample_range(const Vector3f *accel_sample, uint8_t num_samples,
+                                            enum Rotation rotation)
 {
     // we want at least 12 m/s/s range on all axes. This should be
     // very easy to achieve, and guarantees the accels have been
@@ -931,7 +1210,7 @@ bool AP_InertialSensor::_check_sample_range(const Vector3f accel_sample[6], enum
     min_sample.rotate(rotation);
     max_sample = min_sample;
 
-    for (uint8_t s=1; s<6; s++) {
+    for (uint8_t s=1; s<num_samples; s++) {
         Vector3f sample = accel_sample[s];
         sample.rotate(rotation);
         for (uint8_t i=0; i<3; i++) {
@@ -944,85 +1223,128 @@ bool AP_InertialSensor::_check_sample_range(const Vector3f accel_sample[6], enum
         }
     }
     Vector3f range = max_sample - min_sample;
-    interact->printf_P(PSTR("AccelRange: %.1f %.1f %.1f"),
-            (double)range.x, (double)range.y, (double)range.z);
     bool ok = (range.x >= min_range && 
                range.y >= min_range && 
                range.z >= min_range);
     return ok;
 }
 
-
-// _calibrate_model - perform low level accel calibration
-// accel_sample are accelerometer samples collected in 6 different positions
-// accel_offsets are output from the calibration routine
-// accel_scale are output from the calibration routine
-// returns true if successful
-bool AP_InertialSensor::_calibrate_accel(const Vector3f accel_sample[6],
-                                         Vector3f& accel_offsets, Vector3f& accel_scale,
-                                         enum Rotation rotation)
+/*
+  one Gauss-Newton iteration of the fit for one accel. When the fit
+  has converged the sample that fits worst is dropped if it is too far
+  off and there are more samples than unknowns, and the fit is started
+  again without it. Returns false if the calibration failed
+ */
+bool AP_InertialSensor::_acal_fit_step(struct AccelCalState &cal)
 {
-    int16_t i;
-    int16_t num_iterations = 0;
-    float eps = 0.000000001f;
-    float change = 100.0f;
     float data[3];
-    float beta[6];
     float delta[6];
     float ds[6];
     float JS[6][6];
-    bool success = true;
 
-    // reset
-    beta[0] = beta[1] = beta[2] = 0;
-    beta[3] = beta[4] = beta[5] = 1.0f/GRAVITY_MSS;
-    
-    while( num_iterations < 20 && change > eps ) {
-        num_iterations++;
+    if (cal.iterations == 0) {
+        if (!_check_sample_range(cal.samples, cal.num_samples, _acal_saved_orientation)) {
+            _acal_fail(PSTR("Insufficient accel range"));
+            return false;
+        }
+        // reset
+        cal.beta[0] = cal.beta[1] = cal.beta[2] = 0;
+        cal.beta[3] = cal.beta[4] = cal.beta[5] = 1.0f/GRAVITY_MSS;
+    }
 
-        _calibrate_reset_matrices(ds, JS);
+    _calibrate_reset_matrices(ds, JS);
 
-        for( i=0; i<6; i++ ) {
-            data[0] = accel_sample[i].x;
-            data[1] = accel_sample[i].y;
-            data[2] = accel_sample[i].z;
-            _calibrate_update_matrices(ds, JS, beta, data);
-        }
+    for (uint8_t i=0; i<cal.num_samples; i++) {
+        data[0] = cal.samples[i].x;
+        data[1] = cal.samples[i].y;
+        data[2] = cal.samples[i].z;
+        _calibrate_update_matrices(ds, JS, cal.beta, data);
+    }
 
-        _calibrate_find_delta(ds, JS, delta);
+    _calibrate_find_delta(ds, JS, delta);
 
-        change =    delta[0]*delta[0] +
-                    delta[0]*delta[0] +
+    float change =  delta[0]*delta[0] +
                     delta[1]*delta[1] +
                     delta[2]*delta[2] +
-                    delta[3]*delta[3] / (beta[3]*beta[3]) +
-                    delta[4]*delta[4] / (beta[4]*beta[4]) +
-                    delta[5]*delta[5] / (beta[5]*beta[5]);
+                    delta[3]*delta[3] / (cal.beta[3]*cal.beta[3]) +
+                    delta[4]*delta[4] / (cal.beta[4]*cal.beta[4]) +
+                    delta[5]*delta[5] / (cal.beta[5]*cal.beta[5]);
+
+    for (uint8_t i=0; i<6; i++) {
+        cal.beta[i] -= delta[i];
+    }
 
-        for( i=0; i<6; i++ ) {
-            beta[i] -= delta[i];
+    cal.iterations++;
+    if (cal.iterations < 20 && change > 0.000000001f) {
+        return true;
+    }
+
+    // find the sample that fits worst
+    uint8_t worst = 0;
+    float worst_err = 0;
+    float sum_sq = 0;
+    for (uint8_t i=0; i<cal.num_samples; i++) {
+        float err = fabsf(_acal_residual(cal, cal.samples[i]));
+        sum_sq += err*err;
+        if (err > worst_err) {
+            worst_err = err;
+            worst = i;
         }
     }
+    cal.fitness = safe_sqrt(sum_sq / cal.num_samples);
+
+    if (worst_err > INS_ACCELCAL_MAX_RESIDUAL && cal.num_samples > INS_ACCELCAL_MIN_POSITIONS) {
+        // with no samples to spare the fit is judged by the scale
+        // and offset checks below, as it always has been
+        cal.num_samples--;
+        for (uint8_t i=worst; i<cal.num_samples; i++) {
+            cal.samples[i] = cal.samples[i+1];
+        }
+        cal.iterations = 0;
+        return true;
+    }
 
-    // copy results out
-    accel_scale.x = beta[3] * GRAVITY_MSS;
-    accel_scale.y = beta[4] * GRAVITY_MSS;
-    accel_scale.z = beta[5] * GRAVITY_MSS;
-    accel_offsets.x = beta[0] * accel_scale.x;
-    accel_offsets.y = beta[1] * accel_scale.y;
-    accel_offsets.z = beta[2] * accel_scale.z;
+    Vector3f accel_offsets, accel_scale;
+    _acal_get_calibration(cal, accel_offsets, accel_scale);
 
     // sanity check scale
     if( accel_scale.is_nan() || fabsf(accel_scale.x-1.0f) > 0.1f || fabsf(accel_scale.y-1.0f) > 0.1f || fabsf(accel_scale.z-1.0f) > 0.1f ) {
-        success = false;
+        _acal_fail(PSTR("Accel scaling out of range"));
+        return false;
     }
     // sanity check offsets (3.5 is roughly 3/10th of a G, 5.0 is roughly half a G)
     if( accel_offsets.is_nan() || fabsf(accel_offsets.x) > 3.5f || fabsf(accel_offsets.y) > 3.5f || fabsf(accel_offsets.z) > 3.5f ) {
-        success = false;
+        _acal_fail(PSTR("Accel offsets out of range"));
+        return false;
+    }
+
+    cal.done = true;
+    return true;
+}
+
+/*
+  how far the length of a sample corrected by the current fit is from
+  one G, in m/s/s
+ */
+float AP_InertialSensor::_acal_residual(const struct AccelCalState &cal, const Vector3f &sample) const
+{
+    float sum = 0;
+    for (uint8_t j=0; j<3; j++) {
+        float dx = sample[j] - cal.beta[j];
+        sum += cal.beta[3+j]*cal.beta[3+j]*dx*dx;
     }
+    return GRAVITY_MSS * (safe_sqrt(sum) - 1.0f);
+}
 
-    // return success or failure
-    return success;
+void AP_InertialSensor::_acal_get_calibration(const struct AccelCalState &cal,
+                                              Vector3f &accel_offsets, Vector3f &accel_scale) const
+{
+    accel_scale.x = cal.beta[3] * GRAVITY_MSS;
+    accel_scale.y = cal.beta[4] * GRAVITY_MSS;
+    accel_scale.z = cal.beta[5] * GRAVITY_MSS;
+    accel_offsets.x = cal.beta[0] * accel_scale.x;
+    accel_offsets.y = cal.beta[1] * accel_scale.y;
+    accel_offsets.z = cal.beta[2] * accel_scale.z;
 }
 
 void AP_InertialSensor::_calibrate_update_matrices(float dS[6], float JS[6][6],
@@ -1133,6 +1455,9 @@ void AP_InertialSensor::update(void)
             _delta_velocity_valid[i] = false;
             _delta_angle_valid[i] = false;
         }
+#if INS_HARMONIC_NOTCH_ENABLED
+        _update_harmonic_notch();
+#endif
         for (uint8_t i=0; i<_backend_count; i++) {
             _backends[i]->update();
         }
@@ -1176,9 +1501,222 @@ void AP_InertialSensor::update(void)
         }
     }
 
+#if !defined( __AVR_ATmega1280__ )
+    if (_acal_status == ACCEL_CAL_COLLECTING_SAMPLE) {
+        _acal_accumulate();
+    }
+#endif
+
     _have_sample = false;
 }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+/*
+  work out where the harmonic notch should be and let the backends
+  know if it has moved
+ */
+void AP_InertialSensor::_update_harmonic_notch(void)
+{
+    float freq = 0;
+    if (_hnotch_enable) {
+        freq = _hnotch_base_freq;
+        if (_hnotch_mode == HNOTCH_MODE_THROTTLE && _hnotch_ref > 0) {
+            // motor speed goes roughly with the square root of thrust
+            freq *= sqrtf(max(_hnotch_throttle / _hnotch_ref, 1.0f));
+        } else if (_hnotch_mode == HNOTCH_MODE_TRACKED && _hnotch_tracked_freq > 0) {
+            freq = _hnotch_tracked_freq;
+        }
+    }
+
+    // small changes in frequency are ignored to save recalculating
+    // the filters on every loop
+    if (fabsf(freq - _hnotch_freq_hz) < 0.5f &&
+        _hnotch_bw_hz == _hnotch_bandwidth &&
+        _hnotch_att_db == _hnotch_attenuation &&
+        _hnotch_harmonics_mask == (uint8_t)_hnotch_harmonics) {
+        return;
+    }
+
+    _hnotch_freq_hz = freq;
+    _hnotch_bw_hz = _hnotch_bandwidth;
+    _hnotch_att_db = _hnotch_attenuation;
+    _hnotch_harmonics_mask = _hnotch_harmonics;
+    _hnotch_version++;
+}
+#endif
+
+#if INS_GYRO_WINDOW_ENABLED
+/*
+  allocate the gyro window. Backends start filling it on their next
+  sample
+ */
+bool AP_InertialSensor::enable_gyro_window(uint16_t size)
+{
+    if (_gyro_window != NULL) {
+        return true;
+    }
+    // one slot is kept empty to tell a full buffer from an empty one
+    Vector3f *window = (Vector3f *)calloc(size+1, sizeof(Vector3f));
+    if (window == NULL) {
+        return false;
+    }
+    _gyro_window_size = size+1;
+    _gyro_window_head = 0;
+    _gyro_window_tail = 0;
+    _gyro_window = window;
+    return true;
+}
+
+uint16_t AP_InertialSensor::read_gyro_window(Vector3f *samples, uint16_t max)
+{
+    if (_gyro_window == NULL) {
+        return 0;
+    }
+    uint16_t _tail;
+    uint16_t n = BUF_AVAILABLE(_gyro_window);
+    if (n > max) {
+        n = max;
+    }
+    for (uint16_t i=0; i<n; i++) {
+        samples[i] = _gyro_window[_gyro_window_head];
+        BUF_ADVANCEHEAD(_gyro_window, 1);
+    }
+    return n;
+}
+
+/*
+  add a sample to the gyro window, dropping it if the window is full
+ */
+void AP_InertialSensor::_push_gyro_window(const Vector3f &gyro)
+{
+    if (_gyro_window == NULL) {
+        return;
+    }
+    uint16_t _head;
+    if (BUF_SPACE(_gyro_window) == 0) {
+        _gyro_window_drops++;
+        return;
+    }
+    _gyro_window[_gyro_window_tail] = gyro;
+    BUF_ADVANCETAIL(_gyro_window, 1);
+}
+#endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+/*
+  add a raw sample to the batch being captured. Samples of the other
+  sensor type, and any after the batch is full, are ignored
+ */
+void AP_InertialSensor::_push_batch_sample(enum ins_batch_type_t type, const Vector3f &sample)
+{
+    if (_batch_data == NULL || type != _batch_type) {
+        return;
+    }
+    uint16_t i = _batch_captured;
+    if (i >= _batch_size) {
+        return;
+    }
+    if (i == 0) {
+        _batch_start_us = hal.scheduler->micros64();
+    }
+    const float mul = (type == INS_BATCH_ACCEL) ? INS_BATCH_ACCEL_MULTIPLIER : INS_BATCH_GYRO_MULTIPLIER;
+    _batch_data[i]                 = constrain_float(sample.x * mul, -32767, 32767);
+    _batch_data[_batch_size + i]   = constrain_float(sample.y * mul, -32767, 32767);
+    _batch_data[2*_batch_size + i] = constrain_float(sample.z * mul, -32767, 32767);
+    _batch_captured = i + 1;
+}
+
+/*
+  start capturing a batch of the next sensor type in the mask. The
+  type must be changed before the count is cleared, as clearing the
+  count is what lets the backend start writing
+ */
+void AP_InertialSensor::_next_batch(void)
+{
+    uint8_t type = _batch_type;
+    for (uint8_t i=0; i<2; i++) {
+        type = (type + 1) % 2;
+        if (_batch_mask & (1U<<type)) {
+            break;
+        }
+    }
+    _batch_type = type;
+    _batch_written = 0;
+    _batch_captured = 0;
+}
+
+void AP_InertialSensor::write_batch_log(void)
+{
+    if (_batch_mask == 0 || _dataflash == NULL) {
+        return;
+    }
+
+    if (_batch_data == NULL) {
+        uint16_t size = constrain_int16(_batch_samples, INS_BATCH_SAMPLES_PER_MSG, 4096);
+        size -= size % INS_BATCH_SAMPLES_PER_MSG;
+        _batch_data = (int16_t *)calloc(3 * size, sizeof(int16_t));
+        if (_batch_data == NULL) {
+            hal.console->println_P(PSTR("INS: not enough memory for batch sampler"));
+            _batch_mask.set(0);
+            return;
+        }
+        _batch_size = size;
+        _next_batch();
+        return;
+    }
+
+    if (_batch_captured < _batch_size) {
+        // still capturing
+        return;
+    }
+
+    if (!_dataflash->logging_started()) {
+        // don't let a stale batch be written when logging starts
+        _next_batch();
+        return;
+    }
+
+    const uint16_t rate_hz = (_batch_type == INS_BATCH_ACCEL) ? _accel_raw_rate_hz : _gyro_raw_rate_hz;
+    for (uint8_t n=0; n<_batch_msgs_per_call; n++) {
+        if (_batch_written == 0) {
+            struct log_ISBH hdr = {
+                LOG_PACKET_HEADER_INIT(LOG_ISBH_MSG),
+                time_us       : hal.scheduler->micros64(),
+                seqno         : _batch_seqno,
+                sensor_type   : _batch_type,
+                instance      : 0,
+                multiplier    : (_batch_type == INS_BATCH_ACCEL) ? INS_BATCH_ACCEL_MULTIPLIER : INS_BATCH_GYRO_MULTIPLIER,
+                sample_count  : _batch_size,
+                sample_us     : _batch_start_us,
+                sample_rate_hz: rate_hz
+            };
+            _dataflash->WriteBlock(&hdr, sizeof(hdr));
+        }
+
+        struct log_ISBD pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_ISBD_MSG),
+            time_us   : hal.scheduler->micros64(),
+            isb_seqno : _batch_seqno,
+            seqno     : (uint16_t)(_batch_written / INS_BATCH_SAMPLES_PER_MSG),
+            x         : {},
+            y         : {},
+            z         : {}
+        };
+        memcpy(pkt.x, &_batch_data[_batch_written], sizeof(pkt.x));
+        memcpy(pkt.y, &_batch_data[_batch_size + _batch_written], sizeof(pkt.y));
+        memcpy(pkt.z, &_batch_data[2*_batch_size + _batch_written], sizeof(pkt.z));
+        _dataflash->WriteBlock(&pkt, sizeof(pkt));
+
+        _batch_written += INS_BATCH_SAMPLES_PER_MSG;
+        if (_batch_written >= _batch_size) {
+            _batch_seqno++;
+            _next_batch();
+            break;
+        }
+    }
+}
+#endif
+
 /*
   wait for a sample to be available. This is the function that
   determines the timing of the main loop in ardupilot. 
@@ -1296,6 +1834,13 @@ void AP_InertialSensor::set_accel(uint8_t instance, const Vector3f &accel)
         if (!_accel_healthy[_primary_accel]) {
             _primary_accel = instance;
         }
+#if INS_BATCH_SAMPLER_ENABLED
+        if (instance == 0) {
+            // HIL and SITL give one accel sample per main loop
+            _accel_raw_rate_hz = _sample_rate;
+            _push_batch_sample(INS_BATCH_ACCEL, accel);
+        }
+#endif
     }
 }
 
@@ -1315,6 +1860,18 @@ void AP_InertialSensor::set_gyro(uint8_t instance, const Vector3f &gyro)
         if (!_accel_healthy[_primary_accel]) {
             _primary_accel = instance;
         }
+#if INS_RAW_SAMPLES_ENABLED
+        if (instance == 0) {
+            // HIL and SITL give one gyro sample per main loop
+            _gyro_raw_rate_hz = _sample_rate;
+#if INS_GYRO_WINDOW_ENABLED
+            _push_gyro_window(gyro);
+#endif
+#if INS_BATCH_SAMPLER_ENABLED
+            _push_batch_sample(INS_BATCH_GYRO, gyro);
+#endif
+        }
+#endif
     }
 }
 
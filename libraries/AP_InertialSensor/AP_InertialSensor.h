@@ -19,6 +19,80 @@
 #define INS_MAX_BACKENDS  1
 #endif
 
+/*
+  number of orientations an accel calibration can use. The first six
+  are the usual level, sides, nose and back positions, any more are
+  extra tilted positions that give the fit some redundancy so bad
+  samples can be rejected
+ */
+#define INS_ACCELCAL_MIN_POSITIONS 6
+#if HAL_CPU_CLASS > HAL_CPU_CLASS_16
+#define INS_ACCELCAL_MAX_POSITIONS 12
+#else
+#define INS_ACCELCAL_MAX_POSITIONS 6
+#endif
+
+/*
+  the gyro harmonic notch filter runs on every raw sample, so is only
+  available on boards with the CPU to spare
+ */
+#define INS_HARMONIC_NOTCH_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+
+/*
+  backends pass each raw sample from the first accel and gyro to the
+  frontend, for the gyro window and the batch sampler
+ */
+#define INS_RAW_SAMPLES_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+
+/*
+  raw samples from the first gyro can be kept for spectrum analysis
+  on boards with memory to spare
+ */
+#define INS_GYRO_WINDOW_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+
+/*
+  short batches of raw samples can be captured and written to the log
+  for vibration analysis and filter design
+ */
+#define INS_BATCH_SAMPLER_ENABLED INS_RAW_SAMPLES_ENABLED
+
+// number of samples of each axis in an ISBD log message
+#define INS_BATCH_SAMPLES_PER_MSG 32
+
+// scaling of raw samples into the int16_t values in the log. This
+// covers +-16g and +-2000 degrees/s
+#define INS_BATCH_ACCEL_MULTIPLIER (32767.0f / (16 * GRAVITY_MSS))
+#define INS_BATCH_GYRO_MULTIPLIER  (32767.0f / radians(2000))
+
+/*
+  how the centre frequency of the harmonic notch is chosen
+ */
+enum harmonic_notch_mode_t {
+    HNOTCH_MODE_FIXED=0,
+    HNOTCH_MODE_THROTTLE=1,
+    HNOTCH_MODE_TRACKED=2
+};
+
+/*
+  sensor types for the batch sampler, also the bit in INS_LOG_BAT_MASK
+ */
+enum ins_batch_type_t {
+    INS_BATCH_ACCEL=0,
+    INS_BATCH_GYRO=1
+};
+
+/*
+  state of a background accel calibration
+ */
+enum accel_cal_status_t {
+    ACCEL_CAL_NOT_STARTED=0,
+    ACCEL_CAL_WAITING_FOR_ORIENTATION=1,
+    ACCEL_CAL_COLLECTING_SAMPLE=2,
+    ACCEL_CAL_FITTING=3,
+    ACCEL_CAL_SUCCESS=4,
+    ACCEL_CAL_FAILED=5
+};
+
 
 #include <stdint.h>
 #include <AP_HAL.h>
@@ -83,10 +157,39 @@ public:
 
 #if !defined( __AVR_ATmega1280__ )
     // perform accelerometer calibration including providing user instructions
-    // and feedback
+    // and feedback. This blocks until the calibration is finished
     bool calibrate_accel(AP_InertialSensor_UserInteract *interact,
                          float& trim_roll,
                          float& trim_pitch);
+
+    /*
+      background accel calibration. After accel_cal_start() the user
+      is asked for each orientation in turn (see
+      accel_cal_orientation()) and accel_cal_collect_sample() is
+      called once the vehicle is in place. Sampling is done in
+      update() and the fit by accel_cal_update(), which should be
+      called at 10Hz or more
+     */
+    bool accel_cal_start(void);
+    bool accel_cal_collect_sample(void);
+    void accel_cal_update(void);
+    void accel_cal_cancel(void);
+    enum accel_cal_status_t accel_cal_status(void) const { return _acal_status; }
+
+    // the orientation being asked for, and how many there are
+    uint8_t accel_cal_step(void) const { return _acal_step; }
+    uint8_t accel_cal_num_steps(void) const { return _acal_num_steps; }
+    static const prog_char_t *accel_cal_orientation(uint8_t step);
+
+    // RMS residual of the fit in m/s/s, worst over all accels
+    float accel_cal_fitness(void) const { return _acal_fitness; }
+
+    // why the last calibration failed
+    const prog_char_t *accel_cal_fail_reason(void) const { return _acal_fail_msg; }
+
+    // get the trims from a successful calibration. Returns true only
+    // once per calibration
+    bool accel_cal_get_trim(float &trim_roll, float &trim_pitch);
 #endif
     bool calibrate_trim(float &trim_roll, float &trim_pitch);
 
@@ -216,6 +319,46 @@ public:
     // enable/disable raw gyro/accel logging
     void set_raw_logging(bool enable) { _log_raw_data = enable; }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // set the throttle, from 0 to 1, used to track the motor
+    // frequency with the harmonic notch
+    void set_harmonic_notch_throttle(float throttle) { _hnotch_throttle = throttle; }
+
+    // set the frequency measured by a spectrum analysis of the
+    // gyros, used in tracked mode
+    void set_harmonic_notch_tracked_freq(float freq_hz) { _hnotch_tracked_freq = freq_hz; }
+
+    // get the current centre frequency of the harmonic notch, or
+    // zero if it is disabled
+    float get_harmonic_notch_freq_hz(void) const { return _hnotch_freq_hz; }
+#endif
+
+#if INS_GYRO_WINDOW_ENABLED
+    // start keeping raw samples from the first gyro, at the rate the
+    // backend reads the sensor. size is the number of samples that
+    // can be held between calls to read_gyro_window()
+    bool enable_gyro_window(uint16_t size);
+
+    // read up to max of the oldest raw gyro samples, in rad/s in
+    // sensor frame. Returns the number read
+    uint16_t read_gyro_window(Vector3f *samples, uint16_t max);
+
+    // sample rate of the gyro window, or zero if not known yet
+    uint16_t get_gyro_window_rate_hz(void) const { return _gyro_raw_rate_hz; }
+
+    // number of samples dropped because the window was full. A
+    // change in this means the samples read are not contiguous
+    uint32_t get_gyro_window_drops(void) const { return _gyro_window_drops; }
+#endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+    // write the current batch of raw samples to the log a few
+    // messages at a time, and start capturing the next batch once it
+    // has all been written. Should be called at 50Hz from a low
+    // priority task
+    void write_batch_log(void);
+#endif
+
 private:
 
     // load backend drivers
@@ -230,10 +373,28 @@ private:
     // blog post describing the method: http://chionophilous.wordpress.com/2011/10/24/accelerometer-calibration-iv-1-implementing-gauss-newton-on-an-atmega/
     // original sketch available at http://rolfeschmidt.com/mathtools/skimetrics/adxl_gn_calibration.pde
 
-    // _calibrate_accel - perform low level accel calibration
-    bool _calibrate_accel(const Vector3f accel_sample[6], Vector3f& accel_offsets, Vector3f& accel_scale, enum Rotation r);
-    bool _check_sample_range(const Vector3f accel_sample[6], enum Rotation rotation, 
-                             AP_InertialSensor_UserInteract* interact);
+
+    // per accel state of a background calibration
+    struct AccelCalState {
+        Vector3f samples[INS_ACCELCAL_MAX_POSITIONS];
+        uint8_t num_samples;
+        float beta[6];
+        uint8_t iterations;
+        bool done;
+        float fitness;
+        Vector3f orig_offset;
+        Vector3f orig_scale;
+    };
+
+    void _acal_accumulate(void);
+    void _acal_fail(const prog_char_t *msg);
+    void _acal_finish(void);
+    void _acal_restore(void);
+    bool _acal_fit_step(struct AccelCalState &cal);
+    float _acal_residual(const struct AccelCalState &cal, const Vector3f &sample) const;
+    void _acal_get_calibration(const struct AccelCalState &cal, Vector3f &accel_offsets, Vector3f &accel_scale) const;
+
+    bool _check_sample_range(const Vector3f *accel_sample, uint8_t num_samples, enum Rotation rotation);
     void _calibrate_update_matrices(float dS[6], float JS[6][6], float beta[6], float data[3]);
     void _calibrate_reset_matrices(float dS[6], float JS[6][6]);
     void _calibrate_find_delta(float dS[6], float JS[6][6], float delta[6]);
@@ -243,6 +404,19 @@ private:
     // save parameters to eeprom
     void  _save_parameters();
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    void _update_harmonic_notch(void);
+#endif
+
+#if INS_GYRO_WINDOW_ENABLED
+    void _push_gyro_window(const Vector3f &gyro);
+#endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+    void _push_batch_sample(enum ins_batch_type_t type, const Vector3f &sample);
+    void _next_batch(void);
+#endif
+
     // backend objects
     AP_InertialSensor_Backend *_backends[INS_MAX_BACKENDS];
 
@@ -324,6 +498,89 @@ private:
     uint32_t _gyro_error_count[INS_MAX_INSTANCES];
 
     DataFlash_Class *_dataflash;
+
+#if !defined( __AVR_ATmega1280__ )
+    // number of orientations to use for accel calibration
+    AP_Int8 _acal_positions;
+
+    // background accel calibration state. _acal is only allocated
+    // while a calibration is running
+    struct AccelCalState *_acal;
+    enum accel_cal_status_t _acal_status;
+    uint8_t _acal_num_accels;
+    uint8_t _acal_step;
+    uint8_t _acal_num_steps;
+    uint32_t _acal_step_start_ms;
+    uint16_t _acal_sample_count;
+    Vector3f _acal_sum[INS_MAX_INSTANCES];
+    Vector3f _acal_level_sample;
+    enum Rotation _acal_saved_orientation;
+    float _acal_fitness;
+    float _acal_trim_roll;
+    float _acal_trim_pitch;
+    bool _acal_have_trim;
+    const prog_char_t *_acal_fail_msg;
+#endif
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    // gyro harmonic notch settings
+    AP_Int8 _hnotch_enable;
+    AP_Float _hnotch_base_freq;
+    AP_Float _hnotch_bandwidth;
+    AP_Float _hnotch_attenuation;
+    AP_Int8 _hnotch_harmonics;
+    AP_Int8 _hnotch_mode;
+    AP_Float _hnotch_ref;
+
+    // the settings the backends should use. _hnotch_version is
+    // incremented each time they change so backends know to update
+    // their filters
+    float _hnotch_throttle;
+    float _hnotch_tracked_freq;
+    float _hnotch_freq_hz;
+    float _hnotch_bw_hz;
+    float _hnotch_att_db;
+    uint8_t _hnotch_harmonics_mask;
+    uint8_t _hnotch_version;
+#endif
+
+#if INS_RAW_SAMPLES_ENABLED
+    // rate the backends read raw samples from the first accel and
+    // gyro, or zero if not known
+    uint16_t _accel_raw_rate_hz;
+    uint16_t _gyro_raw_rate_hz;
+#endif
+
+#if INS_GYRO_WINDOW_ENABLED
+    // ring buffer of raw samples from the first gyro. Written by the
+    // backend, which may be on a timer thread, and read by
+    // read_gyro_window()
+    Vector3f *_gyro_window;
+    uint16_t _gyro_window_size;
+    volatile uint16_t _gyro_window_head;
+    volatile uint16_t _gyro_window_tail;
+    volatile uint32_t _gyro_window_drops;
+#endif
+
+#if INS_BATCH_SAMPLER_ENABLED
+    // batch sampler settings
+    AP_Int8 _batch_mask;
+    AP_Int16 _batch_samples;
+    AP_Int8 _batch_msgs_per_call;
+
+    // one batch of raw samples, all the x values, then y, then z. The
+    // backend fills it until _batch_captured reaches _batch_size, then
+    // write_batch_log() empties it into the log. _batch_data is
+    // allocated on the first call to write_batch_log() with
+    // INS_LOG_BAT_MASK set
+    int16_t *_batch_data;
+    uint16_t _batch_size;
+    volatile uint8_t _batch_type;
+    volatile uint16_t _batch_captured;
+    uint64_t _batch_start_us;
+    uint16_t _batch_written;
+    uint16_t _batch_seqno;
+#endif
 };
 
 #include "AP_InertialSensor_Backend.h"
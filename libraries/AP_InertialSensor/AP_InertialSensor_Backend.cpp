@@ -3,10 +3,14 @@
 #include <AP_HAL.h>
 #include "AP_InertialSensor.h"
 #include "AP_InertialSensor_Backend.h"
+#include <NotchFilter.h>
 
 AP_InertialSensor_Backend::AP_InertialSensor_Backend(AP_InertialSensor &imu) :
     _imu(imu),
     _product_id(AP_PRODUCT_ID_NONE)
+#if INS_HARMONIC_NOTCH_ENABLED
+    ,_gyro_notch_version(0)
+#endif
 {}
 
 void AP_InertialSensor_Backend::_rotate_and_correct_accel(uint8_t instance, Vector3f &accel) 
@@ -104,3 +108,57 @@ void AP_InertialSensor_Backend::_publish_temperature(uint8_t instance, float tem
 {
     _imu._temperature[instance] = temperature;
 }
+
+#if INS_HARMONIC_NOTCH_ENABLED
+bool AP_InertialSensor_Backend::_gyro_notch_changed(void)
+{
+    if (_gyro_notch_version == _imu._hnotch_version) {
+        return false;
+    }
+    _gyro_notch_version = _imu._hnotch_version;
+    return true;
+}
+
+void AP_InertialSensor_Backend::_setup_gyro_notch(HarmonicNotchFilterVector3f &notch, uint16_t sample_rate_hz)
+{
+    notch.update(sample_rate_hz, _imu._hnotch_freq_hz, _imu._hnotch_bw_hz,
+                 _imu._hnotch_att_db, _imu._hnotch_harmonics_mask);
+}
+#endif
+
+#if INS_RAW_SAMPLES_ENABLED
+void AP_InertialSensor_Backend::_set_accel_raw_sample_rate(uint8_t instance, uint16_t rate_hz)
+{
+    if (instance == 0) {
+        _imu._accel_raw_rate_hz = rate_hz;
+    }
+}
+
+void AP_InertialSensor_Backend::_set_gyro_raw_sample_rate(uint8_t instance, uint16_t rate_hz)
+{
+    if (instance == 0) {
+        _imu._gyro_raw_rate_hz = rate_hz;
+    }
+}
+
+void AP_InertialSensor_Backend::_notify_new_accel_raw_sample(uint8_t instance, const Vector3f &accel)
+{
+#if INS_BATCH_SAMPLER_ENABLED
+    if (instance == 0) {
+        _imu._push_batch_sample(INS_BATCH_ACCEL, accel);
+    }
+#endif
+}
+
+void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &gyro)
+{
+    if (instance == 0) {
+#if INS_GYRO_WINDOW_ENABLED
+        _imu._push_gyro_window(gyro);
+#endif
+#if INS_BATCH_SAMPLER_ENABLED
+        _imu._push_batch_sample(INS_BATCH_GYRO, gyro);
+#endif
+    }
+}
+#endif
@@ -24,6 +24,8 @@
 #ifndef __AP_INERTIALSENSOR_BACKEND_H__
 #define __AP_INERTIALSENSOR_BACKEND_H__
 
+class HarmonicNotchFilterVector3f;
+
 class AP_InertialSensor_Backend
 {
 public:
@@ -94,6 +96,30 @@ protected:
     // return the requested sample rate in Hz
     uint16_t get_sample_rate_hz(void) const;
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // return true once each time the harmonic notch settings change,
+    // when the backend should call _setup_gyro_notch() for each of
+    // its gyro notch filters
+    bool _gyro_notch_changed(void);
+
+    // set up a gyro notch filter for the raw sample rate of the sensor
+    void _setup_gyro_notch(HarmonicNotchFilterVector3f &notch, uint16_t sample_rate_hz);
+
+    uint8_t _gyro_notch_version;
+#endif
+
+#if INS_RAW_SAMPLES_ENABLED
+    // set the rate raw samples are read from the sensor
+    void _set_accel_raw_sample_rate(uint8_t instance, uint16_t rate_hz);
+    void _set_gyro_raw_sample_rate(uint8_t instance, uint16_t rate_hz);
+
+    // pass a raw sample in m/s/s or rad/s, in sensor frame, to the
+    // gyro window and batch sampler. Called for every sample read
+    // from the sensor
+    void _notify_new_accel_raw_sample(uint8_t instance, const Vector3f &accel);
+    void _notify_new_gyro_raw_sample(uint8_t instance, const Vector3f &gyro);
+#endif
+
     // access to frontend dataflash
     DataFlash_Class *get_dataflash(void) const { 
         return _imu._log_raw_data? _imu._dataflash : NULL; 
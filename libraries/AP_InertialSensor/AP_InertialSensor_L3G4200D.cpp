@@ -225,6 +225,10 @@ bool AP_InertialSensor_L3G4200D::_init_sensor(void)
 
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+#if INS_RAW_SAMPLES_ENABLED
+    _set_accel_raw_sample_rate(_accel_instance, 800);
+    _set_gyro_raw_sample_rate(_gyro_instance, 800);
+#endif
 
     _product_id = AP_PRODUCT_ID_L3G4200D;
 
@@ -267,6 +271,12 @@ bool AP_InertialSensor_L3G4200D::update(void)
         _last_filter_hz = _accel_filter_cutoff();
     }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    if (_gyro_notch_changed()) {
+        _setup_gyro_notch(_gyro_notch, 800);
+    }
+#endif
+
     return true;
 }
 
@@ -304,10 +314,19 @@ void AP_InertialSensor_L3G4200D::_accumulate(void)
         int16_t buffer[num_samples_available][3];
         if (hal.i2c->readRegisters(L3G4200D_I2C_ADDRESS, L3G4200D_REG_XL | L3G4200D_REG_AUTO_INCREMENT, 
                                    sizeof(buffer), (uint8_t *)&buffer[0][0]) == 0) {
+            Vector3f gyro[num_samples_available];
             for (uint8_t i=0; i<num_samples_available; i++) {
-                _data[_data_idx].gyro_filtered = _gyro_filter.apply(Vector3f(buffer[i][0], -buffer[i][1], -buffer[i][2]));
-                _have_gyro_sample = true;
+                gyro[i] = Vector3f(buffer[i][0], -buffer[i][1], -buffer[i][2]);
+#if INS_RAW_SAMPLES_ENABLED
+                _notify_new_gyro_raw_sample(_gyro_instance, gyro[i] * L3G4200D_GYRO_SCALE_R_S);
+#endif
+#if INS_HARMONIC_NOTCH_ENABLED
+                gyro[i] = _gyro_notch.apply(gyro[i]);
+#endif
             }
+            // low pass filter the whole FIFO in one pass
+            _data[_data_idx].gyro_filtered = _gyro_filter.apply_block(gyro, num_samples_available);
+            _have_gyro_sample = true;
         }
     }
 
@@ -324,10 +343,15 @@ void AP_InertialSensor_L3G4200D::_accumulate(void)
                                            ADXL345_ACCELEROMETER_ADXLREG_DATAX0, 
                                            sizeof(buffer[0]), num_samples_available,
                                            (uint8_t *)&buffer[0][0]) == 0) {
+            Vector3f accel[num_samples_available];
             for (uint8_t i=0; i<num_samples_available; i++) {
-                _data[_data_idx].accel_filtered = _accel_filter.apply(Vector3f(buffer[i][0], -buffer[i][1], -buffer[i][2]));
-                _have_accel_sample = true;
+                accel[i] = Vector3f(buffer[i][0], -buffer[i][1], -buffer[i][2]);
+#if INS_RAW_SAMPLES_ENABLED
+                _notify_new_accel_raw_sample(_accel_instance, accel[i] * ADXL345_ACCELEROMETER_SCALE_M_S);
+#endif
             }
+            _data[_data_idx].accel_filtered = _accel_filter.apply_block(accel, num_samples_available);
+            _have_accel_sample = true;
         }
     }
 
@@ -11,6 +11,7 @@
 #include "AP_InertialSensor.h"
 #include <Filter.h>
 #include <LowPassFilter2p.h>
+#include <NotchFilter.h>
 
 class AP_InertialSensor_L3G4200D : public AP_InertialSensor_Backend
 {
@@ -55,6 +56,11 @@ private:
     LowPassFilter2pVector3f _accel_filter;
     LowPassFilter2pVector3f _gyro_filter;
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // notch on motor noise, applied before the low pass filter
+    HarmonicNotchFilterVector3f _gyro_notch;
+#endif
+
     // gyro and accel instances
     uint8_t _gyro_instance;
     uint8_t _accel_instance;
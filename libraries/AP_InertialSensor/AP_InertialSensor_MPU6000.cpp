@@ -250,6 +250,10 @@ bool AP_InertialSensor_MPU6000::_init_sensor(void)
     // grab the used instances
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+#if INS_RAW_SAMPLES_ENABLED
+    _set_accel_raw_sample_rate(_accel_instance, 1000);
+    _set_gyro_raw_sample_rate(_gyro_instance, 1000);
+#endif
 
     hal.scheduler->resume_timer_procs();
     
@@ -316,6 +320,12 @@ bool AP_InertialSensor_MPU6000::update( void )
         _gyro_filter.set_cutoff_frequency(1000, _gyro_filter_cutoff());
         _last_gyro_filter_hz = _gyro_filter_cutoff();
     }
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    if (_gyro_notch_changed()) {
+        _setup_gyro_notch(_gyro_notch, 1000);
+    }
+#endif
 #else
     if (_last_accel_filter_hz != _accel_filter_cutoff()) {
         if (_spi_sem->take(10)) {
@@ -391,13 +401,22 @@ void AP_InertialSensor_MPU6000::_read_data_transaction() {
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 #if MPU6000_FAST_SAMPLING
-    _accel_filtered = _accel_filter.apply(Vector3f(int16_val(rx.v, 1),
-                                                   int16_val(rx.v, 0),
-                                                   -int16_val(rx.v, 2)));
-
-    _gyro_filtered = _gyro_filter.apply(Vector3f(int16_val(rx.v, 5),
-                                                 int16_val(rx.v, 4),
-                                                 -int16_val(rx.v, 6)));
+    Vector3f accel(int16_val(rx.v, 1),
+                   int16_val(rx.v, 0),
+                   -int16_val(rx.v, 2));
+    _accel_filtered = _accel_filter.apply(accel);
+
+    Vector3f gyro(int16_val(rx.v, 5),
+                  int16_val(rx.v, 4),
+                  -int16_val(rx.v, 6));
+#if INS_RAW_SAMPLES_ENABLED
+    _notify_new_accel_raw_sample(_accel_instance, accel * MPU6000_ACCEL_SCALE_1G);
+    _notify_new_gyro_raw_sample(_gyro_instance, gyro * _gyro_scale);
+#endif
+#if INS_HARMONIC_NOTCH_ENABLED
+    gyro = _gyro_notch.apply(gyro);
+#endif
+    _gyro_filtered = _gyro_filter.apply(gyro);
 #else
     _accel_sum.x += int16_val(rx.v, 1);
     _accel_sum.y += int16_val(rx.v, 0);
@@ -22,6 +22,7 @@
 #if MPU6000_FAST_SAMPLING
 #include <Filter.h>
 #include <LowPassFilter2p.h>
+#include <NotchFilter.h>
 #endif
 
 class AP_InertialSensor_MPU6000 : public AP_InertialSensor_Backend
@@ -83,6 +84,11 @@ private:
     // Low Pass filters for gyro and accel 
     LowPassFilter2pVector3f _accel_filter;
     LowPassFilter2pVector3f _gyro_filter;
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    // notch on motor noise, applied before the low pass filter
+    HarmonicNotchFilterVector3f _gyro_notch;
+#endif
 #else
     // accumulation in timer - must be read with timer disabled
     // the sum of the values since last read
@@ -467,6 +467,10 @@ bool AP_InertialSensor_MPU9150::_init_sensor(void)
 
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+#if INS_RAW_SAMPLES_ENABLED
+    _set_accel_raw_sample_rate(_accel_instance, 800);
+    _set_gyro_raw_sample_rate(_gyro_instance, 800);
+#endif
 
     // start the timer process to read samples    
     hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_MPU9150::_accumulate, void));
@@ -1088,7 +1092,15 @@ void AP_InertialSensor_MPU9150::_accumulate(void)
         //  is because the sensor is placed in the bottom side of the board?
         _accel_filtered = _accel_filter.apply(Vector3f(accel_x, accel_y, accel_z));
 
+#if INS_RAW_SAMPLES_ENABLED
+        _notify_new_accel_raw_sample(_accel_instance, Vector3f(accel_x, accel_y, accel_z) * MPU9150_ACCEL_SCALE_2G);
+        _notify_new_gyro_raw_sample(_gyro_instance, Vector3f(gyro_x, gyro_y, gyro_z) * MPU9150_GYRO_SCALE_2000);
+#endif
+#if INS_HARMONIC_NOTCH_ENABLED
+        _gyro_filtered = _gyro_filter.apply(_gyro_notch.apply(Vector3f(gyro_x, gyro_y, gyro_z)));
+#else
         _gyro_filtered = _gyro_filter.apply(Vector3f(gyro_x, gyro_y, gyro_z));
+#endif
 
         _have_sample_available = true;
     }
@@ -1123,6 +1135,12 @@ bool AP_InertialSensor_MPU9150::update(void)
         _last_gyro_filter_hz = _gyro_filter_cutoff();
     }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    if (_gyro_notch_changed()) {
+        _setup_gyro_notch(_gyro_notch, 800);
+    }
+#endif
+
     return true;
 }
 
@@ -10,6 +10,7 @@
 #include "AP_InertialSensor.h"
 #include <Filter.h>
 #include <LowPassFilter2p.h>
+#include <NotchFilter.h>
 
 
 class AP_InertialSensor_MPU9150 : public AP_InertialSensor_Backend
@@ -56,6 +57,11 @@ private:
     LowPassFilter2pVector3f _accel_filter;
     LowPassFilter2pVector3f _gyro_filter;
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // notch on motor noise, applied before the low pass filter
+    HarmonicNotchFilterVector3f _gyro_notch;
+#endif
+
     uint8_t _gyro_instance;
     uint8_t _accel_instance;
 };
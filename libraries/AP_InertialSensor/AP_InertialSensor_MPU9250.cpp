@@ -245,11 +245,16 @@ bool AP_InertialSensor_MPU9250::_init_sensor(void)
 
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+#if INS_RAW_SAMPLES_ENABLED
+    _set_accel_raw_sample_rate(_accel_instance, 1000);
+    _set_gyro_raw_sample_rate(_gyro_instance, 1000);
+#endif
 
     _product_id = AP_PRODUCT_ID_MPU9250;
 
     // start the timer process to read samples
-    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_MPU9250::_poll_data, void));
+    hal.scheduler->register_bus_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_MPU9250::_poll_data, void),
+                                        _spi_sem, 1000);
 
 #if MPU9250_DEBUG
     _dump_registers();
@@ -303,6 +308,12 @@ bool AP_InertialSensor_MPU9250::update( void )
         _last_gyro_filter_hz = _gyro_filter_cutoff();
     }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    if (_gyro_notch_changed()) {
+        _setup_gyro_notch(_gyro_notch, 1000);
+    }
+#endif
+
     return true;
 }
 
@@ -343,13 +354,22 @@ void AP_InertialSensor_MPU9250::_read_data_transaction()
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 
-    Vector3f _accel_filtered = _accel_filter.apply(Vector3f(int16_val(rx.v, 1),
-                                                   int16_val(rx.v, 0),
-                                                   -int16_val(rx.v, 2)));
-
-    Vector3f _gyro_filtered = _gyro_filter.apply(Vector3f(int16_val(rx.v, 5),
-                                                 int16_val(rx.v, 4),
-                                                 -int16_val(rx.v, 6)));
+    Vector3f accel(int16_val(rx.v, 1),
+                   int16_val(rx.v, 0),
+                   -int16_val(rx.v, 2));
+    Vector3f _accel_filtered = _accel_filter.apply(accel);
+
+    Vector3f gyro(int16_val(rx.v, 5),
+                  int16_val(rx.v, 4),
+                  -int16_val(rx.v, 6));
+#if INS_RAW_SAMPLES_ENABLED
+    _notify_new_accel_raw_sample(_accel_instance, accel * MPU9250_ACCEL_SCALE_1G);
+    _notify_new_gyro_raw_sample(_gyro_instance, gyro * GYRO_SCALE);
+#endif
+#if INS_HARMONIC_NOTCH_ENABLED
+    gyro = _gyro_notch.apply(gyro);
+#endif
+    Vector3f _gyro_filtered = _gyro_filter.apply(gyro);
     // update the shared buffer
     uint8_t idx = _shared_data_idx ^ 1;
     _shared_data[idx]._accel_filtered = _accel_filtered;
@@ -9,6 +9,7 @@
 #include <AP_Progmem.h>
 #include <Filter.h>
 #include <LowPassFilter2p.h>
+#include <NotchFilter.h>
 #include "AP_InertialSensor.h"
 
 // enable debug to see a register dump on startup
@@ -65,6 +66,11 @@ private:
     LowPassFilter2pVector3f _accel_filter;
     LowPassFilter2pVector3f _gyro_filter;
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // notch on motor noise, applied before the low pass filter
+    HarmonicNotchFilterVector3f _gyro_notch;
+#endif
+
     // do we currently have a sample pending?
     bool _have_sample_available;
 
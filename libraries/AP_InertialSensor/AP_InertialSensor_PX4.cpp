@@ -155,6 +155,22 @@ bool AP_InertialSensor_PX4::_init_sensor(void)
         }
     }
 
+    // the sample rates don't change after this, so read them once
+    for (uint8_t i=0; i<_num_accel_instances; i++) {
+        int samplerate = ioctl(_accel_fd[i],  ACCELIOCGSAMPLERATE, 0);
+        _accel_sample_rate[i] = (samplerate < 100 || samplerate > 2000) ? 0 : samplerate;
+#if INS_RAW_SAMPLES_ENABLED
+        _set_accel_raw_sample_rate(_accel_instance[i], _accel_sample_rate[i]);
+#endif
+    }
+    for (uint8_t i=0; i<_num_gyro_instances; i++) {
+        int samplerate = ioctl(_gyro_fd[i],  GYROIOCGSAMPLERATE, 0);
+        _gyro_sample_rate[i] = (samplerate < 100 || samplerate > 2000) ? 0 : samplerate;
+#if INS_RAW_SAMPLES_ENABLED
+        _set_gyro_raw_sample_rate(_gyro_instance[i], _gyro_sample_rate[i]);
+#endif
+    }
+
     _set_accel_filter_frequency(_accel_filter_cutoff());
     _set_gyro_filter_frequency(_gyro_filter_cutoff());
 
@@ -176,8 +192,8 @@ bool AP_InertialSensor_PX4::_init_sensor(void)
 void AP_InertialSensor_PX4::_set_accel_filter_frequency(uint8_t filter_hz)
 {
     for (uint8_t i=0; i<_num_accel_instances; i++) {
-        int samplerate = ioctl(_accel_fd[i],  ACCELIOCGSAMPLERATE, 0);
-        if(samplerate < 100 || samplerate > 2000) {
+        uint16_t samplerate = _accel_sample_rate[i];
+        if (samplerate == 0) {
             // sample rate doesn't seem sane, turn off filter
             _accel_filter[i].set_cutoff_frequency(0, 0);
         } else {
@@ -192,8 +208,8 @@ void AP_InertialSensor_PX4::_set_accel_filter_frequency(uint8_t filter_hz)
 void AP_InertialSensor_PX4::_set_gyro_filter_frequency(uint8_t filter_hz)
 {
     for (uint8_t i=0; i<_num_gyro_instances; i++) {
-        int samplerate = ioctl(_gyro_fd[i],  GYROIOCGSAMPLERATE, 0);
-        if(samplerate < 100 || samplerate > 2000) {
+        uint16_t samplerate = _gyro_sample_rate[i];
+        if (samplerate == 0) {
             // sample rate doesn't seem sane, turn off filter
             _gyro_filter[i].set_cutoff_frequency(0, 0);
         } else {
@@ -202,6 +218,19 @@ void AP_InertialSensor_PX4::_set_gyro_filter_frequency(uint8_t filter_hz)
     }
 }
 
+#if INS_HARMONIC_NOTCH_ENABLED
+/*
+  update the gyro notch filters from the harmonic notch settings
+ */
+void AP_InertialSensor_PX4::_set_gyro_notch(void)
+{
+    for (uint8_t i=0; i<_num_gyro_instances; i++) {
+        // a zero sample rate turns off the notch
+        _setup_gyro_notch(_gyro_notch[i], _gyro_sample_rate[i]);
+    }
+}
+#endif
+
 bool AP_InertialSensor_PX4::update(void) 
 {
     // get the latest sample from the sensor drivers
@@ -244,6 +273,12 @@ bool AP_InertialSensor_PX4::update(void)
         _set_gyro_filter_frequency(_gyro_filter_cutoff());
         _last_gyro_filter_hz = _gyro_filter_cutoff();
     }
+
+#if INS_HARMONIC_NOTCH_ENABLED
+    if (_gyro_notch_changed()) {
+        _set_gyro_notch();
+    }
+#endif
     
     return true;
 }
@@ -253,6 +288,10 @@ void AP_InertialSensor_PX4::_new_accel_sample(uint8_t i, accel_report &accel_rep
     Vector3f accel = Vector3f(accel_report.x, accel_report.y, accel_report.z);
     uint8_t frontend_instance = _accel_instance[i];
 
+#if INS_RAW_SAMPLES_ENABLED
+    _notify_new_accel_raw_sample(frontend_instance, accel);
+#endif
+
     // apply corrections
     _rotate_and_correct_accel(frontend_instance, accel);
 
@@ -300,11 +339,19 @@ void AP_InertialSensor_PX4::_new_gyro_sample(uint8_t i, gyro_report &gyro_report
     Vector3f gyro = Vector3f(gyro_report.x, gyro_report.y, gyro_report.z);
     uint8_t frontend_instance = _gyro_instance[i];
 
+#if INS_RAW_SAMPLES_ENABLED
+    _notify_new_gyro_raw_sample(frontend_instance, gyro);
+#endif
+
     // apply corrections
     _rotate_and_correct_gyro(frontend_instance, gyro);
 
     // apply filter for control path
+#if INS_HARMONIC_NOTCH_ENABLED
+    _gyro_in[i] = _gyro_filter[i].apply(_gyro_notch[i].apply(gyro));
+#else
     _gyro_in[i] = _gyro_filter[i].apply(gyro);
+#endif
 
     // compute time since last sample - not more than 50ms
     float dt = min((gyro_report.timestamp - _last_gyro_timestamp[i]) * 1.0e-6f, 0.05f);
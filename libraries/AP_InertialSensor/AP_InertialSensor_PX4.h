@@ -15,6 +15,7 @@
 
 #include <Filter.h>
 #include <LowPassFilter2p.h>
+#include <NotchFilter.h>
 
 class AP_InertialSensor_PX4 : public AP_InertialSensor_Backend
 {
@@ -59,6 +60,9 @@ private:
 
     void _set_gyro_filter_frequency(uint8_t filter_hz);
     void _set_accel_filter_frequency(uint8_t filter_hz);
+#if INS_HARMONIC_NOTCH_ENABLED
+    void _set_gyro_notch(void);
+#endif
 
     // accelerometer and gyro driver handles
     uint8_t _num_accel_instances;
@@ -67,6 +71,10 @@ private:
     int _accel_fd[INS_MAX_INSTANCES];
     int _gyro_fd[INS_MAX_INSTANCES];
 
+    // sensor sample rates read at init, 0 if not sane
+    uint16_t _accel_sample_rate[INS_MAX_INSTANCES];
+    uint16_t _gyro_sample_rate[INS_MAX_INSTANCES];
+
     // indexes in frontend object. Note that these could be different
     // from the backend indexes
     uint8_t _accel_instance[INS_MAX_INSTANCES];
@@ -76,6 +84,11 @@ private:
     LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
     LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
 
+#if INS_HARMONIC_NOTCH_ENABLED
+    // notches on motor noise, applied before the low pass filter
+    HarmonicNotchFilterVector3f _gyro_notch[INS_MAX_INSTANCES];
+#endif
+
     Vector3f _delta_angle_accumulator[INS_MAX_INSTANCES];
     Vector3f _delta_velocity_accumulator[INS_MAX_INSTANCES];
     float _delta_velocity_dt[INS_MAX_INSTANCES];
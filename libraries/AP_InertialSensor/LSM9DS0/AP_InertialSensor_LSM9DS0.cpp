@@ -181,7 +181,8 @@ uint16_t AP_InertialSensor_LSM9DS0::_init_sensor( Sample_rate sample_rate)
     }
 
     // start the timer process to read samples
-    hal.scheduler->register_timer_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_LSM9DS0::_poll_data, void));
+    hal.scheduler->register_bus_process(FUNCTOR_BIND_MEMBER(&AP_InertialSensor_LSM9DS0::_poll_data, void),
+                                        _spi_sem, 1000);
 
 #if LSM9DS0_DEBUG
     _dump_registers();
@@ -41,7 +41,7 @@ const AP_Param::GroupInfo AP_L1_Control::var_info[] PROGMEM = {
 int32_t AP_L1_Control::nav_roll_cd(void) const
 {
 	float ret;	
-	ret = cosf(_ahrs.pitch)*degrees(atanf(_latAccDem * 0.101972f) * 100.0f); // 0.101972 = 1/9.81
+	ret = ap_cosf(_ahrs.pitch)*degrees(ap_atanf(_latAccDem * 0.101972f) * 100.0f); // 0.101972 = 1/9.81
 	ret = constrain_float(ret, -9000, 9000);
 	return ret;
 }
@@ -154,7 +154,7 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
         // use a small ground speed vector in the right direction,
         // allowing us to use the compass heading at zero GPS velocity
         groundSpeed = 0.1f;
-        _groundspeed_vector = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw)) * groundSpeed;
+        _groundspeed_vector = Vector2f(ap_cosf(_ahrs.yaw), ap_sinf(_ahrs.yaw)) * groundSpeed;
     }
 
 	// Calculate time varying control parameters
@@ -170,7 +170,7 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 	if (AB.length() < 1.0e-6f) {
 		AB = location_diff(_current_loc, next_WP);
         if (AB.length() < 1.0e-6f) {
-            AB = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw));
+            AB = Vector2f(ap_cosf(_ahrs.yaw), ap_sinf(_ahrs.yaw));
         }
 	}
 	AB.normalize();
@@ -192,23 +192,23 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 		Vector2f A_air_unit = (A_air).normalized(); // Unit vector from WP A to aircraft
 		xtrackVel = _groundspeed_vector % (-A_air_unit); // Velocity across line
 		ltrackVel = _groundspeed_vector * (-A_air_unit); // Velocity along line
-		Nu = atan2f(xtrackVel,ltrackVel);
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
+		Nu = ap_atan2f(xtrackVel,ltrackVel);
+		_nav_bearing = ap_atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 
 	} else { //Calc Nu to fly along AB line
 			
 		//Calculate Nu2 angle (angle of velocity vector relative to line connecting waypoints)
 		xtrackVel = _groundspeed_vector % AB; // Velocity cross track
 		ltrackVel = _groundspeed_vector * AB; // Velocity along track
-		float Nu2 = atan2f(xtrackVel,ltrackVel);
+		float Nu2 = ap_atan2f(xtrackVel,ltrackVel);
 		//Calculate Nu1 angle (Angle to L1 reference point)
 		float xtrackErr = A_air % AB;
 		float sine_Nu1 = xtrackErr/max(_L1_dist, 0.1f);
 		//Limit sine of Nu1 to provide a controlled track capture angle of 45 deg
 		sine_Nu1 = constrain_float(sine_Nu1, -0.7071f, 0.7071f);
-		float Nu1 = asinf(sine_Nu1);
+		float Nu1 = ap_safe_asin(sine_Nu1);
 		Nu = Nu1 + Nu2;
-		_nav_bearing = atan2f(AB.y, AB.x) + Nu1; // bearing (radians) from AC to L1 point		
+		_nav_bearing = ap_atan2f(AB.y, AB.x) + Nu1; // bearing (radians) from AC to L1 point		
 	}	
 
     _prevent_indecision(Nu);
@@ -216,7 +216,7 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 			
 	//Limit Nu to +-pi
 	Nu = constrain_float(Nu, -1.5708f, +1.5708f);
-	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * ap_sinf(Nu);
 	
 	// Waypoint capture status is always false during waypoint following
 	_WPcircle = false;
@@ -271,7 +271,7 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
         A_air_unit = A_air.normalized();
     } else {
         if (_groundspeed_vector.length() < 0.1f) {
-            A_air_unit = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw));
+            A_air_unit = Vector2f(ap_cosf(_ahrs.yaw), ap_sinf(_ahrs.yaw));
         } else {
             A_air_unit = _groundspeed_vector.normalized();
         }
@@ -280,7 +280,7 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 	//Calculate Nu to capture center_WP
 	float xtrackVelCap = A_air_unit % _groundspeed_vector; // Velocity across line - perpendicular to radial inbound to WP
 	float ltrackVelCap = - (_groundspeed_vector * A_air_unit); // Velocity along line - radial inbound to WP
-	float Nu = atan2f(xtrackVelCap,ltrackVelCap);
+	float Nu = ap_atan2f(xtrackVelCap,ltrackVelCap);
 
     _prevent_indecision(Nu);
     _last_Nu = Nu;
@@ -288,7 +288,7 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 	Nu = constrain_float(Nu, -M_PI_2, M_PI_2); //Limit Nu to +- Pi/2
 
 	//Calculate lat accln demand to capture center_WP (use L1 guidance law)
-	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * ap_sinf(Nu);
 	
 	//Calculate radial position and velocity errors
 	float xtrackVelCirc = -ltrackVelCap; // Radial outbound velocity - reuse previous radial inbound velocity
@@ -321,12 +321,12 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 		_latAccDem = latAccDemCap;
 		_WPcircle = false;
 		_bearing_error = Nu; // angle between demanded and achieved velocity vector, +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
+		_nav_bearing = ap_atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 	} else {
 		_latAccDem = latAccDemCirc;
 		_WPcircle = true;
 		_bearing_error = 0.0f; // bearing error (radians), +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians)from AC to L1 point
+		_nav_bearing = ap_atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians)from AC to L1 point
 	}
 }
 
@@ -367,7 +367,7 @@ void AP_L1_Control::update_heading_hold(int32_t navigation_heading_cd)
 
 	// Limit Nu to +-pi
 	Nu = constrain_float(Nu, -M_PI_2, M_PI_2);
-	_latAccDem = 2.0f*sinf(Nu)*VomegaA;
+	_latAccDem = 2.0f*ap_sinf(Nu)*VomegaA;
 }
 
 // update L1 control for level flight on current heading
@@ -0,0 +1,196 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Unit tests and timing for the AP_Math fast_math approximations
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_RangeFinder.h>
+#include <AP_OpticalFlow.h>
+
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+static uint16_t failures;
+
+static void check_bound(const char *name, float err, float bound)
+{
+    hal.console->printf("%-16s max error %.3e bound %.1e %s\n",
+                        name, err, bound, err > bound ? "FAILED" : "OK");
+    if (err > bound) {
+        failures++;
+    }
+}
+
+static void test_sin_cos(void)
+{
+    float err_sin = 0, err_cos = 0;
+    for (int32_t i=-200000; i<=200000; i++) {
+        float x = i * 5.0e-4f;
+        err_sin = max(err_sin, fabsf(fast_sinf(x) - (float)sin(x)));
+        err_cos = max(err_cos, fabsf(fast_cosf(x) - (float)cos(x)));
+    }
+    check_bound("fast_sinf", err_sin, 1.0e-6f);
+    check_bound("fast_cosf", err_cos, 1.0e-6f);
+}
+
+static void test_atan(void)
+{
+    float err = 0;
+    for (int32_t i=-100000; i<=100000; i++) {
+        float x = i * 2.0e-3f;
+        err = max(err, fabsf(fast_atanf(x) - (float)atan(x)));
+    }
+    check_bound("fast_atanf", err, 2.0e-6f);
+
+    err = 0;
+    for (int16_t i=-300; i<=300; i++) {
+        for (int16_t j=-300; j<=300; j++) {
+            float y = i * 0.013f;
+            float x = j * 0.0171f;
+            if (i == 0 && j == 0) {
+                continue;
+            }
+            err = max(err, fabsf(fast_atan2f(y, x) - (float)atan2(y, x)));
+        }
+    }
+    check_bound("fast_atan2f", err, 2.0e-6f);
+
+    // zero vector gives zero, like atan2f()
+    check_bound("fast_atan2f(0,0)", fabsf(fast_atan2f(0, 0)), 0);
+}
+
+static void test_asin(void)
+{
+    float err = 0;
+    for (int32_t i=-100000; i<=100000; i++) {
+        float v = i * 1.0e-5f;
+        err = max(err, fabsf(fast_asinf(v) - (float)asin(v)));
+    }
+    check_bound("fast_asinf", err, 5.0e-6f);
+
+    // out of range and NaN are clamped the same way as safe_asin()
+    err = fabsf(fast_asinf(1.5f) - safe_asin(1.5f));
+    err = max(err, fabsf(fast_asinf(-1.5f) - safe_asin(-1.5f)));
+    err = max(err, fabsf(fast_asinf(NAN) - safe_asin(NAN)));
+    check_bound("fast_asinf clamp", err, 0);
+}
+
+static void test_sqrt(void)
+{
+    float err_inv = 0, err_sqrt = 0;
+    for (int32_t i=1; i<200000; i++) {
+        float v = i * 1.37e-3f;
+        float s = sqrt(v);
+        err_inv = max(err_inv, fabsf(fast_inv_sqrtf(v) * s - 1));
+        err_sqrt = max(err_sqrt, fabsf(fast_sqrtf(v) / s - 1));
+    }
+    // check tiny and large values too
+    for (int8_t e=-30; e<=30; e++) {
+        float v = 1.7f * powf(10, e);
+        float s = sqrt(v);
+        err_inv = max(err_inv, fabsf(fast_inv_sqrtf(v) * s - 1));
+        err_sqrt = max(err_sqrt, fabsf(fast_sqrtf(v) / s - 1));
+    }
+    check_bound("fast_inv_sqrtf", err_inv, 5.0e-6f);
+    check_bound("fast_sqrtf", err_sqrt, 5.0e-6f);
+
+    // zero, negative and NaN give zero, like safe_sqrt()
+    float err = fabsf(fast_sqrtf(0)) + fabsf(fast_sqrtf(-1)) + fabsf(fast_sqrtf(NAN));
+    check_bound("fast_sqrtf <= 0", err, 0);
+}
+
+/*
+  time the approximations against libm. The result is accumulated so
+  the loop can't be optimised away
+ */
+#define NLOOPS 20000
+static void test_speed(void)
+{
+    volatile float input = 0.3f;
+    float x = input;
+    float sum = 0;
+    uint32_t t0, t_fast, t_libm;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += fast_sinf(x + i*1.0e-4f); }
+    t_fast = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += sinf(x + i*1.0e-4f); }
+    t_libm = hal.scheduler->micros() - t0;
+    hal.console->printf("sinf     fast %6lu usec  libm %6lu usec\n", (unsigned long)t_fast, (unsigned long)t_libm);
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += fast_atan2f(x, 1 + i*1.0e-4f); }
+    t_fast = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += atan2f(x, 1 + i*1.0e-4f); }
+    t_libm = hal.scheduler->micros() - t0;
+    hal.console->printf("atan2f   fast %6lu usec  libm %6lu usec\n", (unsigned long)t_fast, (unsigned long)t_libm);
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += fast_asinf(x + i*1.0e-5f); }
+    t_fast = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += safe_asin(x + i*1.0e-5f); }
+    t_libm = hal.scheduler->micros() - t0;
+    hal.console->printf("asinf    fast %6lu usec  libm %6lu usec\n", (unsigned long)t_fast, (unsigned long)t_libm);
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += fast_inv_sqrtf(x + i*1.0e-4f); }
+    t_fast = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NLOOPS; i++) { sum += 1.0f / sqrtf(x + i*1.0e-4f); }
+    t_libm = hal.scheduler->micros() - t0;
+    hal.console->printf("1/sqrtf  fast %6lu usec  libm %6lu usec\n", (unsigned long)t_fast, (unsigned long)t_libm);
+
+    hal.console->printf("(%f)\n", sum);
+}
+
+void setup(void)
+{
+    hal.console->println("fast_math unit tests\n");
+
+    test_sin_cos();
+    test_atan();
+    test_asin();
+    test_sqrt();
+
+    hal.console->printf("%u failures\n\n", (unsigned)failures);
+
+    test_speed();
+}
+
+void loop(void) {}
+
+AP_HAL_MAIN();
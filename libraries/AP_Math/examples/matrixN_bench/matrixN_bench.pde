@@ -0,0 +1,185 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Benchmark and check of MatrixN against VectorN of VectorN and a
+// plain C array, using a 22 state covariance prediction of the form
+// used in the EKF (P = F*P*F' followed by forcing symmetry)
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <vectorN.h>
+#include <matrixN.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_RangeFinder.h>
+#include <AP_OpticalFlow.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NSTATES 22
+#define NLOOPS  200
+
+typedef float Array22[NSTATES][NSTATES];
+typedef VectorN<VectorN<float,NSTATES>,NSTATES> VecVec22;
+typedef MatrixN<float,NSTATES,NSTATES> Matrix22;
+
+static Array22  a_F, a_P, a_tmp;
+static VecVec22 v_F, v_P, v_tmp;
+static Matrix22 m_F, m_P, m_tmp;
+
+// fill F and P with the same pseudo-random contents for each type
+static void fill(void)
+{
+    uint32_t seed = 1;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            seed = seed * 1103515245UL + 12345UL;
+            float f = ((seed >> 16) & 0x7FFF) * (1.0f/32768.0f) - 0.5f;
+            seed = seed * 1103515245UL + 12345UL;
+            float p = ((seed >> 16) & 0x7FFF) * (1.0f/32768.0f);
+            a_F[i][j] = v_F[i][j] = m_F[i][j] = (i==j) ? 1.0f : 0.01f*f;
+            a_P[i][j] = v_P[i][j] = m_P[i][j] = p;
+        }
+    }
+}
+
+static void predict_array(void)
+{
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NSTATES; k++) {
+                sum += a_F[i][k] * a_P[k][j];
+            }
+            a_tmp[i][j] = sum;
+        }
+    }
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NSTATES; k++) {
+                sum += a_tmp[i][k] * a_F[j][k];
+            }
+            a_P[i][j] = sum;
+        }
+    }
+    for (uint8_t i=1; i<NSTATES; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            float temp = 0.5f*(a_P[i][j] + a_P[j][i]);
+            a_P[i][j] = temp;
+            a_P[j][i] = temp;
+        }
+    }
+}
+
+static void predict_vecvec(void)
+{
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NSTATES; k++) {
+                sum += v_F[i][k] * v_P[k][j];
+            }
+            v_tmp[i][j] = sum;
+        }
+    }
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NSTATES; k++) {
+                sum += v_tmp[i][k] * v_F[j][k];
+            }
+            v_P[i][j] = sum;
+        }
+    }
+    for (uint8_t i=1; i<NSTATES; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            float temp = 0.5f*(v_P[i][j] + v_P[j][i]);
+            v_P[i][j] = temp;
+            v_P[j][i] = temp;
+        }
+    }
+}
+
+static void predict_matrixN(void)
+{
+    m_tmp.mult(m_F, m_P);
+    m_P.mult_transpose(m_tmp, m_F);
+    m_P.force_symmetry();
+}
+
+static uint32_t time_it(void (*fn)(void))
+{
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NLOOPS; n++) {
+        fn();
+    }
+    return hal.scheduler->micros() - t0;
+}
+
+static void check_results(void)
+{
+    float max_err = 0;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            max_err = max(max_err, fabsf(a_P[i][j] - m_P[i][j]));
+            max_err = max(max_err, fabsf(a_P[i][j] - v_P[i][j]));
+        }
+    }
+    hal.console->printf("max difference %.6e %s\n", max_err,
+                        max_err > 1.0e-3f ? "FAILED" : "OK");
+}
+
+void setup(void)
+{
+    hal.console->println("MatrixN benchmark\n");
+
+    hal.console->printf("sizeof array=%u vecvec=%u matrixN=%u\n",
+                        (unsigned)sizeof(Array22),
+                        (unsigned)sizeof(VecVec22),
+                        (unsigned)sizeof(Matrix22));
+
+    fill();
+    uint32_t t_array  = time_it(predict_array);
+    uint32_t t_vecvec = time_it(predict_vecvec);
+    uint32_t t_matrix = time_it(predict_matrixN);
+
+    hal.console->printf("%u predictions of %ux%u\n", NLOOPS, NSTATES, NSTATES);
+    hal.console->printf("array   %8lu usec\n", (unsigned long)t_array);
+    hal.console->printf("vecvec  %8lu usec\n", (unsigned long)t_vecvec);
+    hal.console->printf("matrixN %8lu usec\n", (unsigned long)t_matrix);
+
+    check_results();
+}
+
+void loop(void) {}
+
+AP_HAL_MAIN();
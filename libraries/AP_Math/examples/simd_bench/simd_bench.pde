@@ -0,0 +1,226 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Benchmark and check of the Matrix3f and Quaternion kernels against
+// plain scalar reference versions. Build with
+// EXTRAFLAGS="-DMATH_USE_SIMD=1" to compare the SIMD kernels
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_RangeFinder.h>
+#include <AP_OpticalFlow.h>
+
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NLOOPS 100000
+
+/*
+  scalar reference versions, matching the non-SIMD AP_Math code
+ */
+static Vector3f ref_mul(const Matrix3f &m, const Vector3f &v)
+{
+    return Vector3f(m.a.x * v.x + m.a.y * v.y + m.a.z * v.z,
+                    m.b.x * v.x + m.b.y * v.y + m.b.z * v.z,
+                    m.c.x * v.x + m.c.y * v.y + m.c.z * v.z);
+}
+
+static Vector3f ref_mul_transpose(const Matrix3f &m, const Vector3f &v)
+{
+    return Vector3f(m.a.x * v.x + m.b.x * v.y + m.c.x * v.z,
+                    m.a.y * v.x + m.b.y * v.y + m.c.y * v.z,
+                    m.a.z * v.x + m.b.z * v.y + m.c.z * v.z);
+}
+
+static Matrix3f ref_mul(const Matrix3f &m1, const Matrix3f &m)
+{
+    return Matrix3f(ref_mul_transpose(m, m1.a),
+                    ref_mul_transpose(m, m1.b),
+                    ref_mul_transpose(m, m1.c));
+}
+
+static void ref_rotate(Matrix3f &m, const Vector3f &g)
+{
+    m.a += m.a % g;
+    m.b += m.b % g;
+    m.c += m.c % g;
+}
+
+static Quaternion ref_mul(const Quaternion &p, const Quaternion &q)
+{
+    return Quaternion(p.q1*q.q1 - p.q2*q.q2 - p.q3*q.q3 - p.q4*q.q4,
+                      p.q1*q.q2 + p.q2*q.q1 + p.q3*q.q4 - p.q4*q.q3,
+                      p.q1*q.q3 - p.q2*q.q4 + p.q3*q.q1 + p.q4*q.q2,
+                      p.q1*q.q4 + p.q2*q.q3 - p.q3*q.q2 + p.q4*q.q1);
+}
+
+static float max_err;
+
+static void check(float a, float b)
+{
+    max_err = max(max_err, fabsf(a - b));
+}
+
+static void check(const Vector3f &a, const Vector3f &b)
+{
+    check(a.x, b.x);
+    check(a.y, b.y);
+    check(a.z, b.z);
+}
+
+static void check(const Matrix3f &a, const Matrix3f &b)
+{
+    check(a.a, b.a);
+    check(a.b, b.b);
+    check(a.c, b.c);
+}
+
+static void check(const Quaternion &a, const Quaternion &b)
+{
+    check(a.q1, b.q1);
+    check(a.q2, b.q2);
+    check(a.q3, b.q3);
+    check(a.q4, b.q4);
+}
+
+static void test_accuracy(void)
+{
+    max_err = 0;
+    for (uint16_t i=0; i<1000; i++) {
+        Matrix3f m, m2;
+        Vector3f v(i*0.01f, -i*0.02f, 0.5f + i*0.003f);
+        Vector3f g(0.001f*i, -0.0005f*i, 0.002f);
+        m.from_euler(radians(i*0.37f), radians(i*0.11f - 45), radians(i*0.71f));
+        m2.from_euler(radians(i*0.13f), radians(30 - i*0.05f), radians(i*0.29f));
+        Quaternion q1, q2;
+        q1.from_rotation_matrix(m);
+        q2.from_rotation_matrix(m2);
+
+        check(m * v, ref_mul(m, v));
+        check(m.mul_transpose(v), ref_mul_transpose(m, v));
+        check(m * m2, ref_mul(m, m2));
+        Matrix3f mr = m;
+        mr.rotate(g);
+        ref_rotate(m, g);
+        check(mr, m);
+        check(q1 * q2, ref_mul(q1, q2));
+        Quaternion q3 = q1;
+        q3 *= q2;
+        check(q3, ref_mul(q1, q2));
+    }
+    hal.console->printf("max error %.3e %s\n", max_err,
+                        max_err > 1.0e-5f ? "FAILED" : "OK");
+}
+
+static void show_timing(const char *name, uint32_t t_lib, uint32_t t_ref)
+{
+    hal.console->printf("%-14s %6lu usec  ref %6lu usec\n",
+                        name, (unsigned long)t_lib, (unsigned long)t_ref);
+}
+
+/*
+  time a kernel against its scalar reference. The result is fed back
+  into the input so the compiler can't hoist the work out of the loop
+ */
+static void test_speed(void)
+{
+    Matrix3f m, m2;
+    m.from_euler(0.1f, 0.2f, 0.3f);
+    m2.from_euler(0.01f, -0.02f, 0.03f);
+    Vector3f v(1, 2, 3);
+    const Vector3f g(0.0001f, -0.0002f, 0.0003f);
+    Quaternion q, dq;
+    q.from_rotation_matrix(m);
+    dq.from_rotation_matrix(m2);
+    uint32_t t0, t_lib, t_ref;
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { v = m * v; }
+    t_lib = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { v = ref_mul(m, v); }
+    t_ref = hal.scheduler->micros() - t0;
+    show_timing("M*v", t_lib, t_ref);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { v = m.mul_transpose(v); }
+    t_lib = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { v = ref_mul_transpose(m, v); }
+    t_ref = hal.scheduler->micros() - t0;
+    show_timing("M'*v", t_lib, t_ref);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { m = m * m2; }
+    t_lib = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { m = ref_mul(m, m2); }
+    t_ref = hal.scheduler->micros() - t0;
+    show_timing("M*M", t_lib, t_ref);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { m.rotate(g); }
+    t_lib = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { ref_rotate(m, g); }
+    t_ref = hal.scheduler->micros() - t0;
+    show_timing("M.rotate(g)", t_lib, t_ref);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { q *= dq; }
+    t_lib = hal.scheduler->micros() - t0;
+    t0 = hal.scheduler->micros();
+    for (uint32_t i=0; i<NLOOPS; i++) { q = ref_mul(q, dq); }
+    t_ref = hal.scheduler->micros() - t0;
+    show_timing("q*=dq", t_lib, t_ref);
+
+    // print the results so the loops are not optimised away
+    hal.console->printf("(%f %f %f %f)\n", v.x, m.a.x, m.c.z, q.q1);
+}
+
+void setup(void)
+{
+#if MATH_SIMD_NEON
+    hal.console->println("AP_Math SIMD benchmark (NEON)\n");
+#elif MATH_SIMD_SSE
+    hal.console->println("AP_Math SIMD benchmark (SSE)\n");
+#else
+    hal.console->println("AP_Math SIMD benchmark (scalar)\n");
+#endif
+    test_accuracy();
+    test_speed();
+}
+
+void loop(void) {}
+
+AP_HAL_MAIN();
@@ -0,0 +1,171 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  fast polynomial approximations of the trig and sqrt functions used
+  in the attitude and navigation hot paths.
+
+  Maximum absolute errors, checked by examples/fast_math:
+    fast_sinf, fast_cosf    1e-6 for |x| <= 100 radians
+    fast_atanf, fast_atan2f 2e-6 radians
+    fast_asinf              5e-6 radians
+  and maximum relative error:
+    fast_inv_sqrtf, fast_sqrtf  5e-6
+
+  The ap_*() wrappers are what the vehicle code calls. They use the
+  approximations when built with EXTRAFLAGS="-DMATH_FAST_TRIG=1" and
+  the normal libm functions otherwise.
+ */
+
+#ifndef AP_MATH_FAST_MATH_H
+#define AP_MATH_FAST_MATH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef MATH_FAST_TRIG
+#define MATH_FAST_TRIG 0
+#endif
+
+// sin(x) for x in [-PI/2, PI/2]
+static inline float fast_sinf_reduced(float x)
+{
+    const float x2 = x*x;
+    return x * (0.999996616f + x2*(-0.166648284f + x2*(0.00830632523f + x2*-0.00018363654f)));
+}
+
+// sin(x) for any x, accuracy degrades slowly above |x| of 100
+static inline float fast_sinf(float x)
+{
+    // reduce to [-PI/2, PI/2] with PI split in two for extra precision
+    const int32_t k = (int32_t)(x * 0.318309886f + (x >= 0 ? 0.5f : -0.5f));
+    const float r = (x - k * 3.140625f) - k * 9.67653590e-4f;
+    const float s = fast_sinf_reduced(r);
+    return (k & 1) ? -s : s;
+}
+
+// cos(x) for any x, reduced about the zeros of cos so no precision is
+// lost adding PI/2 to x
+static inline float fast_cosf(float x)
+{
+    const float t = x * 0.318309886f - 0.5f;
+    const int32_t k = (int32_t)(t + (t >= 0 ? 0.5f : -0.5f));
+    const float m = k + 0.5f;
+    const float r = (x - m * 3.140625f) - m * 9.67653590e-4f;
+    const float s = fast_sinf_reduced(r);
+    return (k & 1) ? s : -s;
+}
+
+// atan(x) for x in [-1, 1]
+static inline float fast_atanf_reduced(float x)
+{
+    const float x2 = x*x;
+    return x * (0.999977219f + x2*(-0.332622827f + x2*(0.193540369f +
+                x2*(-0.116426466f + x2*(0.0526473352f + x2*-0.0117191297f)))));
+}
+
+static inline float fast_atanf(float x)
+{
+    if (x > 1.0f) {
+        return 1.57079633f - fast_atanf_reduced(1.0f / x);
+    }
+    if (x < -1.0f) {
+        return -1.57079633f - fast_atanf_reduced(1.0f / x);
+    }
+    return fast_atanf_reduced(x);
+}
+
+static inline float fast_atan2f(float y, float x)
+{
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+    if (ax < 1.0e-30f && ay < 1.0e-30f) {
+        return 0.0f;
+    }
+    float a;
+    if (ay > ax) {
+        a = 1.57079633f - fast_atanf_reduced(ax / ay);
+    } else {
+        a = fast_atanf_reduced(ay / ax);
+    }
+    if (x < 0) {
+        a = 3.14159265f - a;
+    }
+    return (y < 0) ? -a : a;
+}
+
+// 1/sqrt(x) for x > 0, using the integer estimate then two Newton steps
+static inline float fast_inv_sqrtf(float x)
+{
+    uint32_t i;
+    float y;
+    memcpy(&i, &x, sizeof(i));
+    i = 0x5f375a86UL - (i >> 1);
+    memcpy(&y, &i, sizeof(y));
+    const float xhalf = 0.5f * x;
+    y = y * (1.5f - xhalf * y * y);
+    y = y * (1.5f - xhalf * y * y);
+    return y;
+}
+
+// sqrt(x), returning 0 for zero, negative and NaN input like safe_sqrt()
+static inline float fast_sqrtf(float x)
+{
+    if (!(x > 0)) {
+        return 0.0f;
+    }
+    return x * fast_inv_sqrtf(x);
+}
+
+// asin(v), clamped to +-PI/2 like safe_asin()
+static inline float fast_asinf(float v)
+{
+    if (isnan(v)) {
+        return 0.0f;
+    }
+    if (v >= 1.0f) {
+        return 1.57079633f;
+    }
+    if (v <= -1.0f) {
+        return -1.57079633f;
+    }
+    // (1-v)*(1+v) rather than 1-v*v keeps precision close to +-1
+    return fast_atan2f(v, fast_sqrtf((1.0f - v)*(1.0f + v)));
+}
+
+/*
+  build time selection between the approximations and libm
+ */
+#if MATH_FAST_TRIG
+static inline float ap_sinf(float x) { return fast_sinf(x); }
+static inline float ap_cosf(float x) { return fast_cosf(x); }
+static inline float ap_atanf(float x) { return fast_atanf(x); }
+static inline float ap_atan2f(float y, float x) { return fast_atan2f(y, x); }
+static inline float ap_safe_asin(float v) { return fast_asinf(v); }
+static inline float ap_safe_sqrt(float v) { return fast_sqrtf(v); }
+static inline float ap_inv_sqrtf(float v) { return fast_inv_sqrtf(v); }
+#else
+static inline float ap_sinf(float x) { return sinf(x); }
+static inline float ap_cosf(float x) { return cosf(x); }
+static inline float ap_atanf(float x) { return atanf(x); }
+static inline float ap_atan2f(float y, float x) { return atan2f(y, x); }
+static inline float ap_safe_asin(float v) { return safe_asin(v); }
+static inline float ap_safe_sqrt(float v) { return safe_sqrt(v); }
+static inline float ap_inv_sqrtf(float v) { return 1.0f / sqrtf(v); }
+#endif
+
+#endif // AP_MATH_FAST_MATH_H
@@ -226,9 +226,88 @@ void Matrix3<T>::zero(void)
 }
 
 
+#if MATH_SIMD
+/*
+  SIMD versions of the hot Matrix3f operations. These give the same
+  results as the scalar versions to within float rounding. Rows a and
+  b are loaded 4 wide (the 4th lane is the next row's x and is
+  ignored), row c is loaded 3 wide so we never read past the object
+ */
+
+// apply an additional rotation from a body frame gyro vector
+// to a rotation matrix. Each row r becomes r + r % g, done as a
+// product with the skew matrix of g
+template <>
+void Matrix3<float>::rotate(const Vector3<float> &g)
+{
+    const simd_f4 g0 = simd_set(0, -g.z, g.y, 0);
+    const simd_f4 g1 = simd_set(g.z, 0, -g.x, 0);
+    const simd_f4 g2 = simd_set(-g.y, g.x, 0, 0);
+    const simd_f4 ra = simd_load4(&a.x);
+    const simd_f4 rb = simd_load4(&b.x);
+    const simd_f4 rc = simd_load3(&c.x);
+    simd_store3(&a.x, simd_add(ra, simd_madd(simd_madd(simd_mul(simd_splat(a.x), g0), simd_splat(a.y), g1), simd_splat(a.z), g2)));
+    simd_store3(&b.x, simd_add(rb, simd_madd(simd_madd(simd_mul(simd_splat(b.x), g0), simd_splat(b.y), g1), simd_splat(b.z), g2)));
+    simd_store3(&c.x, simd_add(rc, simd_madd(simd_madd(simd_mul(simd_splat(c.x), g0), simd_splat(c.y), g1), simd_splat(c.z), g2)));
+}
+
+/*
+  the products below only pay off on NEON. On x86 the compiler already
+  does a good job of the scalar code with SSE registers and the lane
+  shuffles make the SIMD versions slower (see examples/simd_bench)
+ */
+#if MATH_SIMD_NEON
+
+// multiplication by a vector
+template <>
+Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const
+{
+    const simd_f4 vv = simd_load3(&v.x);
+    Vector3<float> ret;
+    simd_store3(&ret.x, simd_hsum3x3(simd_mul(simd_load4(&a.x), vv),
+                                     simd_mul(simd_load4(&b.x), vv),
+                                     simd_mul(simd_load3(&c.x), vv)));
+    return ret;
+}
+
+// multiplication of transpose by a vector
+template <>
+Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const
+{
+    simd_f4 r = simd_mul(simd_load4(&a.x), simd_splat(v.x));
+    r = simd_madd(r, simd_load4(&b.x), simd_splat(v.y));
+    r = simd_madd(r, simd_load3(&c.x), simd_splat(v.z));
+    Vector3<float> ret;
+    simd_store3(&ret.x, r);
+    return ret;
+}
+
+// multiplication by another Matrix3f
+template <>
+Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const
+{
+    const simd_f4 ma = simd_load4(&m.a.x);
+    const simd_f4 mb = simd_load4(&m.b.x);
+    const simd_f4 mc = simd_load3(&m.c.x);
+    Matrix3<float> temp;
+    simd_store3(&temp.a.x, simd_madd(simd_madd(simd_mul(simd_splat(a.x), ma), simd_splat(a.y), mb), simd_splat(a.z), mc));
+    simd_store3(&temp.b.x, simd_madd(simd_madd(simd_mul(simd_splat(b.x), ma), simd_splat(b.y), mb), simd_splat(b.z), mc));
+    simd_store3(&temp.c.x, simd_madd(simd_madd(simd_mul(simd_splat(c.x), ma), simd_splat(c.y), mb), simd_splat(c.z), mc));
+    return temp;
+}
+#endif // MATH_SIMD_NEON
+#endif // MATH_SIMD
+
 // only define for float
 template void Matrix3<float>::zero(void);
+#if !MATH_SIMD
 template void Matrix3<float>::rotate(const Vector3<float> &g);
+#endif
+#if !MATH_SIMD_NEON
+template Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
+template Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
+template Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const;
+#endif
 template void Matrix3<float>::rotateXY(const Vector3<float> &g);
 template void Matrix3<float>::rotateXYinv(const Vector3<float> &g);
 template void Matrix3<float>::normalize(void);
@@ -236,9 +315,6 @@ template void Matrix3<float>::from_euler(float roll, float pitch, float yaw);
 template void Matrix3<float>::to_euler(float *roll, float *pitch, float *yaw) const;
 template void Matrix3<float>::from_euler312(float roll, float pitch, float yaw);
 template Vector3<float> Matrix3<float>::to_euler312(void) const;
-template Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
-template Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
-template Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const;
 template Matrix3<float> Matrix3<float>::transposed(void) const;
 template Vector2<float> Matrix3<float>::mulXY(const Vector3<float> &v) const;
 
@@ -41,6 +41,7 @@
 #define MATRIX3_H
 
 #include "vector3.h"
+#include "simd.h"
 
 // 3x3 matrix with elements of type T
 template <typename T>
@@ -245,4 +246,14 @@ typedef Matrix3<float>                  Matrix3f;
     typedef Matrix3<double>                 Matrix3d;
 #endif
 
+#if MATH_SIMD
+// SIMD specialisations, see matrix3.cpp
+template <> void Matrix3<float>::rotate(const Vector3<float> &g);
+#endif
+#if MATH_SIMD_NEON
+template <> Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
+template <> Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
+template <> Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const;
+#endif
+
 #endif // MATRIX3_H
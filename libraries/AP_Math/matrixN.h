@@ -0,0 +1,250 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  fixed size R x C matrix template
+
+  This is intended for the large state covariance matrices in the
+  EKFs. Unlike a VectorN of VectorN it stores a single contiguous
+  row-major block, so memset/memcpy on &m[0][0] behave exactly as they
+  do with a plain C array. The default constructor does not zero the
+  storage, and all arithmetic is done in place into an existing
+  matrix so no temporaries are created on the stack.
+
+  When MATH_CHECK_INDEXES is set both row and column indexes are
+  checked.
+ */
+
+#ifndef MATRIXN_H
+#define MATRIXN_H
+
+#include <stdint.h>
+#include <string.h>
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+#include <assert.h>
+#endif
+
+template <typename T, uint8_t R, uint8_t C>
+class MatrixN
+{
+public:
+    static constexpr uint8_t rows = R;
+    static constexpr uint8_t cols = C;
+
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+    // row accessor that checks the column index
+    template <typename E>
+    class Row {
+    public:
+        Row(E *r) : _r(r) {}
+        inline E & operator[](uint8_t j) const {
+            assert(j < C);
+            return _r[j];
+        }
+    private:
+        E *_r;
+    };
+    typedef Row<T> row_type;
+    typedef Row<const T> const_row_type;
+#else
+    typedef T *row_type;
+    typedef const T *const_row_type;
+#endif
+
+    // trivial ctor. Storage is left uninitialised, call zero() if
+    // needed
+    inline MatrixN<T,R,C>() {}
+
+    inline row_type operator[](uint8_t i) {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R);
+#endif
+        return row_type(_m[i]);
+    }
+
+    inline const_row_type operator[](uint8_t i) const {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R);
+#endif
+        return const_row_type(_m[i]);
+    }
+
+    // raw row pointer, for use with memcpy and friends
+    inline T *row(uint8_t i) { return _m[i]; }
+    inline const T *row(uint8_t i) const { return _m[i]; }
+
+    // zero the matrix
+    inline void zero() {
+        memset(_m, 0, sizeof(_m));
+    }
+
+    // set to the identity matrix. Only valid for square matrices
+    void identity() {
+        static_assert(R == C, "identity() needs a square matrix");
+        zero();
+        for (uint8_t i=0; i<R; i++) {
+            _m[i][i] = 1;
+        }
+    }
+
+    // this += m
+    MatrixN<T,R,C> &operator +=(const MatrixN<T,R,C> &m) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] += m._m[i][j];
+            }
+        }
+        return *this;
+    }
+
+    // this -= m
+    MatrixN<T,R,C> &operator -=(const MatrixN<T,R,C> &m) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] -= m._m[i][j];
+            }
+        }
+        return *this;
+    }
+
+    // uniform scaling
+    MatrixN<T,R,C> &operator *=(const T num) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] *= num;
+            }
+        }
+        return *this;
+    }
+
+    // this = a * b. Neither a nor b may alias this
+    template <uint8_t K>
+    void mult(const MatrixN<T,R,K> &a, const MatrixN<T,K,C> &b) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                T sum = 0;
+                for (uint8_t k=0; k<K; k++) {
+                    sum += a._m[i][k] * b._m[k][j];
+                }
+                _m[i][j] = sum;
+            }
+        }
+    }
+
+    // this = a * transpose(b). Neither a nor b may alias this. This
+    // walks both operands along rows so is cache friendly for the
+    // F*P*F' form used in covariance prediction
+    template <uint8_t K>
+    void mult_transpose(const MatrixN<T,R,K> &a, const MatrixN<T,C,K> &b) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                T sum = 0;
+                for (uint8_t k=0; k<K; k++) {
+                    sum += a._m[i][k] * b._m[j][k];
+                }
+                _m[i][j] = sum;
+            }
+        }
+    }
+
+    // this = transpose(m). m may not alias this
+    void transpose_of(const MatrixN<T,C,R> &m) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] = m._m[j][i];
+            }
+        }
+    }
+
+    // out = this * v
+    void mult_vector(const T v[C], T out[R]) const {
+        for (uint8_t i=0; i<R; i++) {
+            T sum = 0;
+            for (uint8_t j=0; j<C; j++) {
+                sum += _m[i][j] * v[j];
+            }
+            out[i] = sum;
+        }
+    }
+
+    // average the off-diagonal terms so the matrix is symmetric. Only
+    // valid for square matrices
+    void force_symmetry() {
+        static_assert(R == C, "force_symmetry() needs a square matrix");
+        for (uint8_t i=1; i<R; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                T temp = 0.5f*(_m[i][j] + _m[j][i]);
+                _m[i][j] = temp;
+                _m[j][i] = temp;
+            }
+        }
+    }
+
+    // solve this * x = b by Gaussian elimination with partial
+    // pivoting, leaving x in b. The matrix is destroyed. Returns false
+    // if the matrix is singular. Only valid for square matrices
+    bool solve(T b[R]) {
+        static_assert(R == C, "solve() needs a square matrix");
+        for (uint8_t k=0; k<R; k++) {
+            // use the row with the largest value in this column as the pivot
+            uint8_t p = k;
+            for (uint8_t i=k+1; i<R; i++) {
+                if (abs_of(_m[i][k]) > abs_of(_m[p][k])) {
+                    p = i;
+                }
+            }
+            if (_m[p][k] == 0) {
+                return false;
+            }
+            if (p != k) {
+                for (uint8_t j=k; j<C; j++) {
+                    T tmp = _m[k][j];
+                    _m[k][j] = _m[p][j];
+                    _m[p][j] = tmp;
+                }
+                T tmp = b[k];
+                b[k] = b[p];
+                b[p] = tmp;
+            }
+            for (uint8_t i=k+1; i<R; i++) {
+                T f = _m[i][k] / _m[k][k];
+                for (uint8_t j=k; j<C; j++) {
+                    _m[i][j] -= f * _m[k][j];
+                }
+                b[i] -= f * b[k];
+            }
+        }
+        // back substitution
+        for (int16_t i=R-1; i>=0; i--) {
+            T sum = b[i];
+            for (uint8_t j=i+1; j<C; j++) {
+                sum -= _m[i][j] * b[j];
+            }
+            b[i] = sum / _m[i][i];
+        }
+        return true;
+    }
+
+    // let other dimensions of MatrixN see our storage for mult()
+    template <typename T2, uint8_t R2, uint8_t C2> friend class MatrixN;
+
+private:
+    static inline T abs_of(T v) { return v < 0 ? -v : v; }
+
+    T _m[R][C] __attribute__((aligned(16)));
+};
+
+#endif // MATRIXN_H
@@ -25,6 +25,51 @@
  */
 
 
+/*
+ *  Polygon_edge_crosses(): test if the edge from A to B crosses the
+ *  ray running from P in the +x direction. This is the inner test of
+ *  Polygon_outside(), split out so a spatially indexed fence can apply
+ *  it to a subset of the edges and get exactly the same answer
+ */
+bool Polygon_edge_crosses(const Vector2l &P, const Vector2l &A, const Vector2l &B)
+{
+    if ((A.y > P.y) == (B.y > P.y)) {
+        return false;
+    }
+    int32_t dx1, dx2, dy1, dy2;
+    dx1 = P.x - A.x;
+    dx2 = B.x - A.x;
+    dy1 = P.y - A.y;
+    dy2 = B.y - A.y;
+    int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
+#define sign(x) ((x)<0 ? -1 : 1)
+    dx1s = sign(dx1);
+    dx2s = sign(dx2);
+    dy1s = sign(dy1);
+    dy2s = sign(dy2);
+    m1 = dx1s * dy2s;
+    m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
+            return true;
+        }
+    } else {
+        if (m1 < m2) {
+            return true;
+        } else if (m1 > m2) {
+            return false;
+        } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
  *  Polygon_outside(): test for a point in a polygon
  *     Input:   P = a point,
@@ -40,39 +85,8 @@ bool Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n)
     unsigned i, j;
     bool outside = true;
     for (i = 0, j = n-1; i < n; j = i++) {
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        int32_t dx1, dx2, dy1, dy2;
-        dx1 = P.x - V[i].x;
-        dx2 = V[j].x - V[i].x;
-        dy1 = P.y - V[i].y;
-        dy2 = V[j].y - V[i].y;
-        int8_t dx1s, dx2s, dy1s, dy2s, m1, m2;
-#define sign(x) ((x)<0 ? -1 : 1)
-        dx1s = sign(dx1);
-        dx2s = sign(dx2);
-        dy1s = sign(dy1);
-        dy2s = sign(dy2);
-        m1 = dx1s * dy2s;
-        m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
+        if (Polygon_edge_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -17,6 +17,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+bool        Polygon_edge_crosses(const Vector2l &P, const Vector2l &A, const Vector2l &B);
 bool        Polygon_outside(const Vector2l &P, const Vector2l *V, unsigned n);
 bool        Polygon_complete(const Vector2l *V, unsigned n);
 
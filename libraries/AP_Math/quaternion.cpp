@@ -268,6 +268,32 @@ void Quaternion::normalize(void)
     }    
 }
 
+#if MATH_SIMD
+/*
+  Hamilton product as a sum of 4 lane products, with the second
+  quaternion permuted and sign flipped for each term of the first
+ */
+static inline simd_f4 quat_mul_simd(const float *p, const float *q)
+{
+    const simd_f4 vq = simd_load4(q);
+    simd_f4 r = simd_mul(simd_splat(p[0]), vq);
+    r = simd_madd(r, simd_splat(p[1]), simd_mul(simd_swap_pairs(vq),  simd_set(-1,  1, -1,  1)));
+    r = simd_madd(r, simd_splat(p[2]), simd_mul(simd_swap_halves(vq), simd_set(-1,  1,  1, -1)));
+    r = simd_madd(r, simd_splat(p[3]), simd_mul(simd_reverse(vq),     simd_set(-1, -1,  1,  1)));
+    return r;
+}
+
+Quaternion Quaternion::operator*(const Quaternion &v) const {
+    Quaternion ret;
+    simd_store4(&ret.q1, quat_mul_simd(&q1, &v.q1));
+    return ret;
+}
+
+Quaternion &Quaternion::operator*=(const Quaternion &v) {
+    simd_store4(&q1, quat_mul_simd(&q1, &v.q1));
+    return *this;
+}
+#else
 Quaternion Quaternion::operator*(const Quaternion &v) const {
     Quaternion ret;
     const float &w1 = q1;
@@ -289,10 +315,11 @@ Quaternion Quaternion::operator*(const Quaternion &v) const {
 }
 
 Quaternion &Quaternion::operator*=(const Quaternion &v) {
-    float &w1 = q1;
-    float &x1 = q2;
-    float &y1 = q3;
-    float &z1 = q4;
+    // take copies, as q1..q4 are overwritten below
+    float w1 = q1;
+    float x1 = q2;
+    float y1 = q3;
+    float z1 = q4;
 
     float w2 = v.q1;
     float x2 = v.q2;
@@ -306,6 +333,7 @@ Quaternion &Quaternion::operator*=(const Quaternion &v) {
 
     return *this;
 }
+#endif // MATH_SIMD
 
 Quaternion Quaternion::operator/(const Quaternion &v) const {
     Quaternion ret;
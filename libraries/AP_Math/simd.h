@@ -0,0 +1,118 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  minimal 4 lane float SIMD layer used by the Matrix3f and Quaternion
+  kernels.
+
+  This is opt-in at build time. Build with
+  EXTRAFLAGS="-DMATH_USE_SIMD=1" to enable it. NEON is used when the
+  compiler targets it (for Linux ARM boards this usually also needs
+  -mfpu=neon), and SSE is used on x86 (SITL). On any other target, or
+  without MATH_USE_SIMD, MATH_SIMD is 0 and the plain scalar code is
+  used.
+
+  The 3 element load/store helpers never touch memory beyond the 3rd
+  element, so they are safe to use on Vector3f and the last row of a
+  Matrix3f.
+ */
+
+#ifndef AP_MATH_SIMD_H
+#define AP_MATH_SIMD_H
+
+#ifndef MATH_USE_SIMD
+#define MATH_USE_SIMD 0
+#endif
+
+#if MATH_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define MATH_SIMD_NEON 1
+#define MATH_SIMD 1
+#include <arm_neon.h>
+#elif MATH_USE_SIMD && defined(__SSE__)
+#define MATH_SIMD_SSE 1
+#define MATH_SIMD 1
+#include <xmmintrin.h>
+#else
+#define MATH_SIMD 0
+#endif
+
+#if MATH_SIMD_NEON
+
+typedef float32x4_t simd_f4;
+
+static inline simd_f4 simd_load3(const float *p) {
+    return vcombine_f32(vld1_f32(p), vld1_lane_f32(p+2, vdup_n_f32(0), 0));
+}
+static inline simd_f4 simd_load4(const float *p) { return vld1q_f32(p); }
+static inline void simd_store3(float *p, simd_f4 v) {
+    vst1_f32(p, vget_low_f32(v));
+    vst1q_lane_f32(p+2, v, 2);
+}
+static inline void simd_store4(float *p, simd_f4 v) { vst1q_f32(p, v); }
+static inline simd_f4 simd_set(float a, float b, float c, float d) {
+    const float v[4] = { a, b, c, d };
+    return vld1q_f32(v);
+}
+static inline simd_f4 simd_splat(float a) { return vdupq_n_f32(a); }
+static inline simd_f4 simd_add(simd_f4 a, simd_f4 b) { return vaddq_f32(a, b); }
+static inline simd_f4 simd_mul(simd_f4 a, simd_f4 b) { return vmulq_f32(a, b); }
+// acc + a*b
+static inline simd_f4 simd_madd(simd_f4 acc, simd_f4 a, simd_f4 b) { return vaddq_f32(acc, vmulq_f32(a, b)); }
+// lanes [1,0,3,2]
+static inline simd_f4 simd_swap_pairs(simd_f4 v) { return vrev64q_f32(v); }
+// lanes [2,3,0,1]
+static inline simd_f4 simd_swap_halves(simd_f4 v) { return vextq_f32(v, v, 2); }
+// lanes [3,2,1,0]
+static inline simd_f4 simd_reverse(simd_f4 v) { return vrev64q_f32(vextq_f32(v, v, 2)); }
+// returns [sum(a[0..2]), sum(b[0..2]), sum(c[0..2]), 0]
+static inline simd_f4 simd_hsum3x3(simd_f4 a, simd_f4 b, simd_f4 c) {
+    float32x4x2_t ab = vtrnq_f32(a, b);
+    float32x4x2_t cz = vtrnq_f32(c, vdupq_n_f32(0));
+    simd_f4 r0 = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cz.val[0]));
+    simd_f4 r1 = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cz.val[1]));
+    simd_f4 r2 = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cz.val[0]));
+    return vaddq_f32(vaddq_f32(r0, r1), r2);
+}
+
+#elif MATH_SIMD_SSE
+
+typedef __m128 simd_f4;
+
+static inline simd_f4 simd_load3(const float *p) {
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)p), _mm_load_ss(p+2));
+}
+static inline simd_f4 simd_load4(const float *p) { return _mm_loadu_ps(p); }
+static inline void simd_store3(float *p, simd_f4 v) {
+    _mm_storel_pi((__m64 *)p, v);
+    _mm_store_ss(p+2, _mm_movehl_ps(v, v));
+}
+static inline void simd_store4(float *p, simd_f4 v) { _mm_storeu_ps(p, v); }
+static inline simd_f4 simd_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline simd_f4 simd_splat(float a) { return _mm_set1_ps(a); }
+static inline simd_f4 simd_add(simd_f4 a, simd_f4 b) { return _mm_add_ps(a, b); }
+static inline simd_f4 simd_mul(simd_f4 a, simd_f4 b) { return _mm_mul_ps(a, b); }
+// acc + a*b
+static inline simd_f4 simd_madd(simd_f4 acc, simd_f4 a, simd_f4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+// lanes [1,0,3,2]
+static inline simd_f4 simd_swap_pairs(simd_f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,3,0,1)); }
+// lanes [2,3,0,1]
+static inline simd_f4 simd_swap_halves(simd_f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,0,3,2)); }
+// lanes [3,2,1,0]
+static inline simd_f4 simd_reverse(simd_f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0,1,2,3)); }
+
+#endif // MATH_SIMD_SSE
+
+#endif // AP_MATH_SIMD_H
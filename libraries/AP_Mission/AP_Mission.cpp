@@ -6,6 +6,12 @@
 #include "AP_Mission.h"
 #include <AP_Terrain.h>
 
+#if AP_MISSION_FILE_STORAGE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
 const AP_Param::GroupInfo AP_Mission::var_info[] PROGMEM = {
 
     // @Param: TOTAL
@@ -37,10 +43,20 @@ StorageAccess AP_Mission::_storage(StorageManager::StorageMission);
 /// init - initialises this library including checks the version in eeprom matches this library
 void AP_Mission::init()
 {
+#if AP_MISSION_FILE_STORAGE
+    // use the mission file if it can be opened
+    file_open();
+#endif
+
     // check_eeprom_version - checks version of missions stored in eeprom matches this library
     // command list will be cleared if they do not match
     check_eeprom_version();
 
+#if AP_MISSION_CACHE_ENABLED
+    // take a copy of the mission for fast lookups
+    cache_init();
+#endif
+
     // prevent an easy programming error, this will be optimised out
     if (sizeof(union Content) != 12) {
         hal.scheduler->panic(PSTR("AP_Mission Content must be 12 bytes"));
@@ -253,8 +269,21 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 {
     uint16_t cmd_index = start_index;
 
+#if AP_MISSION_CACHE_ENABLED
+    cache_update_index();
+#endif
+
     // search until the end of the mission command list
     while(cmd_index < (unsigned)_cmd_total) {
+#if AP_MISSION_CACHE_ENABLED
+        // skip over "do" commands, they would be passed over below anyway
+        if (_cache_next_nav != NULL && cmd_index < _cache_index_total) {
+            cmd_index = _cache_next_nav[cmd_index];
+            if (cmd_index >= (unsigned)_cmd_total) {
+                return false;
+            }
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -397,22 +426,47 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.id = MAV_CMD_NAV_WAYPOINT;
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
+#if AP_MISSION_CACHE_ENABLED
+    }else if (index < _cache_size) {
+        // the cached copy already has its index set
+        cmd = _cache[index];
+#endif
     }else{
-        // Find out proper location in memory by using the start_byte position + the index
-        // we can load a command, we don't process it yet
-        // read WP position
-        uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+        read_cmd_uncached(index, cmd);
+    }
 
+    // return success
+    return true;
+}
+
+/// read_cmd_uncached - reads and decodes a command directly from storage
+void AP_Mission::read_cmd_uncached(uint16_t index, Mission_Command& cmd) const
+{
+    // Find out proper location in memory by using the start_byte position + the index
+    // we can load a command, we don't process it yet
+    // read WP position
+    uint32_t pos_in_storage = 4 + (index * (uint32_t)AP_MISSION_EEPROM_COMMAND_SIZE);
+
+#if AP_MISSION_FILE_STORAGE
+    if (_file_fd != -1) {
+        uint8_t b[AP_MISSION_EEPROM_COMMAND_SIZE];
+        if (pread(_file_fd, b, sizeof(b), pos_in_storage) != (ssize_t)sizeof(b)) {
+            // beyond the end of the file
+            memset(b, 0, sizeof(b));
+        }
+        cmd.id = b[0];
+        memcpy(&cmd.p1, &b[1], sizeof(cmd.p1));
+        memcpy(cmd.content.bytes, &b[3], 12);
+    } else
+#endif
+    {
         cmd.id = _storage.read_byte(pos_in_storage);
         cmd.p1 = _storage.read_uint16(pos_in_storage+1);
         _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
-
-        // set command's index to it's position in eeprom
-        cmd.index = index;
     }
 
-    // return success
-    return true;
+    // set command's index to it's position in eeprom
+    cmd.index = index;
 }
 
 /// write_cmd_to_storage - write a command to storage
@@ -426,11 +480,33 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     }
 
     // calculate where in storage the command should be placed
-    uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+    uint32_t pos_in_storage = 4 + (index * (uint32_t)AP_MISSION_EEPROM_COMMAND_SIZE);
+
+#if AP_MISSION_FILE_STORAGE
+    if (_file_fd != -1) {
+        uint8_t b[AP_MISSION_EEPROM_COMMAND_SIZE];
+        b[0] = cmd.id;
+        memcpy(&b[1], &cmd.p1, sizeof(cmd.p1));
+        memcpy(&b[3], cmd.content.bytes, 12);
+        if (pwrite(_file_fd, b, sizeof(b), pos_in_storage) != (ssize_t)sizeof(b)) {
+            return false;
+        }
+    } else
+#endif
+    {
+        _storage.write_byte(pos_in_storage, cmd.id);
+        _storage.write_uint16(pos_in_storage+1, cmd.p1);
+        _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+    }
 
-    _storage.write_byte(pos_in_storage, cmd.id);
-    _storage.write_uint16(pos_in_storage+1, cmd.p1);
-    _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+#if AP_MISSION_CACHE_ENABLED
+    // keep the cached copy in step with storage
+    if (_cache != NULL && cache_reserve(index+1)) {
+        _cache[index] = cmd;
+        _cache[index].index = index;
+        _cache_index_dirty = true;
+    }
+#endif
 
     // remember when the mission last changed
     _last_change_time_ms = hal.scheduler->millis();
@@ -1310,7 +1386,28 @@ void AP_Mission::increment_jump_times_run(Mission_Command& cmd)
 // command list will be cleared if they do not match
 void AP_Mission::check_eeprom_version()
 {
-    uint32_t eeprom_version = _storage.read_uint32(0);
+    uint32_t eeprom_version;
+
+#if AP_MISSION_FILE_STORAGE
+    if (_file_fd != -1) {
+        if (pread(_file_fd, &eeprom_version, sizeof(eeprom_version), 0) != (ssize_t)sizeof(eeprom_version)) {
+            eeprom_version = 0;
+        }
+        if (eeprom_version != AP_MISSION_EEPROM_VERSION && clear()) {
+            eeprom_version = AP_MISSION_EEPROM_VERSION;
+            if (pwrite(_file_fd, &eeprom_version, sizeof(eeprom_version), 0) != (ssize_t)sizeof(eeprom_version)) {
+                // the file can't be written, so fall back to the storage area
+                ::close(_file_fd);
+                _file_fd = -1;
+            }
+        }
+        if (_file_fd != -1) {
+            return;
+        }
+    }
+#endif
+
+    eeprom_version = _storage.read_uint32(0);
 
     // if eeprom version does not match, clear the command list and update the eeprom version
     if (eeprom_version != AP_MISSION_EEPROM_VERSION) {
@@ -1325,6 +1422,12 @@ void AP_Mission::check_eeprom_version()
  */
 uint16_t AP_Mission::num_commands_max(void) const
 {
+#if AP_MISSION_FILE_STORAGE
+    if (_file_fd != -1) {
+        return AP_MISSION_FILE_MAX_COMMANDS;
+    }
+#endif
+
     // -4 to remove space for eeprom version number
     return (_storage.size() - 4) / AP_MISSION_EEPROM_COMMAND_SIZE;
 }
@@ -1343,6 +1446,22 @@ uint16_t AP_Mission::get_landing_sequence_start()
     uint16_t landing_start_index = 0;
     float min_distance = -1;
 
+#if AP_MISSION_CACHE_ENABLED
+    // use the list of landing starts if there weren't too many to index
+    cache_update_index();
+    if (_cache_next_nav != NULL && !_cache_land_start_overflow) {
+        for (uint8_t i = 0; i < _cache_num_land_start; i++) {
+            const Mission_Command &tmp = _cache[_cache_land_start[i]];
+            float tmp_distance = get_distance(tmp.content.location, current_loc);
+            if (min_distance < 0 || tmp_distance < min_distance) {
+                min_distance = tmp_distance;
+                landing_start_index = tmp.index;
+            }
+        }
+        return landing_start_index;
+    }
+#endif
+
     // Go through mission looking for nearest landing start command
     for (uint16_t i = 0; i < num_commands(); i++) {
         Mission_Command tmp;
@@ -1361,3 +1480,141 @@ uint16_t AP_Mission::get_landing_sequence_start()
     return landing_start_index;
 }
 
+#if AP_MISSION_FILE_STORAGE
+/*
+  open the mission file. A new file is seeded with the mission from
+  the storage area so an existing mission survives the move. If the
+  file can't be used the mission stays in the storage area
+ */
+void AP_Mission::file_open()
+{
+    int fd = ::open(AP_MISSION_FILE_NAME, O_RDWR|O_CREAT, 0666);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0 &&
+        _storage.read_uint32(0) == AP_MISSION_EEPROM_VERSION) {
+        uint16_t num_cmds = _cmd_total;
+        if (num_cmds > num_commands_max()) {
+            num_cmds = num_commands_max();
+        }
+        uint32_t len = 4 + num_cmds * (uint32_t)AP_MISSION_EEPROM_COMMAND_SIZE;
+        uint8_t buf[AP_MISSION_EEPROM_COMMAND_SIZE];
+        for (uint32_t ofs=0; ofs<len; ofs += sizeof(buf)) {
+            uint8_t n = min(sizeof(buf), len - ofs);
+            _storage.read_block(buf, ofs, n);
+            if (pwrite(fd, buf, n, ofs) != n) {
+                ::close(fd);
+                ::unlink(AP_MISSION_FILE_NAME);
+                return;
+            }
+        }
+    }
+
+    _file_fd = fd;
+}
+#endif // AP_MISSION_FILE_STORAGE
+
+#if AP_MISSION_CACHE_ENABLED
+/*
+  allocate the mission cache and fill it from storage. Only the stored
+  mission is loaded; the cache grows as commands are added. If there
+  isn't enough memory the mission is read from storage as before
+ */
+void AP_Mission::cache_init()
+{
+    cache_reserve(_cmd_total > 0 ? _cmd_total : 1);
+}
+
+/*
+  grow the cache to hold at least num_slots commands. It grows in
+  doubling steps so a mission uploaded one command at a time is not
+  reallocated for every command
+ */
+bool AP_Mission::cache_reserve(uint16_t num_slots)
+{
+    num_slots = min(num_slots, num_commands_max());
+    if (num_slots <= _cache_size) {
+        return true;
+    }
+    uint32_t new_size = max((uint32_t)num_slots, (uint32_t)_cache_size*2);
+    new_size = max(new_size, (uint32_t)AP_MISSION_CACHE_MIN_SLOTS);
+    new_size = min(new_size, (uint32_t)num_commands_max());
+
+    Mission_Command *cache = (Mission_Command *)realloc(_cache, new_size * sizeof(Mission_Command));
+    if (cache != NULL) {
+        _cache = cache;
+    }
+    uint16_t *next_nav = (uint16_t *)realloc(_cache_next_nav, new_size * sizeof(uint16_t));
+    if (next_nav != NULL) {
+        _cache_next_nav = next_nav;
+    }
+    if (cache == NULL || next_nav == NULL) {
+        // out of memory, so fall back to reading storage
+        free(_cache);
+        free(_cache_next_nav);
+        _cache = NULL;
+        _cache_next_nav = NULL;
+        _cache_size = 0;
+        _cache_index_total = 0;
+        return false;
+    }
+
+    for (uint16_t i=_cache_size; i<new_size; i++) {
+        read_cmd_uncached(i, _cache[i]);
+    }
+    _cache_size = new_size;
+    _cache_index_dirty = true;
+    return true;
+}
+
+/*
+  rebuild the next navigation command index and the list of landing
+  starts after the mission has been changed
+ */
+void AP_Mission::cache_update_index()
+{
+    if (_cache_next_nav == NULL) {
+        return;
+    }
+    uint16_t total = _cmd_total;
+    if (total > num_commands_max()) {
+        total = num_commands_max();
+    }
+    if (!_cache_index_dirty && _cache_index_total == total) {
+        return;
+    }
+    if (!cache_reserve(total)) {
+        // the total was raised beyond what we could cache
+        return;
+    }
+
+    // work backwards so each entry is either its own index or the
+    // entry after it. Jumps are included as the search has to follow them
+    uint16_t next_nav = total;
+    for (int32_t i=total-1; i>=0; i--) {
+        const Mission_Command &cmd = _cache[i];
+        if (is_nav_cmd(cmd) || cmd.id == MAV_CMD_DO_JUMP) {
+            next_nav = i;
+        }
+        _cache_next_nav[i] = next_nav;
+    }
+
+    _cache_num_land_start = 0;
+    _cache_land_start_overflow = false;
+    for (uint16_t i=1; i<total; i++) {
+        if (_cache[i].id == MAV_CMD_DO_LAND_START) {
+            if (_cache_num_land_start >= AP_MISSION_MAX_NUM_LAND_START) {
+                _cache_land_start_overflow = true;
+                break;
+            }
+            _cache_land_start[_cache_num_land_start++] = i;
+        }
+    }
+
+    _cache_index_total = total;
+    _cache_index_dirty = false;
+}
+#endif // AP_MISSION_CACHE_ENABLED
@@ -44,6 +44,28 @@
 
 #define AP_MISSION_RESTART_DEFAULT          0       // resume the mission from the last command run by default
 
+// boards with plenty of RAM keep a decoded copy of the whole mission so
+// lookups don't go through storage
+#ifndef AP_MISSION_CACHE_ENABLED
+ # define AP_MISSION_CACHE_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_1000)
+#endif
+#define AP_MISSION_MAX_NUM_LAND_START       16      // number of DO_LAND_START commands indexed by the cache
+#define AP_MISSION_CACHE_MIN_SLOTS          16      // smallest cache allocation, in commands
+
+// Linux boards and SITL keep the mission in a file of its own instead
+// of the StorageManager mission area, which allows much larger missions
+#ifndef AP_MISSION_FILE_STORAGE
+ # define AP_MISSION_FILE_STORAGE (CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+#endif
+#if AP_MISSION_FILE_STORAGE
+ # if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+ #  define AP_MISSION_FILE_NAME              "/var/APM/" SKETCHNAME ".mission"
+ # else
+ #  define AP_MISSION_FILE_NAME              "mission.bin"
+ # endif
+ # define AP_MISSION_FILE_MAX_COMMANDS      32766   // limited by the range of the MIS_TOTAL parameter
+#endif
+
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
@@ -251,6 +273,22 @@ public:
         _flags.state = MISSION_STOPPED;
         _flags.nav_cmd_loaded = false;
         _flags.do_cmd_loaded = false;
+
+#if AP_MISSION_CACHE_ENABLED
+        // cache is allocated in init()
+        _cache = NULL;
+        _cache_next_nav = NULL;
+        _cache_size = 0;
+        _cache_num_land_start = 0;
+        _cache_land_start_overflow = false;
+        _cache_index_dirty = true;
+        _cache_index_total = 0;
+#endif
+
+#if AP_MISSION_FILE_STORAGE
+        // file is opened in init()
+        _file_fd = -1;
+#endif
     }
 
     ///
@@ -433,6 +471,30 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+    /// read_cmd_uncached - reads and decodes a command directly from storage, bypassing the cache
+    void read_cmd_uncached(uint16_t index, Mission_Command& cmd) const;
+
+#if AP_MISSION_FILE_STORAGE
+    /// file_open - opens the mission file, copying any mission held in the storage area into it when first created
+    void file_open();
+#endif
+
+#if AP_MISSION_CACHE_ENABLED
+    ///
+    /// mission cache methods
+    ///
+
+    /// cache_init - allocates the cache and fills it from storage
+    void cache_init();
+
+    /// cache_reserve - grows the cache to hold num_slots commands, filling new slots from storage.
+    ///     If it can't, the cache is freed and commands are read from storage
+    bool cache_reserve(uint16_t num_slots);
+
+    /// cache_update_index - rebuilds the next nav index and landing start list if the mission has changed
+    void cache_update_index();
+#endif
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
@@ -458,6 +520,35 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+#if AP_MISSION_CACHE_ENABLED
+    // decoded copy of the first _cache_size command slots in storage,
+    // written through on every change and grown as the mission
+    // grows. NULL if it could not be allocated
+    Mission_Command         *_cache;
+
+    // for each cached command index, the index of the first
+    // "navigation" or do-jump command at or after it, so "do" commands
+    // can be skipped when looking for the next navigation command
+    uint16_t                *_cache_next_nav;
+    uint16_t                _cache_size;
+
+    // indexes of the DO_LAND_START commands in the mission
+    uint16_t                _cache_land_start[AP_MISSION_MAX_NUM_LAND_START];
+    uint8_t                 _cache_num_land_start;
+    bool                    _cache_land_start_overflow;    // true if there are more DO_LAND_START commands than fit
+
+    // _cache_next_nav and _cache_land_start are rebuilt when the
+    // mission changes
+    bool                    _cache_index_dirty;
+    uint16_t                _cache_index_total;     // _cmd_total when the index was built
+#endif
+
+#if AP_MISSION_FILE_STORAGE
+    // mission file, laid out the same way as the storage area. -1 if
+    // the mission is in the storage area
+    int                     _file_fd;
+#endif
 };
 
 #endif
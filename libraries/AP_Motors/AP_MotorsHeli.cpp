@@ -268,6 +268,9 @@ void AP_MotorsHeli::output()
     // update throttle filter
     update_throttle_filter();
 
+    // send all the channels to the output in one go
+    hal.rcout->cork();
+
     if (_flags.armed) {
         if (!_flags.interlock) {
             output_armed_zero_throttle();
@@ -279,6 +282,8 @@ void AP_MotorsHeli::output()
     } else {
         output_disarmed();
     }
+
+    hal.rcout->push();
 };
 
 // output_min - sets servos to neutral point
@@ -203,6 +203,9 @@ void AP_Motors::output()
     // move throttle_low_comp towards desired throttle low comp
     update_throttle_thr_mix();
 
+    // send all the channels to the output in one go
+    hal.rcout->cork();
+
     if (_flags.armed) {
         if (!_flags.interlock) {
             output_armed_zero_throttle();
@@ -214,6 +217,8 @@ void AP_Motors::output()
     } else {
         output_disarmed();
     }
+
+    hal.rcout->push();
 };
 
 // slow_start - set to true to slew motors from current speed to maximum
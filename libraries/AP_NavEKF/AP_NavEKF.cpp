@@ -222,7 +222,7 @@ const AP_Param::GroupInfo NavEKF::var_info[] PROGMEM = {
 
     // @Param: VEL_DELAY
     // @DisplayName: GPS velocity measurement delay (msec)
-    // @Description: This is the number of msec that the GPS velocity measurements lag behind the inertial measurements.
+    // @Description: This is the number of msec that the GPS velocity measurements lag behind the inertial measurements. The lag is measured from the time the GPS driver estimates the fix was valid at, so it should not include the variable delay in delivering the fix.
     // @Range: 0 500
     // @Increment: 10
     // @User: Advanced
@@ -230,7 +230,7 @@ const AP_Param::GroupInfo NavEKF::var_info[] PROGMEM = {
 
     // @Param: POS_DELAY
     // @DisplayName: GPS position measurement delay (msec)
-    // @Description: This is the number of msec that the GPS position measurements lag behind the inertial measurements.
+    // @Description: This is the number of msec that the GPS position measurements lag behind the inertial measurements. The lag is measured from the time the GPS driver estimates the fix was valid at, so it should not include the variable delay in delivering the fix.
     // @Range: 0 500
     // @Increment: 10
     // @User: Advanced
@@ -370,6 +370,13 @@ const AP_Param::GroupInfo NavEKF::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("ALT_SOURCE",    32, NavEKF, _altSource, 1),
 
+    // @Param: IMU_MASK
+    // @DisplayName: Bitmask of IMUs to run independent filters on
+    // @Description: When set to zero a single filter is run that blends data from the first two IMUs. When non-zero an independent filter instance is run for each selected IMU and the AHRS selects the instance with the lowest innovation test ratios. Only supported on boards with enough memory and processing power. A reboot is required for changes to take effect.
+    // @Bitmask: 0:FirstIMU,1:SecondIMU,2:ThirdIMU
+    // @User: Advanced
+    AP_GROUPINFO("IMU_MASK",    33, NavEKF, _imuMask, 0),
+
     AP_GROUPEND
 };
 
@@ -410,7 +417,11 @@ NavEKF::NavEKF(const AP_AHRS *ahrs, AP_Baro &baro, const RangeFinder &rng) :
     flowTimeDeltaAvg_ms(100),       // average interval between optical flow measurements (msec)
     flowIntervalMax_ms(100),        // maximum allowable time between flow fusion events
     gndEffectTimeout_ms(1000),          // time in msec that baro ground effect compensation will timeout after initiation
-    gndEffectBaroScaler(4.0f)      // scaler applied to the barometer observation variance when operating in ground effect
+    gndEffectBaroScaler(4.0f),      // scaler applied to the barometer observation variance when operating in ground effect
+    imuIndex(-1),
+    prevArmedUpdate(false),
+    lastRngMeasTime_ms(0),
+    rngMeasIndex(0)
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     ,_perf_UpdateFilter(perf_alloc(PC_ELAPSED, "EKF_UpdateFilter")),
@@ -423,6 +434,8 @@ NavEKF::NavEKF(const AP_AHRS *ahrs, AP_Baro &baro, const RangeFinder &rng) :
 {
     AP_Param::setup_object_defaults(this, var_info);
 
+    memset(storedRngMeas, 0, sizeof(storedRngMeas));
+    memset(storedRngMeasTime_ms, 0, sizeof(storedRngMeasTime_ms));
 }
 
 // Check basic filter health metrics and return a consolidated health status
@@ -692,18 +705,17 @@ void NavEKF::UpdateFilter()
     // read IMU data and convert to delta angles and velocities
     readIMUData();
 
-    static bool prev_armed = false;
     bool armed = getVehicleArmStatus();
 
     // the vehicle was previously disarmed and time has slipped
     // gyro auto-zero has likely just been done - skip this timestep
-    if (!prev_armed && dtIMUactual > dtIMUavg*5.0f) {
+    if (!prevArmedUpdate && dtIMUactual > dtIMUavg*5.0f) {
         // stop the timer used for load measurement
         perf_end(_perf_UpdateFilter);
-        prev_armed = armed;
+        prevArmedUpdate = armed;
         return;
     }
-    prev_armed = armed;
+    prevArmedUpdate = armed;
 
     // detect if the filter update has been delayed for too long
     if (dtIMUactual > 0.2f) {
@@ -1899,6 +1911,7 @@ void NavEKF::FuseVelPosNED()
     Vector6 R_OBS_DATA_CHECKS; // Measurement variances used for data checks only
     Vector6 observation;
     float SK;
+    uint8_t numFused = 0; // number of observations that passed the checks and will be fused
 
     // perform sequential fusion of GPS measurements. This assumes that the
     // errors in the different velocity and position components are
@@ -1942,6 +1955,12 @@ void NavEKF::FuseVelPosNED()
         // calculate additional error in GPS position caused by manoeuvring
         posErr = gpsPosVarAccScale * accNavMag;
 
+        // GPS velocity noise floors and manoeuvre error, shared by the fusion variances,
+        // the data checks and the IMU blending weights
+        const float R_velNE = sq(constrain_float(_gpsHorizVelNoise, 0.05f, 5.0f));
+        const float R_velD = sq(constrain_float(_gpsVertVelNoise, 0.05f, 5.0f));
+        const float R_velNE_manoeuvre = R_velNE + sq(gpsNEVelVarAccScale * accNavMag);
+
         // estimate the GPS Velocity, GPS horiz position and height measurement variances.
         // if the GPS is able to report a speed error, we use it to adjust the observation noise for GPS velocity
         // otherwise we scale it using manoeuvre acceleration
@@ -1951,8 +1970,8 @@ void NavEKF::FuseVelPosNED()
             R_OBS[2] = sq(constrain_float(gpsSpdAccuracy, _gpsVertVelNoise, 50.0f));
         } else {
             // calculate additional error in GPS velocity caused by manoeuvring
-            R_OBS[0] = sq(constrain_float(_gpsHorizVelNoise, 0.05f, 5.0f)) + sq(gpsNEVelVarAccScale * accNavMag);
-            R_OBS[2] = sq(constrain_float(_gpsVertVelNoise,  0.05f, 5.0f)) + sq(gpsDVelVarAccScale  * accNavMag);
+            R_OBS[0] = R_velNE_manoeuvre;
+            R_OBS[2] = R_velD + sq(gpsDVelVarAccScale  * accNavMag);
         }
         R_OBS[1] = R_OBS[0];
         R_OBS[3] = sq(constrain_float(_gpsHorizPosNoise, 0.1f, 10.0f)) + sq(posErr);
@@ -1967,7 +1986,7 @@ void NavEKF::FuseVelPosNED()
         // For data integrity checks we use the same measurement variances as used to calculate the Kalman gains for all measurements except GPS horizontal velocity
         // For horizontal GPs velocity we don't want the acceptance radius to increase with reported GPS accuracy so we use a value based on best GPs perfomrance
         // plus a margin for manoeuvres. It is better to reject GPS horizontal velocity errors early
-        for (uint8_t i=0; i<=1; i++) R_OBS_DATA_CHECKS[i] = sq(constrain_float(_gpsHorizVelNoise, 0.05f, 5.0f)) + sq(gpsNEVelVarAccScale * accNavMag);
+        for (uint8_t i=0; i<=1; i++) R_OBS_DATA_CHECKS[i] = R_velNE_manoeuvre;
         for (uint8_t i=2; i<=5; i++) R_OBS_DATA_CHECKS[i] = R_OBS[i];
 
 
@@ -2054,12 +2073,7 @@ void NavEKF::FuseVelPosNED()
                 varInnovVelPos[i] = P[stateIndex][stateIndex] + R_OBS_DATA_CHECKS[i];
                 // calculate error weightings for single IMU velocity states using
                 // observation error to normalise
-                float R_hgt;
-                if (i == 2) {
-                    R_hgt = sq(constrain_float(_gpsVertVelNoise, 0.05f, 5.0f));
-                } else {
-                    R_hgt = sq(constrain_float(_gpsHorizVelNoise, 0.05f, 5.0f));
-                }
+                float R_hgt = (i == 2) ? R_velD : R_velNE;
                 K1 += R_hgt / (R_hgt + sq(velInnov1[i]));
                 K2 += R_hgt / (R_hgt + sq(velInnov2[i]));
                 // sum the innovation and innovation variances
@@ -2144,21 +2158,33 @@ void NavEKF::FuseVelPosNED()
             fuseData[0] = true;
             fuseData[1] = true;
         }
-
-        // fuse measurements sequentially
         for (obsIndex=0; obsIndex<=5; obsIndex++) {
+            if (fuseData[obsIndex]) {
+                numFused++;
+            }
+        }
+
+        // terms that are common to all observations fused on this time step
+        // adjust scaling on GPS measurement noise variances if not enough satellites
+        const float gpsNoiseScalerSq = sq(gpsNoiseScaler);
+        // Don't spread quaternion corrections if total angle change across predicted interval is going to exceed 0.1 rad
+        const bool highRates = ((gpsUpdateCountMax * correctedDelAng.length()) > 0.1f);
+        Vector22 Prow; // copy of the row of P for the observed state used by the covariance update
+
+        // fuse measurements sequentially. Observations rejected by the consistency
+        // checks above skip the Kalman gain, state and covariance updates entirely
+        for (obsIndex=0; obsIndex<=5 && numFused > 0; obsIndex++) {
             if (fuseData[obsIndex]) {
                 stateIndex = 4 + obsIndex;
                 // calculate the measurement innovation, using states from a different time coordinate if fusing height data
-                // adjust scaling on GPS measurement noise variances if not enough satellites
                 if (obsIndex <= 2)
                 {
                     innovVelPos[obsIndex] = statesAtVelTime.velocity[obsIndex] - observation[obsIndex];
-                    R_OBS[obsIndex] *= sq(gpsNoiseScaler);
+                    R_OBS[obsIndex] *= gpsNoiseScalerSq;
                 }
                 else if (obsIndex == 3 || obsIndex == 4) {
                     innovVelPos[obsIndex] = statesAtPosTime.position[obsIndex-3] - observation[obsIndex];
-                    R_OBS[obsIndex] *= sq(gpsNoiseScaler);
+                    R_OBS[obsIndex] *= gpsNoiseScalerSq;
                 } else {
                     innovVelPos[obsIndex] = statesAtHgtTime.position[obsIndex-3] - observation[obsIndex];
                     if (obsIndex == 5) {
@@ -2257,9 +2283,7 @@ void NavEKF::FuseVelPosNED()
                 // calculate state corrections and re-normalise the quaternions for states predicted using the blended IMU data
                 // attitude, velocity and position corrections are spread across multiple prediction cycles between now
                 // and the anticipated time for the next measurement.
-                // Don't spread quaternion corrections if total angle change across predicted interval is going to exceed 0.1 rad
                 // Don't apply corrections to Z bias state as this has been done already as part of the single IMU calculations
-                bool highRates = ((gpsUpdateCountMax * correctedDelAng.length()) > 0.1f);
                 for (uint8_t i = 0; i<=21; i++) {
                     if (i != 13) {
                         if ((i <= 3 && highRates) || i >= 10 || constPosMode || constVelMode) {
@@ -2277,15 +2301,17 @@ void NavEKF::FuseVelPosNED()
 
                 // update the covariance - take advantage of direct observation of a single state at index = stateIndex to reduce computations
                 // this is a numerically optimised implementation of standard equation P = (I - K*H)*P;
+                // KH only has one non-zero column so KHP[i][j] = Kfusion[i] * P[stateIndex][j]. The observed row is
+                // copied first so P can be updated in place, and the rows of the inhibited wind and magnetic field
+                // states, whose gains were set to zero above, are unchanged
+                memcpy(&Prow[0], &P[stateIndex][0], sizeof(Prow));
                 for (uint8_t i= 0; i<=21; i++) {
-                    for (uint8_t j= 0; j<=21; j++)
-                    {
-                        KHP[i][j] = Kfusion[i] * P[stateIndex][j];
+                    if ((inhibitWindStates && (i == 14 || i == 15)) || (inhibitMagStates && i >= 16)) {
+                        continue;
                     }
-                }
-                for (uint8_t i= 0; i<=21; i++) {
+                    const float Ki = Kfusion[i];
                     for (uint8_t j= 0; j<=21; j++) {
-                        P[i][j] = P[i][j] - KHP[i][j];
+                        P[i][j] -= Ki * Prow[j];
                     }
                 }
             }
@@ -2293,8 +2319,11 @@ void NavEKF::FuseVelPosNED()
     }
 
     // force the covariance matrix to be symmetrical and limit the variances to prevent ill-condiioning.
-    ForceSymmetry();
-    ConstrainVariances();
+    // The covariance matrix is unchanged if all observations were rejected
+    if (numFused > 0) {
+        ForceSymmetry();
+        ConstrainVariances();
+    }
 
     // stop performance timer
     perf_end(_perf_FuseVelPosNED);
@@ -3730,6 +3759,59 @@ void NavEKF::getIMU1Weighting(float &ret) const
     ret = IMU1_weighting;
 }
 
+// copy tuning parameters from another filter instance
+void NavEKF::copyParameters(const NavEKF &src)
+{
+    _gpsHorizVelNoise = src._gpsHorizVelNoise;
+    _gpsVertVelNoise = src._gpsVertVelNoise;
+    _gpsHorizPosNoise = src._gpsHorizPosNoise;
+    _baroAltNoise = src._baroAltNoise;
+    _magNoise = src._magNoise;
+    _easNoise = src._easNoise;
+    _windVelProcessNoise = src._windVelProcessNoise;
+    _wndVarHgtRateScale = src._wndVarHgtRateScale;
+    _magEarthProcessNoise = src._magEarthProcessNoise;
+    _magBodyProcessNoise = src._magBodyProcessNoise;
+    _gyrNoise = src._gyrNoise;
+    _accNoise = src._accNoise;
+    _gyroBiasProcessNoise = src._gyroBiasProcessNoise;
+    _accelBiasProcessNoise = src._accelBiasProcessNoise;
+    _msecVelDelay = src._msecVelDelay;
+    _msecPosDelay = src._msecPosDelay;
+    _fusionModeGPS = src._fusionModeGPS;
+    _gpsVelInnovGate = src._gpsVelInnovGate;
+    _gpsPosInnovGate = src._gpsPosInnovGate;
+    _hgtInnovGate = src._hgtInnovGate;
+    _magInnovGate = src._magInnovGate;
+    _tasInnovGate = src._tasInnovGate;
+    _magCal = src._magCal;
+    _gpsGlitchAccelMax = src._gpsGlitchAccelMax;
+    _gpsGlitchRadiusMax = src._gpsGlitchRadiusMax;
+    _gndGradientSigma = src._gndGradientSigma;
+    _flowNoise = src._flowNoise;
+    _flowInnovGate = src._flowInnovGate;
+    _msecFLowDelay = src._msecFLowDelay;
+    _rngInnovGate = src._rngInnovGate;
+    _maxFlowRate = src._maxFlowRate;
+    _fallback = src._fallback;
+    _altSource = src._altSource;
+    _imuMask = src._imuMask;
+}
+
+// return the largest of the innovation consistency test ratios
+float NavEKF::errorScore(void) const
+{
+    float score = max(velTestRatio, posTestRatio);
+    score = max(score, hgtTestRatio);
+    if (use_compass()) {
+        score = max(score, max(magTestRatio.x, max(magTestRatio.y, magTestRatio.z)));
+    }
+    if (useAirspeed()) {
+        score = max(score, tasTestRatio);
+    }
+    return score;
+}
+
 // return the individual Z-accel bias estimates in m/s^2
 void NavEKF::getAccelZBias(float &zbias1, float &zbias2) const {
     if (dtIMUavg > 0) {
@@ -3967,15 +4049,7 @@ void NavEKF::CovarianceInit()
 // force symmetry on the covariance matrix to prevent ill-conditioning
 void NavEKF::ForceSymmetry()
 {
-    for (uint8_t i=1; i<=21; i++)
-    {
-        for (uint8_t j=0; j<=i-1; j++)
-        {
-            float temp = 0.5f*(P[i][j] + P[j][i]);
-            P[i][j] = temp;
-            P[j][i] = temp;
-        }
-    }
+    P.force_symmetry();
 }
 
 // copy covariances across from covariance prediction calculation and fix numerical errors
@@ -4071,6 +4145,16 @@ void NavEKF::readIMUData()
     // the imu sample time is used as a common time reference throughout the filter
     imuSampleTime_ms = hal.scheduler->millis();
 
+    if (imuIndex >= 0) {
+        // single lane mode - this instance only uses one IMU so that a fault
+        // on another IMU cannot corrupt its solution
+        readDeltaVelocity(imuIndex, dVelIMU1, dtDelVel1);
+        dtDelVel2 = dtDelVel1;
+        dVelIMU2 = dVelIMU1;
+        readDeltaAngle(imuIndex, dAngIMU);
+        return;
+    }
+
     if (ins.get_accel_health(0) && ins.get_accel_health(1)) {
         // dual accel mode
         readDeltaVelocity(0, dVelIMU1, dtDelVel1);
@@ -4117,10 +4201,17 @@ void NavEKF::readGpsData()
         // set flag that lets other functions know that new GPS data has arrived
         newDataGps = true;
 
+        // get the time the fix was valid at, which takes out the varying delay before we
+        // were given it. Fall back to the current time if it is not plausible
+        uint32_t gpsTimeOfValidity_ms = _ahrs->get_gps().last_fix_tov_ms();
+        if (imuSampleTime_ms - gpsTimeOfValidity_ms > 500) {
+            gpsTimeOfValidity_ms = imuSampleTime_ms;
+        }
+
         // get state vectors that were stored at the time that is closest to when the the GPS measurement
         // time after accounting for measurement delays
-        RecallStates(statesAtVelTime, (imuSampleTime_ms - constrain_int16(_msecVelDelay, 0, 500)));
-        RecallStates(statesAtPosTime, (imuSampleTime_ms - constrain_int16(_msecPosDelay, 0, 500)));
+        RecallStates(statesAtVelTime, (gpsTimeOfValidity_ms - constrain_int16(_msecVelDelay, 0, 500)));
+        RecallStates(statesAtPosTime, (gpsTimeOfValidity_ms - constrain_int16(_msecPosDelay, 0, 500)));
 
         // read the NED velocity from the GPS
         velNED = _ahrs->get_gps().velocity();
@@ -5082,10 +5173,6 @@ bool NavEKF::calcGpsGoodToAlign(void)
 // Read at 20Hz and apply a median filter
 void NavEKF::readRangeFinder(void)
 {
-    static float storedRngMeas[3];
-    static uint32_t storedRngMeasTime_ms[3];
-    static uint32_t lastRngMeasTime_ms = 0;
-    static uint8_t rngMeasIndex = 0;
     uint8_t midIndex;
     uint8_t maxIndex;
     uint8_t minIndex;
@@ -34,6 +34,7 @@
 // #define MATH_CHECK_INDEXES 1
 
 #include <vectorN.h>
+#include <matrixN.h>
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
 #include <systemlib/perf_counter.h>
@@ -62,9 +63,6 @@ public:
     typedef VectorN<ftype,22> Vector22;
     typedef VectorN<ftype,31> Vector31;
     typedef VectorN<ftype,34> Vector34;
-    typedef VectorN<VectorN<ftype,3>,3> Matrix3;
-    typedef VectorN<VectorN<ftype,22>,22> Matrix22;
-    typedef VectorN<VectorN<ftype,34>,22> Matrix34_50;
     typedef VectorN<uint32_t,50> Vector_u32_50;
 #else
     typedef ftype Vector2[2];
@@ -82,11 +80,11 @@ public:
     typedef ftype Vector22[22];
     typedef ftype Vector31[31];
     typedef ftype Vector34[34];
-    typedef ftype Matrix3[3][3];
-    typedef ftype Matrix22[22][22];
-    typedef ftype Matrix34_50[34][50];
     typedef uint32_t Vector_u32_50[50];
 #endif
+    typedef MatrixN<ftype,3,3> Matrix3;
+    typedef MatrixN<ftype,22,22> Matrix22;
+    typedef MatrixN<ftype,34,50> Matrix34_50;
 
     // Constructor
     NavEKF(const AP_AHRS *ahrs, AP_Baro &baro, const RangeFinder &rng);
@@ -137,6 +135,24 @@ public:
     // return weighting of first IMU in blending function
     void getIMU1Weighting(float &ret) const;
 
+    // restrict this filter instance to a single IMU lane. An index of -1
+    // restores the default behaviour of blending the first two IMUs
+    void setIMUIndex(int8_t index) { imuIndex = index; }
+
+    // return the IMU lane used by this filter instance, or -1 if blending
+    int8_t getIMUIndex(void) const { return imuIndex; }
+
+    // return the bitmask of IMUs that should each run an independent filter instance
+    uint8_t getIMUMask(void) const { return _imuMask; }
+
+    // copy tuning parameters from another filter instance
+    // used to keep additional filter instances consistent with the instance that owns the parameters
+    void copyParameters(const NavEKF &src);
+
+    // return a consolidated error score for the filter, being the largest of the
+    // innovation consistency test ratios. Values above 1 indicate measurements are being rejected
+    float errorScore(void) const;
+
     // return the individual Z-accel bias estimates in m/s^2
     void getAccelZBias(float &zbias1, float &zbias2) const;
 
@@ -490,6 +506,7 @@ private:
     AP_Float _maxFlowRate;          // Maximum flow rate magnitude that will be accepted by the filter
     AP_Int8 _fallback;              // EKF-to-DCM fallback strictness. 0 = trust EKF more, 1 = fallback more conservatively.
     AP_Int8 _altSource;             // Primary alt source during optical flow navigation. 0 = use Baro, 1 = use range finder.
+    AP_Int8 _imuMask;               // Bitmask of IMUs to run independent filter instances on. 0 = single instance blending IMU1 and IMU2
 
     // Tuning parameters
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
@@ -746,6 +763,14 @@ private:
     // IMU processing
     float dtDelVel1;
     float dtDelVel2;
+    int8_t imuIndex;                // IMU lane used by this instance, -1 when blending IMU1 and IMU2
+    bool prevArmedUpdate;           // arm status at the previous filter update used to detect gyro auto-zero time slips
+
+    // Range finder median filter
+    float storedRngMeas[3];         // ring buffer of range finder measurements (m)
+    uint32_t storedRngMeasTime_ms[3]; // time stamps of range finder measurements in the ring buffer (msec)
+    uint32_t lastRngMeasTime_ms;    // time of the last range finder measurement (msec)
+    uint8_t rngMeasIndex;           // index of the latest range finder measurement in the ring buffer
 
     // baro ground effect
     bool expectGndEffectTakeoff;      // external state from ArduCopter - takeoff expected
@@ -34,7 +34,6 @@ SmallEKF::SmallEKF(const AP_AHRS_NavEKF &ahrs) :
     states(),
     state(*reinterpret_cast<struct state_elements *>(&states)),
     gSense{},
-    Cov{},
     TiltCorrection(0),
     StartTime_ms(0),
     FiltInit(false),
@@ -42,6 +41,7 @@ SmallEKF::SmallEKF(const AP_AHRS_NavEKF &ahrs) :
     dtIMU(0)
 {
     AP_Param::setup_object_defaults(this, var_info);
+    Cov.zero();
 }
 
 // run a 9-state EKF used to calculate orientation
@@ -452,7 +452,7 @@ void SmallEKF::predictCovariance()
     float t1625 = Cov[2][8]*t1526;
     float t1626 = Cov[0][8]*t1523;
     float t1627 = Cov[5][8]+t1625+t1626-Cov[1][8]*t1521;
-    float nextCov[9][9];
+    Matrix9 nextCov;
     nextCov[0][0] = daxNoise*t1485+t1397*t1424+t1411*t1431-t1419*t1432-t1402*t1454;
     nextCov[1][0] = -t1397*t1478-t1411*t1481+t1419*t1484+t1402*(t1527+t1528-Cov[1][6]*t1468-Cov[2][6]*t1472);
     nextCov[2][0] = -t1397*t1538-t1411*t1541+t1419*t1544+t1402*(t1553+t1554-Cov[0][6]*t1491-Cov[2][6]*t1503);
@@ -889,12 +889,7 @@ float SmallEKF::calcMagHeadingInnov()
 void SmallEKF::fixCovariance()
 {
     // force symmetry
-    for (uint8_t rowIndex=1; rowIndex<=8; rowIndex++) {
-        for (uint8_t colIndex=0; colIndex<=rowIndex-1; colIndex++) {
-            Cov[rowIndex][colIndex] = 0.5f*(Cov[rowIndex][colIndex] + Cov[colIndex][rowIndex]);
-            Cov[colIndex][rowIndex] = Cov[rowIndex][colIndex];
-        }
-    }
+    Cov.force_symmetry();
 
     // constrain diagonals to be non-negative
     for (uint8_t index=1; index<=8; index++) {
@@ -32,6 +32,7 @@
 #include <AP_NavEKF.h>
 
 #include <vectorN.h>
+#include <matrixN.h>
 
 class SmallEKF
 {
@@ -52,9 +53,6 @@ public:
     typedef VectorN<ftype,22> Vector22;
     typedef VectorN<ftype,31> Vector31;
     typedef VectorN<ftype,34> Vector34;
-    typedef VectorN<VectorN<ftype,3>,3> Matrix3;
-    typedef VectorN<VectorN<ftype,22>,22> Matrix22;
-    typedef VectorN<VectorN<ftype,34>,22> Matrix34_50;
     typedef VectorN<uint32_t,50> Vector_u32_50;
 #else
     typedef ftype Vector2[2];
@@ -71,11 +69,12 @@ public:
     typedef ftype Vector22[22];
     typedef ftype Vector31[31];
     typedef ftype Vector34[34];
-    typedef ftype Matrix3[3][3];
-    typedef ftype Matrix22[22][22];
-    typedef ftype Matrix34_50[34][50];
     typedef uint32_t Vector_u32_50[50];
 #endif
+    typedef MatrixN<ftype,3,3> Matrix3;
+    typedef MatrixN<ftype,9,9> Matrix9;
+    typedef MatrixN<ftype,22,22> Matrix22;
+    typedef MatrixN<ftype,34,50> Matrix34_50;
 
     // Constructor
     SmallEKF(const AP_AHRS_NavEKF &ahrs);
@@ -121,7 +120,7 @@ private:
         float gTheta;
     } gSense;
 
-    float Cov[9][9];                // covariance matrix
+    Matrix9 Cov;                    // covariance matrix
     Matrix3f Tsn;                   // Sensor to NED rotation matrix
     float TiltCorrection;           // Angle correction applied to tilt from last velocity fusion (rad)
     bool newDataMag;                // true when new magnetometer data is waiting to be used
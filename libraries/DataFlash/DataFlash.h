@@ -17,6 +17,7 @@
 #include "../AP_Airspeed/AP_Airspeed.h"
 #include "../AP_BattMonitor/AP_BattMonitor.h"
 #include <stdint.h>
+#include "LogCompact.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4
 #include <uORB/topics/esc_status.h>
@@ -27,6 +28,9 @@
 #define DATAFLASH_NO_CLI
 #endif
 
+// returned by get_log_data_nonblocking() when the data isn't read yet
+#define DATAFLASH_DATA_PENDING -2
+
 class DataFlash_Class
 {
 public:
@@ -44,14 +48,34 @@ public:
     virtual bool NeedErase(void) = 0;
     virtual void EraseAll() = 0;
 
-    /* Write a block of data at current offset */
-    virtual void WriteBlock(const void *pBuffer, uint16_t size) = 0;
+    /*
+      Write a block of data at current offset. With compact logging
+      enabled a whole log message is written in the compact encoding
+      where that makes it smaller
+    */
+    void WriteBlock(const void *pBuffer, uint16_t size) {
+        if (_compact) {
+            _write_compact(pBuffer, size);
+        } else {
+            WriteRawBlock(pBuffer, size);
+        }
+    }
 
     // high level interface
     virtual uint16_t find_last_log(void) = 0;
     virtual void get_log_boundaries(uint16_t log_num, uint16_t & start_page, uint16_t & end_page) = 0;
     virtual void get_log_info(uint16_t log_num, uint32_t &size, uint32_t &time_utc) = 0;
     virtual int16_t get_log_data(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data) = 0;
+    /*
+      get log data for a download without waiting on the storage.
+      Returns DATAFLASH_DATA_PENDING if the data is still being read,
+      otherwise the same as get_log_data()
+    */
+    virtual int16_t get_log_data_nonblocking(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data) {
+        return get_log_data(log_num, page, offset, len, data);
+    }
+    // the GCS has finished downloading logs
+    virtual void end_log_transfer(void) {}
     virtual uint16_t get_num_logs(void) = 0;
 #ifndef DATAFLASH_NO_CLI
     virtual void LogReadProcess(uint16_t log_num,
@@ -67,6 +91,7 @@ public:
     uint16_t StartNewLog(void);
     void AddLogFormats(const struct LogStructure *structures, uint8_t num_types);
     void EnableWrites(bool enable) { _writes_enabled = enable; }
+    void SetCompact(bool enable);
     void Log_Write_Format(const struct LogStructure *structure);
     void Log_Write_Parameter(const char *name, float value);
     void Log_Write_GPS(const AP_GPS &gps, uint8_t instance, int32_t relative_alt);
@@ -127,11 +152,36 @@ protected:
     void Log_Write_Parameters(void);
     virtual uint16_t start_new_log(void) = 0;
 
+    /*
+      write a block of data as it is. Returns false if the block was
+      not written
+    */
+    virtual bool WriteRawBlock(const void *pBuffer, uint16_t size) = 0;
+
+    /*
+      skip over a compact log entry when printing a log. The header
+      bytes have already been read
+    */
+    void _skip_compact_entry(void);
+
+    /*
+      write a block with compact logging enabled
+    */
+    void _write_compact(const void *pBuffer, uint16_t size);
+
     const struct LogStructure *_structures;
     uint8_t _num_types;
     bool _writes_enabled;
     bool log_write_started;
 
+    // compact logging state, with the last message of each type
+    // written and a count towards the next one written in full
+    bool _compact;
+    uint8_t **_compact_last;
+    uint8_t *_compact_count;
+    // index into _structures for each message type, 0xFF for none
+    uint8_t *_compact_index;
+
     /*
       read a block
     */
@@ -576,6 +626,33 @@ struct PACKED log_GYRO {
     float GyrX, GyrY, GyrZ;
 };
 
+/*
+  header for a batch of raw IMU samples, followed by sample_count /
+  32 ISBD messages with the same seqno. Sample values are the int16_t
+  values divided by multiplier
+ */
+struct PACKED log_ISBH {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint16_t seqno;
+    uint8_t  sensor_type; // 0:accel 1:gyro
+    uint8_t  instance;
+    float    multiplier;
+    uint16_t sample_count;
+    uint64_t sample_us;
+    uint16_t sample_rate_hz;
+};
+
+struct PACKED log_ISBD {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint16_t isb_seqno;
+    uint16_t seqno;
+    int16_t x[32];
+    int16_t y[32];
+    int16_t z[32];
+};
+
 /*
 Format characters in the format string for binary log messages
   b   : int8_t
@@ -597,6 +674,7 @@ Format characters in the format string for binary log messages
   M   : uint8_t flight mode
   q   : int64_t
   Q   : uint64_t
+  a   : int16_t[32]
  */
 
 // messages for all boards
@@ -711,7 +789,11 @@ Format characters in the format string for binary log messages
     { LOG_PIDA_MSG, sizeof(log_PID), \
       "PIDA", "Qffffff",  "TimeUS,Des,P,I,D,FF,AFF" }, \
     { LOG_BAR2_MSG, sizeof(log_BARO), \
-      "BAR2",  "Qffcf", "TimeUS,Alt,Press,Temp,CRt" }
+      "BAR2",  "Qffcf", "TimeUS,Alt,Press,Temp,CRt" }, \
+    { LOG_ISBH_MSG, sizeof(log_ISBH), \
+      "ISBH", "QHBBfHQH", "TimeUS,N,type,instance,mul,smp_cnt,SampleUS,smp_rate" }, \
+    { LOG_ISBD_MSG, sizeof(log_ISBD), \
+      "ISBD", "QHHaaa", "TimeUS,N,seqno,x,y,z" }
 
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
 #define LOG_COMMON_STRUCTURES LOG_BASE_STRUCTURES, LOG_EXTRA_STRUCTURES
@@ -777,6 +859,8 @@ Format characters in the format string for binary log messages
 #define LOG_PIDP_MSG      180
 #define LOG_PIDY_MSG      181
 #define LOG_PIDA_MSG      182
+#define LOG_ISBH_MSG      183
+#define LOG_ISBD_MSG      184
 
 // message types 200 to 210 reversed for GPS driver use
 // message types 211 to 220 reversed for autotune use
@@ -35,10 +35,10 @@ void DataFlash_Block::FinishWrite(void)
     df_BufferIdx = 0;
 }
 
-void DataFlash_Block::WriteBlock(const void *pBuffer, uint16_t size)
+bool DataFlash_Block::WriteRawBlock(const void *pBuffer, uint16_t size)
 {
     if (!CardInserted() || !log_write_started || !_writes_enabled) {
-        return;
+        return false;
     }
     while (size > 0) {
         uint16_t n = df_PageSize - df_BufferIdx;
@@ -68,6 +68,7 @@ void DataFlash_Block::WriteBlock(const void *pBuffer, uint16_t size)
             df_FilePage++;
         }
     }
+    return true;
 }
 
 
@@ -174,7 +175,7 @@ void DataFlash_Block::EraseAll()
     uint32_t version = DF_LOGGING_FORMAT;
     log_write_started = true;
     _writes_enabled = true;
-    WriteBlock(&version, sizeof(version));
+    WriteRawBlock(&version, sizeof(version));
     log_write_started = false;
     FinishWrite();
     hal.scheduler->delay(100);
@@ -20,9 +20,6 @@ public:
     bool NeedErase(void);
     void EraseAll();
 
-    /* Write a block of data at current offset */
-    void WriteBlock(const void *pBuffer, uint16_t size);
-
     // high level interface
     uint16_t find_last_log(void);
     void get_log_boundaries(uint16_t log_num, uint16_t & start_page, uint16_t & end_page);
@@ -92,6 +89,9 @@ private:
     void StartWrite(uint16_t PageAdr);
     void FinishWrite(void);
 
+    /* Write a block of data at current offset */
+    bool WriteRawBlock(const void *pBuffer, uint16_t size);
+
     // Read methods
     bool ReadBlock(void *pBuffer, uint16_t size);
 
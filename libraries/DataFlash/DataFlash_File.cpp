@@ -31,6 +31,9 @@ extern const AP_HAL::HAL& hal;
 #define MAX_LOG_FILES 500U
 #define DATAFLASH_PAGE_SIZE 1024UL
 
+// size of each read ahead block for log download
+#define DATAFLASH_READ_AHEAD_SIZE 4096U
+
 /*
   constructor
  */
@@ -64,14 +67,19 @@ DataFlash_File::DataFlash_File(const char *log_directory) :
 #endif
     _writebuf_head(0),
     _writebuf_tail(0),
-    _last_write_time(0)
+    _last_write_time(0),
+    _read_ahead_fd(-1),
+    _read_ahead_log_num(0),
+    _read_ahead_flush(false)
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     ,_perf_write(perf_alloc(PC_ELAPSED, "DF_write")),
     _perf_fsync(perf_alloc(PC_ELAPSED, "DF_fsync")),
     _perf_errors(perf_alloc(PC_COUNT, "DF_errors")),
     _perf_overruns(perf_alloc(PC_COUNT, "DF_overruns"))
 #endif
-{}
+{
+    memset(_read_ahead, 0, sizeof(_read_ahead));
+}
 
 
 // initialisation
@@ -175,6 +183,7 @@ void DataFlash_File::EraseAll()
 {
     uint16_t log_num;
     stop_logging();
+    _read_ahead_reset();
     for (log_num=0; log_num<MAX_LOG_FILES; log_num++) {
         char *fname = _log_file_name(log_num);
         if (fname == NULL) {
@@ -191,17 +200,17 @@ void DataFlash_File::EraseAll()
 }
 
 /* Write a block of data at current offset */
-void DataFlash_File::WriteBlock(const void *pBuffer, uint16_t size)
+bool DataFlash_File::WriteRawBlock(const void *pBuffer, uint16_t size)
 {
     if (_write_fd == -1 || !_initialised || _open_error || !_writes_enabled) {
-        return;
+        return false;
     }
     uint16_t _head;
     uint16_t space = BUF_SPACE(_writebuf);
     if (space < size) {
         // discard the whole write, to keep the log consistent
         perf_count(_perf_overruns);
-        return;
+        return false;
     }
 
     if (_writebuf_tail < _head) {
@@ -224,6 +233,7 @@ void DataFlash_File::WriteBlock(const void *pBuffer, uint16_t size)
             BUF_ADVANCETAIL(_writebuf, n);
         }
     }
+    return true;
 }
 
 /*
@@ -370,6 +380,202 @@ int16_t DataFlash_File::get_log_data(uint16_t log_num, uint16_t page, uint32_t o
     return ret;
 }
 
+/*
+  find the read ahead block holding offset, if it has been read
+ */
+struct DataFlash_File::read_ahead_block *DataFlash_File::_read_ahead_find(uint16_t log_num, uint32_t offset)
+{
+    uint32_t block_offset = offset - (offset % DATAFLASH_READ_AHEAD_SIZE);
+    for (uint8_t i=0; i<2; i++) {
+        struct read_ahead_block &b = _read_ahead[i];
+        if (b.state == READ_AHEAD_READY && b.log_num == log_num && b.offset == block_offset) {
+            // don't look at the data before the state that published it
+            __sync_synchronize();
+            return &b;
+        }
+    }
+    return NULL;
+}
+
+/*
+  ask the io thread for the block holding offset, without throwing
+  away the block holding keep_offset
+ */
+void DataFlash_File::_read_ahead_request(uint16_t log_num, uint32_t offset, uint32_t keep_offset)
+{
+    uint32_t block_offset = offset - (offset % DATAFLASH_READ_AHEAD_SIZE);
+    uint32_t keep_block = keep_offset - (keep_offset % DATAFLASH_READ_AHEAD_SIZE);
+    for (uint8_t i=0; i<2; i++) {
+        const struct read_ahead_block &b = _read_ahead[i];
+        if (b.state != READ_AHEAD_EMPTY && b.log_num == log_num && b.offset == block_offset) {
+            // already read or on its way
+            return;
+        }
+    }
+
+    // use an empty block, or else a block that has been read and
+    // isn't the one being sent from. Requested blocks belong to the
+    // io thread
+    struct read_ahead_block *victim = NULL;
+    for (uint8_t i=0; i<2 && victim == NULL; i++) {
+        if (_read_ahead[i].state == READ_AHEAD_EMPTY) {
+            victim = &_read_ahead[i];
+        }
+    }
+    for (uint8_t i=0; i<2 && victim == NULL; i++) {
+        struct read_ahead_block &b = _read_ahead[i];
+        if (b.state == READ_AHEAD_READY && (b.log_num != log_num || b.offset != keep_block)) {
+            victim = &b;
+        }
+    }
+    if (victim == NULL) {
+        return;
+    }
+    victim->log_num = log_num;
+    victim->offset = block_offset;
+    victim->len = 0;
+    __sync_synchronize();
+    victim->state = READ_AHEAD_REQUESTED;
+}
+
+/*
+  forget all read ahead data and close the file, as the logs have
+  changed or the download is over. A block may be in the middle of
+  being read, so the io thread does this, and no block is used until
+  it has
+ */
+void DataFlash_File::_read_ahead_reset(void)
+{
+    __sync_synchronize();
+    _read_ahead_flush = true;
+}
+
+/*
+  the GCS has finished downloading logs
+ */
+void DataFlash_File::end_log_transfer(void)
+{
+    _read_ahead_reset();
+}
+
+/*
+  get log data from the read ahead blocks, so the main thread never
+  waits on the SD card while sending a log
+ */
+int16_t DataFlash_File::get_log_data_nonblocking(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data)
+{
+    if (!_initialised || _open_error) {
+        return -1;
+    }
+    if (_read_ahead[0].data == NULL) {
+        _read_ahead[0].data = (uint8_t *)malloc(DATAFLASH_READ_AHEAD_SIZE);
+        _read_ahead[1].data = (uint8_t *)malloc(DATAFLASH_READ_AHEAD_SIZE);
+        if (_read_ahead[0].data == NULL || _read_ahead[1].data == NULL) {
+            free(_read_ahead[0].data);
+            free(_read_ahead[1].data);
+            _read_ahead[0].data = NULL;
+            _read_ahead[1].data = NULL;
+            return get_log_data(log_num, page, offset, len, data);
+        }
+    }
+    // as for get_log_data(), we don't log while sending a log
+    stop_logging();
+
+    if (_read_ahead_flush) {
+        // the io thread hasn't dropped the old blocks yet
+        return DATAFLASH_DATA_PENDING;
+    }
+
+    uint32_t ofs = page * (uint32_t)DATAFLASH_PAGE_SIZE + offset;
+    uint16_t count = 0;
+    bool eof = false;
+    while (count < len) {
+        struct read_ahead_block *b = _read_ahead_find(log_num, ofs + count);
+        if (b == NULL) {
+            _read_ahead_request(log_num, ofs + count, ofs);
+            return DATAFLASH_DATA_PENDING;
+        }
+        if (b->len < 0) {
+            return -1;
+        }
+        uint32_t block_ofs = ofs + count - b->offset;
+        if (b->len < (int16_t)DATAFLASH_READ_AHEAD_SIZE) {
+            // a short block is the end of the log
+            eof = true;
+        }
+        if (block_ofs >= (uint32_t)b->len) {
+            break;
+        }
+        uint16_t n = min((uint32_t)(len - count), b->len - block_ofs);
+        memcpy(&data[count], &b->data[block_ofs], n);
+        count += n;
+        if (eof) {
+            break;
+        }
+    }
+
+    if (!eof) {
+        // keep the next block on its way
+        uint32_t next = ofs + count;
+        _read_ahead_request(log_num, next - (next % DATAFLASH_READ_AHEAD_SIZE) + DATAFLASH_READ_AHEAD_SIZE, next);
+    }
+    return count;
+}
+
+/*
+  read the requested read ahead blocks. Called on the io thread
+ */
+void DataFlash_File::_read_ahead_io(void)
+{
+    if (_read_ahead_flush) {
+        if (_read_ahead_fd != -1) {
+            ::close(_read_ahead_fd);
+            _read_ahead_fd = -1;
+        }
+        for (uint8_t i=0; i<2; i++) {
+            _read_ahead[i].state = READ_AHEAD_EMPTY;
+        }
+        __sync_synchronize();
+        _read_ahead_flush = false;
+        return;
+    }
+    for (uint8_t i=0; i<2; i++) {
+        struct read_ahead_block &b = _read_ahead[i];
+        if (b.state != READ_AHEAD_REQUESTED) {
+            continue;
+        }
+        // don't look at the request before the state that published it
+        __sync_synchronize();
+        if (_read_ahead_fd != -1 && _read_ahead_log_num != b.log_num) {
+            ::close(_read_ahead_fd);
+            _read_ahead_fd = -1;
+        }
+        if (_read_ahead_fd == -1) {
+            char *fname = _log_file_name(b.log_num);
+            if (fname != NULL) {
+                _read_ahead_fd = ::open(fname, O_RDONLY);
+                free(fname);
+            }
+            _read_ahead_log_num = b.log_num;
+        }
+        if (_read_ahead_fd == -1 ||
+            ::lseek(_read_ahead_fd, b.offset, SEEK_SET) != (off_t)b.offset) {
+            b.len = -1;
+        } else {
+            ssize_t ret = ::read(_read_ahead_fd, b.data, DATAFLASH_READ_AHEAD_SIZE);
+            b.len = ret < 0 ? -1 : ret;
+        }
+        if (b.len < (int16_t)DATAFLASH_READ_AHEAD_SIZE && _read_ahead_fd != -1) {
+            // end of the log or a read error, so the download is over
+            ::close(_read_ahead_fd);
+            _read_ahead_fd = -1;
+        }
+        // the data has to be seen before the state
+        __sync_synchronize();
+        b.state = READ_AHEAD_READY;
+    }
+}
+
 /*
   find size and date of a log
  */
@@ -427,6 +633,7 @@ uint16_t DataFlash_File::start_new_log(void)
         ::close(_read_fd);
         _read_fd = -1;
     }
+    _read_ahead_reset();
 
     uint16_t log_num = find_last_log();
     // re-use empty logs if possible
@@ -519,6 +726,9 @@ void DataFlash_File::LogReadProcess(uint16_t log_num,
                 if (data == HEAD_BYTE2) {
                     log_step++;
                 } else {
+                    if (data == HEAD_BYTE2_COMPACT) {
+                        _skip_compact_entry();
+                    }
                     log_step = 0;
                 }
                 break;
@@ -606,6 +816,9 @@ void DataFlash_File::ListAvailableLogs(AP_HAL::BetterStream *port)
 void DataFlash_File::_io_timer(void)
 {
     uint16_t _tail;
+    if (_initialised && !_open_error) {
+        _read_ahead_io();
+    }
     if (_write_fd == -1 || !_initialised || _open_error) {
         return;
     }
@@ -33,14 +33,13 @@ public:
     bool NeedErase(void);
     void EraseAll();
 
-    /* Write a block of data at current offset */
-    void WriteBlock(const void *pBuffer, uint16_t size);
-
     // high level interface
     uint16_t find_last_log(void);
     void get_log_boundaries(uint16_t log_num, uint16_t & start_page, uint16_t & end_page);
     void get_log_info(uint16_t log_num, uint32_t &size, uint32_t &time_utc);
     int16_t get_log_data(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data);
+    int16_t get_log_data_nonblocking(uint16_t log_num, uint16_t page, uint32_t offset, uint16_t len, uint8_t *data);
+    void end_log_transfer(void);
     uint16_t get_num_logs(void);
     uint16_t start_new_log(void);
     void LogReadProcess(uint16_t log_num,
@@ -66,6 +65,9 @@ private:
     */
     bool ReadBlock(void *pkt, uint16_t size);
 
+    /* Write a block of data at current offset */
+    bool WriteRawBlock(const void *pBuffer, uint16_t size);
+
     // write buffer
     uint8_t *_writebuf;
     uint16_t _writebuf_size;
@@ -84,6 +86,35 @@ private:
 
     void _io_timer(void);
 
+    /*
+      read ahead for log download. Blocks of the log are requested by
+      the main thread and read on the io thread, with the state of
+      each block handing it from one thread to the other. The file is
+      only touched by the io thread
+     */
+    enum read_ahead_state {
+        READ_AHEAD_EMPTY = 0,
+        READ_AHEAD_REQUESTED,
+        READ_AHEAD_READY
+    };
+    struct read_ahead_block {
+        volatile enum read_ahead_state state;
+        uint16_t log_num;
+        uint32_t offset;
+        int16_t len;    // bytes read, or -1 on error
+        uint8_t *data;
+    } _read_ahead[2];
+    int _read_ahead_fd;
+    uint16_t _read_ahead_log_num;
+    // set by the main thread to have the io thread close the file and
+    // empty all the blocks
+    volatile bool _read_ahead_flush;
+
+    struct read_ahead_block *_read_ahead_find(uint16_t log_num, uint32_t offset);
+    void _read_ahead_request(uint16_t log_num, uint32_t offset, uint32_t keep_offset);
+    void _read_ahead_reset(void);
+    void _read_ahead_io(void);
+
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     // performance counters
     perf_counter_t  _perf_write;
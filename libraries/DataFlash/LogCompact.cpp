@@ -0,0 +1,237 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  compact encoding of log messages
+ */
+
+#include "LogCompact.h"
+#include <string.h>
+
+// the fixed header on every message
+#define LOG_HEADER_LEN 3
+
+// longest format string in a FMT message
+#define LOG_FORMAT_LEN 16
+
+/*
+  size of a field in bytes given its format character, or 0 if unknown
+ */
+uint8_t LogCompact::field_size(char c)
+{
+    switch (c) {
+    case 'b':
+    case 'B':
+    case 'M':
+        return 1;
+    case 'h':
+    case 'H':
+    case 'c':
+    case 'C':
+        return 2;
+    case 'i':
+    case 'I':
+    case 'e':
+    case 'E':
+    case 'L':
+    case 'f':
+    case 'n':
+        return 4;
+    case 'd':
+    case 'q':
+    case 'Q':
+        return 8;
+    case 'N':
+        return 16;
+    case 'Z':
+    case 'a':
+        return 64;
+    }
+    return 0;
+}
+
+/*
+  true for fields encoded as a difference from the last value
+ */
+bool LogCompact::is_integer(char c)
+{
+    return strchr("hHcCiIeELqQ", c) != NULL;
+}
+
+/*
+  true for fields encoded as the XOR of their bits with the last value
+ */
+bool LogCompact::is_float(char c)
+{
+    return c == 'f' || c == 'd';
+}
+
+uint64_t LogCompact::get_uint(const uint8_t *p, uint8_t size)
+{
+    switch (size) {
+    case 2: {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    case 4: {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    default: {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    }
+}
+
+void LogCompact::put_uint(uint8_t *p, uint8_t size, uint64_t v)
+{
+    switch (size) {
+    case 2: {
+        uint16_t v16 = v;
+        memcpy(p, &v16, sizeof(v16));
+        break;
+    }
+    case 4: {
+        uint32_t v32 = v;
+        memcpy(p, &v32, sizeof(v32));
+        break;
+    }
+    default:
+        memcpy(p, &v, sizeof(v));
+        break;
+    }
+}
+
+/*
+  append a varint to out at ofs, returning the new offset, or 0 if it
+  doesn't fit
+ */
+uint8_t LogCompact::put_varint(uint8_t *out, uint8_t ofs, uint64_t v)
+{
+    do {
+        if (ofs == LOG_COMPACT_MAX_PAYLOAD) {
+            return 0;
+        }
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        if (v != 0) {
+            b |= 0x80;
+        }
+        out[ofs++] = b;
+    } while (v != 0);
+    return ofs;
+}
+
+bool LogCompact::get_varint(const uint8_t *in, uint8_t in_len, uint8_t &ofs, uint64_t &v)
+{
+    v = 0;
+    for (uint8_t shift=0; shift<64; shift+=7) {
+        if (ofs >= in_len) {
+            return false;
+        }
+        uint8_t b = in[ofs++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t LogCompact::encode(const char *format, const uint8_t *prev,
+                           const uint8_t *pkt, uint16_t len, uint8_t *out)
+{
+    // work out which fields changed, checking the format matches
+    // the message length as we go
+    uint32_t mask = 0;
+    uint16_t ofs = LOG_HEADER_LEN;
+    uint8_t nfields;
+    for (nfields=0; nfields<LOG_FORMAT_LEN && format[nfields] != 0; nfields++) {
+        uint8_t size = field_size(format[nfields]);
+        if (size == 0 || ofs + size > len) {
+            return 0;
+        }
+        if (memcmp(&prev[ofs], &pkt[ofs], size) != 0) {
+            mask |= 1UL << nfields;
+        }
+        ofs += size;
+    }
+    if (ofs != len) {
+        return 0;
+    }
+
+    uint8_t n = put_varint(out, 0, mask);
+    ofs = LOG_HEADER_LEN;
+    for (uint8_t i=0; i<nfields && n != 0; i++) {
+        uint8_t size = field_size(format[i]);
+        if (mask & (1UL << i)) {
+            if (is_integer(format[i])) {
+                // difference as a signed value of the field width,
+                // so it wraps the same way as the field does
+                uint8_t shift = 64 - 8*size;
+                int64_t d = (int64_t)((get_uint(&pkt[ofs], size) - get_uint(&prev[ofs], size)) << shift) >> shift;
+                n = put_varint(out, n, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+            } else if (is_float(format[i])) {
+                // close values share their sign, exponent and top
+                // mantissa bits, so the XOR is a small number
+                n = put_varint(out, n, get_uint(&pkt[ofs], size) ^ get_uint(&prev[ofs], size));
+            } else if (n + size <= LOG_COMPACT_MAX_PAYLOAD) {
+                memcpy(&out[n], &pkt[ofs], size);
+                n += size;
+            } else {
+                n = 0;
+            }
+        }
+        ofs += size;
+    }
+
+    // only worth it if smaller than the message, allowing for the
+    // length byte
+    if (n == 0 || n + 1 + LOG_HEADER_LEN >= len) {
+        return 0;
+    }
+    return n;
+}
+
+bool LogCompact::decode(const char *format, const uint8_t *in, uint8_t in_len,
+                        uint8_t *pkt, uint16_t len)
+{
+    uint8_t n = 0;
+    uint64_t mask;
+    if (!get_varint(in, in_len, n, mask)) {
+        return false;
+    }
+    uint16_t ofs = LOG_HEADER_LEN;
+    for (uint8_t i=0; i<LOG_FORMAT_LEN && format[i] != 0; i++) {
+        uint8_t size = field_size(format[i]);
+        if (size == 0 || ofs + size > len) {
+            return false;
+        }
+        if (mask & (1UL << i)) {
+            if (is_integer(format[i])) {
+                uint64_t z;
+                if (!get_varint(in, in_len, n, z)) {
+                    return false;
+                }
+                uint64_t d = (z >> 1) ^ (~(z & 1) + 1);
+                put_uint(&pkt[ofs], size, get_uint(&pkt[ofs], size) + d);
+            } else if (is_float(format[i])) {
+                uint64_t x;
+                if (!get_varint(in, in_len, n, x) || (size < 8 && (x >> (8*size)) != 0)) {
+                    return false;
+                }
+                put_uint(&pkt[ofs], size, get_uint(&pkt[ofs], size) ^ x);
+            } else {
+                if (n + size > in_len) {
+                    return false;
+                }
+                memcpy(&pkt[ofs], &in[n], size);
+                n += size;
+            }
+        }
+        ofs += size;
+    }
+    return ofs == len && n == in_len;
+}
@@ -0,0 +1,67 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  compact encoding of log messages
+
+  A compact message is written as HEAD_BYTE1, HEAD_BYTE2_COMPACT, the
+  message type, the length of the encoded payload, then the payload.
+  The payload is encoded against the last message of the same type in
+  the log, using the field layout from its FMT message:
+
+    - a varint bitmask of the fields that changed, bit 0 being the
+      first field after the header
+    - for each changed field in order, integer fields (h, H, c, C, i,
+      I, e, E, L, q, Q) as a zigzag varint of the difference from the
+      last value, float fields (f, d) as a varint of their bits XORed
+      with the bits of the last value, and all other fields as they
+      are
+
+  So a reader needs only the FMT messages and the last message of each
+  type to decode a log. A message written in full resets the last
+  message of its type, so the writer sends each type in full from time
+  to time to allow a reader to resync.
+ */
+#ifndef __DATAFLASH_LOGCOMPACT_H__
+#define __DATAFLASH_LOGCOMPACT_H__
+
+#include <stdint.h>
+
+#define HEAD_BYTE2_COMPACT     0x96
+
+// longest encoded payload, as it has to fit the length byte
+#define LOG_COMPACT_MAX_PAYLOAD 255
+
+// write every Nth message of each type in full
+#define LOG_COMPACT_KEYFRAME   50
+
+class LogCompact
+{
+public:
+    /*
+      encode the message pkt of length len against prev, the last
+      message of the same type, into out, which must have room for
+      LOG_COMPACT_MAX_PAYLOAD bytes. format is the FMT format string,
+      which need not be null terminated at 16 characters. Returns the
+      payload length, or 0 if the message is better written in full
+     */
+    static uint8_t encode(const char *format, const uint8_t *prev,
+                          const uint8_t *pkt, uint16_t len, uint8_t *out);
+
+    /*
+      decode a payload of in_len bytes into pkt of length len, which
+      must start as a copy of the last message of the same type.
+      Returns false if the payload doesn't match the format
+     */
+    static bool decode(const char *format, const uint8_t *in, uint8_t in_len,
+                       uint8_t *pkt, uint16_t len);
+
+private:
+    static uint8_t field_size(char c);
+    static bool is_integer(char c);
+    static bool is_float(char c);
+    static uint64_t get_uint(const uint8_t *p, uint8_t size);
+    static void put_uint(uint8_t *p, uint8_t size, uint64_t v);
+    static uint8_t put_varint(uint8_t *out, uint8_t ofs, uint64_t v);
+    static bool get_varint(const uint8_t *in, uint8_t in_len, uint8_t &ofs, uint64_t &v);
+};
+
+#endif // __DATAFLASH_LOGCOMPACT_H__
@@ -17,6 +17,10 @@ void DataFlash_Class::Init(const struct LogStructure *structure, uint8_t num_typ
     _num_types = num_types;
     _structures = structure;
     _writes_enabled = true;
+    _compact = false;
+    _compact_last = NULL;
+    _compact_count = NULL;
+    _compact_index = NULL;
 }
 
 // This function determines the number of whole or partial log files in the DataFlash
@@ -422,6 +426,15 @@ void DataFlash_Class::_print_log_entry(uint8_t msg_type,
             ofs += 1;
             break;
         }
+        case 'a': {
+            int16_t v[32];
+            memcpy(&v, &pkt[ofs], sizeof(v));
+            for (uint8_t j=0; j<32; j++) {
+                port->printf_P(PSTR("%s%d"), j==0?"":" ", (int)v[j]);
+            }
+            ofs += sizeof(v);
+            break;
+        }
         default:
             ofs = msg_len;
             break;
@@ -487,6 +500,9 @@ void DataFlash_Block::LogReadProcess(uint16_t log_num,
                 if (data == HEAD_BYTE2) {
                     log_step++;
                 } else {
+                    if (data == HEAD_BYTE2_COMPACT) {
+                        _skip_compact_entry();
+                    }
                     log_step = 0;
                 }
                 break;
@@ -584,6 +600,11 @@ uint16_t DataFlash_Class::StartNewLog(void)
         // don't write out parameters if we fail to open the log
         return ret;
     }
+    // the first message of each type in the new log goes in full
+    if (_compact_count != NULL) {
+        memset(_compact_count, 0, _num_types);
+    }
+
     // write log formats so the log is self-describing
     for (uint8_t i=0; i<_num_types; i++) {
         Log_Write_Format(&_structures[i]);
@@ -596,6 +617,108 @@ uint16_t DataFlash_Class::StartNewLog(void)
     return ret;
 }
 
+/*
+  enable or disable the compact log encoding. Only messages of the
+  types given to Init() are encoded. The encoder state, including the
+  table from message type to structure, is allocated the first time
+  it is enabled, so boards that never enable it don't pay for it
+ */
+void DataFlash_Class::SetCompact(bool enable)
+{
+    if (enable && _compact_last == NULL) {
+        _compact_last = (uint8_t **)calloc(_num_types, sizeof(_compact_last[0]));
+        _compact_count = (uint8_t *)calloc(_num_types, 1);
+        _compact_index = (uint8_t *)malloc(256);
+        if (_compact_last == NULL || _compact_count == NULL || _compact_index == NULL) {
+            free(_compact_last);
+            free(_compact_count);
+            free(_compact_index);
+            _compact_last = NULL;
+            _compact_count = NULL;
+            _compact_index = NULL;
+            return;
+        }
+        memset(_compact_index, 0xFF, 256);
+        for (uint8_t i=0; i<_num_types; i++) {
+            _compact_index[PGM_UINT8(&_structures[i].msg_type)] = i;
+        }
+    }
+    if (enable && !_compact) {
+        // we may have written messages in full in the meantime
+        memset(_compact_count, 0, _num_types);
+    }
+    _compact = enable;
+}
+
+/*
+  write a block of data, using the compact encoding for whole log
+  messages
+ */
+void DataFlash_Class::_write_compact(const void *pBuffer, uint16_t size)
+{
+    const uint8_t *pkt = (const uint8_t *)pBuffer;
+    if (size <= sizeof(struct log_Header) ||
+        pkt[0] != HEAD_BYTE1 || pkt[1] != HEAD_BYTE2 || pkt[2] == LOG_FORMAT_MSG) {
+        WriteRawBlock(pBuffer, size);
+        return;
+    }
+
+    uint8_t i = _compact_index[pkt[2]];
+    if (i == 0xFF || size != PGM_UINT8(&_structures[i].msg_len)) {
+        WriteRawBlock(pBuffer, size);
+        return;
+    }
+    if (_compact_last[i] == NULL) {
+        _compact_last[i] = (uint8_t *)malloc(size);
+        if (_compact_last[i] == NULL) {
+            WriteRawBlock(pBuffer, size);
+            return;
+        }
+    }
+
+    uint8_t buf[4+LOG_COMPACT_MAX_PAYLOAD];
+    uint8_t n = 0;
+    if (_compact_count[i] != 0) {
+        char format[17];
+        for (uint8_t j=0; j<16; j++) {
+            format[j] = PGM_UINT8(&_structures[i].format[j]);
+        }
+        format[16] = 0;
+        n = LogCompact::encode(format, _compact_last[i], pkt, size, &buf[4]);
+    }
+
+    bool written;
+    if (n == 0) {
+        written = WriteRawBlock(pBuffer, size);
+    } else {
+        buf[0] = HEAD_BYTE1;
+        buf[1] = HEAD_BYTE2_COMPACT;
+        buf[2] = pkt[2];
+        buf[3] = n;
+        written = WriteRawBlock(buf, n+4);
+    }
+
+    // the next message is encoded against the last one that made it
+    // into the log
+    if (written) {
+        memcpy(_compact_last[i], pkt, size);
+        _compact_count[i] = (_compact_count[i] + 1) % LOG_COMPACT_KEYFRAME;
+    }
+}
+
+/*
+  skip over a compact log entry when printing a log
+ */
+void DataFlash_Class::_skip_compact_entry(void)
+{
+    uint8_t hdr[2];
+    if (!ReadBlock(hdr, sizeof(hdr))) {
+        return;
+    }
+    uint8_t payload[LOG_COMPACT_MAX_PAYLOAD];
+    ReadBlock(payload, hdr[1]);
+}
+
 // add new logging formats to the log. Used by libraries that want to
 // add their own log messages
 void DataFlash_Class::AddLogFormats(const struct LogStructure *structures, uint8_t num_types)
@@ -0,0 +1,228 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Tests for the compact log encoding. Encodes a stream of synthetic
+// messages for some common formats the way DataFlash_Class does,
+// decodes it the way a log reader does, and checks the decoded
+// messages match the originals. Also checks the compact stream is at
+// least a given ratio smaller than the messages written in full
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <LogCompact.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_RangeFinder.h>
+#include <AP_OpticalFlow.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_MESSAGES 2000
+
+static const struct {
+    const char *name;
+    const char *format;
+    uint32_t interval_us;
+    float min_ratio;
+} formats[] = {
+    { "RCOU", "Qhhhhhhhhhhhh", 10000,  1.6f },
+    { "GPS",  "QBIHBcLLeeEef", 200000, 1.7f },
+    { "EKF1", "QccCffffffccc", 100000, 1.3f },
+    { "EKF3", "Qcccccchhhc",   100000, 1.6f },
+    { "IMU",  "QffffffIIfBB",  20000,  1.3f },
+};
+
+static uint32_t seed = 1;
+
+static int32_t random_offset(int32_t range)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (int32_t)((seed >> 8) % (2*(uint32_t)range+1)) - range;
+}
+
+static uint8_t field_size(char c)
+{
+    switch (c) {
+    case 'b': case 'B': case 'M':
+        return 1;
+    case 'h': case 'H': case 'c': case 'C':
+        return 2;
+    case 'q': case 'Q': case 'd':
+        return 8;
+    }
+    return 4;
+}
+
+/*
+  fill in message k of a format. Integer fields wander slowly and
+  some hold still for a while, floats are noisy on every sample, as
+  they are in real logs
+ */
+static uint16_t make_message(uint8_t msg_type, const char *format, uint32_t interval_us,
+                             uint16_t k, uint8_t *pkt)
+{
+    pkt[0] = HEAD_BYTE1;
+    pkt[1] = HEAD_BYTE2;
+    pkt[2] = msg_type;
+    uint16_t ofs = 3;
+    for (uint8_t j=0; format[j] != 0; j++) {
+        float wave = sinf(k * 0.01f * (j+1));
+        switch (format[j]) {
+        case 'Q': {
+            uint64_t v = 1000000ULL + (uint64_t)k * interval_us + random_offset(20);
+            memcpy(&pkt[ofs], &v, 8);
+            break;
+        }
+        case 'B': {
+            uint8_t v = (k / 300) + j;
+            pkt[ofs] = v;
+            break;
+        }
+        case 'h':
+        case 'c': {
+            int16_t v = 1500 + (int16_t)(200 * wave) + ((k/4) % 3 == 0 ? random_offset(2) : 0);
+            memcpy(&pkt[ofs], &v, 2);
+            break;
+        }
+        case 'H':
+        case 'C': {
+            uint16_t v = 1800 + (k / 25);
+            memcpy(&pkt[ofs], &v, 2);
+            break;
+        }
+        case 'I':
+        case 'E': {
+            uint32_t v = 300000 + k * (interval_us / 1000);
+            memcpy(&pkt[ofs], &v, 4);
+            break;
+        }
+        case 'L':
+        case 'e':
+        case 'i': {
+            int32_t v = -353632620L + (int32_t)(5000 * wave) + random_offset(3);
+            memcpy(&pkt[ofs], &v, 4);
+            break;
+        }
+        default: {
+            float v = 0.5f * wave + random_offset(1000) * 1.0e-5f;
+            memcpy(&pkt[ofs], &v, 4);
+            break;
+        }
+        }
+        ofs += field_size(format[j]);
+    }
+    return ofs;
+}
+
+/*
+  encode and decode NUM_MESSAGES of one format, returning false on
+  any mismatch or if the compact stream is not at least min_ratio
+  smaller
+ */
+static bool round_trip(uint8_t msg_type, const char *name, const char *format, uint32_t interval_us,
+                       float min_ratio)
+{
+    uint8_t pkt[256];
+    uint8_t enc_last[256];
+    uint8_t dec_last[256];
+    uint8_t payload[LOG_COMPACT_MAX_PAYLOAD];
+    uint32_t full_bytes = 0;
+    uint32_t compact_bytes = 0;
+    uint16_t mismatches = 0;
+
+    for (uint16_t k=0; k<NUM_MESSAGES; k++) {
+        uint16_t len = make_message(msg_type, format, interval_us, k, pkt);
+        full_bytes += len;
+
+        // the writer sends every LOG_COMPACT_KEYFRAME'th message in full
+        uint8_t n = 0;
+        if (k % LOG_COMPACT_KEYFRAME != 0) {
+            n = LogCompact::encode(format, enc_last, pkt, len, payload);
+        }
+        memcpy(enc_last, pkt, len);
+
+        if (n == 0) {
+            compact_bytes += len;
+            memcpy(dec_last, pkt, len);
+        } else {
+            compact_bytes += n + 4;
+            if (!LogCompact::decode(format, payload, n, dec_last, len)) {
+                mismatches++;
+                memcpy(dec_last, pkt, len);
+                continue;
+            }
+        }
+        if (memcmp(dec_last, pkt, len) != 0) {
+            mismatches++;
+            memcpy(dec_last, pkt, len);
+        }
+    }
+
+    float ratio = full_bytes / (float)compact_bytes;
+    hal.console->printf("%-5s %6lu -> %6lu bytes  ratio %.2f (min %.2f)  mismatches %u\n",
+                        name,
+                        (unsigned long)full_bytes,
+                        (unsigned long)compact_bytes,
+                        ratio,
+                        min_ratio,
+                        (unsigned)mismatches);
+    return mismatches == 0 && ratio >= min_ratio;
+}
+
+void setup(void)
+{
+    bool all_passed = true;
+
+    hal.console->println("LogCompact tests\n");
+
+    for (uint8_t i=0; i<sizeof(formats)/sizeof(formats[0]); i++) {
+        if (!round_trip(i+1, formats[i].name, formats[i].format, formats[i].interval_us,
+                        formats[i].min_ratio)) {
+            all_passed = false;
+        }
+    }
+
+    // a payload cut short must be rejected
+    uint8_t pkt[256], last[256], payload[LOG_COMPACT_MAX_PAYLOAD];
+    uint16_t len = make_message(1, formats[0].format, formats[0].interval_us, 0, last);
+    make_message(1, formats[0].format, formats[0].interval_us, 1, pkt);
+    uint8_t n = LogCompact::encode(formats[0].format, last, pkt, len, payload);
+    if (n < 2 || LogCompact::decode(formats[0].format, payload, n-1, last, len)) {
+        hal.console->println("short payload accepted");
+        all_passed = false;
+    }
+
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void) {}
+
+AP_HAL_MAIN();
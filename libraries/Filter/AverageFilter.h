@@ -17,6 +17,8 @@
 //
 /// @file	AverageFilter.h
 /// @brief	A class to provide the average of a number of samples
+///         A running sum of the samples is kept, so each apply() is a
+///         subtraction and an addition rather than a sum over the buffer
 
 #ifndef __AVERAGE_FILTER_H__
 #define __AVERAGE_FILTER_H__
@@ -32,7 +34,7 @@ class AverageFilter : public FilterWithBuffer<T,FILTER_SIZE>
 {
 public:
     // constructor
-    AverageFilter() : FilterWithBuffer<T,FILTER_SIZE>(), _num_samples(0) {
+    AverageFilter() : FilterWithBuffer<T,FILTER_SIZE>(), _num_samples(0), _sum(0) {
     };
 
     // apply - Add a new raw value to the filter, retrieve the filtered result
@@ -43,6 +45,7 @@ public:
 
 private:
     uint8_t        _num_samples; // the number of samples in the filter, maxes out at size of the filter
+    U              _sum;         // sum of the samples in the buffer
 };
 
 // Typedef for convenience (1st argument is the data type, 2nd is a larger datatype to handle overflows, 3rd is buffer size)
@@ -80,7 +83,10 @@ typedef AverageFilter<float,float,5> AverageFilterFloat_Size5;
 template <class T, class U, uint8_t FILTER_SIZE>
 T AverageFilter<T,U,FILTER_SIZE>::        apply(T sample)
 {
-    U        result = 0;
+    // take the sample about to be overwritten out of the sum. Unused
+    // slots are zero, so this is right while the buffer is filling
+    _sum -= FilterWithBuffer<T,FILTER_SIZE>::samples[FilterWithBuffer<T,FILTER_SIZE>::sample_index];
+    _sum += sample;
 
     // call parent's apply function to get the sample into the array
     FilterWithBuffer<T,FILTER_SIZE>::apply(sample);
@@ -90,11 +96,16 @@ T AverageFilter<T,U,FILTER_SIZE>::        apply(T sample)
     if( _num_samples > FILTER_SIZE || _num_samples == 0 )
         _num_samples = FILTER_SIZE;
 
-    // get sum of all values - there is a risk of overflow here that we ignore
-    for(uint8_t i=0; i<FILTER_SIZE; i++)
-        result += FilterWithBuffer<T,FILTER_SIZE>::samples[i];
+    // each time round the buffer redo the sum, so rounding errors in a
+    // float sum can't build up - there is a risk of overflow here that
+    // we ignore
+    if( FilterWithBuffer<T,FILTER_SIZE>::sample_index == 0 ) {
+        _sum = 0;
+        for(uint8_t i=0; i<FILTER_SIZE; i++)
+            _sum += FilterWithBuffer<T,FILTER_SIZE>::samples[i];
+    }
 
-    return (T)(result / _num_samples);
+    return (T)(_sum / _num_samples);
 }
 
 // reset - clear all samples
@@ -104,8 +115,9 @@ void AverageFilter<T,U,FILTER_SIZE>::        reset()
     // call parent's apply function to get the sample into the array
     FilterWithBuffer<T,FILTER_SIZE>::reset();
 
-    // clear our variable
+    // clear our variables
     _num_samples = 0;
+    _sum = 0;
 }
 
 #endif // __AVERAGE_FILTER_H__
@@ -16,7 +16,8 @@
 
 //
 /// @file	FilterClass.h
-/// @brief	A pure virtual interface class
+/// @brief	A pure virtual interface class, and a base for filters
+///         with an inlineable apply()
 ///
 
 #ifndef __FILTER_CLASS_H__
@@ -36,6 +37,32 @@ public:
 
 };
 
+/*
+  base class for filters with a non-virtual apply(). The derived class
+  is passed as a template parameter (so MyFilter derives from
+  InlineFilter<T, MyFilter>), which lets apply() be inlined into the
+  loop in apply_block(), and into callers that hold the filter by
+  value.
+
+  Derived classes provide:
+    T apply(T sample);
+    void reset();
+ */
+template <class T, class Derived>
+class InlineFilter
+{
+public:
+    // apply_block - filter an array of samples in place, such as a
+    // burst read from a sensor FIFO. Returns the last filtered sample
+    T apply_block(T *samples, uint16_t count) {
+        Derived &filter = static_cast<Derived &>(*this);
+        for (uint16_t i=0; i<count; i++) {
+            samples[i] = filter.apply(samples[i]);
+        }
+        return count > 0 ? samples[count-1] : T();
+    }
+};
+
 // Typedef for convenience
 typedef Filter<int8_t> FilterInt8;
 typedef Filter<uint8_t> FilterUInt8;
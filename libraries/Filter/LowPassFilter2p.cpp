@@ -41,6 +41,72 @@ float DigitalBiquadFilter::apply(float sample, const struct biquad_params &param
     return output;
 }
 
+Vector3f DigitalBiquadFilterVector3f::apply(const Vector3f &sample, const struct DigitalBiquadFilter::biquad_params &params)
+{
+    if(is_zero(params.cutoff_freq) || is_zero(params.sample_freq)) {
+        return sample;
+    }
+
+    Vector3f delay_element_0 = sample - _delay_element_1 * params.a1 - _delay_element_2 * params.a2;
+    if (delay_element_0.is_nan() || delay_element_0.is_inf()) {
+        delay_element_0 = sample;
+    }
+    Vector3f output = delay_element_0 * params.b0 + _delay_element_1 * params.b1 + _delay_element_2 * params.b2;
+
+    _delay_element_2 = _delay_element_1;
+    _delay_element_1 = delay_element_0;
+
+    return output;
+}
+
+void DigitalBiquadFilter::apply_block(float *samples, uint16_t count, const struct biquad_params &params)
+{
+    if(is_zero(params.cutoff_freq) || is_zero(params.sample_freq)) {
+        return;
+    }
+
+    float d1 = _delay_element_1;
+    float d2 = _delay_element_2;
+
+    for (uint16_t i=0; i<count; i++) {
+        float sample = samples[i];
+        float delay_element_0 = sample - d1 * params.a1 - d2 * params.a2;
+        if (isnan(delay_element_0) || isinf(delay_element_0)) {
+            delay_element_0 = sample;
+        }
+        samples[i] = delay_element_0 * params.b0 + d1 * params.b1 + d2 * params.b2;
+        d2 = d1;
+        d1 = delay_element_0;
+    }
+
+    _delay_element_1 = d1;
+    _delay_element_2 = d2;
+}
+
+void DigitalBiquadFilterVector3f::apply_block(Vector3f *samples, uint16_t count, const struct DigitalBiquadFilter::biquad_params &params)
+{
+    if(is_zero(params.cutoff_freq) || is_zero(params.sample_freq)) {
+        return;
+    }
+
+    Vector3f d1 = _delay_element_1;
+    Vector3f d2 = _delay_element_2;
+
+    for (uint16_t i=0; i<count; i++) {
+        const Vector3f sample = samples[i];
+        Vector3f delay_element_0 = sample - d1 * params.a1 - d2 * params.a2;
+        if (delay_element_0.is_nan() || delay_element_0.is_inf()) {
+            delay_element_0 = sample;
+        }
+        samples[i] = delay_element_0 * params.b0 + d1 * params.b1 + d2 * params.b2;
+        d2 = d1;
+        d1 = delay_element_0;
+    }
+
+    _delay_element_1 = d1;
+    _delay_element_2 = d2;
+}
+
 void DigitalBiquadFilter::compute_params(float sample_freq, float cutoff_freq, biquad_params &ret)
 {
     ret.cutoff_freq = cutoff_freq;
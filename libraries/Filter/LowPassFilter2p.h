@@ -41,6 +41,10 @@ public:
 
     float apply(float sample, const struct biquad_params &params);
 
+    // filter an array of samples in place, with the coefficients
+    // checked once and the state kept in registers for the block
+    void apply_block(float *samples, uint16_t count, const struct biquad_params &params);
+
     void reset() { _delay_element_1 = _delay_element_2 = 0.0f; }
 
     static void compute_params(float sample_freq, float cutoff_freq, biquad_params &ret);
@@ -50,6 +54,25 @@ private:
     float _delay_element_2;
 };
 
+/*
+  a biquad filtering the three axes of a vector with one set of
+  coefficients. Doing the axes together lets the compiler vectorise
+  the arithmetic, and the coefficients are only checked once
+ */
+class DigitalBiquadFilterVector3f
+{
+public:
+    Vector3f apply(const Vector3f &sample, const struct DigitalBiquadFilter::biquad_params &params);
+
+    void apply_block(Vector3f *samples, uint16_t count, const struct DigitalBiquadFilter::biquad_params &params);
+
+    void reset() { _delay_element_1.zero(); _delay_element_2.zero(); }
+
+private:
+    Vector3f _delay_element_1;
+    Vector3f _delay_element_2;
+};
+
 class LowPassFilter2p
 {
 public:
@@ -90,6 +113,12 @@ public:
     float apply(float sample) {
         return _filter.apply(sample, _params);
     }
+
+    // filter a block of samples in place, returning the last one
+    float apply_block(float *samples, uint16_t count) {
+        _filter.apply_block(samples, count, _params);
+        return count > 0 ? samples[count-1] : 0.0f;
+    }
 private:
     DigitalBiquadFilter _filter;
 };
@@ -104,17 +133,18 @@ public:
     LowPassFilter2p(sample_freq,cutoff_freq) {}
 
     Vector3f apply(const Vector3f &sample) {
-        Vector3f ret;
-        ret.x = _filter_x.apply(sample.x, _params);
-        ret.y = _filter_y.apply(sample.y, _params);
-        ret.z = _filter_z.apply(sample.z, _params);
-        return ret;
+        return _filter.apply(sample, _params);
+    }
+
+    // filter a block of samples in place, such as a burst read from a
+    // sensor FIFO, returning the last one
+    Vector3f apply_block(Vector3f *samples, uint16_t count) {
+        _filter.apply_block(samples, count, _params);
+        return count > 0 ? samples[count-1] : Vector3f();
     }
 
 private:
-    DigitalBiquadFilter _filter_x;
-    DigitalBiquadFilter _filter_y;
-    DigitalBiquadFilter _filter_z;
+    DigitalBiquadFilterVector3f _filter;
 };
 
 
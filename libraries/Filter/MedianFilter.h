@@ -0,0 +1,220 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//
+/// @file	MedianFilter.h
+/// @brief	A running median of the last FILTER_SIZE samples
+///
+/// The samples are kept in a max-heap of the samples below the median
+/// and a min-heap of the samples above it, sharing one array with the
+/// median in the middle. A new sample replaces the oldest one in
+/// place and is sifted through the heaps, so each apply() costs
+/// O(log FILTER_SIZE) comparisons rather than a sort of the window.
+///
+/// Unlike ModeFilter, which drops the highest and lowest samples in
+/// turn, this is the exact median of the window. FILTER_SIZE should be
+/// odd. While the window is filling and holds an even number of
+/// samples the upper of the two middle samples is returned.
+
+#ifndef __MEDIAN_FILTER_H__
+#define __MEDIAN_FILTER_H__
+
+#include <inttypes.h>
+#include "FilterClass.h"
+
+template <class T, uint8_t FILTER_SIZE>
+class MedianFilter : public InlineFilter<T, MedianFilter<T,FILTER_SIZE> >
+{
+public:
+    MedianFilter() {
+        reset();
+    }
+
+    // apply - Add a new raw value to the filter, retrieve the filtered result
+    T apply(T sample);
+
+    // reset - clear the filter
+    void reset();
+
+    // get filter size
+    uint8_t get_filter_size() const {
+        return FILTER_SIZE;
+    }
+
+private:
+    // the samples, in the order they arrived
+    T               _samples[FILTER_SIZE];
+
+    // heap position of each sample
+    int16_t         _pos[FILTER_SIZE];
+
+    // sample index at each heap position. Position 0 is the median,
+    // negative positions are the max-heap and positive the min-heap
+    uint8_t         _heap[FILTER_SIZE];
+
+    // next sample to replace, and number of samples so far
+    uint8_t         _index;
+    uint8_t         _count;
+
+    uint8_t &heap(int16_t i) { return _heap[i + FILTER_SIZE/2]; }
+    uint8_t min_count() const { return (_count - 1) / 2; }
+    uint8_t max_count() const { return _count / 2; }
+
+    bool less(int16_t i, int16_t j) { return _samples[heap(i)] < _samples[heap(j)]; }
+    bool compare_exchange(int16_t i, int16_t j);
+    void min_sort_down(int16_t i);
+    void max_sort_down(int16_t i);
+    bool min_sort_up(int16_t i);
+    bool max_sort_up(int16_t i);
+};
+
+// Typedef for convenience
+typedef MedianFilter<int16_t,3> MedianFilterInt16_Size3;
+typedef MedianFilter<int16_t,5> MedianFilterInt16_Size5;
+typedef MedianFilter<int16_t,7> MedianFilterInt16_Size7;
+typedef MedianFilter<uint16_t,3> MedianFilterUInt16_Size3;
+typedef MedianFilter<uint16_t,5> MedianFilterUInt16_Size5;
+typedef MedianFilter<uint16_t,7> MedianFilterUInt16_Size7;
+typedef MedianFilter<float,5> MedianFilterFloat_Size5;
+typedef MedianFilter<float,7> MedianFilterFloat_Size7;
+
+// Public Methods //////////////////////////////////////////////////////////////
+
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::reset()
+{
+    // lay the sample slots out so that as the window fills the new
+    // sample goes alternately below and above the median
+    for (uint8_t i=0; i<FILTER_SIZE; i++) {
+        _pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+        heap(_pos[i]) = i;
+        _samples[i] = 0;
+    }
+    _index = 0;
+    _count = 0;
+}
+
+template <class T, uint8_t FILTER_SIZE>
+T MedianFilter<T,FILTER_SIZE>::apply(T sample)
+{
+    bool is_new = _count < FILTER_SIZE;
+    int16_t p = _pos[_index];
+    T old = _samples[_index];
+
+    _samples[_index] = sample;
+    if (++_index >= FILTER_SIZE) {
+        _index = 0;
+    }
+    if (is_new) {
+        _count++;
+    }
+
+    if (p > 0) {
+        // sample is in the min-heap
+        if (!is_new && old < sample) {
+            min_sort_down(p*2);
+        } else if (min_sort_up(p)) {
+            max_sort_down(-1);
+        }
+    } else if (p < 0) {
+        // sample is in the max-heap
+        if (!is_new && sample < old) {
+            max_sort_down(p*2);
+        } else if (max_sort_up(p)) {
+            min_sort_down(1);
+        }
+    } else {
+        // sample replaced the median
+        if (max_count() > 0) {
+            max_sort_down(-1);
+        }
+        if (min_count() > 0) {
+            min_sort_down(1);
+        }
+    }
+
+    return _samples[heap(0)];
+}
+
+// Private Methods /////////////////////////////////////////////////////////////
+
+// swap heap positions i and j if sample at i is less than sample at
+// j, returning true if they were swapped
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::compare_exchange(int16_t i, int16_t j)
+{
+    if (!less(i, j)) {
+        return false;
+    }
+    uint8_t t = heap(i);
+    heap(i) = heap(j);
+    heap(j) = t;
+    _pos[heap(i)] = i;
+    _pos[heap(j)] = j;
+    return true;
+}
+
+// move the sample at position i/2 down the min-heap
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::min_sort_down(int16_t i)
+{
+    for (; i <= min_count(); i *= 2) {
+        if (i > 1 && i < min_count() && less(i+1, i)) {
+            i++;
+        }
+        if (!compare_exchange(i, i/2)) {
+            break;
+        }
+    }
+}
+
+// move the sample at position i/2 down the max-heap
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::max_sort_down(int16_t i)
+{
+    for (; i >= -max_count(); i *= 2) {
+        if (i < -1 && i > -max_count() && less(i, i-1)) {
+            i--;
+        }
+        if (!compare_exchange(i/2, i)) {
+            break;
+        }
+    }
+}
+
+// move the sample at position i up the min-heap, returning true if it
+// reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::min_sort_up(int16_t i)
+{
+    while (i > 0 && compare_exchange(i, i/2)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+// move the sample at position i up the max-heap, returning true if it
+// reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::max_sort_up(int16_t i)
+{
+    while (i < 0 && compare_exchange(i/2, i)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+#endif // __MEDIAN_FILTER_H__
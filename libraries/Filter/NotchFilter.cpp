@@ -0,0 +1,110 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include <AP_Math.h>
+#include "NotchFilter.h"
+
+/*
+  the standard biquad notch, from the Audio EQ Cookbook, with the
+  depth set by A. The gain at the centre is A squared
+ */
+void NotchFilter::compute_params(float sample_freq, float center_freq,
+                                 float bandwidth_hz, float attenuation_db,
+                                 DigitalBiquadFilter::biquad_params &ret)
+{
+    if (center_freq <= 0 || sample_freq <= 0 || center_freq >= 0.5f*sample_freq) {
+        // a zero cutoff makes the biquad pass samples straight through
+        memset(&ret, 0, sizeof(ret));
+        return;
+    }
+
+    ret.cutoff_freq = center_freq;
+    ret.sample_freq = sample_freq;
+
+    // a notch wider than its centre frequency would reach below zero
+    bandwidth_hz = constrain_float(bandwidth_hz, 1.0f, center_freq);
+
+    float octaves = logf(center_freq / (center_freq - bandwidth_hz*0.5f)) * 2.0f / logf(2.0f);
+    float Q = sqrtf(powf(2.0f, octaves)) / (powf(2.0f, octaves) - 1.0f);
+    float A = powf(10.0f, -attenuation_db / 40.0f);
+
+    float omega = 2.0f * PI * center_freq / sample_freq;
+    float alpha = sinf(omega) / (2.0f * Q);
+    float a0 = 1.0f + alpha;
+
+    ret.b0 = (1.0f + alpha*A*A) / a0;
+    ret.b1 = -2.0f * cosf(omega) / a0;
+    ret.b2 = (1.0f - alpha*A*A) / a0;
+    ret.a1 = ret.b1;
+    ret.a2 = (1.0f - alpha) / a0;
+}
+
+HarmonicNotchFilterVector3f::HarmonicNotchFilterVector3f() :
+    _set_idx(0),
+    _center_freq(0)
+{
+    memset(_sets, 0, sizeof(_sets));
+}
+
+void HarmonicNotchFilterVector3f::update(float sample_freq, float center_freq, float bandwidth_hz,
+                                         float attenuation_db, uint8_t harmonics)
+{
+    struct notch_set &set = _sets[_set_idx ^ 1];
+
+    set.num_notches = 0;
+    if (center_freq <= 0) {
+        harmonics = 0;
+    }
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        if (!(harmonics & (1U<<i))) {
+            continue;
+        }
+        float freq = center_freq * (i+1);
+        // keep clear of the Nyquist frequency, where the notch
+        // coefficients become badly conditioned
+        if (freq > 0.4f * sample_freq) {
+            break;
+        }
+        // the bandwidth scales with the harmonic so each notch
+        // covers the same spread of motor speeds
+        NotchFilter::compute_params(sample_freq, freq, bandwidth_hz*(i+1), attenuation_db,
+                                    set.params[set.num_notches]);
+        set.num_notches++;
+    }
+
+    _set_idx ^= 1;
+    _center_freq = set.num_notches > 0 ? center_freq : 0;
+}
+
+Vector3f HarmonicNotchFilterVector3f::apply(const Vector3f &sample)
+{
+    const struct notch_set &set = _sets[_set_idx];
+    Vector3f ret = sample;
+    for (uint8_t i=0; i<set.num_notches; i++) {
+        ret = _filters[i].apply(ret, set.params[i]);
+    }
+    return ret;
+}
+
+void HarmonicNotchFilterVector3f::reset()
+{
+    for (uint8_t i=0; i<HNF_MAX_HARMONICS; i++) {
+        _filters[i].reset();
+    }
+}
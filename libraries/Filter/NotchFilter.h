@@ -0,0 +1,105 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NOTCHFILTER_H
+#define NOTCHFILTER_H
+
+/// @file   NotchFilter.h
+/// @brief  Biquad notch filters, including a set of notches on the
+///         harmonics of a frequency that can move while it runs
+
+#include "LowPassFilter2p.h"
+
+// most harmonics a HarmonicNotchFilterVector3f can notch
+#define HNF_MAX_HARMONICS 3
+
+class NotchFilter
+{
+public:
+    // calculate the coefficients of a notch at center_freq. The
+    // bandwidth is the width of the notch in Hz and the attenuation
+    // the depth at its centre in dB
+    static void compute_params(float sample_freq, float center_freq,
+                               float bandwidth_hz, float attenuation_db,
+                               DigitalBiquadFilter::biquad_params &ret);
+};
+
+class NotchFilterVector3f
+{
+public:
+    NotchFilterVector3f() { memset(&_params, 0, sizeof(_params)); }
+
+    void set_params(float sample_freq, float center_freq, float bandwidth_hz, float attenuation_db) {
+        NotchFilter::compute_params(sample_freq, center_freq, bandwidth_hz, attenuation_db, _params);
+    }
+
+    float get_center_freq(void) const {
+        return _params.cutoff_freq;
+    }
+
+    Vector3f apply(const Vector3f &sample) {
+        return _filter.apply(sample, _params);
+    }
+
+    void reset() { _filter.reset(); }
+
+private:
+    struct DigitalBiquadFilter::biquad_params _params;
+    DigitalBiquadFilterVector3f _filter;
+};
+
+/*
+  notches on a frequency and its harmonics, for vibration from motors
+  and props whose speed varies in flight.
+
+  update() may be called from a different thread to apply(), so there
+  are two sets of coefficients. update() fills in the one apply() is
+  not using and then switches apply() over to it
+ */
+class HarmonicNotchFilterVector3f
+{
+public:
+    HarmonicNotchFilterVector3f();
+
+    // move the notches to a new fundamental frequency. harmonics is
+    // a bitmask with bit 0 the fundamental, bit 1 the second harmonic
+    // and so on. Harmonics too close to the Nyquist frequency are
+    // left out
+    void update(float sample_freq, float center_freq, float bandwidth_hz,
+                float attenuation_db, uint8_t harmonics);
+
+    Vector3f apply(const Vector3f &sample);
+
+    void reset();
+
+    // the fundamental frequency, or zero if there are no notches
+    float get_center_freq(void) const { return _center_freq; }
+
+private:
+    struct notch_set {
+        struct DigitalBiquadFilter::biquad_params params[HNF_MAX_HARMONICS];
+        uint8_t num_notches;
+    };
+
+    struct notch_set _sets[2];
+    volatile uint8_t _set_idx;
+    float _center_freq;
+
+    DigitalBiquadFilterVector3f _filters[HNF_MAX_HARMONICS];
+};
+
+#endif // NOTCHFILTER_H
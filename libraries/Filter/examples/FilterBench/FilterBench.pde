@@ -0,0 +1,136 @@
+/*
+ *       Benchmark of the Filter library. Times each filter per sample,
+ *       and checks MedianFilter against a sort of the same window
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_FLYMAPLE.h>
+#include <AP_HAL_Empty.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>            // ArduPilot Mega Vector/Matrix math Library
+#include <Filter.h>                     // Filter library
+#include <LowPassFilter2p.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_SAMPLES 256
+#define BLOCK_SIZE  16
+#define WINDOW      31
+
+static float samples[NUM_SAMPLES];
+static int16_t samples_int16[NUM_SAMPLES];
+static Vector3f samples_vec[NUM_SAMPLES];
+
+static ModeFilterInt16_Size5 mode_filter5(2);
+static MedianFilterInt16_Size5 median_filter5;
+static ModeFilter<float,WINDOW> mode_filter(WINDOW/2);
+static MedianFilter<float,WINDOW> median_filter;
+static AverageFilter<float,float,WINDOW> average_filter;
+static LowPassFilter2pVector3f lpf_sample(1000, 80);
+static LowPassFilter2pVector3f lpf_block(1000, 80);
+
+// fill the sample arrays with noisy data with some spikes
+static void make_samples(void)
+{
+    uint32_t seed = 1;
+    for (uint16_t i=0; i<NUM_SAMPLES; i++) {
+        seed = seed * 1103515245 + 12345;
+        float v = 100.0f * sinf(i * 0.05f) + ((seed >> 16) % 200) * 0.1f;
+        if (i % 17 == 0) {
+            v += 5000.0f;
+        }
+        samples[i] = v;
+        samples_int16[i] = (int16_t)v;
+        samples_vec[i] = Vector3f(v, -v, v*0.5f);
+    }
+}
+
+// median of the last n samples up to and including index i, by sorting
+static float sorted_median(uint16_t i, uint8_t n)
+{
+    float window[WINDOW];
+    uint8_t count = (i + 1 < n) ? i + 1 : n;
+    for (uint8_t j=0; j<count; j++) {
+        window[j] = samples[i - j];
+    }
+    for (uint8_t j=1; j<count; j++) {
+        float v = window[j];
+        int8_t k = j - 1;
+        while (k >= 0 && window[k] > v) {
+            window[k+1] = window[k];
+            k--;
+        }
+        window[k+1] = v;
+    }
+    return window[count/2];
+}
+
+static void check_median(void)
+{
+    uint16_t errors = 0;
+    median_filter.reset();
+    for (uint16_t i=0; i<NUM_SAMPLES; i++) {
+        float v = median_filter.apply(samples[i]);
+        if (v != sorted_median(i, WINDOW)) {
+            errors++;
+        }
+    }
+    hal.console->printf("MedianFilter check: %u errors in %u samples\n",
+                        (unsigned)errors, (unsigned)NUM_SAMPLES);
+}
+
+#define TIME_FILTER(name, code)                                         \
+    do {                                                                \
+        uint32_t t0 = hal.scheduler->micros();                          \
+        for (uint16_t i=0; i<NUM_SAMPLES; i++) { code; }                \
+        uint32_t t1 = hal.scheduler->micros();                          \
+        hal.console->printf("%-28s %8.3f usec/sample\n", name,          \
+                            (double)((t1 - t0) / (float)NUM_SAMPLES));  \
+    } while (0)
+
+void setup()
+{
+    hal.console->printf("Filter library benchmark\n\n");
+    hal.scheduler->delay(500);
+    make_samples();
+}
+
+void loop()
+{
+    volatile float fsink;
+    volatile int16_t isink;
+
+    check_median();
+
+    TIME_FILTER("ModeFilterInt16_Size5", isink = mode_filter5.apply(samples_int16[i]));
+    TIME_FILTER("MedianFilterInt16_Size5", isink = median_filter5.apply(samples_int16[i]));
+    TIME_FILTER("ModeFilter<float,31>", fsink = mode_filter.apply(samples[i]));
+    TIME_FILTER("MedianFilter<float,31>", fsink = median_filter.apply(samples[i]));
+    TIME_FILTER("AverageFilter<float,31>", fsink = average_filter.apply(samples[i]));
+    TIME_FILTER("LowPassFilter2pVector3f", fsink = lpf_sample.apply(samples_vec[i]).x);
+
+    // the same filter over the same data, a FIFO burst at a time
+    static Vector3f block[BLOCK_SIZE];
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<NUM_SAMPLES; i += BLOCK_SIZE) {
+        memcpy(block, &samples_vec[i], sizeof(block));
+        fsink = lpf_block.apply_block(block, BLOCK_SIZE).x;
+    }
+    uint32_t t1 = hal.scheduler->micros();
+    hal.console->printf("%-28s %8.3f usec/sample\n", "LowPassFilter2pVector3f block",
+                        (double)((t1 - t0) / (float)NUM_SAMPLES));
+
+    (void)fsink;
+    (void)isink;
+    hal.console->printf("\n");
+    hal.scheduler->delay(2000);
+}
+
+AP_HAL_MAIN();
@@ -0,0 +1,62 @@
+/*
+ *       Example sketch to demonstrate use of the harmonic notch filter.
+ *       Prints the gain of the filter across a sweep of frequencies
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_FLYMAPLE.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>            // ArduPilot Mega Vector/Matrix math Library
+#include <Filter.h>                     // Filter library
+#include <NotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define SAMPLE_FREQ 1000
+
+// notches on 80Hz and 160Hz
+static HarmonicNotchFilterVector3f notch;
+
+// setup routine
+static void setup()
+{
+    // introduction
+    hal.console->printf("ArduPilot NotchFilter test\n\n");
+    notch.update(SAMPLE_FREQ, 80, 40, 40, 3);
+}
+
+// gain of the filter at a frequency, from the RMS of the output
+// once the filter has settled
+static float measure_gain(float freq)
+{
+    float sum_in = 0, sum_out = 0;
+    notch.reset();
+    for (uint16_t i=0; i<2*SAMPLE_FREQ; i++) {
+        float v = sinf(i*2*PI*freq/SAMPLE_FREQ);
+        Vector3f out = notch.apply(Vector3f(v, v, v));
+        if (i >= SAMPLE_FREQ) {
+            sum_in += v*v;
+            sum_out += out.x*out.x;
+        }
+    }
+    return sqrtf(sum_out/sum_in);
+}
+
+void loop()
+{
+    uint32_t start_us = hal.scheduler->micros();
+    for (uint16_t freq=10; freq<=250; freq+=10) {
+        float gain = measure_gain(freq);
+        hal.console->printf("%3uHz gain %6.4f %6.1fdB\n",
+                            (unsigned)freq, gain, 20*log10f(gain));
+    }
+    hal.console->printf("took %luus\n\n", (unsigned long)(hal.scheduler->micros() - start_us));
+    hal.scheduler->delay(10000);
+}
+
+AP_HAL_MAIN();
@@ -12,12 +12,51 @@
 #include <GCS_MAVLink.h>
 #include <DataFlash.h>
 #include <AP_Mission.h>
+#include <AP_Compass.h>
+#include <AP_InertialSensor.h>
 #include "../AP_BattMonitor/AP_BattMonitor.h"
 #include <stdint.h>
 #include <MAVLink_routing.h>
 #include "../AP_SerialManager/AP_SerialManager.h"
 #include "../AP_Mount/AP_Mount.h"
 
+// number of MISSION_REQUESTs kept outstanding while receiving a
+// mission. The replies to a full window have to fit in the UART
+// receive buffer, which is 8k on Linux, 512 bytes on PX4 and too
+// small on the AVR boards to ask for more than one item at a time.
+// At most 32, the size of the mask of items held out of order
+#ifndef MAVLINK_MISSION_REQUEST_WINDOW
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define MAVLINK_MISSION_REQUEST_WINDOW 32
+#elif HAL_CPU_CLASS >= HAL_CPU_CLASS_150
+#define MAVLINK_MISSION_REQUEST_WINDOW 8
+#else
+#define MAVLINK_MISSION_REQUEST_WINDOW 1
+#endif
+#endif
+
+// number of gaps in a log download the GCS can ask to have sent again
+// while the rest of the log keeps streaming
+#define GCS_LOG_MAX_RETRANSMIT 8
+
+// bytes of transmit space left for other messages while sending a log
+#define GCS_LOG_TXSPACE_RESERVE 128
+
+// most LOG_DATA messages sent in one call, to bound the time spent
+// in the main loop on fast links
+#define GCS_LOG_MAX_SENDS 64
+
+// log download rate in bytes/s on telemetry radios, adapted to the
+// transmit buffer the radio reports in RADIO_STATUS. The maximum is
+// the UART rate when the baud rate is known
+#define GCS_LOG_DEFAULT_RATE 5000
+#define GCS_LOG_MIN_RATE     1000
+#define GCS_LOG_MAX_RATE     50000
+
+// a link is treated as a telemetry radio while it has sent RADIO_STATUS
+// within this time
+#define GCS_LOG_RADIO_TIMEOUT_MS 5000
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -59,6 +98,7 @@ enum ap_message {
     MSG_EKF_STATUS_REPORT,
     MSG_LOCAL_POSITION,
     MSG_PID_TUNING,
+    MSG_GYRO_FFT,
     MSG_RETRY_DEFERRED // this must be last
 };
 
@@ -85,6 +125,7 @@ public:
     void        data_stream_send(void);
     void        queued_param_send();
     void        queued_waypoint_send();
+    void        request_missing_waypoints();
     void        set_snoop(void (*_msg_snoop)(const mavlink_message_t* msg)) {
         msg_snoop = _msg_snoop;
     }
@@ -155,6 +196,23 @@ public:
     */
     static void send_statustext_all(const prog_char_t *msg);
 
+#if COMPASS_CAL_ENABLED
+    /*
+      report onboard compass calibration progress to all active
+      MAVLink connections. Call at about 1Hz
+     */
+    static void send_compass_cal_status(const Compass &compass);
+#endif
+
+#if !defined( __AVR_ATmega1280__ )
+    /*
+      prompt for the next orientation of a background accel
+      calibration, and report its result, on all active MAVLink
+      connections. Call at 10Hz or more
+     */
+    static void send_accel_cal_status(const AP_InertialSensor &ins);
+#endif
+
     /*
       send a MAVLink message to all components with this vehicle's system id
       This is a no-op if no routes to components have been learned
@@ -207,6 +265,13 @@ private:
     // waypoints
     uint16_t        waypoint_request_i; // request index
     uint16_t        waypoint_request_last; // last request index
+    uint16_t        waypoint_request_sent; // one past the highest index requested
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+    // items that arrived ahead of waypoint_request_i, held until the
+    // ones before them arrive. Item n is in slot n % MAVLINK_MISSION_REQUEST_WINDOW
+    AP_Mission::Mission_Command waypoint_window[MAVLINK_MISSION_REQUEST_WINDOW];
+    uint32_t        waypoint_window_mask; // bit set for each slot holding an item
+#endif
     uint16_t        waypoint_dest_sysid; // where to send requests
     uint16_t        waypoint_dest_compid; // "
     bool            waypoint_receiving; // currently receiving
@@ -255,6 +320,24 @@ private:
     // start page of log data
     uint16_t _log_data_page;
 
+    // gaps the GCS has asked for again while a log is streaming,
+    // sent ahead of the stream without restarting it
+    struct {
+        uint32_t offset;
+        uint32_t remaining;
+    } _log_retransmit[GCS_LOG_MAX_RETRANSMIT];
+    uint8_t _log_num_retransmit;
+
+    // log download rate on telemetry radios, and the bytes we may
+    // send now at that rate
+    uint32_t _log_rate;
+    uint32_t _log_max_rate;
+    uint32_t _log_credit;
+    uint32_t _log_last_send_ms;
+
+    // last time a RADIO_STATUS came in on this link
+    uint32_t _log_radio_status_ms;
+
     // deferred message handling
     enum ap_message deferred_messages[MSG_RETRY_DEFERRED];
     uint8_t next_deferred_message;
@@ -283,6 +366,7 @@ private:
     void handle_log_send(DataFlash_Class &dataflash);
     void handle_log_send_listing(DataFlash_Class &dataflash);
     bool handle_log_send_data(DataFlash_Class &dataflash);
+    void queue_log_retransmit(uint32_t offset, uint32_t count);
 
     void handle_mission_request_list(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_request(AP_Mission &mission, mavlink_message_t *msg);
@@ -292,6 +376,7 @@ private:
     void handle_mission_clear_all(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_write_partial_list(AP_Mission &mission, mavlink_message_t *msg);
     bool handle_mission_item(mavlink_message_t *msg, AP_Mission &mission);
+    bool store_mission_item(AP_Mission &mission, uint16_t seq, AP_Mission::Mission_Command &cmd);
 
     void handle_request_data_stream(mavlink_message_t *msg, bool save);
     void handle_param_request_list(mavlink_message_t *msg);
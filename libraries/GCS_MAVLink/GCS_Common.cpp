@@ -28,7 +28,13 @@ uint32_t GCS_MAVLINK::last_radio_status_remrssi_ms;
 uint8_t GCS_MAVLINK::mavlink_active = 0;
 
 GCS_MAVLINK::GCS_MAVLINK() :
-    waypoint_receive_timeout(5000)
+    waypoint_receive_timeout(5000),
+    _log_num_retransmit(0),
+    _log_rate(GCS_LOG_DEFAULT_RATE),
+    _log_max_rate(GCS_LOG_MAX_RATE),
+    _log_credit(0),
+    _log_last_send_ms(0),
+    _log_radio_status_ms(0)
 {
     AP_Param::setup_object_defaults(this, var_info);
 }
@@ -92,7 +98,15 @@ GCS_MAVLINK::setup_uart(const AP_SerialManager& serial_manager, AP_SerialManager
     uart->set_flow_control(old_flow_control);
 
     // now change back to desired baudrate
-    uart->begin(serial_manager.find_baudrate(protocol, instance));
+    uint32_t baudrate = serial_manager.find_baudrate(protocol, instance);
+    uart->begin(baudrate);
+
+    // a radio can't send logs faster than the UART feeding it, at 10
+    // bits per byte
+    if (baudrate >= 10*GCS_LOG_MIN_RATE) {
+        _log_max_rate = baudrate / 10;
+        _log_rate = min(_log_rate, _log_max_rate);
+    }
 
     // and init the gcs instance
     init(uart, mav_chan);
@@ -171,8 +185,9 @@ GCS_MAVLINK::queued_param_send()
 }
 
 /**
- * @brief Send the next pending waypoint, called from deferred message
- * handling code
+ * @brief Send the next pending waypoint requests, called from deferred
+ * message handling code. Up to MAVLINK_MISSION_REQUEST_WINDOW requests
+ * are kept outstanding so the GCS can stream the mission
  */
 void
 GCS_MAVLINK::queued_waypoint_send()
@@ -180,11 +195,46 @@ GCS_MAVLINK::queued_waypoint_send()
     if (initialised &&
         waypoint_receiving &&
         waypoint_request_i <= waypoint_request_last) {
+        // a single item partial update has start_index == end_index
+        uint16_t request_limit = max(waypoint_request_last, waypoint_request_i+1);
+        if (waypoint_request_sent < waypoint_request_i) {
+            waypoint_request_sent = waypoint_request_i;
+        }
+        while (waypoint_request_sent < request_limit &&
+               waypoint_request_sent - waypoint_request_i < MAVLINK_MISSION_REQUEST_WINDOW &&
+               comm_get_txspace(chan) >= MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_REQUEST_LEN) {
+            mavlink_msg_mission_request_send(
+                chan,
+                waypoint_dest_sysid,
+                waypoint_dest_compid,
+                waypoint_request_sent);
+            waypoint_request_sent++;
+        }
+    }
+}
+
+/**
+ * @brief Ask again for the items in the request window that haven't
+ * arrived, leaving out those that arrived out of order
+ */
+void
+GCS_MAVLINK::request_missing_waypoints()
+{
+    for (uint16_t seq=waypoint_request_i; seq<waypoint_request_sent; seq++) {
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+        if (waypoint_window_mask & (1UL << (seq % MAVLINK_MISSION_REQUEST_WINDOW))) {
+            continue;
+        }
+#endif
+        if (comm_get_txspace(chan) < MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_REQUEST_LEN) {
+            // the rest are asked for on the next timeout
+            break;
+        }
         mavlink_msg_mission_request_send(
             chan,
             waypoint_dest_sysid,
             waypoint_dest_compid,
-            waypoint_request_i);
+            seq);
     }
 }
 
@@ -342,6 +392,10 @@ void GCS_MAVLINK::handle_mission_count(AP_Mission &mission, mavlink_message_t *m
     waypoint_receiving = true;              // record that we expect to receive commands
     waypoint_request_i = 0;                 // reset the next expected command number to zero
     waypoint_request_last = packet.count;   // record how many commands we expect to receive
+    waypoint_request_sent = 0;              // nothing requested yet
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+    waypoint_window_mask = 0;               // nothing held out of order
+#endif
     waypoint_timelast_request = 0;          // set time we last requested commands to zero
 }
 
@@ -386,6 +440,10 @@ void GCS_MAVLINK::handle_mission_write_partial_list(AP_Mission &mission, mavlink
     waypoint_receiving   = true;
     waypoint_request_i   = packet.start_index;
     waypoint_request_last= packet.end_index;
+    waypoint_request_sent= packet.start_index;
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+    waypoint_window_mask = 0;
+#endif
 }
 
 
@@ -645,6 +703,14 @@ void GCS_MAVLINK::handle_radio_status(mavlink_message_t *msg, DataFlash_Class &d
         stream_slowdown--;
     }
 
+    // and the same for the rate we send logs at
+    _log_radio_status_ms = hal.scheduler->millis();
+    if (packet.txbuf < 50) {
+        _log_rate = max(_log_rate * 7 / 10, GCS_LOG_MIN_RATE);
+    } else if (packet.txbuf > 90 && _log_rate < _log_max_rate) {
+        _log_rate = min(_log_rate + _log_rate / 10, _log_max_rate);
+    }
+
     //log rssi, noise, etc if logging Performance monitoring data
     if (log_radio) {
         dataflash.Log_Write_Radio(packet);
@@ -699,28 +765,32 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
 
     // check if this is the requested waypoint
     if (packet.seq != waypoint_request_i) {
+        if (packet.seq < waypoint_request_i) {
+            // a repeat of an item we already have
+            return false;
+        }
+        if (packet.seq < waypoint_request_sent) {
+            // an item from further along the request window
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+            // keep it until the items before it arrive
+            uint8_t slot = packet.seq % MAVLINK_MISSION_REQUEST_WINDOW;
+            waypoint_window[slot] = cmd;
+            waypoint_window_mask |= (1UL << slot);
+#endif
+            waypoint_timelast_receive = hal.scheduler->millis();
+            if (packet.seq + 1 == waypoint_request_sent) {
+                // the window has drained without the expected items,
+                // so ask again for just those
+                waypoint_timelast_request = hal.scheduler->millis();
+                request_missing_waypoints();
+            }
+            return false;
+        }
         result = MAV_MISSION_INVALID_SEQUENCE;
         goto mission_ack;
     }
-    
-    // if command index is within the existing list, replace the command
-    if (packet.seq < mission.num_commands()) {
-        if (mission.replace_cmd(packet.seq,cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
-            goto mission_ack;
-        }
-        // if command is at the end of command list, add the command
-    } else if (packet.seq == mission.num_commands()) {
-        if (mission.add_cmd(cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
-            goto mission_ack;
-        }
-        // if beyond the end of the command list, return an error
-    } else {
+
+    if (!store_mission_item(mission, packet.seq, cmd)) {
         result = MAV_MISSION_ERROR;
         goto mission_ack;
     }
@@ -728,6 +798,22 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
     // update waypoint receiving state machine
     waypoint_timelast_receive = hal.scheduler->millis();
     waypoint_request_i++;
+
+#if MAVLINK_MISSION_REQUEST_WINDOW > 1
+    // store the items that arrived ahead of this one
+    while (waypoint_request_i < waypoint_request_last) {
+        uint8_t slot = waypoint_request_i % MAVLINK_MISSION_REQUEST_WINDOW;
+        if (!(waypoint_window_mask & (1UL << slot))) {
+            break;
+        }
+        waypoint_window_mask &= ~(1UL << slot);
+        if (!store_mission_item(mission, waypoint_request_i, waypoint_window[slot])) {
+            result = MAV_MISSION_ERROR;
+            goto mission_ack;
+        }
+        waypoint_request_i++;
+    }
+#endif
     
     if (waypoint_request_i >= waypoint_request_last) {
         mavlink_msg_mission_ack_send_buf(
@@ -766,6 +852,24 @@ mission_ack:
     return mission_is_complete;
 }
 
+/*
+  store a received mission item, replacing the command at seq or
+  adding it to the end of the mission. Returns false on failure
+ */
+bool GCS_MAVLINK::store_mission_item(AP_Mission &mission, uint16_t seq, AP_Mission::Mission_Command &cmd)
+{
+    if (seq < mission.num_commands()) {
+        // if command index is within the existing list, replace the command
+        return mission.replace_cmd(seq, cmd);
+    }
+    if (seq == mission.num_commands()) {
+        // if command is at the end of command list, add the command
+        return mission.add_cmd(cmd);
+    }
+    // beyond the end of the command list
+    return false;
+}
+
 void 
 GCS_MAVLINK::handle_gps_inject(const mavlink_message_t *msg, AP_GPS &gps)
 {
@@ -884,6 +988,9 @@ GCS_MAVLINK::update(run_cli_fn run_cli)
         waypoint_request_i <= waypoint_request_last &&
         tnow - waypoint_timelast_request > wp_recv_time) {
         waypoint_timelast_request = tnow;
+        // nothing arrived, so ask again for the items we are missing
+        // and carry on with the window
+        request_missing_waypoints();
         send_message(MSG_NEXT_WAYPOINT);
     }
 
@@ -1168,6 +1275,100 @@ void GCS_MAVLINK::send_statustext_all(const prog_char_t *msg)
     }
 }
 
+#if COMPASS_CAL_ENABLED
+/*
+  report onboard compass calibration progress. Running calibrations
+  are reported on every call, and the result once when one finishes
+ */
+void GCS_MAVLINK::send_compass_cal_status(const Compass &compass)
+{
+    static uint8_t last_status[COMPASS_MAX_INSTANCES];
+
+    for (uint8_t i=0; i<compass.get_count(); i++) {
+        const CompassCalibrator &cal = compass.get_calibrator(i);
+        uint8_t status = cal.get_status();
+        char msg[50];
+        switch (status) {
+        case COMPASS_CAL_WAITING_TO_START:
+        case COMPASS_CAL_RUNNING_STEP_ONE:
+        case COMPASS_CAL_RUNNING_STEP_TWO:
+            hal.util->snprintf(msg, sizeof(msg), "Mag%u cal %u%%",
+                               (unsigned)i+1, (unsigned)cal.get_completion_percent());
+            break;
+        case COMPASS_CAL_SUCCESS:
+            hal.util->snprintf(msg, sizeof(msg), "Mag%u cal done, fit %.1f",
+                               (unsigned)i+1, cal.get_fitness());
+            break;
+        case COMPASS_CAL_FAILED:
+            hal.util->snprintf(msg, sizeof(msg), "Mag%u cal failed, fit %.1f",
+                               (unsigned)i+1, cal.get_fitness());
+            break;
+        default:
+            last_status[i] = status;
+            continue;
+        }
+        if (status >= COMPASS_CAL_SUCCESS && status == last_status[i]) {
+            // already reported
+            continue;
+        }
+        last_status[i] = status;
+        send_statustext_all(msg);
+    }
+}
+#endif
+
+#if !defined( __AVR_ATmega1280__ )
+/*
+  report background accel calibration progress. Each orientation is
+  asked for once, and the result is reported once. The texts match
+  the ones calibrate_accel() gives, which ground stations look for
+ */
+void GCS_MAVLINK::send_accel_cal_status(const AP_InertialSensor &ins)
+{
+    static uint8_t last_status;
+    static uint8_t last_step;
+
+    uint8_t status = ins.accel_cal_status();
+    uint8_t step = ins.accel_cal_step();
+    if (status == last_status && step == last_step) {
+        return;
+    }
+    last_status = status;
+    last_step = step;
+
+    char msg[2][50];
+    uint8_t num_msgs = 1;
+    switch (status) {
+    case ACCEL_CAL_WAITING_FOR_ORIENTATION:
+        hal.util->snprintf_P(msg[0], sizeof(msg[0]), PSTR("Place vehicle %S and press any key."),
+                             AP_InertialSensor::accel_cal_orientation(step));
+        break;
+    case ACCEL_CAL_SUCCESS:
+        hal.util->snprintf_P(msg[0], sizeof(msg[0]), PSTR("Calibration successful, fit %.2f"),
+                             (double)ins.accel_cal_fitness());
+        break;
+    case ACCEL_CAL_FAILED:
+        hal.util->snprintf_P(msg[0], sizeof(msg[0]), PSTR("%S"), ins.accel_cal_fail_reason());
+        hal.util->snprintf_P(msg[1], sizeof(msg[1]), PSTR("Calibration FAILED"));
+        num_msgs = 2;
+        break;
+    default:
+        return;
+    }
+
+    for (uint8_t i=0; i<MAVLINK_COMM_NUM_BUFFERS; i++) {
+        if ((1U<<i) & mavlink_active) {
+            mavlink_channel_t chan = (mavlink_channel_t)(MAVLINK_COMM_0+i);
+            for (uint8_t m=0; m<num_msgs; m++) {
+                if (comm_get_txspace(chan) >= MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_STATUSTEXT_LEN) {
+                    mavlink_msg_statustext_send(chan, SEVERITY_HIGH, msg[m]);
+                }
+            }
+        }
+    }
+}
+#endif
+
 // report battery2 state
 void GCS_MAVLINK::send_battery2(const AP_BattMonitor &battery)
 {
@@ -57,6 +57,7 @@ void GCS_MAVLINK::handle_log_request_list(mavlink_message_t *msg, DataFlash_Clas
 
     _log_listing = false;
     _log_sending = false;
+    _log_num_retransmit = 0;
 
     _log_num_logs = dataflash.get_num_logs();
     if (_log_num_logs == 0) {
@@ -90,6 +91,17 @@ void GCS_MAVLINK::handle_log_request_data(mavlink_message_t *msg, DataFlash_Clas
     mavlink_msg_log_request_data_decode(msg, &packet);
 
     _log_listing = false;
+    if (_log_sending && _log_num_data == packet.id &&
+        packet.ofs < _log_data_offset &&
+        packet.count <= _log_data_offset - packet.ofs) {
+        // a gap in what we have already sent. Send it again ahead of
+        // the stream rather than going back and sending everything
+        // after it
+        queue_log_retransmit(packet.ofs, packet.count);
+        return;
+    }
+    _log_num_retransmit = 0;
+
     if (!_log_sending || _log_num_data != packet.id) {
         _log_sending = false;
 
@@ -118,6 +130,8 @@ void GCS_MAVLINK::handle_log_request_data(mavlink_message_t *msg, DataFlash_Clas
         _log_data_remaining = packet.count;
     }
     _log_sending = true;
+    _log_credit = 0;
+    _log_last_send_ms = hal.scheduler->millis();
 
     handle_log_send(dataflash);
 }
@@ -141,6 +155,28 @@ void GCS_MAVLINK::handle_log_request_end(mavlink_message_t *msg, DataFlash_Class
     mavlink_log_request_end_t packet;
     mavlink_msg_log_request_end_decode(msg, &packet);
     _log_sending = false;
+    _log_num_retransmit = 0;
+    dataflash.end_log_transfer();
+}
+
+/**
+   queue a range of the log being sent to be sent again
+ */
+void GCS_MAVLINK::queue_log_retransmit(uint32_t offset, uint32_t count)
+{
+    for (uint8_t i=0; i<_log_num_retransmit; i++) {
+        if (_log_retransmit[i].offset == offset) {
+            // already queued
+            return;
+        }
+    }
+    if (_log_num_retransmit == GCS_LOG_MAX_RETRANSMIT) {
+        // the GCS will ask again
+        return;
+    }
+    _log_retransmit[_log_num_retransmit].offset = offset;
+    _log_retransmit[_log_num_retransmit].remaining = count;
+    _log_num_retransmit++;
 }
 
 /**
@@ -154,22 +190,38 @@ void GCS_MAVLINK::handle_log_send(DataFlash_Class &dataflash)
     if (!_log_sending) {
         return;
     }
-    uint8_t num_sends = 1;
-    if (chan == MAVLINK_COMM_0 && hal.gpio->usb_connected()) {
-        // when on USB we can send a lot more data
-        num_sends = 40;
-    } else if (have_flow_control()) {
-        num_sends = 10;        
-    }
 
-#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
-    // assume USB speeds in SITL for the purposes of log download
-    num_sends = 40;
-#endif
+    /*
+      a telemetry radio without flow control that sends RADIO_STATUS
+      gets data at the rate it has shown it can carry. Any other link
+      gets as much data as it has transmit space for, so it is paced
+      by the rate its transmit buffer drains
+     */
+    uint32_t now = hal.scheduler->millis();
+    bool self_paced = have_flow_control() || _log_radio_status_ms == 0 ||
+        now - _log_radio_status_ms > GCS_LOG_RADIO_TIMEOUT_MS;
+
+    const uint16_t pkt_len = MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_LOG_DATA_LEN;
+    if (!self_paced) {
+        _log_credit += _log_rate * (now - _log_last_send_ms) / 1000;
+        // allow bursts of up to 0.1s worth of data
+        _log_credit = min(_log_credit, max(_log_rate / 10, (uint32_t)pkt_len));
+    }
+    _log_last_send_ms = now;
 
-    for (uint8_t i=0; i<num_sends; i++) {
-        if (_log_sending) {
-            if (!handle_log_send_data(dataflash)) break;
+    for (uint8_t i=0; i<GCS_LOG_MAX_SENDS && _log_sending; i++) {
+        if (!self_paced && _log_credit < pkt_len) {
+            break;
+        }
+        if (i > 0 && comm_get_txspace(chan) < pkt_len + GCS_LOG_TXSPACE_RESERVE) {
+            // leave some room for other messages
+            break;
+        }
+        if (!handle_log_send_data(dataflash)) {
+            break;
+        }
+        if (!self_paced) {
+            _log_credit -= pkt_len;
         }
     }
 }
@@ -219,14 +271,29 @@ bool GCS_MAVLINK::handle_log_send_data(DataFlash_Class &dataflash)
         return false;
     }
 
+    if (_log_num_retransmit == 0 && _log_data_remaining == 0) {
+        // the stream has finished and all the gaps are filled
+        _log_sending = false;
+        return false;
+    }
+
+    // gaps the GCS asked for go first
+    bool retransmit = (_log_num_retransmit != 0);
+    uint32_t &offset = retransmit ? _log_retransmit[0].offset : _log_data_offset;
+    uint32_t &remaining = retransmit ? _log_retransmit[0].remaining : _log_data_remaining;
+
     int16_t ret = 0;
-    uint32_t len = _log_data_remaining;
+    uint32_t len = remaining;
 	mavlink_log_data_t packet;
 
     if (len > 90) {
         len = 90;
     }
-    ret = dataflash.get_log_data(_log_num_data, _log_data_page, _log_data_offset, len, packet.data);
+    ret = dataflash.get_log_data_nonblocking(_log_num_data, _log_data_page, offset, len, packet.data);
+    if (ret == DATAFLASH_DATA_PENDING) {
+        // still being read from storage
+        return false;
+    }
     if (ret < 0) {
         // report as EOF on error
         ret = 0;
@@ -235,16 +302,22 @@ bool GCS_MAVLINK::handle_log_send_data(DataFlash_Class &dataflash)
         memset(&packet.data[ret], 0, 90-ret);
     }
 
-    packet.ofs = _log_data_offset;
+    packet.ofs = offset;
     packet.id = _log_num_data;
     packet.count = ret;
     _mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_LOG_DATA, (const char *)&packet, 
                                     MAVLINK_MSG_ID_LOG_DATA_LEN, MAVLINK_MSG_ID_LOG_DATA_CRC);
 
-    _log_data_offset += len;
-    _log_data_remaining -= len;
-    if (ret < 90 || _log_data_remaining == 0) {
-        _log_sending = false;
+    offset += len;
+    remaining -= len;
+    if (ret < 90 || remaining == 0) {
+        if (retransmit) {
+            _log_num_retransmit--;
+            memmove(&_log_retransmit[0], &_log_retransmit[1],
+                    _log_num_retransmit * sizeof(_log_retransmit[0]));
+        } else {
+            _log_data_remaining = 0;
+        }
     }
     return true;
 }
@@ -52,10 +52,13 @@ Aircraft::Aircraft(const char *home_str, const char *frame_str) :
     last_time_us(0),
     autotest_dir(NULL),
 #ifdef __CYGWIN__
-    min_sleep_time(20000)
+    min_sleep_time(20000),
 #else
-    min_sleep_time(5000)
+    min_sleep_time(5000),
 #endif
+    use_time_sync(true),
+    integrator(INTEGRATOR_SEMI_IMPLICIT),
+    substeps(1)
 {
     char *saveptr=NULL;
     char *s = strdup(home_str);
@@ -135,7 +138,9 @@ void Aircraft::setup_frame_time(float new_rate, float new_speedup)
     target_speedup = new_speedup;
     frame_time_us = 1.0e6f/rate_hz;
 
-    scaled_frame_time_us = frame_time_us/target_speedup;
+    // a speedup of zero or less means free running
+    use_time_sync = target_speedup > 0;
+    scaled_frame_time_us = use_time_sync ? frame_time_us/target_speedup : 0;
     last_wall_time_us = get_wall_time_us();
     achieved_rate_hz = rate_hz;
 }
@@ -146,7 +151,7 @@ void Aircraft::adjust_frame_time(float new_rate)
     if (rate_hz != new_rate) {
         rate_hz = new_rate;
         frame_time_us = 1.0e6f/rate_hz;
-        scaled_frame_time_us = frame_time_us/target_speedup;
+        scaled_frame_time_us = use_time_sync ? frame_time_us/target_speedup : 0;
     }
 }
 
@@ -158,6 +163,9 @@ void Aircraft::adjust_frame_time(float new_rate)
 */
 void Aircraft::sync_frame_time(void)
 {
+    if (!use_time_sync) {
+        return;
+    }
     frame_counter++;
     uint64_t now = get_wall_time_us();
     if (frame_counter >= 40 &&
@@ -185,6 +193,111 @@ void Aircraft::sync_frame_time(void)
     }
 }
 
+/*
+  advance the model state by one frame, in substeps physics steps
+ */
+void Aircraft::integrate(const struct sitl_input &input)
+{
+    struct body_state s;
+    s.dcm = dcm;
+    s.gyro = gyro;
+    s.velocity_ef = velocity_ef;
+    s.position = position;
+
+    float dt = frame_time_us * 1.0e-6f / substeps;
+    Vector3f accel_earth;
+    for (uint8_t i=0; i<substeps; i++) {
+        switch (integrator) {
+        case INTEGRATOR_RK4:
+            step_rk4(input, s, dt, accel_earth);
+            break;
+        case INTEGRATOR_SEMI_IMPLICIT:
+        default:
+            step_semi_implicit(input, s, dt, accel_earth);
+            break;
+        }
+    }
+
+    dcm = s.dcm;
+    gyro = s.gyro;
+    velocity_ef = s.velocity_ef;
+    position = s.position;
+
+    // work out acceleration as seen by the accelerometers. It sees the kinematic
+    // acceleration (ie. real movement), plus gravity
+    accel_body = dcm.transposed() * (accel_earth + Vector3f(0, 0, -GRAVITY_MSS));
+}
+
+/*
+  one semi-implicit Euler step: rates are updated first and the new
+  rates used to move the attitude, then the forces at the new
+  attitude update velocity, and the new velocity moves the position.
+  This is the order the multicopter and helicopter models used before
+  integrate(). The rover used to take its speed and yaw rate from the
+  attitude before the rotation, so it now differs from its old update
+  by a term of order dt
+ */
+void Aircraft::step_semi_implicit(const struct sitl_input &input, struct body_state &s,
+                                  float dt, Vector3f &accel_earth)
+{
+    Vector3f rot_accel;
+    calculate_forces(input, s, rot_accel, accel_earth);
+
+    s.gyro += rot_accel * dt;
+    s.dcm.rotate(attitude_rates(s) * dt);
+    s.dcm.normalize();
+
+    calculate_forces(input, s, rot_accel, accel_earth);
+
+    s.velocity_ef += accel_earth * dt;
+    s.position += s.velocity_ef * dt;
+}
+
+/*
+  one classic 4th order Runge-Kutta step. The attitude is moved by
+  the weighted body rates as a single rotation
+ */
+void Aircraft::step_rk4(const struct sitl_input &input, struct body_state &s,
+                        float dt, Vector3f &accel_earth)
+{
+    static const float stage_dt[3] = { 0.5f, 0.5f, 1.0f };
+    struct body_rates k[4];
+    struct body_state t = s;
+
+    for (uint8_t i=0; i<4; i++) {
+        k[i].omega = attitude_rates(t);
+        k[i].velocity_ef = t.velocity_ef;
+        calculate_forces(input, t, k[i].rot_accel, k[i].accel_earth);
+        if (i < 3) {
+            advance(s, k[i], dt * stage_dt[i], t);
+        }
+    }
+
+    struct body_rates avg;
+    avg.omega       = (k[0].omega       + (k[1].omega       + k[2].omega)*2       + k[3].omega) / 6;
+    avg.rot_accel   = (k[0].rot_accel   + (k[1].rot_accel   + k[2].rot_accel)*2   + k[3].rot_accel) / 6;
+    avg.velocity_ef = (k[0].velocity_ef + (k[1].velocity_ef + k[2].velocity_ef)*2 + k[3].velocity_ef) / 6;
+    avg.accel_earth = (k[0].accel_earth + (k[1].accel_earth + k[2].accel_earth)*2 + k[3].accel_earth) / 6;
+
+    advance(s, avg, dt, s);
+    accel_earth = avg.accel_earth;
+}
+
+/*
+  move state s0 along rates k for dt seconds, giving s
+ */
+void Aircraft::advance(const struct body_state &s0, const struct body_rates &k,
+                       float dt, struct body_state &s)
+{
+    struct body_state r = s0;
+    r.dcm.rotate(k.omega * dt);
+    r.dcm.normalize();
+    r.gyro += k.rot_accel * dt;
+    r.velocity_ef += k.accel_earth * dt;
+    r.position += k.velocity_ef * dt;
+    s = r;
+}
+
 /* add noise based on throttle level (from 0..1) */
 void Aircraft::add_noise(float throttle)
 {
@@ -290,4 +403,13 @@ void Aircraft::set_speedup(float speedup)
 {
     setup_frame_time(rate_hz, speedup);
 }
+
+/*
+  set integration method and physics steps per frame
+ */
+void Aircraft::set_integrator(enum Integrator _integrator, uint8_t _substeps)
+{
+    integrator = _integrator;
+    substeps = _substeps > 0 ? _substeps : 1;
+}
 #endif // CONFIG_HAL_BOARD
@@ -31,6 +31,7 @@ class Aircraft
 {
 public:
     Aircraft(const char *home_str, const char *frame_str);
+    virtual ~Aircraft() {}
 
     /*
       structure passed in giving servo positions as PWM values in
@@ -46,10 +47,25 @@ public:
     };
 
     /*
-      set simulation speedup
+      numerical integration method for the built-in physics models
+     */
+    enum Integrator {
+        INTEGRATOR_SEMI_IMPLICIT = 0, // semi-implicit (symplectic) Euler
+        INTEGRATOR_RK4           = 1  // classic 4th order Runge-Kutta
+    };
+
+    /*
+      set simulation speedup. A speedup of zero or less runs as fast
+      as possible, without syncing to the wall clock
      */
     void set_speedup(float speedup);
 
+    /*
+      set the integration method, and the number of physics steps
+      taken per frame
+     */
+    void set_integrator(enum Integrator integrator, uint8_t substeps);
+
     /*
       set instance number
      */
@@ -72,6 +88,9 @@ public:
     /* fill a sitl_fdm structure from the simulator state */
     void fill_fdm(struct sitl_fdm &fdm) const;
 
+    /* simulation time in microseconds */
+    uint64_t get_time_us(void) const { return time_now_us; }
+
 protected:
     Location home;
     Location location;
@@ -99,6 +118,39 @@ protected:
     uint8_t instance;
     const char *autotest_dir;
 
+    /*
+      state of a rigid body model, as advanced by integrate()
+     */
+    struct body_state {
+        Matrix3f dcm;
+        Vector3f gyro;
+        Vector3f velocity_ef;
+        Vector3f position;
+    };
+
+    /*
+      accelerations on the vehicle in the given state, for models
+      using integrate(). rot_accel is in rad/s/s in body frame,
+      accel_earth in m/s/s in earth frame including gravity
+     */
+    virtual void calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                                  Vector3f &rot_accel, Vector3f &accel_earth) {
+        rot_accel.zero();
+        accel_earth.zero();
+    }
+
+    /* body rates used to rotate the attitude, normally the gyro state */
+    virtual Vector3f attitude_rates(const struct body_state &s) const {
+        return s.gyro;
+    }
+
+    /*
+      advance dcm, gyro, velocity_ef and position by one frame using
+      calculate_forces(), and set accel_body to what the
+      accelerometers see
+     */
+    void integrate(const struct sitl_input &input);
+
     bool on_ground(const Vector3f &pos) const;
 
     /* update location from position */
@@ -133,6 +185,24 @@ private:
     uint64_t last_time_us;
     uint32_t frame_counter;
     const uint32_t min_sleep_time;
+    bool use_time_sync;
+    enum Integrator integrator;
+    uint8_t substeps;
+
+    // time derivatives of a body_state
+    struct body_rates {
+        Vector3f omega;
+        Vector3f rot_accel;
+        Vector3f velocity_ef;
+        Vector3f accel_earth;
+    };
+
+    void step_semi_implicit(const struct sitl_input &input, struct body_state &s,
+                            float dt, Vector3f &accel_earth);
+    void step_rk4(const struct sitl_input &input, struct body_state &s,
+                  float dt, Vector3f &accel_earth);
+    static void advance(const struct body_state &s0, const struct body_rates &k,
+                        float dt, struct body_state &s);
 };
 
 #endif // _SIM_AIRCRAFT_H
@@ -51,6 +51,16 @@ private:
     float rsc_setpoint = 0.8f;
     float thrust_scale;
     float tail_thrust_scale;
+
+    // control inputs from the last servo input
+    float thrust;     // 0..1 scaled by rsc
+    float roll_rate;
+    float pitch_rate;
+    float yaw_rate;
+    float rsc_scale;
+
+    void calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                          Vector3f &rot_accel, Vector3f &accel_earth);
 };
 
 
@@ -0,0 +1,65 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  table of the simulator models that can be selected by name
+*/
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#include "SIM_Models.h"
+#include "SIM_Multicopter.h"
+#include "SIM_Helicopter.h"
+#include "SIM_Rover.h"
+#include "SIM_Tracker.h"
+#include "SIM_CRRCSim.h"
+#include "SIM_JSBSim.h"
+#include "SIM_last_letter.h"
+#include "SIM_ShmFDM.h"
+
+static const struct {
+    const char *name;
+    sim_model_constructor constructor;
+    bool builtin;                 // physics run in this process
+} model_constructors[] = {
+    { "+",           MultiCopter::create, true },
+    { "quad",        MultiCopter::create, true },
+    { "copter",      MultiCopter::create, true },
+    { "x",           MultiCopter::create, true },
+    { "hexa",        MultiCopter::create, true },
+    { "octa",        MultiCopter::create, true },
+    { "heli",        Helicopter::create,  true },
+    { "rover",       Rover::create,       true },
+    { "crrcsim",     CRRCSim::create,     false },
+    { "jsbsim",      JSBSim::create,      false },
+    { "last_letter", last_letter::create, false },
+    { "tracker",     Tracker::create,     true },
+    { "shm",         ShmFDM::create,      false }
+};
+
+sim_model_constructor sim_model_find(const char *model_str, bool builtin_only)
+{
+    for (uint8_t i=0; i<sizeof(model_constructors)/sizeof(model_constructors[0]); i++) {
+        if (builtin_only && !model_constructors[i].builtin) {
+            continue;
+        }
+        if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
+            return model_constructors[i].constructor;
+        }
+    }
+    return NULL;
+}
+
+#endif // CONFIG_HAL_BOARD
@@ -0,0 +1,35 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  table of the simulator models that can be selected by name
+*/
+
+#ifndef _SIM_MODELS_H
+#define _SIM_MODELS_H
+
+#include "SIM_Aircraft.h"
+
+typedef Aircraft *(*sim_model_constructor)(const char *home_str, const char *frame_str);
+
+/*
+  find the constructor for a model, matching the start of the model
+  name so that frame options can follow it. With builtin_only set,
+  models that need an external simulator are not matched. Returns
+  NULL for an unknown model
+ */
+sim_model_constructor sim_model_find(const char *model_str, bool builtin_only);
+
+#endif // _SIM_MODELS_H
@@ -129,29 +129,14 @@ MultiCopter::MultiCopter(const char *home_str, const char *frame_str) :
 }
 
 /*
-  update the multicopter simulation by one time step
+  accelerations on the multicopter in the given state
  */
-void MultiCopter::update(const struct sitl_input &input)
+void MultiCopter::calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                                   Vector3f &rot_accel, Vector3f &accel_earth)
 {
-    float motor_speed[frame->num_motors];
-
-    for (uint8_t i=0; i<frame->num_motors; i++) {
-        uint16_t servo = input.servos[frame->motors[i].servo-1];
-        // assume 1000 to 2000 PWM range
-        if (servo <= 1000) {
-            motor_speed[i] = 0;
-        } else {
-            motor_speed[i] = (servo-1000) / 1000.0f;
-        }
-    }
-
-    // how much time has passed?
-    float delta_time = frame_time_us * 1.0e-6f;
-
-    // rotational acceleration, in rad/s/s, in body frame
-    Vector3f rot_accel;
     float thrust = 0.0f; // newtons
 
+    rot_accel.zero();
     for (uint8_t i=0; i<frame->num_motors; i++) {
         rot_accel.x  += -radians(5000.0) * sinf(radians(frame->motors[i].angle)) * motor_speed[i];
         rot_accel.y  +=  radians(5000.0) * cosf(radians(frame->motors[i].angle)) * motor_speed[i];
@@ -164,45 +149,49 @@ void MultiCopter::update(const struct sitl_input &input)
     }
 
     // rotational air resistance
-    rot_accel.x -= gyro.x * radians(5000.0) / terminal_rotation_rate;
-    rot_accel.y -= gyro.y * radians(5000.0) / terminal_rotation_rate;
-    rot_accel.z -= gyro.z * radians(400.0)  / terminal_rotation_rate;
-
-    // update rotational rates in body frame
-    gyro += rot_accel * delta_time;
-
-    // update attitude
-    dcm.rotate(gyro * delta_time);
-    dcm.normalize();
+    rot_accel.x -= s.gyro.x * radians(5000.0) / terminal_rotation_rate;
+    rot_accel.y -= s.gyro.y * radians(5000.0) / terminal_rotation_rate;
+    rot_accel.z -= s.gyro.z * radians(400.0)  / terminal_rotation_rate;
 
     // air resistance
-    Vector3f air_resistance = -velocity_ef * (GRAVITY_MSS/terminal_velocity);
-
-    accel_body = Vector3f(0, 0, -thrust / mass);
-    Vector3f accel_earth = dcm * accel_body;
+    Vector3f air_resistance = -s.velocity_ef * (GRAVITY_MSS/terminal_velocity);
 
+    accel_earth = s.dcm * Vector3f(0, 0, -thrust / mass);
     accel_earth += Vector3f(0, 0, GRAVITY_MSS);
     accel_earth += air_resistance;
 
     // if we're on the ground, then our vertical acceleration is limited
     // to zero. This effectively adds the force of the ground on the aircraft
-    if (on_ground(position) && accel_earth.z > 0) {
+    if (on_ground(s.position) && accel_earth.z > 0) {
         accel_earth.z = 0;
     }
+}
 
-    // work out acceleration as seen by the accelerometers. It sees the kinematic
-    // acceleration (ie. real movement), plus gravity
-    accel_body = dcm.transposed() * (accel_earth + Vector3f(0, 0, -GRAVITY_MSS));
-
-    // add some noise
-    add_noise(thrust / (thrust_scale * frame->num_motors));
+/*
+  update the multicopter simulation by one time step
+ */
+void MultiCopter::update(const struct sitl_input &input)
+{
+    float thrust = 0.0f;
 
-    // new velocity vector
-    velocity_ef += accel_earth * delta_time;
+    for (uint8_t i=0; i<frame->num_motors; i++) {
+        uint16_t servo = input.servos[frame->motors[i].servo-1];
+        // assume 1000 to 2000 PWM range
+        if (servo <= 1000) {
+            motor_speed[i] = 0;
+        } else {
+            motor_speed[i] = (servo-1000) / 1000.0f;
+        }
+        thrust += motor_speed[i] * thrust_scale;
+    }
 
-    // new position vector
     Vector3f old_position = position;
-    position += velocity_ef * delta_time;
+
+    // move the vehicle on by one frame
+    integrate(input);
+
+    // add some noise
+    add_noise(thrust / (thrust_scale * frame->num_motors));
 
     // assume zero wind for now
     airspeed = velocity_ef.length();
@@ -78,6 +78,10 @@ private:
 
     const float terminal_rotation_rate;
     float thrust_scale;
+    float motor_speed[8]; // 0..1, from the last servo input
+
+    void calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                          Vector3f &rot_accel, Vector3f &accel_earth);
 };
 
 
@@ -35,7 +35,9 @@ Rover::Rover(const char *home_str, const char *frame_str) :
     max_wheel_turn(35),
     turning_circle(1.8),
     skid_turn_rate(140), // degrees/sec
-    skid_steering(false)
+    skid_steering(false),
+    steering_in(0),
+    throttle_in(0)
 {
     skid_steering = strstr(frame_str, "skid") != NULL;
 
@@ -52,7 +54,7 @@ Rover::Rover(const char *home_str, const char *frame_str) :
 /*
   return turning circle (diameter) in meters for steering angle proportion in degrees
 */
-float Rover::turn_circle(float steering)
+float Rover::turn_circle(float steering) const
 {
     if (fabsf(steering) < 1.0e-6) {
         return 0;
@@ -63,7 +65,7 @@ float Rover::turn_circle(float steering)
 /*
    return yaw rate in degrees/second given steering_angle and speed
 */
-float Rover::calc_yaw_rate(float steering, float speed)
+float Rover::calc_yaw_rate(float steering, float speed) const
 {
     if (skid_steering) {
         return steering * skid_turn_rate;
@@ -81,7 +83,7 @@ float Rover::calc_yaw_rate(float steering, float speed)
 /*
   return lateral acceleration in m/s/s
 */
-float Rover::calc_lat_accel(float steering_angle, float speed)
+float Rover::calc_lat_accel(float steering_angle, float speed) const
 {
     float yaw_rate = calc_yaw_rate(steering_angle, speed);
     float accel = radians(yaw_rate) * speed;
@@ -89,69 +91,76 @@ float Rover::calc_lat_accel(float steering_angle, float speed)
 }
 
 /*
-  update the rover simulation by one time step
+  body rates of the rover in the given state. The yaw rate follows
+  directly from steering and speed
  */
-void Rover::update(const struct sitl_input &input)
+Vector3f Rover::attitude_rates(const struct body_state &s) const
 {
-    float steering, throttle;
-
-    // if in skid steering mode the steering and throttle values are used for motor1 and motor2
-    if (skid_steering) {
-        float motor1 = 2*((input.servos[0]-1000)/1000.0f - 0.5f);
-        float motor2 = 2*((input.servos[2]-1000)/1000.0f - 0.5f);
-        steering = motor1 - motor2;
-        throttle = 0.5*(motor1 + motor2);
-    } else {
-        steering = 2*((input.servos[0]-1000)/1000.0f - 0.5f);
-        throttle = 2*((input.servos[2]-1000)/1000.0f - 0.5f);
-    }
+    // speed along x axis, +ve is forward
+    float speed = (s.dcm.transposed() * s.velocity_ef).x;
 
-    // how much time has passed?
-    float delta_time = frame_time_us * 1.0e-6f;
+    return Vector3f(0, 0, radians(calc_yaw_rate(steering_in, speed)));
+}
 
+/*
+  accelerations on the rover in the given state
+ */
+void Rover::calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                             Vector3f &rot_accel, Vector3f &accel_earth)
+{
     // speed in m/s in body frame
-    Vector3f velocity_body = dcm.transposed() * velocity_ef;
+    Vector3f velocity_body = s.dcm.transposed() * s.velocity_ef;
 
     // speed along x axis, +ve is forward
     float speed = velocity_body.x;
 
     // yaw rate in degrees/s
-    float yaw_rate = calc_yaw_rate(steering, speed);
+    float yaw_rate = calc_yaw_rate(steering_in, speed);
 
     // target speed with current throttle
-    float target_speed = throttle * max_speed;
+    float target_speed = throttle_in * max_speed;
 
     // linear acceleration in m/s/s - very crude model
     float accel = max_accel * (target_speed - speed) / max_speed;
 
-    gyro = Vector3f(0,0,radians(yaw_rate));
-
-    // update attitude
-    dcm.rotate(gyro * delta_time);
-    dcm.normalize();
+    // the yaw rate is kinematic, see attitude_rates()
+    rot_accel.zero();
 
-    // accel in body frame due to motor
-    accel_body = Vector3f(accel, 0, 0);
-
-    // add in accel due to direction change
-    accel_body.y += radians(yaw_rate) * speed;
+    // accel in body frame due to motor, and due to direction change
+    Vector3f body_accel(accel, radians(yaw_rate) * speed, 0);
 
     // now in earth frame
-    Vector3f accel_earth = dcm * accel_body;
+    accel_earth = s.dcm * body_accel;
     accel_earth += Vector3f(0, 0, GRAVITY_MSS);
 
     // we are on the ground, so our vertical accel is zero
     accel_earth.z = 0;
+}
+
+/*
+  update the rover simulation by one time step
+ */
+void Rover::update(const struct sitl_input &input)
+{
+    // if in skid steering mode the steering and throttle values are used for motor1 and motor2
+    if (skid_steering) {
+        float motor1 = 2*((input.servos[0]-1000)/1000.0f - 0.5f);
+        float motor2 = 2*((input.servos[2]-1000)/1000.0f - 0.5f);
+        steering_in = motor1 - motor2;
+        throttle_in = 0.5*(motor1 + motor2);
+    } else {
+        steering_in = 2*((input.servos[0]-1000)/1000.0f - 0.5f);
+        throttle_in = 2*((input.servos[2]-1000)/1000.0f - 0.5f);
+    }
 
-    // work out acceleration as seen by the accelerometers. It sees the kinematic
-    // acceleration (ie. real movement), plus gravity
-    accel_body = dcm.transposed() * (accel_earth + Vector3f(0, 0, -GRAVITY_MSS));
+    // move the vehicle on by one frame
+    integrate(input);
 
-    // new velocity vector
-    velocity_ef += accel_earth * delta_time;
+    struct body_state s;
+    s.dcm = dcm;
+    s.velocity_ef = velocity_ef;
+    gyro = attitude_rates(s);
 
-    // new position vector
-    position += velocity_ef * delta_time;
     position.z = -home.alt*0.01f;
 
     // update lat/lon/altitude
@@ -48,9 +48,17 @@ private:
     float skid_turn_rate;
     bool skid_steering;
 
-    float turn_circle(float steering);
-    float calc_yaw_rate(float steering, float speed);
-    float calc_lat_accel(float steering_angle, float speed);
+    // control inputs from the last servo input, -1..1
+    float steering_in;
+    float throttle_in;
+
+    void calculate_forces(const struct sitl_input &input, const struct body_state &s,
+                          Vector3f &rot_accel, Vector3f &accel_earth);
+    Vector3f attitude_rates(const struct body_state &s) const;
+
+    float turn_circle(float steering) const;
+    float calc_yaw_rate(float steering, float speed) const;
+    float calc_lat_accel(float steering_angle, float speed) const;
 };
 
 
@@ -0,0 +1,91 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connector for an FDM on the same host over shared memory
+*/
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#include "SIM_ShmFDM.h"
+#include <SITL.h>
+#include <stdio.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  constructor
+ */
+ShmFDM::ShmFDM(const char *home_str, const char *frame_str) :
+    Aircraft(home_str, frame_str),
+    last_timestamp_us(0),
+    link(ShmLink::SIDE_AUTOPILOT)
+{
+}
+
+/*
+  receive an update from the FDM
+  This is a blocking function
+ */
+void ShmFDM::recv_fdm(const struct sitl_input &input)
+{
+    struct sitl_fdm pkt;
+
+    /*
+      re-send the servos every 0.1 seconds until we get a reply, so we
+      pick up again if the FDM is restarted
+     */
+    while (link.recv(&pkt, sizeof(pkt), 100) != sizeof(pkt) ||
+           pkt.magic != 0x4c56414f) {
+        link.send(&input, sizeof(input));
+    }
+
+    accel_body = Vector3f(pkt.xAccel, pkt.yAccel, pkt.zAccel);
+    gyro = Vector3f(radians(pkt.rollRate), radians(pkt.pitchRate), radians(pkt.yawRate));
+    velocity_ef = Vector3f(pkt.speedN, pkt.speedE, pkt.speedD);
+    location.lat = pkt.latitude * 1.0e7;
+    location.lng = pkt.longitude * 1.0e7;
+    location.alt = pkt.altitude*1.0e2;
+    dcm.from_euler(radians(pkt.rollDeg), radians(pkt.pitchDeg), radians(pkt.yawDeg));
+
+    airspeed = pkt.airspeed;
+
+    // auto-adjust to the FDM frame rate
+    uint64_t deltat_us = pkt.timestamp_us - last_timestamp_us;
+    if (last_timestamp_us == 0 || pkt.timestamp_us < last_timestamp_us) {
+        // first packet, or the FDM restarted
+        deltat_us = 0;
+    }
+    time_now_us += deltat_us;
+
+    if (deltat_us < 1.0e4 && deltat_us > 0) {
+        adjust_frame_time(1.0e6/deltat_us);
+    }
+    last_timestamp_us = pkt.timestamp_us;
+}
+
+/*
+  update the simulation by one time step
+ */
+void ShmFDM::update(const struct sitl_input &input)
+{
+    if (!link.is_open() && !link.open_instance(instance)) {
+        hal.scheduler->panic("Unable to open FDM shared memory");
+    }
+    link.send(&input, sizeof(input));
+    recv_fdm(input);
+    sync_frame_time();
+}
+#endif // CONFIG_HAL_BOARD
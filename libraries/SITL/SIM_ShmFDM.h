@@ -0,0 +1,50 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connection for an FDM on the same host over shared memory
+*/
+
+#ifndef _SIM_SHMFDM_H
+#define _SIM_SHMFDM_H
+
+#include "SIM_Aircraft.h"
+#include "SIM_ShmLink.h"
+
+/*
+  an external FDM taking a sitl_input and replying with a sitl_fdm
+  over a ShmLink, in lockstep with the autopilot
+ */
+class ShmFDM : public Aircraft
+{
+public:
+    ShmFDM(const char *home_str, const char *frame_str);
+
+    /* update model by one time step */
+    void update(const struct sitl_input &input);
+
+    /* static object creator */
+    static Aircraft *create(const char *home_str, const char *frame_str) {
+        return new ShmFDM(home_str, frame_str);
+    }
+
+private:
+    void recv_fdm(const struct sitl_input &input);
+
+    uint64_t last_timestamp_us;
+    ShmLink link;
+};
+
+#endif // _SIM_SHMFDM_H
@@ -0,0 +1,197 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared memory packet link between SITL and an external FDM
+*/
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#include "SIM_ShmLink.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+ShmLink::ShmLink(enum Side side) :
+    _side(side),
+    _fd(-1),
+    _shared(NULL),
+    _tx_count(0),
+    _rx_count(0)
+{}
+
+ShmLink::~ShmLink()
+{
+    if (_shared != NULL) {
+        munmap(_shared, sizeof(struct shared));
+    }
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+bool ShmLink::open(const char *name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/shm/%s", name);
+
+    _fd = ::open(path, O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+    if (_fd == -1) {
+        ::printf("ShmLink: unable to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    // both sides size the file the same way, so it doesn't matter
+    // which one creates it
+    struct stat st;
+    if (fstat(_fd, &st) != 0 ||
+        (st.st_size != sizeof(struct shared) && ftruncate(_fd, sizeof(struct shared)) != 0)) {
+        ::printf("ShmLink: unable to size %s: %s\n", path, strerror(errno));
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    void *p = mmap(NULL, sizeof(struct shared), PROT_READ|PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (p == MAP_FAILED) {
+        ::printf("ShmLink: unable to map %s: %s\n", path, strerror(errno));
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    _shared = (struct shared *)p;
+
+    uint32_t magic = __sync_val_compare_and_swap(&_shared->magic, 0, SHM_LINK_MAGIC);
+    if (magic != 0 && magic != SHM_LINK_MAGIC) {
+        ::printf("ShmLink: %s is not a SITL link\n", path);
+        munmap(_shared, sizeof(struct shared));
+        _shared = NULL;
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    /*
+      carry on from the counts already in the link, so the other side
+      sees our packets as new after a restart, and we don't take a
+      stale packet as new
+     */
+    const struct buffer &tx = _shared->buf[_side];
+    _tx_count = tx.copy[tx.latest & 1].count;
+    const struct buffer &rx = _shared->buf[_side ^ 1];
+    _rx_count = rx.copy[rx.latest & 1].count;
+
+    return true;
+}
+
+bool ShmLink::open_instance(uint8_t instance)
+{
+    char name[20];
+    snprintf(name, sizeof(name), "sitl_fdm_%u", (unsigned)instance);
+    return open(name);
+}
+
+bool ShmLink::send(const void *pkt, uint16_t len)
+{
+    if (_shared == NULL || len > SHM_LINK_MAX_PACKET) {
+        return false;
+    }
+    struct buffer &b = _shared->buf[_side];
+    uint8_t idx = (b.latest + 1) & 1;
+
+    b.copy[idx].seq++;
+    __sync_synchronize();
+    b.copy[idx].count = ++_tx_count;
+    b.copy[idx].length = len;
+    memcpy(b.copy[idx].data, pkt, len);
+    __sync_synchronize();
+    b.copy[idx].seq++;
+    __sync_synchronize();
+    b.latest = idx;
+
+    return true;
+}
+
+/*
+  take a consistent copy of the latest packet in a buffer
+ */
+bool ShmLink::_read(const struct buffer &b, void *pkt, uint16_t size,
+                    uint16_t &length, uint32_t &count) const
+{
+    for (uint8_t tries=0; tries<100; tries++) {
+        uint8_t idx = b.latest & 1;
+        uint32_t seq = b.copy[idx].seq;
+        if (seq & 1) {
+            // being written, look again
+            continue;
+        }
+        __sync_synchronize();
+        count = b.copy[idx].count;
+        length = b.copy[idx].length;
+        if (length > size) {
+            length = size;
+        }
+        memcpy(pkt, b.copy[idx].data, length);
+        __sync_synchronize();
+        if (b.copy[idx].seq == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ssize_t ShmLink::recv(void *pkt, uint16_t size, uint32_t timeout_ms)
+{
+    if (_shared == NULL) {
+        return -1;
+    }
+    const struct buffer &b = _shared->buf[_side ^ 1];
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+
+    /*
+      spin briefly for a fast peer, then yield the CPU between checks
+      until the timeout
+     */
+    for (uint32_t spins=0; ; spins++) {
+        uint16_t length;
+        uint32_t count;
+        if (b.copy[b.latest & 1].count != _rx_count &&
+            _read(b, pkt, size, length, count) &&
+            count != _rx_count) {
+            _rx_count = count;
+            return length;
+        }
+        if (spins < 1000) {
+            continue;
+        }
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        uint32_t dt_ms = (now.tv_sec - start.tv_sec)*1000 + (now.tv_usec - start.tv_usec)/1000;
+        if (dt_ms >= timeout_ms) {
+            return -1;
+        }
+        sched_yield();
+    }
+}
+
+#endif // CONFIG_HAL_BOARD
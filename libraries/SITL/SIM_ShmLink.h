@@ -0,0 +1,97 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  shared memory packet link between SITL and an external FDM on the
+  same host
+
+  The link is a file in /dev/shm mapped by both processes, holding
+  one buffer for each direction. Each buffer has two copies of the
+  packet, each with a sequence number that is odd while the copy is
+  being written. The single writer fills the copy that isn't the
+  latest and then publishes it, and the reader retries if the sequence
+  number changed under it, so neither side ever takes a lock or makes
+  a system call to pass a packet. Packets are in host byte order.
+*/
+
+#ifndef _SIM_SHMLINK_H
+#define _SIM_SHMLINK_H
+
+#include <AP_Common.h>
+#include <sys/types.h>
+
+#define SHM_LINK_MAGIC       0x4c4d4853 // "SHML"
+#define SHM_LINK_MAX_PACKET  512
+
+class ShmLink
+{
+public:
+    // which end of the link we are
+    enum Side {
+        SIDE_AUTOPILOT = 0,
+        SIDE_FDM       = 1
+    };
+
+    ShmLink(enum Side side);
+    ~ShmLink();
+
+    /*
+      create or attach to the link with the given name, as
+      /dev/shm/name. Either side may start first
+     */
+    bool open(const char *name);
+
+    /* open the link for a SITL instance, /dev/shm/sitl_fdm_N */
+    bool open_instance(uint8_t instance);
+
+    bool is_open(void) const { return _shared != NULL; }
+
+    /* publish a packet to the other side */
+    bool send(const void *pkt, uint16_t len);
+
+    /*
+      wait up to timeout_ms for a packet from the other side newer than
+      the last one received. Returns the packet length, or -1 on timeout
+     */
+    ssize_t recv(void *pkt, uint16_t size, uint32_t timeout_ms);
+
+private:
+    // one direction of the link
+    struct buffer {
+        volatile uint32_t latest;       // copy holding the newest packet
+        struct {
+            volatile uint32_t seq;      // odd while being written
+            uint32_t count;             // packets sent through this buffer
+            uint16_t length;
+            uint8_t data[SHM_LINK_MAX_PACKET];
+        } copy[2];
+    };
+
+    struct shared {
+        volatile uint32_t magic;
+        struct buffer buf[2];           // indexed by the sending side
+    };
+
+    enum Side _side;
+    int _fd;
+    struct shared *_shared;
+    uint32_t _tx_count;
+    uint32_t _rx_count;
+
+    bool _read(const struct buffer &b, void *pkt, uint16_t size,
+               uint16_t &length, uint32_t &count) const;
+};
+
+#endif // _SIM_SHMLINK_H
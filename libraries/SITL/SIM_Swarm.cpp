@@ -0,0 +1,401 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator host for a swarm of SITL vehicles
+*/
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+#include "SIM_Swarm.h"
+#include "SIM_Models.h"
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// base ports of SITL instance 0, each instance adds 10
+#define SWARM_SIMIN_PORT  5501
+#define SWARM_RCOUT_PORT  5502
+#define SWARM_MAVLINK_PORT 5760
+
+// how long to wait for a vehicle to answer an FDM packet before
+// stepping without it
+#define SWARM_SERVO_TIMEOUT_US 200000
+
+// how often to retry connecting to a vehicle's MAVLink port
+#define SWARM_CONNECT_INTERVAL_US 1000000
+
+/*
+  servo packet sent by SITL_State::_simulator_output()
+ */
+struct PACKED swarm_servo_packet {
+    uint16_t pwm[11];
+    uint16_t speed, direction, turbulance;
+};
+
+Swarm::Swarm() :
+    _num_vehicles(0),
+    _frame_count(0),
+    _speedup(1),
+    _last_sim_time_us(0),
+    _last_wall_time_us(0),
+    _gcs_fd(-1),
+    _have_gcs_addr(false),
+    _last_connect_us(0)
+{
+    memset(_vehicle, 0, sizeof(_vehicle));
+}
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+/*
+  make a home string for a vehicle east_m meters east of home_str
+ */
+void Swarm::_make_home(char *buf, size_t size, const char *home_str, float east_m)
+{
+    double lat=0, lng=0, alt=0, yaw=0;
+    sscanf(home_str, "%lf,%lf,%lf,%lf", &lat, &lng, &alt, &yaw);
+    lng += east_m / (111319.5 * cos(radians(lat)));
+    snprintf(buf, size, "%.8f,%.8f,%.2f,%.1f", lat, lng, alt, yaw);
+}
+
+bool Swarm::init(const char *home_str, const char *model_str, uint8_t num_vehicles,
+                 uint8_t first_instance, float spacing, float speedup,
+                 uint16_t gcs_port)
+{
+    // the swarm runs the physics itself, so only built-in models
+    sim_model_constructor constructor = sim_model_find(model_str, true);
+    if (constructor == NULL) {
+        fprintf(stderr, "Swarm: unknown model %s\n", model_str);
+        return false;
+    }
+    if (num_vehicles > SWARM_MAX_VEHICLES) {
+        num_vehicles = SWARM_MAX_VEHICLES;
+    }
+
+    _speedup = speedup;
+
+    for (uint8_t i=0; i<num_vehicles; i++) {
+        struct vehicle &v = _vehicle[i];
+        char home[100];
+        _make_home(home, sizeof(home), home_str, i * spacing);
+        v.model = constructor(home, model_str);
+        // the swarm keeps time against the wall clock for all the
+        // vehicles together, so stop each model from sleeping
+        v.model->set_speedup(0);
+        v.model->set_instance(first_instance + i);
+        v.model->fill_fdm(v.fdm);
+        for (uint8_t c=0; c<11; c++) {
+            v.input.servos[c] = 1000;
+        }
+        if (!_open_vehicle(v, first_instance + i)) {
+            return false;
+        }
+        _num_vehicles++;
+    }
+
+    // the single port the GCS sends to and receives from
+    struct sockaddr_in sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+#ifdef HAVE_SOCK_SIN_LEN
+    sockaddr.sin_len = sizeof(sockaddr);
+#endif
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_port = htons(gcs_port);
+    _gcs_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_gcs_fd == -1 ||
+        bind(_gcs_fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) == -1) {
+        fprintf(stderr, "Swarm: bind failed on GCS port %u - %s\n",
+                (unsigned)gcs_port, strerror(errno));
+        return false;
+    }
+    set_nonblocking(_gcs_fd);
+
+    printf("Swarm: %u %s vehicles from instance %u, GCS on UDP port %u\n",
+           (unsigned)_num_vehicles, model_str, (unsigned)first_instance, (unsigned)gcs_port);
+
+    _last_wall_time_us = _wall_time_us();
+    return true;
+}
+
+/*
+  open the FDM socket for a vehicle. We listen on the port the SITL
+  instance sends servo outputs to, and send FDM packets to the port it
+  listens on
+ */
+bool Swarm::_open_vehicle(struct vehicle &v, uint8_t instance)
+{
+    int one = 1;
+    struct sockaddr_in sockaddr;
+
+    memset(&sockaddr, 0, sizeof(sockaddr));
+#ifdef HAVE_SOCK_SIN_LEN
+    sockaddr.sin_len = sizeof(sockaddr);
+#endif
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_port = htons(SWARM_RCOUT_PORT + instance*10);
+
+    v.fdm_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (v.fdm_fd == -1) {
+        fprintf(stderr, "Swarm: socket failed - %s\n", strerror(errno));
+        return false;
+    }
+    setsockopt(v.fdm_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(v.fdm_fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) == -1) {
+        fprintf(stderr, "Swarm: bind failed on port %u - %s\n",
+                (unsigned)ntohs(sockaddr.sin_port), strerror(errno));
+        return false;
+    }
+    set_nonblocking(v.fdm_fd);
+
+    memset(&v.fdm_addr, 0, sizeof(v.fdm_addr));
+    v.fdm_addr.sin_family = AF_INET;
+    v.fdm_addr.sin_port = htons(SWARM_SIMIN_PORT + instance*10);
+    inet_pton(AF_INET, "127.0.0.1", &v.fdm_addr.sin_addr);
+
+    v.mav_fd = -1;
+    v.mav_port = SWARM_MAVLINK_PORT + instance*10;
+
+    return true;
+}
+
+void Swarm::_send_fdm(struct vehicle &v)
+{
+    v.have_servos = false;
+    sendto(v.fdm_fd, (void *)&v.fdm, sizeof(v.fdm), MSG_DONTWAIT,
+           (const struct sockaddr *)&v.fdm_addr, sizeof(v.fdm_addr));
+}
+
+/*
+  wait for every vehicle to send its servo outputs for this frame.
+  Returns false if any were missing at the timeout, in which case
+  those vehicles step with their previous outputs
+ */
+bool Swarm::_recv_servos(uint32_t timeout_us)
+{
+    uint64_t start = _wall_time_us();
+    uint8_t waiting = _num_vehicles;
+
+    while (waiting > 0) {
+        fd_set fds;
+        int max_fd = -1;
+        FD_ZERO(&fds);
+        for (uint8_t i=0; i<_num_vehicles; i++) {
+            if (!_vehicle[i].have_servos) {
+                FD_SET(_vehicle[i].fdm_fd, &fds);
+                if (_vehicle[i].fdm_fd > max_fd) {
+                    max_fd = _vehicle[i].fdm_fd;
+                }
+            }
+        }
+        uint64_t elapsed = _wall_time_us() - start;
+        if (elapsed >= timeout_us) {
+            return false;
+        }
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = timeout_us - elapsed;
+        if (select(max_fd+1, &fds, NULL, NULL, &tv) <= 0) {
+            continue;
+        }
+
+        for (uint8_t i=0; i<_num_vehicles; i++) {
+            struct vehicle &v = _vehicle[i];
+            if (v.have_servos || !FD_ISSET(v.fdm_fd, &fds)) {
+                continue;
+            }
+            struct swarm_servo_packet pkt;
+            // only the latest packet matters
+            while (recv(v.fdm_fd, &pkt, sizeof(pkt), MSG_DONTWAIT) == sizeof(pkt)) {
+                for (uint8_t c=0; c<11; c++) {
+                    v.input.servos[c] = pkt.pwm[c];
+                }
+                v.input.wind.speed = pkt.speed * 0.01f;
+                v.input.wind.direction = pkt.direction * 0.01f;
+                v.input.wind.turbulance = pkt.turbulance * 0.01f;
+                if (!v.have_servos) {
+                    v.have_servos = true;
+                    waiting--;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/*
+  step every vehicle by one frame
+ */
+void Swarm::update(void)
+{
+    for (uint8_t i=0; i<_num_vehicles; i++) {
+        _send_fdm(_vehicle[i]);
+    }
+
+    _recv_servos(SWARM_SERVO_TIMEOUT_US);
+
+    // step the vehicles in a fixed order, so runs are repeatable
+    for (uint8_t i=0; i<_num_vehicles; i++) {
+        struct vehicle &v = _vehicle[i];
+        v.model->update(v.input);
+        v.model->fill_fdm(v.fdm);
+    }
+    _frame_count++;
+
+    _mavlink_update();
+    _sync_wall_clock();
+}
+
+/*
+  connect to the MAVLink port of a vehicle, once it is listening
+ */
+void Swarm::_mavlink_connect(struct vehicle &v)
+{
+    struct sockaddr_in sockaddr;
+    int one = 1;
+
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_port = htons(v.mav_port);
+    inet_pton(AF_INET, "127.0.0.1", &sockaddr.sin_addr);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return;
+    }
+    if (connect(fd, (struct sockaddr *)&sockaddr, sizeof(sockaddr)) != 0) {
+        close(fd);
+        return;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    set_nonblocking(fd);
+    v.mav_fd = fd;
+    memset(&v.mav_rxmsg, 0, sizeof(v.mav_rxmsg));
+    memset(&v.mav_status, 0, sizeof(v.mav_status));
+}
+
+/*
+  pass MAVLink between the vehicles and the GCS. Packets from the GCS
+  go to every vehicle, which pick out their own by target system.
+  The TCP streams from the vehicles are parsed so that only whole
+  packets are sent to the GCS, otherwise partial packets from
+  different vehicles would interleave on the shared UDP port
+ */
+void Swarm::_mavlink_update(void)
+{
+    uint8_t buf[1024];
+    ssize_t n;
+
+    // only try to connect about once a second
+    uint64_t now = _wall_time_us();
+    bool try_connect = now - _last_connect_us >= SWARM_CONNECT_INTERVAL_US;
+    if (try_connect) {
+        _last_connect_us = now;
+    }
+
+    for (uint8_t i=0; i<_num_vehicles; i++) {
+        struct vehicle &v = _vehicle[i];
+        if (v.mav_fd == -1) {
+            if (try_connect) {
+                _mavlink_connect(v);
+            }
+            continue;
+        }
+        while ((n = recv(v.mav_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            for (ssize_t j=0; j<n; j++) {
+                mavlink_message_t msg;
+                mavlink_status_t status;
+                // frames with a CRC we can't check are passed on
+                // as they are, the GCS may know the message
+                if (mavlink_frame_char_buffer(&v.mav_rxmsg, &v.mav_status, buf[j],
+                                              &msg, &status) == MAVLINK_FRAMING_INCOMPLETE) {
+                    continue;
+                }
+                if (_have_gcs_addr) {
+                    uint8_t pkt[MAVLINK_MAX_PACKET_LEN];
+                    uint16_t len = mavlink_msg_to_send_buffer(pkt, &msg);
+                    sendto(_gcs_fd, pkt, len, MSG_DONTWAIT,
+                           (const struct sockaddr *)&_gcs_addr, sizeof(_gcs_addr));
+                }
+            }
+        }
+        if (n == 0) {
+            // vehicle has gone away
+            close(v.mav_fd);
+            v.mav_fd = -1;
+        }
+    }
+
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    while ((n = recvfrom(_gcs_fd, buf, sizeof(buf), MSG_DONTWAIT,
+                         (struct sockaddr *)&from, &fromlen)) > 0) {
+        _gcs_addr = from;
+        _have_gcs_addr = true;
+        for (uint8_t i=0; i<_num_vehicles; i++) {
+            if (_vehicle[i].mav_fd != -1) {
+                send(_vehicle[i].mav_fd, buf, n, MSG_DONTWAIT);
+            }
+        }
+        fromlen = sizeof(from);
+    }
+}
+
+/*
+  keep simulated time at the requested speedup of wall clock time.
+  A speedup of zero or less runs as fast as the vehicles allow
+ */
+void Swarm::_sync_wall_clock(void)
+{
+    if (_speedup <= 0 || _num_vehicles == 0) {
+        return;
+    }
+    uint64_t sim_time_us = _vehicle[0].fdm.timestamp_us;
+    if (_last_sim_time_us == 0 || sim_time_us < _last_sim_time_us) {
+        _last_sim_time_us = sim_time_us;
+        _last_wall_time_us = _wall_time_us();
+        return;
+    }
+    // sleep in batches of at least 5ms to keep the overhead low
+    uint64_t target_us = (sim_time_us - _last_sim_time_us) / _speedup;
+    if (target_us < 5000) {
+        return;
+    }
+    uint64_t now = _wall_time_us();
+    uint64_t elapsed = now - _last_wall_time_us;
+    if (elapsed < target_us) {
+        usleep(target_us - elapsed);
+    }
+    _last_sim_time_us = sim_time_us;
+    _last_wall_time_us = _wall_time_us();
+}
+
+uint64_t Swarm::_wall_time_us(void)
+{
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return tp.tv_sec*1.0e6 + tp.tv_usec;
+}
+
+#endif // CONFIG_HAL_BOARD
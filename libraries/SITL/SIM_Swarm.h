@@ -0,0 +1,95 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator host for a swarm of SITL vehicles
+
+  Runs the built-in physics model for every vehicle of a swarm in one
+  process, acting as the external FDM for each SITL instance. All
+  vehicles are stepped together: each frame the FDM state is sent to
+  every instance and the physics only advances once every instance
+  has answered with its servo outputs, so multi-vehicle runs are
+  repeatable. The MAVLink streams of all the instances are also
+  multiplexed onto a single UDP port for the GCS.
+*/
+
+#ifndef _SIM_SWARM_H
+#define _SIM_SWARM_H
+
+#include "SIM_Aircraft.h"
+#include <netinet/in.h>
+
+#define SWARM_MAX_VEHICLES 64
+
+class Swarm
+{
+public:
+    Swarm();
+
+    /*
+      create the vehicles and open their sockets. Vehicle i uses the
+      ports of SITL instance first_instance+i, and is placed spacing
+      meters east of the one before it
+     */
+    bool init(const char *home_str, const char *model_str, uint8_t num_vehicles,
+              uint8_t first_instance, float spacing, float speedup,
+              uint16_t gcs_port);
+
+    /*
+      step every vehicle by one frame
+     */
+    void update(void);
+
+    uint8_t num_vehicles(void) const { return _num_vehicles; }
+    uint64_t frame_count(void) const { return _frame_count; }
+
+private:
+    struct vehicle {
+        Aircraft *model;
+        Aircraft::sitl_input input;
+        struct sitl_fdm fdm;
+        int fdm_fd;                   // UDP, to the SITL FDM ports
+        struct sockaddr_in fdm_addr;
+        int mav_fd;                   // TCP, to the SITL uartA port
+        uint16_t mav_port;
+        mavlink_message_t mav_rxmsg;  // parser state for the uartA stream
+        mavlink_status_t mav_status;
+        bool have_servos;
+    } _vehicle[SWARM_MAX_VEHICLES];
+
+    uint8_t _num_vehicles;
+    uint64_t _frame_count;
+    float _speedup;
+    uint64_t _last_sim_time_us;
+    uint64_t _last_wall_time_us;
+
+    // single UDP port the GCS talks to
+    int _gcs_fd;
+    struct sockaddr_in _gcs_addr;
+    bool _have_gcs_addr;
+    uint64_t _last_connect_us;
+
+    bool _open_vehicle(struct vehicle &v, uint8_t instance);
+    void _send_fdm(struct vehicle &v);
+    bool _recv_servos(uint32_t timeout_us);
+    void _mavlink_connect(struct vehicle &v);
+    void _mavlink_update(void);
+    void _sync_wall_clock(void);
+
+    static uint64_t _wall_time_us(void);
+    static void _make_home(char *buf, size_t size, const char *home_str, float east_m);
+};
+
+#endif // _SIM_SWARM_H
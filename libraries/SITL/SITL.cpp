@@ -69,6 +69,12 @@ const AP_Param::GroupInfo SITL::var_info[] PROGMEM = {
     AP_GROUPINFO("MAG_DELAY",     39, SITL,  mag_delay, 0),
     AP_GROUPINFO("WIND_DELAY",    40, SITL,  wind_delay, 0),
     AP_GROUPINFO("MAG_OFS",       41, SITL,  mag_ofs, 0),
+    AP_GROUPINFO("BARO_JITTER",   42, SITL,  baro_jitter, 0),
+    AP_GROUPINFO("MAG_JITTER",    43, SITL,  mag_jitter, 0),
+    AP_GROUPINFO("WIND_JITTER",   44, SITL,  wind_jitter, 0),
+    AP_GROUPINFO("BARO_DROP",     45, SITL,  baro_drop, 0),
+    AP_GROUPINFO("MAG_DROP",      46, SITL,  mag_drop, 0),
+    AP_GROUPINFO("WIND_DROP",     47, SITL,  wind_drop, 0),
     AP_GROUPEND
 };
 
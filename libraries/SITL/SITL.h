@@ -99,6 +99,16 @@ public:
     AP_Int16  mag_delay; // magnetometer data delay in ms
     AP_Int16  wind_delay; // windspeed data delay in ms
 
+    // extra random latency, spread evenly between 0 and this many ms
+    AP_Int16  baro_jitter;
+    AP_Int16  mag_jitter;
+    AP_Int16  wind_jitter;
+
+    // percentage of samples lost, the sensor keeps its last reading
+    AP_Float  baro_drop;
+    AP_Float  mag_drop;
+    AP_Float  wind_drop;
+
     void simstate_send(mavlink_channel_t chan);
 
     void Log_Write_SIMSTATE(DataFlash_Class &dataflash);
@@ -0,0 +1,195 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  Benchmark of the built-in SITL physics models. Flies each model
+  through the same open loop servo sequence with each integrator,
+  free running with no wall clock sync, and reports simulated seconds
+  per wall clock second along with the position error against a
+  finely stepped RK4 reference run
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_ADC.h>
+#include <AP_Declination.h>
+#include <AP_ADC_AnalogSource.h>
+#include <Filter.h>
+#include <AP_Buffer.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_Notify.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_InertialSensor.h>
+#include <AP_InertialNav.h>
+#include <AP_NavEKF.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Terrain.h>
+#include <AP_OpticalFlow.h>
+#include <AP_SerialManager.h>
+#include <RC_Channel.h>
+#include <AP_RangeFinder.h>
+#include <SIM_Models.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#define HOME_STR     "-35.363261,149.165230,584,353"
+#define SIM_SECONDS  120
+#define FRAME_RATE   400
+
+// one model of each kind of built-in physics
+static const char *models[] = { "x", "heli", "rover" };
+
+static const struct {
+    const char *name;
+    Aircraft::Integrator integrator;
+    uint8_t substeps;
+} integrators[] = {
+    { "semi-implicit x1", Aircraft::INTEGRATOR_SEMI_IMPLICIT, 1 },
+    { "semi-implicit x4", Aircraft::INTEGRATOR_SEMI_IMPLICIT, 4 },
+    { "rk4 x1",           Aircraft::INTEGRATOR_RK4,           1 },
+    { "rk4 x4",           Aircraft::INTEGRATOR_RK4,           4 },
+};
+
+static uint64_t wall_time_us(void)
+{
+    struct timeval tp;
+    gettimeofday(&tp, NULL);
+    return tp.tv_sec*1000000ULL + tp.tv_usec;
+}
+
+/*
+  open loop servo inputs: climb out, then a slow turn with some
+  roll and pitch inputs, then a steady hover
+ */
+static void servo_input(uint32_t frame, Aircraft::sitl_input &input)
+{
+    float t = frame / (float)FRAME_RATE;
+    memset(&input, 0, sizeof(input));
+    for (uint8_t i=0; i<16; i++) {
+        input.servos[i] = 1500;
+    }
+    if (t < 5) {
+        for (uint8_t i=0; i<4; i++) {
+            input.servos[i] = 1600;
+        }
+        input.servos[7] = 1800;
+    } else if (t < 60) {
+        float s = sinf(t * 0.5f);
+        input.servos[0] = 1520 + 20*s;
+        input.servos[1] = 1520 - 20*s;
+        input.servos[2] = 1520 + 10*s;
+        input.servos[3] = 1510;
+        input.servos[7] = 1800;
+    } else {
+        for (uint8_t i=0; i<4; i++) {
+            input.servos[i] = 1510;
+        }
+        input.servos[7] = 1800;
+    }
+}
+
+/*
+  fly a model for SIM_SECONDS, returning the wall clock time taken
+  and the final state
+ */
+static uint64_t run(uint8_t model, Aircraft::Integrator integrator, uint8_t substeps,
+                    struct sitl_fdm &fdm)
+{
+    // same noise sequence for every run
+    srand(1);
+
+    Aircraft *aircraft = sim_model_find(models[model], true)(HOME_STR, models[model]);
+    aircraft->set_speedup(0);
+    aircraft->set_integrator(integrator, substeps);
+
+    Aircraft::sitl_input input;
+    uint64_t start_us = wall_time_us();
+    for (uint32_t frame=0; frame<SIM_SECONDS*FRAME_RATE; frame++) {
+        servo_input(frame, input);
+        aircraft->update(input);
+    }
+    uint64_t elapsed_us = wall_time_us() - start_us;
+
+    aircraft->fill_fdm(fdm);
+    delete aircraft;
+    return elapsed_us;
+}
+
+/*
+  distance in meters between two fdm positions
+ */
+static float position_error(const struct sitl_fdm &a, const struct sitl_fdm &b)
+{
+    Location la, lb;
+    memset(&la, 0, sizeof(la));
+    memset(&lb, 0, sizeof(lb));
+    la.lat = a.latitude * 1.0e7;
+    la.lng = a.longitude * 1.0e7;
+    lb.lat = b.latitude * 1.0e7;
+    lb.lng = b.longitude * 1.0e7;
+    Vector2f ne = location_diff(la, lb);
+    return sqrtf(sq(ne.x) + sq(ne.y) + sq(a.altitude - b.altitude));
+}
+
+void setup()
+{
+    ::printf("SITL physics benchmark, %u simulated seconds at %uHz\n",
+             (unsigned)SIM_SECONDS, (unsigned)FRAME_RATE);
+
+    for (uint8_t m=0; m<sizeof(models)/sizeof(models[0]); m++) {
+        struct sitl_fdm reference;
+        run(m, Aircraft::INTEGRATOR_RK4, 32, reference);
+
+        ::printf("%s:\n", models[m]);
+        for (uint8_t i=0; i<sizeof(integrators)/sizeof(integrators[0]); i++) {
+            struct sitl_fdm fdm;
+            uint64_t elapsed_us = run(m, integrators[i].integrator, integrators[i].substeps, fdm);
+            ::printf("  %-18s %8.1f sim s/wall s  error %.3fm\n",
+                     integrators[i].name,
+                     (double)(SIM_SECONDS * 1.0e6 / elapsed_us),
+                     (double)position_error(fdm, reference));
+        }
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
+
+#else
+
+void setup()
+{
+    hal.console->println_P(PSTR("PhysicsBench only runs on the SITL HAL"));
+}
+
+void loop()
+{
+    hal.scheduler->delay(1000);
+}
+
+#endif // CONFIG_HAL_BOARD
+
+AP_HAL_MAIN();